@@ -865,7 +865,7 @@ int main(int argc, char *argv[]) {
                      with_hydro, (with_external_gravity || with_self_gravity),
                      with_stars, with_black_holes, cleanup_h, cleanup_sqrt_a,
                      cosmo.h, cosmo.a, myrank, nr_nodes, MPI_COMM_WORLD,
-                     MPI_INFO_NULL, nr_threads, dry_run);
+                     MPI_INFO_NULL, &initial_partition, nr_threads, dry_run);
 #else
     read_ic_serial(ICfileName, &us, dim, &parts, &gparts, &sparts, &bparts,
                    &Ngas, &Ngpart, &Nspart, &Nbpart, &flag_entropy_ICs,
@@ -1281,6 +1281,9 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  /* Report how often we had to re-build */
+  engine_print_rebuild_stats(&e);
+
   /* Write final output. */
   if (!force_stop) {
 
@@ -437,8 +437,8 @@ int main(int argc, char *argv[]) {
                    &Ngas, &Ngpart, &Nspart, &Nbpart, &flag_entropy_ICs,
                    with_hydro, /*with_grav=*/1, with_stars, with_black_holes,
                    cleanup_h, cleanup_sqrt_a, cosmo.h, cosmo.a, myrank,
-                   nr_nodes, MPI_COMM_WORLD, MPI_INFO_NULL, nr_threads,
-                   /*dry_run=*/0);
+                   nr_nodes, MPI_COMM_WORLD, MPI_INFO_NULL, &initial_partition,
+                   nr_threads, /*dry_run=*/0);
 #else
   read_ic_serial(ICfileName, &us, dim, &parts, &gparts, &sparts, &bparts, &Ngas,
                  &Ngpart, &Nspart, &Nbpart, &flag_entropy_ICs, with_hydro,
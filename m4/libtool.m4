@@ -0,0 +1 @@
+/usr/share/aclocal/libtool.m4
\ No newline at end of file
@@ -428,6 +428,59 @@ __attribute__((always_inline)) INLINE static int bpart_is_inhibited(
   return bp->time_bin == time_bin_inhibited;
 }
 
+/**
+ * @brief Gets the #part of a cell that have to be visited to find all the
+ * active (or starting) ones.
+ *
+ * If the cell holds an ordering of its particles by time-bin, the active ones
+ * come first and only the start of that list is returned. Particles removed
+ * since the list was ordered are passed over, so the callers still have to
+ * check the particles they are given. Without an ordering, all the particles
+ * of the cell are returned.
+ *
+ * @param c The #cell.
+ * @param e The #engine containing information about the current time.
+ * @param order (return) The indices of the particles to visit, or NULL to
+ * visit the particles in their storage order.
+ * @return The number of particles to visit.
+ */
+__attribute__((always_inline)) INLINE static int cell_get_active_hydro_order(
+    const struct cell *c, const struct engine *e, const int **order) {
+
+  const int count = c->hydro.count;
+
+  if (!c->hydro.bin_order_valid) {
+    *order = NULL;
+    return count;
+  }
+
+  const struct part *restrict parts = c->hydro.parts;
+  const int *restrict bin_order = c->hydro.bin_order;
+  const timebin_t max_active_bin = e->max_active_bin;
+
+  int num_visit = 0;
+  while (num_visit < count) {
+    const timebin_t bin = parts[bin_order[num_visit]].time_bin;
+    if (bin > max_active_bin && bin <= num_time_bins) break;
+    num_visit++;
+  }
+
+#ifdef SWIFT_DEBUG_CHECKS
+  int num_active = 0, num_active_visit = 0;
+  for (int k = 0; k < count; k++)
+    if (part_is_active_no_debug(&parts[k], max_active_bin)) num_active++;
+  for (int k = 0; k < num_visit; k++)
+    if (part_is_active_no_debug(&parts[bin_order[k]], max_active_bin))
+      num_active_visit++;
+  if (num_active != num_active_visit)
+    error("Time-bin ordering of the cell misses active particles (%d vs. %d)",
+          num_active_visit, num_active);
+#endif
+
+  *order = bin_order;
+  return num_visit;
+}
+
 /* Are cells / particles active for kick1 tasks ? */
 
 /**
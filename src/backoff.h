@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_BACKOFF_H
+#define SWIFT_BACKOFF_H
+
+/* Config parameters. */
+#include "../config.h"
+
+/* Local headers. */
+#include "cycle.h"
+#include "inline.h"
+
+/*! Longest run of pause instructions between two polls. */
+#define backoff_max_pauses 64
+
+/**
+ * @brief State of a thread spinning while it waits for some work.
+ *
+ * The thread polls for work with an exponentially growing number of pause
+ * instructions in-between, until its time budget is spent and it goes to
+ * sleep instead.
+ */
+struct backoff {
+
+  /*! Ticks after which the thread should stop spinning. */
+  ticks deadline;
+
+  /*! Number of pauses before the next poll. */
+  int pauses;
+};
+
+/**
+ * @brief Tell the CPU that we are in a spin-wait loop.
+ */
+__attribute__((always_inline)) INLINE static void backoff_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield" ::: "memory");
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Start spinning.
+ *
+ * @param b The #backoff.
+ * @param budget The number of ticks to spin for before giving up.
+ */
+__attribute__((always_inline)) INLINE static void backoff_init(
+    struct backoff *b, const ticks budget) {
+
+  b->deadline = getticks() + budget;
+  b->pauses = 1;
+}
+
+/**
+ * @brief Wait a bit longer than the last time before polling again.
+ *
+ * @param b The #backoff.
+ * @return 1 if the thread should poll again, 0 if the budget is spent.
+ */
+__attribute__((always_inline)) INLINE static int backoff_spin(
+    struct backoff *b) {
+
+  if (getticks() >= b->deadline) return 0;
+
+  for (int k = 0; k < b->pauses; k++) backoff_pause();
+  if (b->pauses < backoff_max_pauses) b->pauses *= 2;
+
+  return 1;
+}
+
+#endif /* SWIFT_BACKOFF_H */
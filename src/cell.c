@@ -515,6 +515,7 @@ int cell_pack(struct cell *restrict c, struct pcell *restrict pc,
   pc->hydro.count = c->hydro.count;
   pc->grav.count = c->grav.count;
   pc->stars.count = c->stars.count;
+  pc->stars.count_total = c->stars.count_total;
   pc->black_holes.count = c->black_holes.count;
   pc->maxdepth = c->maxdepth;
 
@@ -647,6 +648,7 @@ int cell_unpack(struct pcell *restrict pc, struct cell *restrict c,
   c->hydro.count = pc->hydro.count;
   c->grav.count = pc->grav.count;
   c->stars.count = pc->stars.count;
+  c->stars.count_total = pc->stars.count_total;
   c->black_holes.count = pc->black_holes.count;
   c->maxdepth = pc->maxdepth;
 
@@ -1992,6 +1994,187 @@ void cell_clean_links(struct cell *c, void *data) {
   c->black_holes.feedback = NULL;
 }
 
+/**
+ * @brief Recursively removes all the tasks from a cell hierarchy.
+ *
+ * Used on trees that survive a rebuild of the space when their tasks cannot
+ * be re-used, so that they look to the task construction as if they had just
+ * been split.
+ *
+ * @param c The #cell to clean.
+ */
+void cell_clean_tasks(struct cell *c) {
+
+  cell_clean_links(c, NULL);
+  c->nr_tasks = 0;
+  c->grav.nr_mm_tasks = 0;
+  c->hydro.sorts = NULL;
+  c->hydro.drift = NULL;
+  c->hydro.ghost_in = NULL;
+  c->hydro.ghost_out = NULL;
+  c->hydro.ghost = NULL;
+  c->hydro.extra_ghost = NULL;
+  c->hydro.end_force = NULL;
+  c->hydro.cooling = NULL;
+  c->hydro.star_formation = NULL;
+  c->hydro.stars_resort = NULL;
+  c->grav.drift = NULL;
+  c->grav.drift_out = NULL;
+  c->grav.init = NULL;
+  c->grav.init_out = NULL;
+  c->grav.long_range = NULL;
+  c->grav.down_in = NULL;
+  c->grav.mesh = NULL;
+  c->grav.down = NULL;
+  c->grav.end_force = NULL;
+  c->stars.ghost = NULL;
+  c->stars.sorts = NULL;
+  c->stars.drift = NULL;
+  c->stars.stars_in = NULL;
+  c->stars.stars_out = NULL;
+  c->black_holes.drift = NULL;
+  c->black_holes.black_holes_in = NULL;
+  c->black_holes.black_holes_out = NULL;
+  c->black_holes.density_ghost = NULL;
+  c->black_holes.swallow_ghost[0] = NULL;
+  c->black_holes.swallow_ghost[1] = NULL;
+  c->kick1 = NULL;
+  c->kick2 = NULL;
+  c->timestep = NULL;
+  c->timestep_limiter = NULL;
+  c->logger = NULL;
+  c->super = (c->parent == NULL) ? c : NULL;
+  c->hydro.super = c->super;
+  c->grav.super = c->super;
+#ifdef WITH_MPI
+  c->mpi.tag = -1;
+  c->mpi.send = NULL;
+#endif
+
+  if (c->split)
+    for (int k = 0; k < 8; k++)
+      if (c->progeny[k] != NULL) cell_clean_tasks(c->progeny[k]);
+}
+
+/**
+ * @brief Recursively removes the sorts and the flags from a cell hierarchy.
+ *
+ * Used on trees that survive a rebuild of the space such that the sorts are
+ * re-computed from scratch, as for the newly split trees.
+ *
+ * @param c The #cell to clean.
+ */
+void cell_clean_sorts(struct cell *c) {
+
+  c->flags = 0;
+  cell_free_hydro_sorts(c);
+  cell_free_hydro_bin_order(c);
+  cell_free_stars_sorts(c);
+  c->hydro.sorted = 0;
+  c->hydro.requires_sorts = 0;
+  c->hydro.do_sort = 0;
+  c->hydro.dx_max_sort = 0.f;
+  c->stars.sorted = 0;
+  c->stars.requires_sorts = 0;
+  c->stars.do_sort = 0;
+  c->stars.dx_max_sort = 0.f;
+
+  if (c->split)
+    for (int k = 0; k < 8; k++)
+      if (c->progeny[k] != NULL) cell_clean_sorts(c->progeny[k]);
+}
+
+/**
+ * @brief Removes the links to empty tasks from a list.
+ *
+ * @param l The list of links.
+ * @param count (return) Counter of the tasks in the list, or NULL.
+ */
+static void cell_clean_dead_links_list(struct link **l, short int *count) {
+
+  while (*l != NULL) {
+    if ((*l)->t->type == task_type_none) {
+      *l = (*l)->next;
+      if (count != NULL) (*count)--;
+    } else {
+      l = &(*l)->next;
+    }
+  }
+}
+
+/**
+ * @brief Recursively removes the links to empty tasks from a cell hierarchy.
+ *
+ * Used on the trees whose tasks are kept over a rebuild once the tasks
+ * involving a re-built cell were emptied.
+ *
+ * @param c The #cell to clean.
+ */
+void cell_clean_dead_links(struct cell *c) {
+
+  /* Only the density and gravity tasks are counted. */
+  cell_clean_dead_links_list(&c->hydro.density, &c->nr_tasks);
+  cell_clean_dead_links_list(&c->hydro.gradient, NULL);
+  cell_clean_dead_links_list(&c->hydro.force, NULL);
+  cell_clean_dead_links_list(&c->hydro.limiter, NULL);
+  cell_clean_dead_links_list(&c->grav.grav, &c->nr_tasks);
+  cell_clean_dead_links_list(&c->grav.mm, &c->grav.nr_mm_tasks);
+  cell_clean_dead_links_list(&c->stars.density, NULL);
+  cell_clean_dead_links_list(&c->stars.feedback, NULL);
+  cell_clean_dead_links_list(&c->black_holes.density, NULL);
+  cell_clean_dead_links_list(&c->black_holes.swallow, NULL);
+  cell_clean_dead_links_list(&c->black_holes.do_swallow, NULL);
+  cell_clean_dead_links_list(&c->black_holes.feedback, NULL);
+
+  if (c->split)
+    for (int k = 0; k < 8; k++)
+      if (c->progeny[k] != NULL) cell_clean_dead_links(c->progeny[k]);
+}
+
+/**
+ * @brief Checks that the super-cell pointers of a cell hierarchy are the ones
+ * cell_set_super_mapper() would set given the current links.
+ *
+ * @param c The #cell to check.
+ * @param super The common super-cell above c, or NULL.
+ * @param super_hydro The hydro super-cell above c, or NULL.
+ * @param super_grav The gravity super-cell above c, or NULL.
+ * @param with_hydro Are we running with hydrodynamics?
+ * @param with_grav Are we running with gravity?
+ *
+ * @return 1 if all the super-cells are unchanged, 0 otherwise.
+ */
+int cell_check_supers(const struct cell *c, const struct cell *super,
+                      const struct cell *super_hydro,
+                      const struct cell *super_grav, const int with_hydro,
+                      const int with_grav) {
+
+  if (with_hydro) {
+    if (super_hydro == NULL && c->hydro.density != NULL) super_hydro = c;
+    if (c->hydro.super != super_hydro) return 0;
+  }
+
+  if (with_grav) {
+    if (super_grav == NULL && (c->grav.grav != NULL || c->grav.mm != NULL))
+      super_grav = c;
+    if (c->grav.super != super_grav) return 0;
+  }
+
+  if (super == NULL && ((with_hydro && c->hydro.super != NULL) ||
+                        (with_grav && c->grav.super != NULL)))
+    super = c;
+  if (c->super != super) return 0;
+
+  if (c->split)
+    for (int k = 0; k < 8; k++)
+      if (c->progeny[k] != NULL &&
+          !cell_check_supers(c->progeny[k], super, super_hydro, super_grav,
+                             with_hydro, with_grav))
+        return 0;
+
+  return 1;
+}
+
 /**
  * @brief Checks that the #part in a cell are at the
  * current point in time
@@ -2347,6 +2530,7 @@ void cell_check_multipole(struct cell *c) {
 void cell_clean(struct cell *c) {
   /* Hydro */
   cell_free_hydro_sorts(c);
+  cell_free_hydro_bin_order(c);
 
   /* Stars */
   cell_free_stars_sorts(c);
@@ -3005,7 +3189,7 @@ void cell_activate_subcell_black_holes_tasks(struct cell *ci, struct cell *cj,
       }
     }
 
-    /* Otherwise, activate the drifts. */
+    /* Otherwise, activate the drifts and sorts. */
     else if (cell_is_active_black_holes(ci, e) ||
              cell_is_active_black_holes(cj, e)) {
 
@@ -3016,6 +3200,18 @@ void cell_activate_subcell_black_holes_tasks(struct cell *ci, struct cell *cj,
       /* Activate the drifts if the cells are local. */
       if (ci->nodeID == engine_rank) cell_activate_drift_part(ci, s);
       if (cj->nodeID == engine_rank) cell_activate_drift_bpart(cj, s);
+
+      /* The BHs use the sorts of the local gas they interact with. */
+      if (cell_is_active_black_holes(ci, e) && cj->nodeID == engine_rank) {
+        atomic_or(&cj->hydro.requires_sorts, 1 << sid);
+        cj->hydro.dx_max_sort_old = cj->hydro.dx_max_sort;
+        cell_activate_hydro_sorts(cj, sid, s);
+      }
+      if (cell_is_active_black_holes(cj, e) && ci->nodeID == engine_rank) {
+        atomic_or(&ci->hydro.requires_sorts, 1 << sid);
+        ci->hydro.dx_max_sort_old = ci->hydro.dx_max_sort;
+        cell_activate_hydro_sorts(ci, sid, s);
+      }
     }
   } /* Otherwise, pair interation */
 }
@@ -3248,7 +3444,10 @@ int cell_unskip_hydro_tasks(struct cell *c, struct scheduler *s) {
     if (t->type == task_type_pair || t->type == task_type_sub_pair) {
       /* Check whether there was too much particle motion, i.e. the
          cell neighbour conditions were violated. */
-      if (cell_need_rebuild_for_hydro_pair(ci, cj)) rebuild = 1;
+      if (cell_need_rebuild_for_hydro_pair(ci, cj)) {
+        rebuild = 1;
+        cell_flag_pair_for_rebuild(ci, cj);
+      }
 
 #ifdef WITH_MPI
       /* Activate the send/recv tasks. */
@@ -3676,8 +3875,14 @@ int cell_unskip_stars_tasks(struct cell *c, struct scheduler *s,
     if (t->type == task_type_pair || t->type == task_type_sub_pair) {
       /* Check whether there was too much particle motion, i.e. the
          cell neighbour conditions were violated. */
-      if (cell_need_rebuild_for_stars_pair(ci, cj)) rebuild = 1;
-      if (cell_need_rebuild_for_stars_pair(cj, ci)) rebuild = 1;
+      if (cell_need_rebuild_for_stars_pair(ci, cj)) {
+        rebuild = 1;
+        cell_flag_pair_for_rebuild(ci, cj);
+      }
+      if (cell_need_rebuild_for_stars_pair(cj, ci)) {
+        rebuild = 1;
+        cell_flag_pair_for_rebuild(ci, cj);
+      }
 
 #ifdef WITH_MPI
       /* Activate the send/recv tasks. */
@@ -3865,6 +4070,18 @@ int cell_unskip_black_holes_tasks(struct cell *c, struct scheduler *s) {
 
         if (cj_nodeID == nodeID) cell_activate_drift_part(cj, s);
         if (cj_nodeID == nodeID) cell_activate_drift_bpart(cj, s);
+
+        /* The BHs use the sorts of the local gas they interact with. */
+        if (ci_active && cj_nodeID == nodeID) {
+          atomic_or(&cj->hydro.requires_sorts, 1 << t->flags);
+          cj->hydro.dx_max_sort_old = cj->hydro.dx_max_sort;
+          cell_activate_hydro_sorts(cj, t->flags, s);
+        }
+        if (cj_active && ci_nodeID == nodeID) {
+          atomic_or(&ci->hydro.requires_sorts, 1 << t->flags);
+          ci->hydro.dx_max_sort_old = ci->hydro.dx_max_sort;
+          cell_activate_hydro_sorts(ci, t->flags, s);
+        }
       }
 
       /* Store current values of dx_max and h_max. */
@@ -3883,8 +4100,14 @@ int cell_unskip_black_holes_tasks(struct cell *c, struct scheduler *s) {
 
       /* Check whether there was too much particle motion, i.e. the
          cell neighbour conditions were violated. */
-      if (cell_need_rebuild_for_black_holes_pair(ci, cj)) rebuild = 1;
-      if (cell_need_rebuild_for_black_holes_pair(cj, ci)) rebuild = 1;
+      if (cell_need_rebuild_for_black_holes_pair(ci, cj)) {
+        rebuild = 1;
+        cell_flag_pair_for_rebuild(ci, cj);
+      }
+      if (cell_need_rebuild_for_black_holes_pair(cj, ci)) {
+        rebuild = 1;
+        cell_flag_pair_for_rebuild(ci, cj);
+      }
 
       scheduler_activate(s, ci->hydro.super->black_holes.swallow_ghost[0]);
       scheduler_activate(s, cj->hydro.super->black_holes.swallow_ghost[0]);
@@ -4156,9 +4379,14 @@ void cell_set_super_mapper(void *map_data, int num_elements, void *extra_data) {
   const int with_grav = (e->policy & engine_policy_self_gravity) ||
                         (e->policy & engine_policy_external_gravity);
 
+  const char *rebuilt = e->s->cells_rebuilt;
+
   for (int ind = 0; ind < num_elements; ind++) {
     struct cell *c = &((struct cell *)map_data)[ind];
 
+    /* Skip the cells whose tasks were kept. */
+    if (rebuilt != NULL && !rebuilt[c - e->s->cells_top]) continue;
+
     /* All top-level cells get an MPI tag. */
 #ifdef WITH_MPI
     cell_ensure_tagged(c);
@@ -5013,6 +5241,86 @@ void cell_clear_hydro_sort_flags(struct cell *c, const int clear_unused_flags) {
   }
 }
 
+/**
+ * @brief Orders the #part of a leaf-cell by increasing time-bin once their
+ * new time-steps have been computed.
+ *
+ * If the cell was already ordered, only the particles at the start of the
+ * list can have changed time-bin. They are moved into place in the rest of
+ * the list, which is still ordered. Otherwise, the list is built from
+ * scratch.
+ *
+ * Removed particles (inhibited or not created yet) are not ordered. They are
+ * passed over when moving the other particles and can hence be anywhere in
+ * the list.
+ *
+ * @param c The #cell.
+ * @param num_updated The number of particles at the start of the list whose
+ * time-bin may have changed since it was last ordered.
+ */
+void cell_sort_hydro_bin_order(struct cell *c, const int num_updated) {
+
+  const int count = c->hydro.count;
+  const struct part *restrict parts = c->hydro.parts;
+
+  if (count == 0) return;
+
+  if (!c->hydro.bin_order_valid) {
+
+    if (c->hydro.bin_order == NULL &&
+        (c->hydro.bin_order = (int *)swift_malloc(
+             "hydro.bin_order", sizeof(int) * count)) == NULL)
+      error("Failed to allocate the time-bin ordering.");
+
+    /* Counting sort of the particles by time-bin */
+    int offsets[time_bin_not_created + 2] = {0};
+    for (int k = 0; k < count; k++) {
+#ifdef SWIFT_DEBUG_CHECKS
+      if (parts[k].time_bin < 0 || parts[k].time_bin > time_bin_not_created)
+        error("Invalid time-bin %d", parts[k].time_bin);
+#endif
+      offsets[parts[k].time_bin + 1]++;
+    }
+    for (int b = 1; b <= time_bin_not_created + 1; b++)
+      offsets[b] += offsets[b - 1];
+    for (int k = 0; k < count; k++)
+      c->hydro.bin_order[offsets[parts[k].time_bin]++] = k;
+
+  } else {
+
+    int *restrict order = c->hydro.bin_order;
+
+    /* Move the updated particles into the ordered end of the list, starting
+     * from the last one such that the end of the list stays ordered. */
+    for (int i = num_updated - 1; i >= 0; i--) {
+      const int ind = order[i];
+      const timebin_t bin = parts[ind].time_bin;
+      if (bin > num_time_bins) continue;
+
+      int j = i;
+      while (j + 1 < count) {
+        const timebin_t next_bin = parts[order[j + 1]].time_bin;
+        if (next_bin >= bin && next_bin <= num_time_bins) break;
+        order[j] = order[j + 1];
+        j++;
+      }
+      order[j] = ind;
+    }
+  }
+
+  c->hydro.bin_order_valid = 1;
+
+#ifdef SWIFT_DEBUG_CHECKS
+  timebin_t last_bin = 0;
+  for (int i = 0; i < count; i++) {
+    const timebin_t bin = parts[c->hydro.bin_order[i]].time_bin;
+    if (bin > num_time_bins) continue;
+    if (bin < last_bin) error("Time-bin ordering is not ordered!");
+    last_bin = bin;
+  }
+#endif
+}
+
 /**
  * @brief Recursively checks that all particles in a cell have a time-step
  */
@@ -5109,164 +5417,221 @@ void cell_check_sort_flags(const struct cell *c) {
 
 /**
  * @brief Recursively update the pointer and counter for #spart after the
- * addition of a new particle.
+ * addition of new particles.
  *
  * @param c The cell we are working on.
- * @param progeny_list The list of the progeny index at each level for the
- * leaf-cell where the particle was added.
- * @param main_branch Are we in a cell directly above the leaf where the new
- * particle was added?
+ * @param cells The leaf-cells where the particles were added, one per new
+ * particle, in the order in which they are located in memory.
+ * @param count The number of new particles.
+ * @param index (in/out) The index in cells of the first new particle located
+ * in or after this cell, i.e. the number of new particles before this cell.
  */
-void cell_recursively_shift_sparts(struct cell *c,
-                                   const int progeny_list[space_cell_maxdepth],
-                                   const int main_branch) {
-  if (c->split) {
-    /* No need to recurse in progenies located before the insestion point */
-    const int first_progeny = main_branch ? progeny_list[(int)c->depth] : 0;
+void cell_recursively_shift_sparts(struct cell *c, struct cell *const *cells,
+                                   const int count, int *index) {
 
-    for (int k = first_progeny; k < 8; ++k) {
+  const int first_index = *index;
+
+  /* All the new particles located before this cell shift its particles */
+  c->stars.parts += first_index;
+
+  if (c->split) {
+    for (int k = 0; k < 8; ++k) {
       if (c->progeny[k] != NULL)
-        cell_recursively_shift_sparts(c->progeny[k], progeny_list,
-                                      main_branch && (k == first_progeny));
+        cell_recursively_shift_sparts(c->progeny[k], cells, count, index);
     }
+  } else {
+    while (*index < count && cells[*index] == c) ++(*index);
   }
 
-  /* When directly above the leaf with the new particle: increase the particle
-   * count */
-  /* When after the leaf with the new particle: shift by one position */
-  if (main_branch)
-    c->stars.count++;
-  else
-    c->stars.parts++;
+  /* Account for the new particles in this cell */
+  c->stars.count += *index - first_index;
 }
 
 /**
- * @brief "Add" a #spart in a given #cell.
+ * @brief "Add" a batch of #spart in the leaf-cells of a top-level cell.
  *
- * This function will a a #spart at the start of the current cell's array by
- * shifting all the #spart in the top-level cell by one position. All the
- * pointers and cell counts are updated accordingly.
+ * All the #spart in the top-level cell are shifted in a single pass such that
+ * every leaf-cell gets as many free slots at the start of its array as
+ * particles are added to it. All the pointers and cell counts are updated
+ * accordingly. The top-level cell is locked only once for the whole batch.
  *
  * @param e The #engine.
- * @param c The leaf-cell in which to add the #spart.
- *
- * @return A pointer to the newly added #spart. The spart has a been zeroed
- * and given a position within the cell as well as set to the minimal active
- * time bin.
+ * @param cells The leaf-cells in which to add the #spart, one per new #spart.
+ * They must all be in the same top-level cell and be sorted by their position
+ * in memory.
+ * @param count The number of #spart to add.
+ * @param sparts (return) Pointers to the newly added #spart. They have been
+ * zeroed and given a position within their cell as well as set to the
+ * minimal active time bin.
+ *
+ * @return The number of #spart actually added. This is smaller than count if
+ * the top-level cell ran out of spare #spart, in which case the last ones are
+ * not added.
  */
-struct spart *cell_add_spart(struct engine *e, struct cell *const c) {
+int cell_add_sparts(struct engine *e, struct cell *const *cells,
+                    const int count, struct spart **sparts) {
+
+  if (count == 0) return 0;
+
   /* Perform some basic consitency checks */
-  if (c->nodeID != engine_rank) error("Adding spart on a foreign node");
-  if (c->grav.ti_old_part != e->ti_current) error("Undrifted cell!");
-  if (c->split) error("Addition of spart performed above the leaf level");
+  for (int i = 0; i < count; ++i) {
+    if (cells[i]->nodeID != engine_rank)
+      error("Adding spart on a foreign node");
+    if (cells[i]->grav.ti_old_part != e->ti_current) error("Undrifted cell!");
+    if (cells[i]->split)
+      error("Addition of spart performed above the leaf level");
+  }
+
+  /* Get the top-level cell these leaf cells are in */
+  struct cell *top = cells[0];
+  while (top->parent != NULL) top = top->parent;
 
-  /* Progeny number at each level */
-  int progeny[space_cell_maxdepth];
 #ifdef SWIFT_DEBUG_CHECKS
-  for (int i = 0; i < space_cell_maxdepth; ++i) progeny[i] = -1;
-#endif
+  for (int i = 0; i < count; ++i) {
 
-  /* Get the top-level this leaf cell is in and compute the progeny indices at
-     each level */
-  struct cell *top = c;
-  while (top->parent != NULL) {
-    /* What is the progeny index of the cell? */
-    for (int k = 0; k < 8; ++k) {
-      if (top->parent->progeny[k] == top) {
-        progeny[(int)top->parent->depth] = k;
-      }
-    }
+    if (i > 0 && cells[i]->stars.parts < cells[i - 1]->stars.parts)
+      error("Leaf-cells are not sorted by position in memory");
 
-      /* Check that the cell was indeed drifted to this point to avoid future
-       * issues */
-#ifdef SWIFT_DEBUG_CHECKS
-    if (top->hydro.super != NULL && top->stars.count > 0 &&
-        top->stars.ti_old_part != e->ti_current) {
-      error("Cell had not been correctly drifted before star formation");
+    /* Check that the cells were indeed drifted to this point to avoid future
+     * issues */
+    struct cell *c = cells[i];
+    while (c->parent != NULL) {
+      if (c->hydro.super != NULL && c->stars.count > 0 &&
+          c->stars.ti_old_part != e->ti_current) {
+        error("Cell had not been correctly drifted before star formation");
+      }
+      c = c->parent;
     }
-#endif
-
-    /* Climb up */
-    top = top->parent;
+    if (c != top) error("Leaf-cells in different top-level cells");
   }
+#endif
 
   /* Lock the top-level cell as we are going to operate on it */
   lock_lock(&top->stars.star_formation_lock);
 
-  /* Are there any extra particles left? */
-  if (top->stars.count == top->stars.count_total - 1) {
+  /* Are there enough extra particles left? */
+  int count_added = count;
+  if (top->stars.count + count > top->stars.count_total - 1) {
+    count_added = top->stars.count_total - 1 - top->stars.count;
+    message("We ran out of star particles!");
+    atomic_inc(&e->forcerebuild_sparts);
+    atomic_inc(&e->forcerebuild);
+  }
+
+  if (count_added == 0) {
     /* Release the local lock before exiting. */
     if (lock_unlock(&top->stars.star_formation_lock) != 0)
       error("Failed to unlock the top-level cell.");
-    message("We ran out of star particles!");
-    atomic_inc(&e->forcerebuild);
-    return NULL;
+    return 0;
   }
 
-  /* Number of particles to shift in order to get a free space. */
-  const size_t n_copy = &top->stars.parts[top->stars.count] - c->stars.parts;
+  /* Keep track of the star formation rate of this top-level cell to size its
+   * reservoir of spare particles at the next rebuild */
+  top->stars.count_formed += count_added;
 
-#ifdef SWIFT_DEBUG_CHECKS
-  if (c->stars.parts + n_copy > top->stars.parts + top->stars.count)
-    error("Copying beyond the allowed range");
-#endif
+  /* Move the particles up, starting from the end of the array. The particles
+   * of a leaf-cell and all the ones after it are shifted by the number of new
+   * particles in this leaf-cell and the ones before it. */
+  struct spart *end = top->stars.parts + top->stars.count;
+  int shift = count_added;
+  int i = count_added - 1;
+  while (i >= 0) {
+    const struct cell *c = cells[i];
+    struct spart *start = c->stars.parts;
+    const size_t n_copy = end - start;
 
-  if (n_copy > 0) {
-    // MATTHIEU: This can be improved. We don't need to copy everything, just
-    // need to swap a few particles.
-    memmove(&c->stars.parts[1], &c->stars.parts[0],
-            n_copy * sizeof(struct spart));
+    if (n_copy > 0) {
+      memmove(&start[shift], &start[0], n_copy * sizeof(struct spart));
 
-    /* Update the gpart->spart links (shift by 1) */
-    for (size_t i = 0; i < n_copy; ++i) {
+      /* Update the gpart->spart links */
+      for (size_t k = 0; k < n_copy; ++k) {
 #ifdef SWIFT_DEBUG_CHECKS
-      if (c->stars.parts[i + 1].gpart == NULL) {
-        error("Incorrectly linked spart!");
-      }
+        if (start[shift + k].gpart == NULL) {
+          error("Incorrectly linked spart!");
+        }
 #endif
-      c->stars.parts[i + 1].gpart->id_or_neg_offset--;
+        start[shift + k].gpart->id_or_neg_offset -= shift;
+      }
     }
+
+    /* Skip the other new particles of this leaf-cell */
+    while (i >= 0 && cells[i] == c) {
+      --i;
+      --shift;
+    }
+    end = start;
   }
 
-  /* Recursively shift all the stars to get a free spot at the start of the
-   * current cell*/
-  cell_recursively_shift_sparts(top, progeny, /* main_branch=*/1);
+  /* Update the pointers and counts of all the cells in the hierarchy */
+  int index = 0;
+  cell_recursively_shift_sparts(top, cells, count_added, &index);
 
-  /* Make sure the gravity will be recomputed for this particle in the next
-   * step
-   */
-  struct cell *top2 = c;
-  while (top2->parent != NULL) {
+  /* Make sure the gravity will be recomputed for these particles in the next
+   * step */
+  for (int k = 0; k < count_added; ++k) {
+    if (k > 0 && cells[k] == cells[k - 1]) continue;
+    struct cell *top2 = cells[k];
+    while (top2->parent != NULL) {
+      top2->stars.ti_old_part = e->ti_current;
+      top2 = top2->parent;
+    }
     top2->stars.ti_old_part = e->ti_current;
-    top2 = top2->parent;
   }
-  top2->stars.ti_old_part = e->ti_current;
 
   /* Release the lock */
   if (lock_unlock(&top->stars.star_formation_lock) != 0)
     error("Failed to unlock the top-level cell.");
 
-  /* We now have an empty spart as the first particle in that cell */
-  struct spart *sp = &c->stars.parts[0];
-  bzero(sp, sizeof(struct spart));
+  /* We now have empty sparts as the first particles in the leaf-cells */
+  int first_in_cell = 0;
+  for (int k = 0; k < count_added; ++k) {
+    struct cell *c = cells[k];
+    if (k > 0 && c != cells[k - 1]) first_in_cell = k;
+
+    struct spart *sp = &c->stars.parts[k - first_in_cell];
+    bzero(sp, sizeof(struct spart));
 
-  /* Give it a decent position */
-  sp->x[0] = c->loc[0] + 0.5 * c->width[0];
-  sp->x[1] = c->loc[1] + 0.5 * c->width[1];
-  sp->x[2] = c->loc[2] + 0.5 * c->width[2];
+    /* Give it a decent position */
+    sp->x[0] = c->loc[0] + 0.5 * c->width[0];
+    sp->x[1] = c->loc[1] + 0.5 * c->width[1];
+    sp->x[2] = c->loc[2] + 0.5 * c->width[2];
 
-  /* Set it to the current time-bin */
-  sp->time_bin = e->min_active_bin;
+    /* Set it to the current time-bin */
+    sp->time_bin = e->min_active_bin;
 
 #ifdef SWIFT_DEBUG_CHECKS
-  /* Specify it was drifted to this point */
-  sp->ti_drift = e->ti_current;
+    /* Specify it was drifted to this point */
+    sp->ti_drift = e->ti_current;
 #endif
 
-  /* Register that we used one of the free slots. */
-  const size_t one = 1;
-  atomic_sub(&e->s->nr_extra_sparts, one);
+    sparts[k] = sp;
+  }
+
+  /* Register that we used some of the free slots. */
+  const size_t n_used = count_added;
+  atomic_sub(&e->s->nr_extra_sparts, n_used);
+
+  return count_added;
+}
+
+/**
+ * @brief "Add" a #spart in a given #cell.
+ *
+ * This function will a a #spart at the start of the current cell's array by
+ * shifting all the #spart in the top-level cell by one position. All the
+ * pointers and cell counts are updated accordingly.
+ *
+ * @param e The #engine.
+ * @param c The leaf-cell in which to add the #spart.
+ *
+ * @return A pointer to the newly added #spart. The spart has a been zeroed
+ * and given a position within the cell as well as set to the minimal active
+ * time bin.
+ */
+struct spart *cell_add_spart(struct engine *e, struct cell *const c) {
 
+  struct spart *sp = NULL;
+  cell_add_sparts(e, &c, /*count=*/1, &sp);
   return sp;
 }
 
@@ -5494,37 +5859,18 @@ struct gpart *cell_convert_spart_to_gpart(const struct engine *e,
 }
 
 /**
- * @brief "Remove" a #part from a #cell and replace it with a #spart
- * connected to the same #gpart.
- *
- * Note that the #part is not destroyed. The pointer is still valid
- * after this call and the properties of the #part are not altered
- * apart from the time-bin and #gpart pointer.
- * The particle is inhibited and will officially be removed at the next
- * rebuild.
+ * @brief "Remove" a #part from a #cell and transfer its #gpart to a freshly
+ * added #spart.
  *
  * @param e The #engine.
  * @param c The #cell from which to remove the #part.
  * @param p The #part to remove (must be inside c).
  * @param xp The extended data of the #part.
- *
- * @return A fresh #spart with the same ID, position, velocity and
- * time-bin as the original #part.
+ * @param sp The new (empty) #spart in c.
  */
-struct spart *cell_convert_part_to_spart(struct engine *e, struct cell *c,
-                                         struct part *p, struct xpart *xp) {
-  /* Quick cross-check */
-  if (c->nodeID != e->nodeID)
-    error("Can't remove a particle in a foreign cell.");
-
-  if (p->gpart == NULL)
-    error("Trying to convert part without gpart friend to star!");
-
-  /* Create a fresh (empty) spart */
-  struct spart *sp = cell_add_spart(e, c);
-
-  /* Did we run out of free spart slots? */
-  if (sp == NULL) return NULL;
+static void cell_transfer_part_to_spart(struct engine *e, struct cell *c,
+                                        struct part *p, struct xpart *xp,
+                                        struct spart *sp) {
 
   /* Copy over the distance since rebuild */
   sp->x_diff[0] = xp->x_diff[0];
@@ -5561,11 +5907,88 @@ struct spart *cell_convert_part_to_spart(struct engine *e, struct cell *c,
 
   /* Set a smoothing length */
   sp->h = max(c->stars.h_max, c->hydro.h_max);
+}
+
+/**
+ * @brief "Remove" a #part from a #cell and replace it with a #spart
+ * connected to the same #gpart.
+ *
+ * Note that the #part is not destroyed. The pointer is still valid
+ * after this call and the properties of the #part are not altered
+ * apart from the time-bin and #gpart pointer.
+ * The particle is inhibited and will officially be removed at the next
+ * rebuild.
+ *
+ * @param e The #engine.
+ * @param c The #cell from which to remove the #part.
+ * @param p The #part to remove (must be inside c).
+ * @param xp The extended data of the #part.
+ *
+ * @return A fresh #spart with the same ID, position, velocity and
+ * time-bin as the original #part.
+ */
+struct spart *cell_convert_part_to_spart(struct engine *e, struct cell *c,
+                                         struct part *p, struct xpart *xp) {
+  /* Quick cross-check */
+  if (c->nodeID != e->nodeID)
+    error("Can't remove a particle in a foreign cell.");
+
+  if (p->gpart == NULL)
+    error("Trying to convert part without gpart friend to star!");
+
+  /* Create a fresh (empty) spart */
+  struct spart *sp = cell_add_spart(e, c);
+
+  /* Did we run out of free spart slots? */
+  if (sp == NULL) return NULL;
 
   /* Here comes the Sun! */
+  cell_transfer_part_to_spart(e, c, p, xp, sp);
   return sp;
 }
 
+/**
+ * @brief "Remove" a batch of #part from the leaf-cells of a top-level cell
+ * and replace them with #spart connected to the same #gpart.
+ *
+ * This is the same as calling cell_convert_part_to_spart() on every #part but
+ * all the new #spart are created at once by cell_add_sparts().
+ *
+ * @param e The #engine.
+ * @param cells The leaf-cells from which to remove the #part. They must all be
+ * in the same top-level cell and be sorted by their position in memory.
+ * @param parts The #part to remove (each must be inside its cell).
+ * @param xparts The extended data of the #part.
+ * @param count The number of #part to convert.
+ * @param sparts (return) The fresh #spart with the same ID, position, velocity
+ * and time-bin as the original #part.
+ *
+ * @return The number of #part actually converted. This is smaller than count
+ * if the top-level cell ran out of spare #spart, in which case the last ones
+ * are not converted.
+ */
+int cell_convert_parts_to_sparts(struct engine *e, struct cell *const *cells,
+                                 struct part *const *parts,
+                                 struct xpart *const *xparts, const int count,
+                                 struct spart **sparts) {
+  /* Quick cross-checks */
+  for (int k = 0; k < count; ++k) {
+    if (cells[k]->nodeID != e->nodeID)
+      error("Can't remove a particle in a foreign cell.");
+
+    if (parts[k]->gpart == NULL)
+      error("Trying to convert part without gpart friend to star!");
+  }
+
+  /* Create the fresh (empty) sparts */
+  const int count_added = cell_add_sparts(e, cells, count, sparts);
+
+  for (int k = 0; k < count_added; ++k)
+    cell_transfer_part_to_spart(e, cells[k], parts[k], xparts[k], sparts[k]);
+
+  return count_added;
+}
+
 /**
  * @brief Re-arrange the #part in a top-level cell such that all the extra
  * ones for on-the-fly creation are located at the end of the array.
@@ -5646,7 +6069,7 @@ void cell_reorder_extra_sparts(struct cell *c, const ptrdiff_t sparts_offset) {
       }
 
 #ifdef SWIFT_DEBUG_CHECKS
-      if (first_not_extra >= count_real + space_extra_sparts)
+      if (first_not_extra >= c->stars.count_total)
         error("Looking for extra particles beyond this cell's range!");
 #endif
 
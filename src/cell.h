@@ -158,6 +158,9 @@ struct pcell {
     /*! Number of #spart in this cell. */
     int count;
 
+    /*! Number of #spart this cell can hold, including spare ones. */
+    int count_total;
+
     /*! Maximal smoothing length. */
     double h_max;
 
@@ -289,7 +292,8 @@ enum cell_flags {
   cell_flag_do_stars_sub_drift = (1UL << 10),
   cell_flag_do_bh_drift = (1UL << 11),
   cell_flag_do_bh_sub_drift = (1UL << 12),
-  cell_flag_do_stars_resort = (1UL << 13)
+  cell_flag_do_stars_resort = (1UL << 13),
+  cell_flag_rebuild = (1UL << 14)
 };
 
 /**
@@ -335,6 +339,10 @@ struct cell {
     /*! Pointer for the sorted indices. */
     struct sort_entry *sort[13];
 
+    /*! Indices of the #part of this leaf-cell ordered by increasing time-bin,
+     * such that the active particles come first. */
+    int *bin_order;
+
     /*! Super cell, i.e. the highest-level parent cell that has a hydro
      * pair/self tasks */
     struct cell *super;
@@ -436,6 +444,14 @@ struct cell {
     /*! Bit-mask indicating the sorted directions */
     uint16_t sorted;
 
+    /*! Bit-mask indicating the sort arrays of this leaf-cell that hold the
+     * order of a previous sort of its particles */
+    uint16_t sorted_old;
+
+    /*! Does the bin_order of this leaf-cell match the current time-bins of
+     * its particles? */
+    char bin_order_valid;
+
 #ifdef SWIFT_DEBUG_CHECKS
 
     /*! Last (integer) time the cell's sort arrays were updated. */
@@ -582,6 +598,14 @@ struct cell {
     /*! Nr of #spart this cell can hold after addition of new #spart. */
     int count_total;
 
+    /*! Nr of #spart created in this (top-level) cell since the last rebuild.
+     * Used to size its reservoir of spare #spart at the next rebuild. */
+    int count_formed;
+
+    /*! Nr of spare #spart this (top-level) cell was given at the last
+     * rebuild. */
+    int count_extra;
+
     /*! Values of h_max before the drifts, used for sub-cell tasks. */
     float h_max_old;
 
@@ -845,6 +869,13 @@ int cell_link_foreign_gparts(struct cell *c, struct gpart *gparts);
 int cell_count_parts_for_tasks(const struct cell *c);
 int cell_count_gparts_for_tasks(const struct cell *c);
 void cell_clean_links(struct cell *c, void *data);
+void cell_clean_tasks(struct cell *c);
+void cell_clean_sorts(struct cell *c);
+void cell_clean_dead_links(struct cell *c);
+int cell_check_supers(const struct cell *c, const struct cell *super,
+                      const struct cell *super_hydro,
+                      const struct cell *super_grav, const int with_hydro,
+                      const int with_grav);
 void cell_make_multipoles(struct cell *c, integertime_t ti_current);
 void cell_check_multipole(struct cell *c);
 void cell_check_foreign_multipole(const struct cell *c);
@@ -894,6 +925,7 @@ void cell_check_spart_pos(const struct cell *c,
 void cell_check_sort_flags(const struct cell *c);
 void cell_clear_stars_sort_flags(struct cell *c, const int unused_flags);
 void cell_clear_hydro_sort_flags(struct cell *c, const int unused_flags);
+void cell_sort_hydro_bin_order(struct cell *c, const int num_updated);
 int cell_has_tasks(struct cell *c);
 void cell_remove_part(const struct engine *e, struct cell *c, struct part *p,
                       struct xpart *xp);
@@ -904,12 +936,18 @@ void cell_remove_spart(const struct engine *e, struct cell *c,
 void cell_remove_bpart(const struct engine *e, struct cell *c,
                        struct bpart *bp);
 struct spart *cell_add_spart(struct engine *e, struct cell *c);
+int cell_add_sparts(struct engine *e, struct cell *const *cells,
+                    const int count, struct spart **sparts);
 struct gpart *cell_convert_part_to_gpart(const struct engine *e, struct cell *c,
                                          struct part *p, struct xpart *xp);
 struct gpart *cell_convert_spart_to_gpart(const struct engine *e,
                                           struct cell *c, struct spart *sp);
 struct spart *cell_convert_part_to_spart(struct engine *e, struct cell *c,
                                          struct part *p, struct xpart *xp);
+int cell_convert_parts_to_sparts(struct engine *e, struct cell *const *cells,
+                                 struct part *const *parts,
+                                 struct xpart *const *xparts, const int count,
+                                 struct spart **sparts);
 void cell_reorder_extra_parts(struct cell *c, const ptrdiff_t parts_offset);
 void cell_reorder_extra_gparts(struct cell *c, struct part *parts,
                                struct spart *sparts);
@@ -1290,6 +1328,22 @@ __attribute__((always_inline)) INLINE static void cell_free_hydro_sorts(
       c->hydro.sort[i] = NULL;
     }
   }
+  c->hydro.sorted_old = 0;
+}
+
+/**
+ * @brief Free the time-bin ordering of the hydro particles of a cell.
+ *
+ * @param c The #cell.
+ */
+__attribute__((always_inline)) INLINE static void cell_free_hydro_bin_order(
+    struct cell *c) {
+
+  if (c->hydro.bin_order != NULL) {
+    swift_free("hydro.bin_order", c->hydro.bin_order);
+    c->hydro.bin_order = NULL;
+  }
+  c->hydro.bin_order_valid = 0;
 }
 
 /**
@@ -1348,6 +1402,21 @@ __attribute__((always_inline)) INLINE static int cell_get_flag(
   return (c->flags & flag) > 0;
 }
 
+/**
+ * @brief Mark the top-level cells of a pair that moved too much as needing
+ * to be re-built.
+ *
+ * Only these trees are re-split by an incremental rebuild of the space.
+ *
+ * @param ci The first #cell.
+ * @param cj The second #cell.
+ */
+__attribute__((always_inline)) INLINE static void cell_flag_pair_for_rebuild(
+    struct cell *ci, struct cell *cj) {
+  cell_set_flag(ci->top, cell_flag_rebuild);
+  cell_set_flag(cj->top, cell_flag_rebuild);
+}
+
 /**
  * @brief Check if a cell has a recv task of the given subtype.
  */
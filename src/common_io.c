@@ -31,6 +31,7 @@
 #include "gravity_io.h"
 #include "hydro.h"
 #include "hydro_io.h"
+#include "io_compression.h"
 #include "io_properties.h"
 #include "kernel_hydro.h"
 #include "part.h"
@@ -41,6 +42,7 @@
 #include "version.h"
 
 /* Some standard headers. */
+#include <float.h>
 #include <math.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -392,8 +394,8 @@ static long long cell_count_non_inhibited_gas(const struct cell* c) {
   struct part* parts = c->hydro.parts;
   long long count = 0;
   for (int i = 0; i < total_count; ++i) {
-    if (!(parts[i].time_bin != time_bin_inhibited) &&
-        !(parts[i].time_bin != time_bin_not_created)) {
+    if ((parts[i].time_bin != time_bin_inhibited) &&
+        (parts[i].time_bin != time_bin_not_created)) {
       ++count;
     }
   }
@@ -405,8 +407,8 @@ static long long cell_count_non_inhibited_dark_matter(const struct cell* c) {
   struct gpart* gparts = c->grav.parts;
   long long count = 0;
   for (int i = 0; i < total_count; ++i) {
-    if (!(gparts[i].time_bin != time_bin_inhibited) &&
-        !(gparts[i].time_bin != time_bin_not_created) &&
+    if ((gparts[i].time_bin != time_bin_inhibited) &&
+        (gparts[i].time_bin != time_bin_not_created) &&
         (gparts[i].type == swift_type_dark_matter)) {
       ++count;
     }
@@ -419,8 +421,8 @@ static long long cell_count_non_inhibited_stars(const struct cell* c) {
   struct spart* sparts = c->stars.parts;
   long long count = 0;
   for (int i = 0; i < total_count; ++i) {
-    if (!(sparts[i].time_bin != time_bin_inhibited) &&
-        !(sparts[i].time_bin != time_bin_not_created)) {
+    if ((sparts[i].time_bin != time_bin_inhibited) &&
+        (sparts[i].time_bin != time_bin_not_created)) {
       ++count;
     }
   }
@@ -432,8 +434,8 @@ static long long cell_count_non_inhibited_black_holes(const struct cell* c) {
   struct bpart* bparts = c->black_holes.parts;
   long long count = 0;
   for (int i = 0; i < total_count; ++i) {
-    if (!(bparts[i].time_bin != time_bin_inhibited) &&
-        !(bparts[i].time_bin != time_bin_not_created)) {
+    if ((bparts[i].time_bin != time_bin_inhibited) &&
+        (bparts[i].time_bin != time_bin_not_created)) {
       ++count;
     }
   }
@@ -1213,9 +1215,64 @@ void io_convert_bpart_l_mapper(void* restrict temp, int N,
     props.convert_bpart_l(e, bparts + delta + i, &temp_l[i * dim]);
 }
 
+/**
+ * @brief Multiplies the floating-point elements of an i/o buffer by a factor.
+ *
+ * @param buffer The elements to scale.
+ * @param num_elements The number of elements.
+ * @param type The type of the elements.
+ * @param factor The factor to apply.
+ */
+static void io_scale_buffer(void* buffer, size_t num_elements,
+                            enum IO_DATA_TYPE type, double factor) {
+
+  if (type == DOUBLE) {
+    double* temp_d = (double*)buffer;
+    for (size_t i = 0; i < num_elements; ++i) temp_d[i] *= factor;
+  } else if (type == FLOAT) {
+    float* temp_f = (float*)buffer;
+    const float factor_f = factor;
+    for (size_t i = 0; i < num_elements; ++i) temp_f[i] *= factor_f;
+  }
+}
+
+/**
+ * @brief Data needed by #io_copy_and_convert_mapper.
+ */
+struct io_copy_data {
+
+  /*! The field being copied */
+  struct io_props props;
+
+  /*! The mapper copying (or converting) the particles into the buffer */
+  threadpool_map_function mapper;
+
+  /*! The unit conversion factor to apply to the buffer */
+  double factor;
+};
+
+/**
+ * @brief Mapper function copying a chunk of particles into the i/o buffer and
+ * converting it to the snapshot units while it is still in cache.
+ */
+static void io_copy_and_convert_mapper(void* restrict temp, int N,
+                                       void* restrict extra_data) {
+
+  struct io_copy_data* data = (struct io_copy_data*)extra_data;
+
+  data->mapper(temp, N, &data->props);
+
+  if (data->factor != 1.)
+    io_scale_buffer(temp, (size_t)N * data->props.dimension, data->props.type,
+                    data->factor);
+}
+
 /**
  * @brief Copy the particle data into a temporary buffer ready for i/o.
  *
+ * The copy (or conversion function) and the unit conversion are done in the
+ * same pass over the particles by the threads of the engine.
+ *
  * @param temp The buffer to be filled. Must be allocated and aligned properly.
  * @param e The #engine.
  * @param props The #io_props corresponding to the particle field we are
@@ -1231,235 +1288,205 @@ void io_copy_temp_buffer(void* temp, const struct engine* e,
 
   const size_t typeSize = io_sizeof_type(props.type);
   const size_t copySize = typeSize * props.dimension;
-  const size_t num_elements = N * props.dimension;
-
-  /* Copy particle data to temporary buffer */
-  if (props.conversion == 0) { /* No conversion */
-
-    /* Prepare some parameters */
-    char* temp_c = (char*)temp;
-    props.start_temp_c = temp_c;
-
-    /* Copy the whole thing into a buffer */
-    threadpool_map((struct threadpool*)&e->threadpool, io_copy_mapper, temp_c,
-                   N, copySize, 0, (void*)&props);
-
-  } else { /* Converting particle to data */
-
-    if (props.convert_part_f != NULL) {
-
-      /* Prepare some parameters */
-      float* temp_f = (float*)temp;
-      props.start_temp_f = (float*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_part_f_mapper, temp_f, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_part_i != NULL) {
-
-      /* Prepare some parameters */
-      int* temp_i = (int*)temp;
-      props.start_temp_i = (int*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_part_i_mapper, temp_i, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_part_d != NULL) {
-
-      /* Prepare some parameters */
-      double* temp_d = (double*)temp;
-      props.start_temp_d = (double*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_part_d_mapper, temp_d, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_part_l != NULL) {
-
-      /* Prepare some parameters */
-      long long* temp_l = (long long*)temp;
-      props.start_temp_l = (long long*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_part_l_mapper, temp_l, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_gpart_f != NULL) {
-
-      /* Prepare some parameters */
-      float* temp_f = (float*)temp;
-      props.start_temp_f = (float*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_gpart_f_mapper, temp_f, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_gpart_i != NULL) {
-
-      /* Prepare some parameters */
-      int* temp_i = (int*)temp;
-      props.start_temp_i = (int*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_gpart_i_mapper, temp_i, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_gpart_d != NULL) {
-
-      /* Prepare some parameters */
-      double* temp_d = (double*)temp;
-      props.start_temp_d = (double*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_gpart_d_mapper, temp_d, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_gpart_l != NULL) {
 
-      /* Prepare some parameters */
-      long long* temp_l = (long long*)temp;
-      props.start_temp_l = (long long*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_gpart_l_mapper, temp_l, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_spart_f != NULL) {
-
-      /* Prepare some parameters */
-      float* temp_f = (float*)temp;
-      props.start_temp_f = (float*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_spart_f_mapper, temp_f, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_spart_i != NULL) {
-
-      /* Prepare some parameters */
-      int* temp_i = (int*)temp;
-      props.start_temp_i = (int*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_spart_i_mapper, temp_i, N, copySize, 0,
-                     (void*)&props);
-
-    } else if (props.convert_spart_d != NULL) {
-
-      /* Prepare some parameters */
-      double* temp_d = (double*)temp;
-      props.start_temp_d = (double*)temp;
-      props.e = e;
-
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_spart_d_mapper, temp_d, N, copySize, 0,
-                     (void*)&props);
+  struct io_copy_data data;
+  data.factor =
+      units_conversion_factor(internal_units, snapshot_units, props.units);
 
-    } else if (props.convert_spart_l != NULL) {
+  /* Prepare some parameters */
+  props.start_temp_c = (char*)temp;
+  props.start_temp_i = (int*)temp;
+  props.start_temp_f = (float*)temp;
+  props.start_temp_d = (double*)temp;
+  props.start_temp_l = (long long*)temp;
+  props.e = e;
+  data.props = props;
+
+  /* Pick the function filling the buffer */
+  if (props.conversion == 0) /* No conversion */
+    data.mapper = io_copy_mapper;
+  else if (props.convert_part_f != NULL)
+    data.mapper = io_convert_part_f_mapper;
+  else if (props.convert_part_i != NULL)
+    data.mapper = io_convert_part_i_mapper;
+  else if (props.convert_part_d != NULL)
+    data.mapper = io_convert_part_d_mapper;
+  else if (props.convert_part_l != NULL)
+    data.mapper = io_convert_part_l_mapper;
+  else if (props.convert_gpart_f != NULL)
+    data.mapper = io_convert_gpart_f_mapper;
+  else if (props.convert_gpart_i != NULL)
+    data.mapper = io_convert_gpart_i_mapper;
+  else if (props.convert_gpart_d != NULL)
+    data.mapper = io_convert_gpart_d_mapper;
+  else if (props.convert_gpart_l != NULL)
+    data.mapper = io_convert_gpart_l_mapper;
+  else if (props.convert_spart_f != NULL)
+    data.mapper = io_convert_spart_f_mapper;
+  else if (props.convert_spart_i != NULL)
+    data.mapper = io_convert_spart_i_mapper;
+  else if (props.convert_spart_d != NULL)
+    data.mapper = io_convert_spart_d_mapper;
+  else if (props.convert_spart_l != NULL)
+    data.mapper = io_convert_spart_l_mapper;
+  else if (props.convert_bpart_f != NULL)
+    data.mapper = io_convert_bpart_f_mapper;
+  else if (props.convert_bpart_i != NULL)
+    data.mapper = io_convert_bpart_i_mapper;
+  else if (props.convert_bpart_d != NULL)
+    data.mapper = io_convert_bpart_d_mapper;
+  else if (props.convert_bpart_l != NULL)
+    data.mapper = io_convert_bpart_l_mapper;
+  else
+    error("Missing conversion function");
+
+  /* Copy (and convert) the whole thing into the buffer */
+  threadpool_map((struct threadpool*)&e->threadpool, io_copy_and_convert_mapper,
+                 temp, N, copySize, 0, &data);
+}
 
-      /* Prepare some parameters */
-      long long* temp_l = (long long*)temp;
-      props.start_temp_l = (long long*)temp;
-      props.e = e;
+/**
+ * @brief Creates a memory dataspace describing where a field lives in an
+ * array of particles, such that HDF5 can read or write it in place.
+ *
+ * The field of each particle is a block of props.dimension elements and the
+ * blocks are props.partSize bytes apart, starting at props.field.
+ *
+ * @param props The #io_props of the field.
+ * @param N The number of particles.
+ *
+ * @return The dataspace, or -1 if the layout cannot be described this way.
+ */
+hid_t io_field_memspace(const struct io_props props, size_t N) {
 
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_spart_l_mapper, temp_l, N, copySize, 0,
-                     (void*)&props);
+  const size_t typeSize = io_sizeof_type(props.type);
 
-    } else if (props.convert_bpart_f != NULL) {
+  /* Need the field and a stride that is a whole number of elements */
+  if (props.field == NULL || props.partSize % typeSize != 0 ||
+      ((size_t)props.field) % typeSize != 0)
+    return -1;
 
-      /* Prepare some parameters */
-      float* temp_f = (float*)temp;
-      props.start_temp_f = (float*)temp;
-      props.e = e;
+  const hsize_t stride = props.partSize / typeSize;
+  const hsize_t extent = (N > 0) ? (N - 1) * stride + props.dimension : 1;
+  const hid_t h_memspace = H5Screate_simple(1, &extent, NULL);
+  if (h_memspace < 0)
+    error("Error while creating memory space for field '%s'.", props.name);
 
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_bpart_f_mapper, temp_f, N, copySize, 0,
-                     (void*)&props);
+  if (N == 0) {
+    H5Sselect_none(h_memspace);
+  } else {
+    const hsize_t start = 0;
+    const hsize_t count = N;
+    const hsize_t block = props.dimension;
+    const herr_t h_err = H5Sselect_hyperslab(h_memspace, H5S_SELECT_SET, &start,
+                                             &stride, &count, &block);
+    if (h_err < 0)
+      error("Error while selecting memory space for field '%s'.", props.name);
+  }
 
-    } else if (props.convert_bpart_i != NULL) {
+  return h_memspace;
+}
 
-      /* Prepare some parameters */
-      int* temp_i = (int*)temp;
-      props.start_temp_i = (int*)temp;
-      props.e = e;
+/**
+ * @brief Creates the memory dataspace to write a field straight from the
+ * particles, if no copy of the field is needed.
+ *
+ * @param props The #io_props of the field.
+ * @param N The number of particles.
+ * @param internal_units The system of units used internally.
+ * @param snapshot_units The system of units used for the snapshots.
+ *
+ * @return The dataspace, or -1 if the field has to go through
+ * io_copy_temp_buffer().
+ */
+hid_t io_write_field_memspace(const struct io_props props, size_t N,
+                              const struct unit_system* internal_units,
+                              const struct unit_system* snapshot_units) {
 
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_bpart_i_mapper, temp_i, N, copySize, 0,
-                     (void*)&props);
+  if (props.conversion != 0) return -1;
+  if (units_conversion_factor(internal_units, snapshot_units, props.units) !=
+      1.)
+    return -1;
 
-    } else if (props.convert_bpart_d != NULL) {
+  return io_field_memspace(props, N);
+}
 
-      /* Prepare some parameters */
-      double* temp_d = (double*)temp;
-      props.start_temp_d = (double*)temp;
-      props.e = e;
+/**
+ * @brief Mapper function applying a conversion factor to a field read in
+ * place in the particles.
+ */
+static void io_convert_read_field_mapper(void* restrict map_data, int N,
+                                         void* restrict extra_data) {
+
+  const struct io_copy_data* data = (const struct io_copy_data*)extra_data;
+  const struct io_props* props = &data->props;
+  char* field = (char*)map_data;
+
+  for (int i = 0; i < N; ++i) {
+
+#ifdef SWIFT_DEBUG_CHECKS
+    /* Check that the converted values are still floats */
+    if (props->type == FLOAT) {
+      for (int k = 0; k < props->dimension; ++k) {
+        const double value = fabs(((float*)field)[k] * data->factor);
+        if (value > FLT_MAX)
+          error("Unit conversion results in numbers larger than floats");
+        else if (value != 0. && value < FLT_MIN)
+          error("Numbers smaller than float precision");
+      }
+    }
+#endif
 
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_bpart_d_mapper, temp_d, N, copySize, 0,
-                     (void*)&props);
+    io_scale_buffer(field, props->dimension, props->type, data->factor);
+    field += props->partSize;
+  }
+}
 
-    } else if (props.convert_bpart_l != NULL) {
+/**
+ * @brief Converts a field freshly read from the ICs to the internal units.
+ *
+ * The unit conversion and the removal of the h-factors and of the sqrt(a)
+ * factor of the Gadget velocities are applied as a single factor in one pass
+ * over the particles.
+ *
+ * @param tp The #threadpool to use, can be NULL.
+ * @param props The #io_props of the field.
+ * @param N The number of particles.
+ * @param internal_units The #unit_system used internally.
+ * @param ic_units The #unit_system used in the ICs.
+ * @param cleanup_h Are we removing h-factors from the ICs?
+ * @param cleanup_sqrt_a Are we cleaning-up the sqrt(a) factors in the Gadget
+ * IC velocities?
+ * @param h The value of the reduced Hubble constant to use for cleaning.
+ * @param a The current value of the scale-factor.
+ */
+void io_convert_read_field(struct threadpool* tp, const struct io_props props,
+                           size_t N, const struct unit_system* internal_units,
+                           const struct unit_system* ic_units, int cleanup_h,
+                           int cleanup_sqrt_a, double h, double a) {
 
-      /* Prepare some parameters */
-      long long* temp_l = (long long*)temp;
-      props.start_temp_l = (long long*)temp;
-      props.e = e;
+  struct io_copy_data data;
+  data.props = props;
+  data.mapper = NULL;
 
-      /* Copy the whole thing into a buffer */
-      threadpool_map((struct threadpool*)&e->threadpool,
-                     io_convert_bpart_l_mapper, temp_l, N, copySize, 0,
-                     (void*)&props);
+  /* Unit conversion */
+  data.factor = units_conversion_factor(ic_units, internal_units, props.units);
 
-    } else {
-      error("Missing conversion function");
-    }
-  }
+  /* Clean-up h if necessary */
+  const float h_factor_exp = units_h_factor(internal_units, props.units);
+  if (cleanup_h && h_factor_exp != 0.f) data.factor *= pow(h, h_factor_exp);
 
-  /* Unit conversion if necessary */
-  const double factor =
-      units_conversion_factor(internal_units, snapshot_units, props.units);
-  if (factor != 1.) {
+  /* Clean-up a if necessary */
+  if (cleanup_sqrt_a && a != 1. && (strcmp(props.name, "Velocities") == 0))
+    data.factor *= sqrt(a);
 
-    /* message("Converting ! factor=%e", factor); */
+  if (data.factor == 1. || N == 0) return;
 
-    if (io_is_double_precision(props.type)) {
-      swift_declare_aligned_ptr(double, temp_d, (double*)temp,
-                                IO_BUFFER_ALIGNMENT);
-      for (size_t i = 0; i < num_elements; ++i) temp_d[i] *= factor;
-    } else {
-      swift_declare_aligned_ptr(float, temp_f, (float*)temp,
-                                IO_BUFFER_ALIGNMENT);
-      for (size_t i = 0; i < num_elements; ++i) temp_f[i] *= factor;
-    }
-  }
+  if (tp != NULL)
+    threadpool_map(tp, io_convert_read_field_mapper, props.field, N,
+                   props.partSize, 0, &data);
+  else
+    io_convert_read_field_mapper(props.field, N, &data);
 }
 
 void io_prepare_dm_gparts_mapper(void* restrict data, int Ndm, void* dummy) {
@@ -1906,17 +1933,20 @@ void io_check_output_fields(const struct swift_params* params,
 
         if (strcmp(param_name, field_name) == 0) {
           found = 1;
-          /* check if correct input */
-          int retParam = 0;
-          char str[PARSER_MAX_LINE_SIZE];
-          sscanf(params->data[param_id].value, "%d%s", &retParam, str);
-
-          /* Check that we have a 0 or 1 */
-          if (retParam != 0 && retParam != 1)
-            message(
-                "WARNING: Unexpected input for %s. Received %i but expect 0 or "
-                "1. ",
-                field_name, retParam);
+
+          /* Check that we have a 0, a 1 or a known compression scheme */
+          const enum lossy_compression_schemes comp =
+              compression_scheme_from_name(params->data[param_id].value);
+          if (comp == compression_write_count)
+            error(
+                "Unexpected input for %s. Received '%s' but expect 0, 1 or "
+                "one of the lossy compression schemes (e.g. DScale3).",
+                field_name, params->data[param_id].value);
+
+          /* Check that the compression can be applied to this field */
+          if (!io_compression_is_compatible(comp, list[field_id].type))
+            error("Lossy compression scheme '%s' cannot be applied to %s.",
+                  lossy_compression_schemes_names[comp], field_name);
 
           /* Found it, so move to the next one. */
           break;
@@ -1943,6 +1973,11 @@ void io_write_output_field_parameter(const char* filename) {
 
   /* Loop over all particle types */
   fprintf(file, "SelectOutput:\n");
+  fprintf(file,
+          "  # Use 0 to skip a field, 1 to write it, or a lossy filter:\n"
+          "  # DScale1 to DScale6, FMantissa9 or FMantissa13 for floating-"
+          "point\n"
+          "  # fields and IntScaleOffset for integer fields.\n\n");
   for (int ptype = 0; ptype < swift_type_count; ptype++) {
 
     int num_fields = 0;
@@ -99,6 +99,15 @@ void io_copy_temp_buffer(void* temp, const struct engine* e,
                          const struct unit_system* internal_units,
                          const struct unit_system* snapshot_units);
 
+hid_t io_field_memspace(const struct io_props props, size_t N);
+hid_t io_write_field_memspace(const struct io_props props, size_t N,
+                              const struct unit_system* internal_units,
+                              const struct unit_system* snapshot_units);
+void io_convert_read_field(struct threadpool* tp, const struct io_props props,
+                           size_t N, const struct unit_system* internal_units,
+                           const struct unit_system* ic_units, int cleanup_h,
+                           int cleanup_sqrt_a, double h, double a);
+
 #endif /* defined HDF5 */
 
 size_t io_sizeof_type(enum IO_DATA_TYPE type);
@@ -0,0 +1,421 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  @file cost_model.c
+ *  @brief Static estimates of the cost of tasks and an online model that
+ *  calibrates them against the measured task timings.
+ */
+
+/* Config parameters. */
+#include "../config.h"
+
+/* Standard headers. */
+#include <string.h>
+
+/* This object's header. */
+#include "cost_model.h"
+
+/* Local headers. */
+#include "atomic.h"
+#include "cell.h"
+#include "clocks.h"
+#include "error.h"
+#include "intrinsics.h"
+#include "parser.h"
+#include "sort_part.h"
+#include "threadpool.h"
+
+/**
+ * @brief Static estimate of the cost of a task.
+ *
+ * Based on the particle counts of the cells involved and, for pairs, the
+ * geometry of the interaction. Only the relative values matter.
+ *
+ * @param t The #task.
+ * @param nodeID The rank we are on.
+ * @return The estimated cost.
+ */
+float cost_model_estimate(const struct task *t, int nodeID) {
+
+  const float wscale = 0.001f;
+  float cost = 0.f;
+
+  const float count_i = (t->ci != NULL) ? t->ci->hydro.count : 0.f;
+  const float count_j = (t->cj != NULL) ? t->cj->hydro.count : 0.f;
+  const float gcount_i = (t->ci != NULL) ? t->ci->grav.count : 0.f;
+  const float gcount_j = (t->cj != NULL) ? t->cj->grav.count : 0.f;
+  const float scount_i = (t->ci != NULL) ? t->ci->stars.count : 0.f;
+  const float scount_j = (t->cj != NULL) ? t->cj->stars.count : 0.f;
+  const float bcount_i = (t->ci != NULL) ? t->ci->black_holes.count : 0.f;
+  const float bcount_j = (t->cj != NULL) ? t->cj->black_holes.count : 0.f;
+
+  switch (t->type) {
+    case task_type_sort:
+      cost = wscale * intrinsics_popcount(t->flags) * count_i *
+             (sizeof(int) * 8 - intrinsics_clz(t->ci->hydro.count));
+      break;
+
+    case task_type_stars_sort:
+      cost = wscale * intrinsics_popcount(t->flags) * scount_i *
+             (sizeof(int) * 8 - intrinsics_clz(t->ci->stars.count));
+      break;
+
+    case task_type_self:
+      if (t->subtype == task_subtype_grav) {
+        cost = 1.f * (wscale * gcount_i) * gcount_i;
+      } else if (t->subtype == task_subtype_external_grav)
+        cost = 1.f * wscale * gcount_i;
+      else if (t->subtype == task_subtype_stars_density)
+        cost = 1.f * wscale * scount_i * count_i;
+      else if (t->subtype == task_subtype_stars_feedback)
+        cost = 1.f * wscale * scount_i * count_i;
+      else if (t->subtype == task_subtype_bh_density)
+        cost = 1.f * wscale * bcount_i * count_i;
+      else if (t->subtype == task_subtype_bh_feedback)
+        cost = 1.f * wscale * bcount_i * count_i;
+      else  // hydro loops
+        cost = 1.f * (wscale * count_i) * count_i;
+      break;
+
+    case task_type_pair:
+      if (t->subtype == task_subtype_grav) {
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
+          cost = 3.f * (wscale * gcount_i) * gcount_j;
+        else
+          cost = 2.f * (wscale * gcount_i) * gcount_j;
+
+      } else if (t->subtype == task_subtype_stars_density ||
+                 t->subtype == task_subtype_stars_feedback) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * count_i * scount_j * sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * scount_i * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_bh_density ||
+                 t->subtype == task_subtype_bh_feedback) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * count_i * bcount_j * sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * bcount_i * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
+                 sid_scale[t->flags];
+
+      } else {  // hydro loops
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
+          cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
+      }
+      break;
+
+    case task_type_sub_pair:
+#ifdef SWIFT_DEBUG_CHECKS
+      if (t->flags < 0) error("Negative flag value!");
+#endif
+      if (t->subtype == task_subtype_stars_density ||
+          t->subtype == task_subtype_stars_feedback) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * scount_j * sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * scount_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
+                 sid_scale[t->flags];
+        }
+
+      } else if (t->subtype == task_subtype_bh_density ||
+                 t->subtype == task_subtype_bh_feedback) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * bcount_j * sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * bcount_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
+                 sid_scale[t->flags];
+        }
+
+      } else {  // hydro loops
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
+        }
+      }
+      break;
+
+    case task_type_sub_self:
+      if (t->subtype == task_subtype_stars_density) {
+        cost = 1.f * (wscale * scount_i) * count_i;
+      } else if (t->subtype == task_subtype_stars_feedback) {
+        cost = 1.f * (wscale * scount_i) * count_i;
+      } else if (t->subtype == task_subtype_bh_density) {
+        cost = 1.f * (wscale * bcount_i) * count_i;
+      } else if (t->subtype == task_subtype_bh_feedback) {
+        cost = 1.f * (wscale * bcount_i) * count_i;
+      } else {
+        cost = 1.f * (wscale * count_i) * count_i;
+      }
+      break;
+    case task_type_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
+      break;
+    case task_type_extra_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
+      break;
+    case task_type_stars_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * scount_i;
+      break;
+    case task_type_bh_density_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
+      break;
+    case task_type_drift_part:
+      cost = wscale * count_i;
+      break;
+    case task_type_drift_gpart:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_drift_spart:
+      cost = wscale * scount_i;
+      break;
+    case task_type_drift_bpart:
+      cost = wscale * bcount_i;
+      break;
+    case task_type_init_grav:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_down:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_long_range:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_mm:
+      cost = wscale * (gcount_i + gcount_j);
+      break;
+    case task_type_end_hydro_force:
+      cost = wscale * count_i;
+      break;
+    case task_type_end_grav_force:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_cooling:
+      cost = wscale * count_i;
+      break;
+    case task_type_star_formation:
+      cost = wscale * (count_i + scount_i);
+      break;
+    case task_type_kick1:
+      cost = wscale * (count_i + gcount_i + scount_i + bcount_i);
+      break;
+    case task_type_kick2:
+      cost = wscale * (count_i + gcount_i + scount_i + bcount_i);
+      break;
+    case task_type_timestep:
+      cost = wscale * (count_i + gcount_i + scount_i + bcount_i);
+      break;
+    case task_type_kick_timestep:
+      cost = 3.f * wscale * (count_i + gcount_i + scount_i + bcount_i);
+      break;
+    case task_type_send:
+      if (count_i < 1e5)
+        cost = 10.f * (wscale * count_i) * count_i;
+      else
+        cost = 2e9;
+      break;
+    case task_type_recv:
+      if (count_i < 1e5)
+        cost = 5.f * (wscale * count_i) * count_i;
+      else
+        cost = 1e9;
+      break;
+    default:
+      cost = 0;
+      break;
+  }
+
+  return cost;
+}
+
+/**
+ * @brief Predicted cost of a task.
+ *
+ * When the model is in use and calibrated this is the expected number of
+ * ticks the task will take, otherwise just the static estimate.
+ *
+ * Communication tasks are always scaled from their static estimate using the
+ * fit over all types, as the time spent posting them is no measure of how
+ * urgently they are needed.
+ *
+ * @param cm The #cost_model.
+ * @param t The #task.
+ * @param nodeID The rank we are on.
+ * @return The predicted cost.
+ */
+float cost_model_task_cost(const struct cost_model *cm, const struct task *t,
+                           int nodeID) {
+
+  const float estimate = cost_model_estimate(t, nodeID);
+  if (!cm->enabled || cm->coeff_all <= 0.) return estimate;
+
+  if (t->type == task_type_send || t->type == task_type_recv)
+    return cm->coeff_all * estimate;
+
+  const double coeff = cm->coeff[t->type][t->subtype];
+  if (coeff > 0.) return coeff * estimate;
+  return cm->coeff_all * estimate;
+}
+
+/**
+ * @brief Initialise the #cost_model from the parameter file.
+ *
+ * @param cm The #cost_model.
+ * @param params The parsed parameter file.
+ */
+void cost_model_init(struct cost_model *cm, struct swift_params *params) {
+
+  bzero(cm, sizeof(struct cost_model));
+
+  cm->enabled = parser_get_opt_param_int(params, "Scheduler:cost_model", 0);
+  cm->decay =
+      parser_get_opt_param_float(params, "Scheduler:cost_model_decay", 0.5f);
+  if (cm->decay < 0.f || cm->decay >= 1.f)
+    error(
+        "Invalid Scheduler:cost_model_decay, must be greater than or equal "
+        "to 0 and less than 1");
+}
+
+/* Extra data for the update mapper. */
+struct cost_model_mapper_data {
+  struct cost_model *cm;
+  int nodeID;
+  ticks since;
+};
+
+/**
+ * @brief Threadpool mapper function accumulating the products of estimated
+ *        and measured costs for all the tasks run since a given time.
+ *
+ * @param map_data The tasks to process.
+ * @param num_elements The number of tasks.
+ * @param extra_data A #cost_model_mapper_data.
+ */
+static void cost_model_update_mapper(void *map_data, int num_elements,
+                                     void *extra_data) {
+
+  struct task *tasks = (struct task *)map_data;
+  struct cost_model_mapper_data *data =
+      (struct cost_model_mapper_data *)extra_data;
+  struct cost_model *cm = data->cm;
+
+  /* Accumulate locally first, there are few distinct types so the atomics
+   * would otherwise be heavily contended. */
+  double sum_xy[task_type_count][task_subtype_count];
+  double sum_xx[task_type_count][task_subtype_count];
+  bzero(sum_xy, sizeof(sum_xy));
+  bzero(sum_xx, sizeof(sum_xx));
+
+  for (int k = 0; k < num_elements; k++) {
+    const struct task *t = &tasks[k];
+
+    /* Only tasks that did some work in this step. */
+    if (t->implicit || t->type == task_type_send ||
+        t->type == task_type_recv || t->tic < data->since || t->toc <= t->tic)
+      continue;
+
+    const double x = cost_model_estimate(t, data->nodeID);
+    if (x <= 0.) continue;
+    const double y = (double)(t->toc - t->tic);
+    sum_xy[t->type][t->subtype] += x * y;
+    sum_xx[t->type][t->subtype] += x * x;
+  }
+
+  for (int i = 0; i < task_type_count; i++) {
+    for (int j = 0; j < task_subtype_count; j++) {
+      if (sum_xx[i][j] > 0.) {
+        atomic_add_d(&cm->sum_xy[i][j], sum_xy[i][j]);
+        atomic_add_d(&cm->sum_xx[i][j], sum_xx[i][j]);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Fold the timings of the tasks run in the last step into the model.
+ *
+ * @param cm The #cost_model.
+ * @param tasks The tasks of the #scheduler.
+ * @param nr_tasks The number of tasks.
+ * @param nodeID The rank we are on.
+ * @param since The start of the step, older timings are ignored.
+ * @param tp The #threadpool to use.
+ * @param verbose Are we talkative?
+ */
+void cost_model_update(struct cost_model *cm, struct task *tasks, int nr_tasks,
+                       int nodeID, ticks since, struct threadpool *tp,
+                       int verbose) {
+
+  if (!cm->enabled) return;
+
+  const ticks tic = getticks();
+
+  /* Forget some of the older steps. */
+  for (int i = 0; i < task_type_count; i++) {
+    for (int j = 0; j < task_subtype_count; j++) {
+      cm->sum_xy[i][j] *= cm->decay;
+      cm->sum_xx[i][j] *= cm->decay;
+    }
+  }
+
+  struct cost_model_mapper_data data;
+  data.cm = cm;
+  data.nodeID = nodeID;
+  data.since = since;
+  threadpool_map(tp, cost_model_update_mapper, tasks, nr_tasks,
+                 sizeof(struct task), 0, &data);
+
+  /* And refit, through the origin. */
+  cm->sum_xy_all = 0.;
+  cm->sum_xx_all = 0.;
+  for (int i = 0; i < task_type_count; i++) {
+    for (int j = 0; j < task_subtype_count; j++) {
+      if (cm->sum_xx[i][j] > 0.) {
+        cm->coeff[i][j] = cm->sum_xy[i][j] / cm->sum_xx[i][j];
+        cm->sum_xy_all += cm->sum_xy[i][j];
+        cm->sum_xx_all += cm->sum_xx[i][j];
+      }
+    }
+  }
+  if (cm->sum_xx_all > 0.) cm->coeff_all = cm->sum_xy_all / cm->sum_xx_all;
+  cm->nr_steps++;
+
+  if (verbose) {
+    for (int i = 0; i < task_type_count; i++)
+      for (int j = 0; j < task_subtype_count; j++)
+        if (cm->coeff[i][j] > 0.)
+          message("%s/%s: %.3e ticks per unit estimate.", taskID_names[i],
+                  subtaskID_names[j], cm->coeff[i][j]);
+    message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
+            clocks_getunit());
+  }
+}
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_COST_MODEL_H
+#define SWIFT_COST_MODEL_H
+
+/* Config parameters. */
+#include "../config.h"
+
+/* MPI headers. */
+#ifdef WITH_MPI
+#include <mpi.h>
+#endif
+
+/* Local headers. */
+#include "cycle.h"
+#include "task.h"
+
+/* Forward declarations to avoid cyclic includes. */
+struct swift_params;
+struct threadpool;
+
+/**
+ * @brief Running fit of the measured cost of the tasks.
+ *
+ * The cost of a task is modelled as a coefficient, per task type and
+ * subtype, times the static estimate of its work (particle counts and
+ * geometry). The coefficients are least-squares fits to the ticks measured
+ * in recent steps, with older steps exponentially forgotten.
+ */
+struct cost_model {
+
+  /*! Is the model in use? */
+  int enabled;
+
+  /*! Fraction of the accumulated sums kept at each update. */
+  float decay;
+
+  /*! Number of steps that have been folded into the fit. */
+  int nr_steps;
+
+  /*! Decayed sums of estimate * ticks and estimate^2 per type and subtype. */
+  double sum_xy[task_type_count][task_subtype_count];
+  double sum_xx[task_type_count][task_subtype_count];
+
+  /*! Fitted ticks per unit of estimated work, zero if no data yet. */
+  double coeff[task_type_count][task_subtype_count];
+
+  /*! Fit over all task types, used for those without data of their own. */
+  double sum_xy_all, sum_xx_all, coeff_all;
+};
+
+void cost_model_init(struct cost_model *cm, struct swift_params *params);
+float cost_model_estimate(const struct task *t, int nodeID);
+float cost_model_task_cost(const struct cost_model *cm, const struct task *t,
+                           int nodeID);
+void cost_model_update(struct cost_model *cm, struct task *tasks, int nr_tasks,
+                       int nodeID, ticks since, struct threadpool *tp,
+                       int verbose);
+
+#endif /* SWIFT_COST_MODEL_H */
@@ -0,0 +1,990 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  @file distributed_io.c
+ *  @brief Snapshots written as one file per MPI rank, plus a master file
+ *  exposing the particle arrays of all the ranks as HDF5 virtual datasets.
+ */
+
+/* Config parameters. */
+#include "../config.h"
+
+#if defined(HAVE_HDF5) && defined(WITH_MPI)
+
+/* Some standard headers. */
+#include <hdf5.h>
+#include <math.h>
+#include <mpi.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* This object's header. */
+#include "distributed_io.h"
+
+/* Local includes. */
+#include "black_holes_io.h"
+#include "chemistry_io.h"
+#include "common_io.h"
+#include "cooling_io.h"
+#include "dimension.h"
+#include "engine.h"
+#include "entropy_floor.h"
+#include "error.h"
+#include "gravity_io.h"
+#include "gravity_properties.h"
+#include "hydro_io.h"
+#include "hydro_properties.h"
+#include "io_compression.h"
+#include "io_properties.h"
+#include "kernel_hydro.h"
+#include "memuse.h"
+#include "part.h"
+#include "part_type.h"
+#include "star_formation_io.h"
+#include "stars_io.h"
+#include "tracers_io.h"
+#include "units.h"
+#include "velociraptor_io.h"
+#include "xmf.h"
+
+/**
+ * @brief Writes the unit and compression attributes of a dataset.
+ *
+ * @param e The #engine we are writing from.
+ * @param h_data The dataset.
+ * @param props The #io_props of the field.
+ * @param snapshot_units The #unit_system used in the snapshots.
+ * @param lossy_compression The lossy filter applied to this field.
+ */
+static void write_array_attributes(
+    const struct engine* e, hid_t h_data, const struct io_props props,
+    const struct unit_system* snapshot_units,
+    const enum lossy_compression_schemes lossy_compression) {
+
+  /* Write unit conversion factors for this data set */
+  char buffer[FIELD_BUFFER_SIZE];
+  units_cgs_conversion_string(buffer, snapshot_units, props.units);
+  float baseUnitsExp[5];
+  units_get_base_unit_exponents_array(baseUnitsExp, props.units);
+  const float a_factor_exp = units_a_factor(snapshot_units, props.units);
+  io_write_attribute_f(h_data, "U_M exponent", baseUnitsExp[UNIT_MASS]);
+  io_write_attribute_f(h_data, "U_L exponent", baseUnitsExp[UNIT_LENGTH]);
+  io_write_attribute_f(h_data, "U_t exponent", baseUnitsExp[UNIT_TIME]);
+  io_write_attribute_f(h_data, "U_I exponent", baseUnitsExp[UNIT_CURRENT]);
+  io_write_attribute_f(h_data, "U_T exponent", baseUnitsExp[UNIT_TEMPERATURE]);
+  io_write_attribute_f(h_data, "h-scale exponent", 0);
+  io_write_attribute_f(h_data, "a-scale exponent", a_factor_exp);
+  io_write_attribute_s(h_data, "Expression for physical CGS units", buffer);
+
+  /* Write the actual number this conversion factor corresponds to */
+  const double factor =
+      units_cgs_conversion_factor(snapshot_units, props.units);
+  io_write_attribute_d(
+      h_data,
+      "Conversion factor to CGS (not including cosmological corrections)",
+      factor);
+  io_write_attribute_d(
+      h_data,
+      "Conversion factor to phyical CGS (including cosmological corrections)",
+      factor * pow(e->cosmology->a, a_factor_exp));
+
+  /* Record the lossy filter applied to this field */
+  io_write_lossy_compression_attribute(h_data, lossy_compression);
+}
+
+/**
+ * @brief Writes a data array of the particles of this rank to its own file.
+ *
+ * @param e The #engine we are writing from.
+ * @param grp The group in which to write.
+ * @param props The #io_props of the field to write.
+ * @param N The number of particles to write.
+ * @param internal_units The #unit_system used internally.
+ * @param snapshot_units The #unit_system used in the snapshots.
+ * @param lossy_compression The lossy filter to apply to this field.
+ */
+static void write_distributed_array(
+    const struct engine* e, hid_t grp, const struct io_props props, size_t N,
+    const struct unit_system* internal_units,
+    const struct unit_system* snapshot_units,
+    const enum lossy_compression_schemes lossy_compression) {
+
+  const size_t typeSize = io_sizeof_type(props.type);
+  const size_t num_elements = N * props.dimension;
+
+  /* Can we write straight from the particles? */
+  const hid_t h_memspace =
+      io_write_field_memspace(props, N, internal_units, snapshot_units);
+
+  /* Otherwise, copy the particle data to a temporary buffer */
+  void* temp = NULL;
+  if (h_memspace < 0 && N > 0) {
+    if (swift_memalign("writebuff", (void**)&temp, IO_BUFFER_ALIGNMENT,
+                       num_elements * typeSize) != 0)
+      error("Unable to allocate temporary i/o buffer");
+
+    io_copy_temp_buffer(temp, e, props, N, internal_units, snapshot_units);
+  }
+
+  /* Create data space */
+  const hid_t h_space = H5Screate(H5S_SIMPLE);
+  if (h_space < 0)
+    error("Error while creating data space for field '%s'.", props.name);
+
+  int rank;
+  hsize_t shape[2];
+  hsize_t chunk_shape[2];
+
+  if (props.dimension > 1) {
+    rank = 2;
+    shape[0] = N;
+    shape[1] = props.dimension;
+    chunk_shape[0] = 1 << 20; /* Just a guess...*/
+    chunk_shape[1] = props.dimension;
+  } else {
+    rank = 1;
+    shape[0] = N;
+    shape[1] = 0;
+    chunk_shape[0] = 1 << 20; /* Just a guess...*/
+    chunk_shape[1] = 0;
+  }
+
+  /* Make sure the chunks are not larger than the dataset */
+  if (chunk_shape[0] > N) chunk_shape[0] = N;
+
+  /* Change shape of data space */
+  hid_t h_err = H5Sset_extent_simple(h_space, rank, shape, shape);
+  if (h_err < 0)
+    error("Error while changing data space shape for field '%s'.", props.name);
+
+  /* Type of the data on disk (may be changed by the lossy filter) */
+  const hid_t h_type = H5Tcopy(io_hdf5_type(props.type));
+
+  /* Dataset properties */
+  const hid_t h_prop = H5Pcreate(H5P_DATASET_CREATE);
+
+  /* Empty arrays cannot be chunked and hence not filtered either */
+  if (N > 0) {
+
+    /* Set chunk size */
+    h_err = H5Pset_chunk(h_prop, rank, chunk_shape);
+    if (h_err < 0)
+      error("Error while setting chunk size (%llu, %llu) for field '%s'.",
+            chunk_shape[0], chunk_shape[1], props.name);
+
+    /* Impose the lossy filter (must come before the lossless ones) */
+    io_set_hdf5_lossy_compression(h_prop, h_type, lossy_compression,
+                                  props.name);
+
+    /* Impose check-sum to verify data corruption */
+    h_err = H5Pset_fletcher32(h_prop);
+    if (h_err < 0)
+      error("Error while setting checksum options for field '%s'.",
+            props.name);
+
+    /* Impose data compression */
+    if (e->snapshot_compression > 0) {
+      h_err = H5Pset_shuffle(h_prop);
+      if (h_err < 0)
+        error("Error while setting shuffling options for field '%s'.",
+              props.name);
+
+      h_err = H5Pset_deflate(h_prop, e->snapshot_compression);
+      if (h_err < 0)
+        error("Error while setting compression options for field '%s'.",
+              props.name);
+    }
+  }
+
+  /* Create dataset */
+  const hid_t h_data = H5Dcreate(grp, props.name, h_type, h_space,
+                                 H5P_DEFAULT, h_prop, H5P_DEFAULT);
+  if (h_data < 0) error("Error while creating dataspace '%s'.", props.name);
+
+  /* Write the particles or the temporary buffer to HDF5 dataspace */
+  if (N > 0) {
+    if (h_memspace >= 0)
+      h_err = H5Dwrite(h_data, io_hdf5_type(props.type), h_memspace, H5S_ALL,
+                       H5P_DEFAULT, props.field);
+    else
+      h_err = H5Dwrite(h_data, io_hdf5_type(props.type), h_space, H5S_ALL,
+                       H5P_DEFAULT, temp);
+    if (h_err < 0) error("Error while writing data array '%s'.", props.name);
+  }
+
+  /* Units and compression */
+  write_array_attributes(e, h_data, props, snapshot_units, lossy_compression);
+
+  /* Free and close everything */
+  if (temp != NULL) swift_free("writebuff", temp);
+  if (h_memspace >= 0) H5Sclose(h_memspace);
+  H5Tclose(h_type);
+  H5Pclose(h_prop);
+  H5Dclose(h_data);
+  H5Sclose(h_space);
+}
+
+/**
+ * @brief Writes a virtual dataset in the master file gathering the arrays
+ * written by all the ranks in their own file.
+ *
+ * The arrays of the ranks are concatenated in the order of the ranks. The
+ * files of the ranks are referred to by their name relative to the master
+ * file, which HDF5 looks for in the directory of the master file.
+ *
+ * @param e The #engine we are writing from.
+ * @param grp The group in which to write in the master file.
+ * @param snapshotName The name of the snapshot (without extension).
+ * @param fileName The name of the master file.
+ * @param xmfFile The (opened) XMF file we are appending to.
+ * @param partTypeGroupName The name of the group of the particles.
+ * @param props The #io_props of the field to write.
+ * @param N_counts The number of particles written by each rank.
+ * @param N_total The total number of particles.
+ * @param mpi_size The number of MPI ranks.
+ * @param snapshot_units The #unit_system used in the snapshots.
+ * @param lossy_compression The lossy filter applied to this field.
+ */
+static void write_virtual_array(
+    const struct engine* e, hid_t grp, const char* snapshotName,
+    char* fileName, FILE* xmfFile, char* partTypeGroupName,
+    const struct io_props props, const long long* N_counts,
+    const long long N_total, const int mpi_size,
+    const struct unit_system* snapshot_units,
+    const enum lossy_compression_schemes lossy_compression) {
+
+#if H5_VERSION_GE(1, 10, 0)
+
+  /* Name of the files of the ranks relative to the master file */
+  const char* baseName = strrchr(snapshotName, '/');
+  baseName = (baseName == NULL) ? snapshotName : baseName + 1;
+
+  /* Path of the array in the files of the ranks */
+  char datasetName[PARTICLE_GROUP_BUFFER_SIZE + FIELD_BUFFER_SIZE];
+  snprintf(datasetName, sizeof(datasetName), "%s/%s", partTypeGroupName,
+           props.name);
+
+  /* Create data space */
+  const int rank = (props.dimension > 1) ? 2 : 1;
+  const hsize_t shape[2] = {(hsize_t)N_total, (hsize_t)props.dimension};
+  const hid_t h_space = H5Screate_simple(rank, shape, NULL);
+  if (h_space < 0)
+    error("Error while creating data space for field '%s'.", props.name);
+
+  /* Map the section of each rank to its own file */
+  const hid_t h_prop = H5Pcreate(H5P_DATASET_CREATE);
+  long long offset = 0;
+  for (int r = 0; r < mpi_size; ++r) {
+
+    if (N_counts[r] == 0) continue;
+
+    const hsize_t src_shape[2] = {(hsize_t)N_counts[r],
+                                  (hsize_t)props.dimension};
+    const hsize_t start[2] = {(hsize_t)offset, 0};
+
+    const hid_t h_src_space = H5Screate_simple(rank, src_shape, NULL);
+    if (h_src_space < 0)
+      error("Error while creating source space for field '%s'.", props.name);
+
+    hid_t h_err = H5Sselect_hyperslab(h_space, H5S_SELECT_SET, start, NULL,
+                                      src_shape, NULL);
+    if (h_err < 0)
+      error("Error while selecting the section of rank %d for field '%s'.", r,
+            props.name);
+
+    char srcFileName[FILENAME_BUFFER_SIZE];
+    snprintf(srcFileName, FILENAME_BUFFER_SIZE, "%s.%d.hdf5", baseName, r);
+
+    h_err =
+        H5Pset_virtual(h_prop, h_space, srcFileName, datasetName, h_src_space);
+    if (h_err < 0)
+      error("Error while mapping field '%s' of rank %d.", props.name, r);
+
+    H5Sclose(h_src_space);
+    offset += N_counts[r];
+  }
+
+  /* Create dataset */
+  const hid_t h_data =
+      H5Dcreate(grp, props.name, io_hdf5_type(props.type), h_space,
+                H5P_DEFAULT, h_prop, H5P_DEFAULT);
+  if (h_data < 0)
+    error("Error while creating virtual dataset '%s'.", props.name);
+
+  /* Units and compression */
+  write_array_attributes(e, h_data, props, snapshot_units, lossy_compression);
+
+  /* Add a line to the XMF */
+  if (xmfFile != NULL)
+    xmf_write_line(xmfFile, fileName, partTypeGroupName, props.name, N_total,
+                   props.dimension, props.type);
+
+  /* Close everything */
+  H5Pclose(h_prop);
+  H5Dclose(h_data);
+  H5Sclose(h_space);
+
+#else
+  error("Distributed snapshots require HDF5 1.10.0 or later.");
+#endif
+}
+
+/**
+ * @brief Writes the header of a snapshot file.
+ *
+ * @param e The #engine we are writing from.
+ * @param h_file The file to write to.
+ * @param N_file The number of particles of each type in this file.
+ * @param N_total The total number of particles of each type.
+ * @param numFiles The number of files the snapshot is made of.
+ * @param internal_units The #unit_system used internally.
+ * @param snapshot_units The #unit_system used in the snapshots.
+ */
+static void write_header(const struct engine* e, hid_t h_file,
+                         const long long N_file[swift_type_count],
+                         const long long N_total[swift_type_count],
+                         const int numFiles,
+                         const struct unit_system* internal_units,
+                         const struct unit_system* snapshot_units) {
+
+  /* Open header to write simulation properties */
+  const hid_t h_grp =
+      H5Gcreate(h_file, "/Header", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  if (h_grp < 0) error("Error while creating file header\n");
+
+  /* Convert basic output information to snapshot units */
+  const double factor_time =
+      units_conversion_factor(internal_units, snapshot_units, UNIT_CONV_TIME);
+  const double factor_length =
+      units_conversion_factor(internal_units, snapshot_units, UNIT_CONV_LENGTH);
+  const double dblTime = e->time * factor_time;
+  const double dim[3] = {e->s->dim[0] * factor_length,
+                         e->s->dim[1] * factor_length,
+                         e->s->dim[2] * factor_length};
+
+  /* Print the relevant information and print status */
+  io_write_attribute(h_grp, "BoxSize", DOUBLE, dim, 3);
+  io_write_attribute(h_grp, "Time", DOUBLE, &dblTime, 1);
+  const int dimension = (int)hydro_dimension;
+  io_write_attribute(h_grp, "Dimension", INT, &dimension, 1);
+  io_write_attribute(h_grp, "Redshift", DOUBLE, &e->cosmology->z, 1);
+  io_write_attribute(h_grp, "Scale-factor", DOUBLE, &e->cosmology->a, 1);
+  io_write_attribute_s(h_grp, "Code", "SWIFT");
+  time_t tm = time(NULL);
+  io_write_attribute_s(h_grp, "Snapshot date", ctime(&tm));
+  io_write_attribute_s(h_grp, "RunName", e->run_name);
+
+  /* GADGET-2 legacy values */
+  /* Number of particles of each type */
+  unsigned int numParticles[swift_type_count] = {0};
+  unsigned int numParticlesHighWord[swift_type_count] = {0};
+  for (int ptype = 0; ptype < swift_type_count; ++ptype) {
+    numParticles[ptype] = (unsigned int)N_total[ptype];
+    numParticlesHighWord[ptype] = (unsigned int)(N_total[ptype] >> 32);
+  }
+  io_write_attribute(h_grp, "NumPart_ThisFile", LONGLONG, N_file,
+                     swift_type_count);
+  io_write_attribute(h_grp, "NumPart_Total", UINT, numParticles,
+                     swift_type_count);
+  io_write_attribute(h_grp, "NumPart_Total_HighWord", UINT,
+                     numParticlesHighWord, swift_type_count);
+  double MassTable[swift_type_count] = {0};
+  io_write_attribute(h_grp, "MassTable", DOUBLE, MassTable, swift_type_count);
+  unsigned int flagEntropy[swift_type_count] = {0};
+  flagEntropy[0] = writeEntropyFlag();
+  io_write_attribute(h_grp, "Flag_Entropy_ICs", UINT, flagEntropy,
+                     swift_type_count);
+  io_write_attribute(h_grp, "NumFilesPerSnapshot", INT, &numFiles, 1);
+
+  /* Close header */
+  H5Gclose(h_grp);
+}
+
+/**
+ * @brief Writes the meta-data of the run (schemes, parameters, units...) in
+ * the master file.
+ *
+ * @param e The #engine we are writing from.
+ * @param h_file The file to write to.
+ * @param internal_units The #unit_system used internally.
+ * @param snapshot_units The #unit_system used in the snapshots.
+ */
+static void write_meta_data(const struct engine* e, hid_t h_file,
+                            const struct unit_system* internal_units,
+                            const struct unit_system* snapshot_units) {
+
+  hid_t h_grp = 0;
+
+  /* Print the code version */
+  io_write_code_description(h_file);
+
+  /* Print the run's policy */
+  io_write_engine_policy(h_file, e);
+
+  /* Print the SPH parameters */
+  if (e->policy & engine_policy_hydro) {
+    h_grp = H5Gcreate(h_file, "/HydroScheme", H5P_DEFAULT, H5P_DEFAULT,
+                      H5P_DEFAULT);
+    if (h_grp < 0) error("Error while creating SPH group");
+    hydro_props_print_snapshot(h_grp, e->hydro_properties);
+    hydro_write_flavour(h_grp);
+    H5Gclose(h_grp);
+  }
+
+  /* Print the subgrid parameters */
+  h_grp = H5Gcreate(h_file, "/SubgridScheme", H5P_DEFAULT, H5P_DEFAULT,
+                    H5P_DEFAULT);
+  if (h_grp < 0) error("Error while creating subgrid group");
+  entropy_floor_write_flavour(h_grp);
+  cooling_write_flavour(h_grp, e->cooling_func);
+  chemistry_write_flavour(h_grp);
+  tracers_write_flavour(h_grp);
+  H5Gclose(h_grp);
+
+  /* Print the gravity parameters */
+  if (e->policy & engine_policy_self_gravity) {
+    h_grp = H5Gcreate(h_file, "/GravityScheme", H5P_DEFAULT, H5P_DEFAULT,
+                      H5P_DEFAULT);
+    if (h_grp < 0) error("Error while creating gravity group");
+    gravity_props_print_snapshot(h_grp, e->gravity_properties);
+    H5Gclose(h_grp);
+  }
+
+  /* Print the stellar parameters */
+  if (e->policy & engine_policy_stars) {
+    h_grp = H5Gcreate(h_file, "/StarsScheme", H5P_DEFAULT, H5P_DEFAULT,
+                      H5P_DEFAULT);
+    if (h_grp < 0) error("Error while creating stars group");
+    stars_props_print_snapshot(h_grp, e->stars_properties);
+    H5Gclose(h_grp);
+  }
+
+  /* Print the cosmological model */
+  h_grp =
+      H5Gcreate(h_file, "/Cosmology", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  if (h_grp < 0) error("Error while creating cosmology group");
+  if (e->policy & engine_policy_cosmology)
+    io_write_attribute_i(h_grp, "Cosmological run", 1);
+  else
+    io_write_attribute_i(h_grp, "Cosmological run", 0);
+  cosmology_write_model(h_grp, e->cosmology);
+  H5Gclose(h_grp);
+
+  /* Print the runtime parameters */
+  h_grp =
+      H5Gcreate(h_file, "/Parameters", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  if (h_grp < 0) error("Error while creating parameters group");
+  parser_write_params_to_hdf5(e->parameter_file, h_grp, 1);
+  H5Gclose(h_grp);
+
+  /* Print the runtime unused parameters */
+  h_grp = H5Gcreate(h_file, "/UnusedParameters", H5P_DEFAULT, H5P_DEFAULT,
+                    H5P_DEFAULT);
+  if (h_grp < 0) error("Error while creating parameters group");
+  parser_write_params_to_hdf5(e->parameter_file, h_grp, 0);
+  H5Gclose(h_grp);
+
+  /* Print the system of Units used in the spashot */
+  io_write_unit_system(h_file, snapshot_units, "Units");
+
+  /* Print the system of Units used internally */
+  io_write_unit_system(h_file, internal_units, "InternalCodeUnits");
+}
+
+/**
+ * @brief Writes a snapshot as one HDF5 file per MPI rank.
+ *
+ * @param e The engine containing all the system.
+ * @param baseName The common part of the snapshot file name.
+ * @param internal_units The #unit_system used internally
+ * @param snapshot_units The #unit_system used in the snapshots
+ * @param mpi_rank The MPI rank of this node.
+ * @param mpi_size The number of MPI nodes.
+ * @param comm The MPI communicator.
+ * @param info The MPI information object
+ *
+ * Every rank writes its particles to its own file "baseName_XXXX.rank.hdf5"
+ * independently of the others, so no collective HDF5 operation is involved.
+ * Rank 0 then writes the master file "baseName_XXXX.hdf5" containing the
+ * meta-data of the run, the cell structure and, for each field, a virtual
+ * dataset concatenating the arrays of all the ranks. The master file can be
+ * read like a snapshot written in a single file as long as the files of the
+ * ranks sit in the same directory.
+ *
+ * Calls #error() if an error occurs.
+ *
+ */
+void write_output_distributed(struct engine* e, const char* baseName,
+                              const struct unit_system* internal_units,
+                              const struct unit_system* snapshot_units,
+                              int mpi_rank, int mpi_size, MPI_Comm comm,
+                              MPI_Info info) {
+
+  hid_t h_file = 0, h_grp = 0, h_file_master = 0, h_grp_master = 0;
+  const struct part* parts = e->s->parts;
+  const struct xpart* xparts = e->s->xparts;
+  const struct gpart* gparts = e->s->gparts;
+  const struct spart* sparts = e->s->sparts;
+  const struct bpart* bparts = e->s->bparts;
+  struct swift_params* params = e->parameter_file;
+  const int with_cosmology = e->policy & engine_policy_cosmology;
+  const int with_cooling = e->policy & engine_policy_cooling;
+  const int with_temperature = e->policy & engine_policy_temperature;
+#ifdef HAVE_VELOCIRAPTOR
+  const int with_stf = (e->policy & engine_policy_structure_finding) &&
+                       (e->s->gpart_group_data != NULL);
+#else
+  const int with_stf = 0;
+#endif
+
+  FILE* xmfFile = 0;
+
+  /* Number of particles currently in the arrays */
+  const size_t Ntot = e->s->nr_gparts;
+  const size_t Ngas = e->s->nr_parts;
+  const size_t Nstars = e->s->nr_sparts;
+  const size_t Nblackholes = e->s->nr_bparts;
+
+  /* Number of particles that we will write */
+  const size_t Ntot_written =
+      e->s->nr_gparts - e->s->nr_inhibited_gparts - e->s->nr_extra_gparts;
+  const size_t Ngas_written =
+      e->s->nr_parts - e->s->nr_inhibited_parts - e->s->nr_extra_parts;
+  const size_t Nstars_written =
+      e->s->nr_sparts - e->s->nr_inhibited_sparts - e->s->nr_extra_sparts;
+  const size_t Nblackholes_written =
+      e->s->nr_bparts - e->s->nr_inhibited_bparts - e->s->nr_extra_bparts;
+  const size_t Nbaryons_written =
+      Ngas_written + Nstars_written + Nblackholes_written;
+  const size_t Ndm_written =
+      Ntot_written > 0 ? Ntot_written - Nbaryons_written : 0;
+
+  /* Name of the snapshot and of the files */
+  char snapshotName[FILENAME_BUFFER_SIZE];
+  if (e->snapshot_int_time_label_on)
+    snprintf(snapshotName, FILENAME_BUFFER_SIZE, "%s_%06i", baseName,
+             (int)round(e->time));
+  else
+    snprintf(snapshotName, FILENAME_BUFFER_SIZE, "%s_%04i", baseName,
+             e->snapshot_output_count);
+
+  char fileName[FILENAME_BUFFER_SIZE + 8];
+  snprintf(fileName, sizeof(fileName), "%s.hdf5", snapshotName);
+  char rankFileName[FILENAME_BUFFER_SIZE + 32];
+  snprintf(rankFileName, sizeof(rankFileName), "%s.%d.hdf5", snapshotName,
+           mpi_rank);
+
+  /* Number of particles on this rank, offset of this rank in the virtual
+   * arrays and total number of particles of each type */
+  long long N_local[swift_type_count] = {
+      (long long)Ngas_written,   (long long)Ndm_written,        0, 0,
+      (long long)Nstars_written, (long long)Nblackholes_written};
+  long long N_total[swift_type_count] = {0};
+  long long offset[swift_type_count] = {0};
+  MPI_Exscan(N_local, offset, swift_type_count, MPI_LONG_LONG_INT, MPI_SUM, comm);
+  MPI_Allreduce(N_local, N_total, swift_type_count, MPI_LONG_LONG_INT, MPI_SUM,
+                comm);
+
+  /* Rank 0 needs the number of particles of every rank for the mapping */
+  long long* N_counts = NULL;
+  long long* N_counts_type = NULL;
+  if (mpi_rank == 0) {
+    N_counts =
+        (long long*)malloc(mpi_size * swift_type_count * sizeof(long long));
+    N_counts_type = (long long*)malloc(mpi_size * sizeof(long long));
+    if (N_counts == NULL || N_counts_type == NULL)
+      error("Error allocating memory for the particle counts of the ranks");
+  }
+  MPI_Gather(N_local, swift_type_count, MPI_LONG_LONG_INT, N_counts,
+             swift_type_count, MPI_LONG_LONG_INT, 0, comm);
+
+  /* Rank 0 prepares the master file */
+  if (mpi_rank == 0) {
+
+    /* First time, we need to create the XMF file */
+    if (e->snapshot_output_count == 0) xmf_create_file(baseName);
+
+    /* Prepare the XMF file for the new entry */
+    xmfFile = xmf_prepare_file(baseName);
+
+    /* Write the part corresponding to this specific output */
+    xmf_write_outputheader(xmfFile, fileName, e->time);
+
+    /* Open file */
+    h_file_master = H5Fcreate(fileName, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    if (h_file_master < 0) error("Error while opening file '%s'.", fileName);
+
+    /* The master file looks like a snapshot written in a single file */
+    write_header(e, h_file_master, N_total, N_total, /*numFiles=*/1,
+                 internal_units, snapshot_units);
+    write_meta_data(e, h_file_master, internal_units, snapshot_units);
+
+    /* Group for the top-level cell structure */
+    h_grp_master = H5Gcreate(h_file_master, "/Cells", H5P_DEFAULT,
+                             H5P_DEFAULT, H5P_DEFAULT);
+    if (h_grp_master < 0) error("Error while creating cells group");
+  }
+
+  /* Write the location of the particles in the virtual arrays */
+  io_write_cell_offsets(h_grp_master, e->s->cdim, e->s->cells_top,
+                        e->s->nr_cells, e->s->width, mpi_rank, N_total, offset,
+                        internal_units, snapshot_units);
+
+  if (mpi_rank == 0) H5Gclose(h_grp_master);
+
+  /* Tell the user if a conversion will be needed */
+  if (e->verbose && mpi_rank == 0) {
+    if (units_are_equal(snapshot_units, internal_units)) {
+
+      message("Snapshot and internal units match. No conversion needed.");
+
+    } else {
+
+      message("Conversion needed from:");
+      message("(Snapshot) Unit system: U_M =      %e g.",
+              snapshot_units->UnitMass_in_cgs);
+      message("(Snapshot) Unit system: U_L =      %e cm.",
+              snapshot_units->UnitLength_in_cgs);
+      message("(Snapshot) Unit system: U_t =      %e s.",
+              snapshot_units->UnitTime_in_cgs);
+      message("(Snapshot) Unit system: U_I =      %e A.",
+              snapshot_units->UnitCurrent_in_cgs);
+      message("(Snapshot) Unit system: U_T =      %e K.",
+              snapshot_units->UnitTemperature_in_cgs);
+      message("to:");
+      message("(internal) Unit system: U_M = %e g.",
+              internal_units->UnitMass_in_cgs);
+      message("(internal) Unit system: U_L = %e cm.",
+              internal_units->UnitLength_in_cgs);
+      message("(internal) Unit system: U_t = %e s.",
+              internal_units->UnitTime_in_cgs);
+      message("(internal) Unit system: U_I = %e A.",
+              internal_units->UnitCurrent_in_cgs);
+      message("(internal) Unit system: U_T = %e K.",
+              internal_units->UnitTemperature_in_cgs);
+    }
+  }
+
+  /* Now, every rank writes its own file independently */
+  h_file = H5Fcreate(rankFileName, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  if (h_file < 0) error("Error while opening file '%s'.", rankFileName);
+
+  /* Header and units of the particles of this rank */
+  write_header(e, h_file, N_local, N_total, mpi_size, internal_units,
+               snapshot_units);
+  io_write_unit_system(h_file, snapshot_units, "Units");
+  io_write_unit_system(h_file, internal_units, "InternalCodeUnits");
+
+  /* Loop over all particle types */
+  for (int ptype = 0; ptype < swift_type_count; ptype++) {
+
+    /* Don't do anything if no particle of this kind */
+    if (N_total[ptype] == 0) continue;
+
+    /* Open the particle group in the file */
+    char partTypeGroupName[PARTICLE_GROUP_BUFFER_SIZE];
+    snprintf(partTypeGroupName, PARTICLE_GROUP_BUFFER_SIZE, "/PartType%d",
+             ptype);
+    h_grp = H5Gcreate(h_file, partTypeGroupName, H5P_DEFAULT, H5P_DEFAULT,
+                      H5P_DEFAULT);
+    if (h_grp < 0) error("Error while creating particle group.\n");
+
+    /* Same in the master file */
+    if (mpi_rank == 0) {
+
+      /* Add the global information for that particle type to the XMF
+       * meta-file */
+      xmf_write_groupheader(xmfFile, fileName, N_total[ptype],
+                            (enum part_type)ptype);
+
+      h_grp_master = H5Gcreate(h_file_master, partTypeGroupName, H5P_DEFAULT,
+                               H5P_DEFAULT, H5P_DEFAULT);
+      if (h_grp_master < 0) error("Error while creating particle group.\n");
+
+      /* Number of particles of this type on each rank */
+      for (int r = 0; r < mpi_size; ++r)
+        N_counts_type[r] = N_counts[r * swift_type_count + ptype];
+    }
+
+    int num_fields = 0;
+    struct io_props list[100];
+    size_t N = 0;
+
+    struct part* parts_written = NULL;
+    struct xpart* xparts_written = NULL;
+    struct gpart* gparts_written = NULL;
+    struct velociraptor_gpart_data* gpart_group_data_written = NULL;
+    struct spart* sparts_written = NULL;
+    struct bpart* bparts_written = NULL;
+
+    /* Write particle fields from the particle structure */
+    switch (ptype) {
+
+      case swift_type_gas: {
+        if (Ngas == Ngas_written) {
+
+          /* No inhibted particles: easy case */
+          N = Ngas;
+          hydro_write_particles(parts, xparts, list, &num_fields);
+          num_fields += chemistry_write_particles(parts, list + num_fields);
+          if (with_cooling || with_temperature) {
+            num_fields += cooling_write_particles(
+                parts, xparts, list + num_fields, e->cooling_func);
+          }
+          if (with_stf) {
+            num_fields +=
+                velociraptor_write_parts(parts, xparts, list + num_fields);
+          }
+          num_fields += tracers_write_particles(
+              parts, xparts, list + num_fields, with_cosmology);
+          num_fields +=
+              star_formation_write_particles(parts, xparts, list + num_fields);
+
+        } else {
+
+          /* Ok, we need to fish out the particles we want */
+          N = Ngas_written;
+
+          /* Allocate temporary arrays */
+          if (swift_memalign("parts_written", (void**)&parts_written,
+                             part_align,
+                             Ngas_written * sizeof(struct part)) != 0)
+            error("Error while allocating temporary memory for parts");
+          if (swift_memalign("xparts_written", (void**)&xparts_written,
+                             xpart_align,
+                             Ngas_written * sizeof(struct xpart)) != 0)
+            error("Error while allocating temporary memory for xparts");
+
+          /* Collect the particles we want to write */
+          io_collect_parts_to_write(parts, xparts, parts_written,
+                                    xparts_written, Ngas, Ngas_written);
+
+          /* Select the fields to write */
+          hydro_write_particles(parts_written, xparts_written, list,
+                                &num_fields);
+          num_fields +=
+              chemistry_write_particles(parts_written, list + num_fields);
+          if (with_cooling || with_temperature) {
+            num_fields +=
+                cooling_write_particles(parts_written, xparts_written,
+                                        list + num_fields, e->cooling_func);
+          }
+          if (with_stf) {
+            num_fields += velociraptor_write_parts(
+                parts_written, xparts_written, list + num_fields);
+          }
+          num_fields += tracers_write_particles(
+              parts_written, xparts_written, list + num_fields, with_cosmology);
+          num_fields += star_formation_write_particles(
+              parts_written, xparts_written, list + num_fields);
+        }
+      } break;
+
+      case swift_type_dark_matter: {
+        if (Ntot == Ndm_written) {
+
+          /* This is a DM-only run without inhibited particles */
+          N = Ntot;
+          darkmatter_write_particles(gparts, list, &num_fields);
+          if (with_stf) {
+            num_fields += velociraptor_write_gparts(e->s->gpart_group_data,
+                                                    list + num_fields);
+          }
+        } else {
+
+          /* Ok, we need to fish out the particles we want */
+          N = Ndm_written;
+
+          /* Allocate temporary array */
+          if (swift_memalign("gparts_written", (void**)&gparts_written,
+                             gpart_align,
+                             Ndm_written * sizeof(struct gpart)) != 0)
+            error("Error while allocating temporary memory for gparts");
+
+          if (with_stf) {
+            if (swift_memalign(
+                    "gpart_group_written", (void**)&gpart_group_data_written,
+                    gpart_align,
+                    Ndm_written * sizeof(struct velociraptor_gpart_data)) != 0)
+              error(
+                  "Error while allocating temporary memory for gparts STF "
+                  "data");
+          }
+
+          /* Collect the non-inhibited DM particles from gpart */
+          io_collect_gparts_to_write(gparts, e->s->gpart_group_data,
+                                     gparts_written, gpart_group_data_written,
+                                     Ntot, Ndm_written, with_stf);
+
+          /* Select the fields to write */
+          darkmatter_write_particles(gparts_written, list, &num_fields);
+          if (with_stf) {
+            num_fields += velociraptor_write_gparts(gpart_group_data_written,
+                                                    list + num_fields);
+          }
+        }
+      } break;
+
+      case swift_type_stars: {
+        if (Nstars == Nstars_written) {
+
+          /* No inhibted particles: easy case */
+          N = Nstars;
+          stars_write_particles(sparts, list, &num_fields);
+          num_fields += chemistry_write_sparticles(sparts, list + num_fields);
+          num_fields += tracers_write_sparticles(sparts, list + num_fields,
+                                                 with_cosmology);
+          if (with_stf) {
+            num_fields += velociraptor_write_sparts(sparts, list + num_fields);
+          }
+        } else {
+
+          /* Ok, we need to fish out the particles we want */
+          N = Nstars_written;
+
+          /* Allocate temporary arrays */
+          if (swift_memalign("sparts_written", (void**)&sparts_written,
+                             spart_align,
+                             Nstars_written * sizeof(struct spart)) != 0)
+            error("Error while allocating temporary memory for sparts");
+
+          /* Collect the particles we want to write */
+          io_collect_sparts_to_write(sparts, sparts_written, Nstars,
+                                     Nstars_written);
+
+          /* Select the fields to write */
+          stars_write_particles(sparts_written, list, &num_fields);
+          num_fields +=
+              chemistry_write_sparticles(sparts_written, list + num_fields);
+          num_fields += tracers_write_sparticles(
+              sparts_written, list + num_fields, with_cosmology);
+          if (with_stf) {
+            num_fields +=
+                velociraptor_write_sparts(sparts_written, list + num_fields);
+          }
+        }
+      } break;
+
+      case swift_type_black_hole: {
+        if (Nblackholes == Nblackholes_written) {
+
+          /* No inhibted particles: easy case */
+          N = Nblackholes;
+          black_holes_write_particles(bparts, list, &num_fields);
+          num_fields += chemistry_write_bparticles(bparts, list + num_fields);
+
+          if (with_stf) {
+            num_fields += velociraptor_write_bparts(bparts, list + num_fields);
+          }
+        } else {
+
+          /* Ok, we need to fish out the particles we want */
+          N = Nblackholes_written;
+
+          /* Allocate temporary arrays */
+          if (swift_memalign("bparts_written", (void**)&bparts_written,
+                             bpart_align,
+                             Nblackholes_written * sizeof(struct bpart)) != 0)
+            error("Error while allocating temporary memory for bparts");
+
+          /* Collect the particles we want to write */
+          io_collect_bparts_to_write(bparts, bparts_written, Nblackholes,
+                                     Nblackholes_written);
+
+          /* Select the fields to write */
+          black_holes_write_particles(bparts_written, list, &num_fields);
+          num_fields +=
+              chemistry_write_bparticles(bparts_written, list + num_fields);
+          if (with_stf) {
+            num_fields +=
+                velociraptor_write_bparts(bparts_written, list + num_fields);
+          }
+        }
+      } break;
+
+      default:
+        error("Particle Type %d not yet supported. Aborting", ptype);
+    }
+
+    /* Write everything that is not cancelled */
+    for (int i = 0; i < num_fields; ++i) {
+
+      /* Did the user cancel or compress this field? */
+      char field[PARSER_MAX_LINE_SIZE];
+      sprintf(field, "SelectOutput:%s_%s", list[i].name,
+              part_type_names[ptype]);
+      const enum lossy_compression_schemes compression_level =
+          io_get_field_compression(params, field);
+
+      if (compression_level != compression_do_not_write) {
+        write_distributed_array(e, h_grp, list[i], N, internal_units,
+                                snapshot_units, compression_level);
+
+        if (mpi_rank == 0)
+          write_virtual_array(e, h_grp_master, snapshotName, fileName, xmfFile,
+                              partTypeGroupName, list[i], N_counts_type,
+                              N_total[ptype], mpi_size, snapshot_units,
+                              compression_level);
+      }
+    }
+
+    /* Free temporary arrays */
+    if (parts_written) swift_free("parts_written", parts_written);
+    if (xparts_written) swift_free("xparts_written", xparts_written);
+    if (gparts_written) swift_free("gparts_written", gparts_written);
+    if (gpart_group_data_written)
+      swift_free("gpart_group_written", gpart_group_data_written);
+    if (sparts_written) swift_free("sparts_written", sparts_written);
+    if (bparts_written) swift_free("bparts_written", bparts_written);
+
+    /* Close particle group */
+    H5Gclose(h_grp);
+
+    /* Close this particle group in the master and XMF files as well */
+    if (mpi_rank == 0) {
+      H5Gclose(h_grp_master);
+      xmf_write_groupfooter(xmfFile, (enum part_type)ptype);
+    }
+  }
+
+  /* Close the file of this rank */
+  H5Fclose(h_file);
+
+  /* Close the master file */
+  if (mpi_rank == 0) {
+
+    /* Write LXMF file descriptor */
+    xmf_write_outputfooter(xmfFile, e->snapshot_output_count, e->time);
+
+    H5Fclose(h_file_master);
+    free(N_counts);
+    free(N_counts_type);
+  }
+
+  /* Make sure the whole snapshot is on disk before anyone moves on */
+  MPI_Barrier(comm);
+
+  e->snapshot_output_count++;
+}
+
+#endif /* HAVE_HDF5 && WITH_MPI */
@@ -62,6 +62,7 @@
 #include "cosmology.h"
 #include "cycle.h"
 #include "debug.h"
+#include "distributed_io.h"
 #include "entropy_floor.h"
 #include "equation_of_state.h"
 #include "error.h"
@@ -1185,7 +1186,7 @@ void engine_redistribute(struct engine *e) {
  */
 void engine_repartition(struct engine *e) {
 
-#if defined(WITH_MPI) && (defined(HAVE_PARMETIS) || defined(HAVE_METIS))
+#if defined(WITH_MPI)
 
   ticks tic = getticks();
 
@@ -1252,7 +1253,7 @@ void engine_repartition(struct engine *e) {
             clocks_getunit());
 #else
   if (e->reparttype->type != REPART_NONE)
-    error("SWIFT was not compiled with MPI and METIS or ParMETIS support.");
+    error("SWIFT was not compiled with MPI support.");
 
   /* Clear the repartition flag. */
   e->forcerepart = 0;
@@ -2117,8 +2118,7 @@ void engine_allocate_foreign_particles(struct engine *e) {
       }
 
       /* For stars, we just use the numbers in the top-level cells */
-      count_sparts_in +=
-          e->proxies[k].cells_in[j]->stars.count + space_extra_sparts;
+      count_sparts_in += e->proxies[k].cells_in[j]->stars.count_total;
 
       /* For black holes, we just use the numbers in the top-level cells */
       count_bparts_in += e->proxies[k].cells_in[j]->black_holes.count;
@@ -2209,8 +2209,7 @@ void engine_allocate_foreign_particles(struct engine *e) {
 
       /* For stars, we just use the numbers in the top-level cells */
       cell_link_sparts(e->proxies[k].cells_in[j], sparts);
-      sparts =
-          &sparts[e->proxies[k].cells_in[j]->stars.count + space_extra_sparts];
+      sparts = &sparts[e->proxies[k].cells_in[j]->stars.count_total];
 
       /* For black holes, we just use the numbers in the top-level cells */
       cell_link_bparts(e->proxies[k].cells_in[j], bparts);
@@ -2233,6 +2232,27 @@ void engine_allocate_foreign_particles(struct engine *e) {
 #endif
 }
 
+/**
+ * @brief Prints how often the space was re-built since the start of the run.
+ *
+ * The rebuilds caused by top-level cells running out of spare star particles
+ * are reported by each node separately.
+ *
+ * @param e The #engine.
+ */
+void engine_print_rebuild_stats(const struct engine *e) {
+
+  if (e->nodeID == 0)
+    message("Re-built the space %d times in %d steps.", e->nr_rebuilds,
+            e->step);
+
+  if (e->nr_rebuilds_sparts > 0)
+    message(
+        "%d rebuilds were caused by top-level cells running out of spare star "
+        "particles.",
+        e->nr_rebuilds_sparts);
+}
+
 /**
  * @brief Prints the number of tasks in the engine
  *
@@ -2461,6 +2481,15 @@ void engine_rebuild(struct engine *e, int repartitioned,
   e->forcerebuild = 0;
   e->restarting = 0;
 
+  /* Keep track of how often, and why, we rebuild */
+  e->nr_rebuilds++;
+  if (e->forcerebuild_sparts) {
+    e->nr_rebuilds_sparts++;
+    if (e->verbose)
+      message("Rebuilding as a top-level cell ran out of spare star particles.");
+  }
+  e->forcerebuild_sparts = 0;
+
   /* Re-build the space. */
   space_rebuild(e->s, repartitioned, e->verbose);
 
@@ -2570,15 +2599,21 @@ void engine_rebuild(struct engine *e, int repartitioned,
 #endif
 
   /* Run through the tasks and mark as skip or not. */
+  const ticks tic_marktasks = getticks();
   if (engine_marktasks(e))
     error("engine_marktasks failed after space_rebuild.");
+  const ticks toc_marktasks = getticks();
+  e->step_profiler.phases[step_profiler_phase_marktasks] +=
+      toc_marktasks - tic_marktasks;
+  e->step_profiler.phases[step_profiler_phase_rebuild] -=
+      toc_marktasks - tic_marktasks;
 
   /* Print the status of the system */
   if (e->verbose) engine_print_task_counts(e);
 
   /* Clear the counters of updates since the last rebuild */
   e->updates_since_rebuild = 0;
-  e->g_updates_since_rebuild = 0;
+  if (!e->s->last_rebuild_incremental) e->g_updates_since_rebuild = 0;
   e->s_updates_since_rebuild = 0;
   e->b_updates_since_rebuild = 0;
 
@@ -2604,7 +2639,12 @@ void engine_prepare(struct engine *e) {
   int repartitioned = 0;
 
   /* Unskip active tasks and check for rebuild */
-  if (!e->forcerebuild && !e->forcerepart && !e->restarting) engine_unskip(e);
+  if (!e->forcerebuild && !e->forcerepart && !e->restarting) {
+    const ticks tic_unskip = getticks();
+    engine_unskip(e);
+    step_profiler_add(&e->step_profiler, step_profiler_phase_marktasks,
+                      tic_unskip);
+  }
 
   const ticks tic3 = getticks();
 
@@ -2623,32 +2663,46 @@ void engine_prepare(struct engine *e) {
       e->run_fof) {
 
     /* Let's start by drifting everybody to the current time */
+    const ticks tic_drift = getticks();
     engine_drift_all(e, /*drift_mpole=*/0);
     drifted_all = 1;
+    step_profiler_add(&e->step_profiler, step_profiler_phase_drift, tic_drift);
 
+    const ticks tic_fof = getticks();
     engine_fof(e, /*dump_results=*/0, /*seed_black_holes=*/1);
+    step_profiler_add(&e->step_profiler, step_profiler_phase_fof, tic_fof);
   }
 
   /* Do we need repartitioning ? */
   if (e->forcerepart) {
 
     /* Let's start by drifting everybody to the current time */
+    const ticks tic_drift = getticks();
     engine_drift_all(e, /*drift_mpole=*/0);
     drifted_all = 1;
+    step_profiler_add(&e->step_profiler, step_profiler_phase_drift, tic_drift);
 
     /* And repartition */
+    const ticks tic_repartition = getticks();
     engine_repartition(e);
     repartitioned = 1;
+    step_profiler_add(&e->step_profiler, step_profiler_phase_repartition,
+                      tic_repartition);
   }
 
   /* Do we need rebuilding ? */
   if (e->forcerebuild) {
 
     /* Let's start by drifting everybody to the current time */
+    const ticks tic_drift = getticks();
     if (!e->restarting && !drifted_all) engine_drift_all(e, /*drift_mpole=*/0);
+    step_profiler_add(&e->step_profiler, step_profiler_phase_drift, tic_drift);
 
-    /* And rebuild */
+    /* And rebuild (the marking of the tasks is accounted for separately) */
+    const ticks tic_rebuild = getticks();
     engine_rebuild(e, repartitioned, 0);
+    step_profiler_add(&e->step_profiler, step_profiler_phase_rebuild,
+                      tic_rebuild);
   }
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -2666,6 +2720,11 @@ void engine_prepare(struct engine *e) {
   if (e->tasks_age % engine_tasksreweight == 1) {
     scheduler_reweight(&e->sched, e->verbose);
   }
+
+  /* With a cost model the weights follow the measured costs every step. */
+  else if (e->sched.cost_model.enabled) {
+    scheduler_reweight(&e->sched, e->verbose);
+  }
   e->tasks_age += 1;
 
   TIMER_TOC2(timer_prepare);
@@ -3315,6 +3374,7 @@ void engine_skip_force_and_kick(struct engine *e) {
         t->type == task_type_kick1 || t->type == task_type_kick2 ||
         t->type == task_type_timestep ||
         t->type == task_type_timestep_limiter ||
+        t->type == task_type_kick_timestep ||
         t->subtype == task_subtype_force ||
         t->subtype == task_subtype_limiter || t->subtype == task_subtype_grav ||
         t->type == task_type_end_hydro_force ||
@@ -3693,6 +3753,9 @@ void engine_step(struct engine *e) {
 
   e->tic_step = getticks();
 
+  /* Start the profile of this step. */
+  step_profiler_start_step(e);
+
   if (e->nodeID == 0) {
 
     /* Print some information to the screen */
@@ -3741,7 +3804,11 @@ void engine_step(struct engine *e) {
   e->step_props = engine_step_prop_none;
 
   /* When restarting, move everyone to the current time. */
-  if (e->restarting) engine_drift_all(e, /*drift_mpole=*/1);
+  if (e->restarting) {
+    const ticks tic_drift = getticks();
+    engine_drift_all(e, /*drift_mpole=*/1);
+    step_profiler_add(&e->step_profiler, step_profiler_phase_drift, tic_drift);
+  }
 
   /* Get the physical value of the time and time-step size */
   if (e->policy & engine_policy_cosmology) {
@@ -3776,9 +3843,13 @@ void engine_step(struct engine *e) {
   /* Trigger a tree-rebuild if we passed the frequency threshold */
   if ((e->policy & engine_policy_self_gravity) &&
       ((double)e->g_updates_since_rebuild >
-       ((double)e->total_nr_gparts) * e->gravity_properties->rebuild_frequency))
+       ((double)e->total_nr_gparts) * e->gravity_properties->rebuild_frequency)) {
     e->forcerebuild = 1;
 
+    /* The multipoles of all the trees need to be re-computed. */
+    e->s->force_full_rebuild = 1;
+  }
+
   /* Trigger a FOF black hole seeding? */
   if (e->policy & engine_policy_fof) {
     if (e->ti_end_min > e->ti_next_fof && e->ti_next_fof > 0) {
@@ -3796,6 +3867,7 @@ void engine_step(struct engine *e) {
 #endif
 
   /* Are we drifting everything (a la Gadget/GIZMO) ? */
+  const ticks tic_drift_all = getticks();
   if (e->policy & engine_policy_drift_all && !e->forcerebuild)
     engine_drift_all(e, /*drift_mpole=*/1);
 
@@ -3807,10 +3879,15 @@ void engine_step(struct engine *e) {
     else
       engine_drift_top_multipoles(e);
   }
+  step_profiler_add(&e->step_profiler, step_profiler_phase_drift,
+                    tic_drift_all);
 
 #ifdef WITH_MPI
   /* Repartition the space amongst the nodes? */
+  const ticks tic_repartition = getticks();
   engine_repartition_trigger(e);
+  step_profiler_add(&e->step_profiler, step_profiler_phase_repartition,
+                    tic_repartition);
 #endif
 
   /* Prepare the tasks to be launched, rebuild or repartition if needed. */
@@ -3844,8 +3921,23 @@ void engine_step(struct engine *e) {
 
   /* Start all the tasks. */
   TIMER_TIC;
+  const ticks tic_launch = getticks();
   engine_launch(e);
+  const ticks toc_launch = getticks();
   TIMER_TOC(timer_runners);
+  e->step_profiler.phases[step_profiler_phase_launch] +=
+      toc_launch - tic_launch;
+
+  /* Learn from the task timings of this step. */
+  cost_model_update(&e->sched.cost_model, e->sched.tasks, e->sched.nr_tasks,
+                    e->nodeID, e->tic_step, &e->threadpool, e->verbose);
+
+  /* Compare the time the tasks took with their critical path. */
+  if (e->verbose)
+    message("tasks took %.3f %s, critical path %.3f %s.",
+            clocks_from_ticks(toc_launch - tic_launch), clocks_getunit(),
+            clocks_from_ticks(scheduler_critical_path(&e->sched, tic_launch)),
+            clocks_getunit());
 
 #ifdef SWIFT_GRAVITY_FORCE_CHECKS
   /* Check the accuracy of the gravity calculation */
@@ -3861,7 +3953,10 @@ void engine_step(struct engine *e) {
 #endif
 
   /* Collect information about the next time-step */
+  const ticks tic_collect = getticks();
   engine_collect_end_of_step(e, 1);
+  step_profiler_add(&e->step_profiler, step_profiler_phase_collect,
+                    tic_collect);
   e->forcerebuild = e->collect_group1.forcerebuild;
   e->updates_since_rebuild += e->collect_group1.updated;
   e->g_updates_since_rebuild += e->collect_group1.g_updated;
@@ -3878,9 +3973,11 @@ void engine_step(struct engine *e) {
   /********************************************************/
 
   /* Create a restart file if needed. */
+  const ticks tic_io = getticks();
   engine_dump_restarts(e, 0, e->restart_onexit && engine_is_done(e));
 
   engine_check_for_dumps(e);
+  step_profiler_add(&e->step_profiler, step_profiler_phase_io, tic_io);
 
   TIMER_TOC2(timer_step);
 
@@ -3889,6 +3986,9 @@ void engine_step(struct engine *e) {
 
   /* Time in ticks at the end of this step. */
   e->toc_step = getticks();
+
+  /* Store the profile of this step. */
+  step_profiler_end_step(e);
 }
 
 /**
@@ -4748,15 +4848,21 @@ void engine_dump_snapshot(struct engine *e) {
 /* Dump... */
 #if defined(HAVE_HDF5)
 #if defined(WITH_MPI)
+  if (e->snapshot_distributed) {
+    write_output_distributed(e, e->snapshot_base_name, e->internal_units,
+                             e->snapshot_units, e->nodeID, e->nr_nodes,
+                             MPI_COMM_WORLD, MPI_INFO_NULL);
+  } else {
 #if defined(HAVE_PARALLEL_HDF5)
-  write_output_parallel(e, e->snapshot_base_name, e->internal_units,
+    write_output_parallel(e, e->snapshot_base_name, e->internal_units,
+                          e->snapshot_units, e->nodeID, e->nr_nodes,
+                          MPI_COMM_WORLD, MPI_INFO_NULL);
+#else
+    write_output_serial(e, e->snapshot_base_name, e->internal_units,
                         e->snapshot_units, e->nodeID, e->nr_nodes,
                         MPI_COMM_WORLD, MPI_INFO_NULL);
-#else
-  write_output_serial(e, e->snapshot_base_name, e->internal_units,
-                      e->snapshot_units, e->nodeID, e->nr_nodes, MPI_COMM_WORLD,
-                      MPI_INFO_NULL);
 #endif
+  }
 #else
   write_output_single(e, e->snapshot_base_name, e->internal_units,
                       e->snapshot_units);
@@ -4947,6 +5053,8 @@ void engine_init(struct engine *e, struct space *s, struct swift_params *params,
   parser_get_param_string(params, "Snapshots:basename", e->snapshot_base_name);
   e->snapshot_compression =
       parser_get_opt_param_int(params, "Snapshots:compression", 0);
+  e->snapshot_distributed =
+      parser_get_opt_param_int(params, "Snapshots:distributed", 0);
   e->snapshot_int_time_label_on =
       parser_get_opt_param_int(params, "Snapshots:int_time_label_on", 0);
   e->snapshot_invoke_stf =
@@ -5098,6 +5206,9 @@ void engine_config(int restart, int fof, struct engine *e,
   e->proxy_ind = NULL;
   e->nr_proxies = 0;
   e->forcerebuild = 1;
+  e->forcerebuild_sparts = 0;
+  e->nr_rebuilds = 0;
+  e->nr_rebuilds_sparts = 0;
   e->forcerepart = 0;
   e->restarting = restart;
   e->step_props = engine_step_prop_none;
@@ -5607,6 +5718,13 @@ void engine_config(int restart, int fof, struct engine *e,
   e->links_per_tasks =
       parser_get_opt_param_int(params, "Scheduler:links_per_tasks", 25);
 
+  /* Fuse the kick2, time-step and kick1 tasks? Only possible if no other
+   * task has to run in-between them. */
+  e->fused_kick_timestep =
+      parser_get_opt_param_int(params, "Scheduler:fused_kick_timestep", 1) &&
+      !(e->policy & (engine_policy_limiter | engine_policy_star_formation |
+                     engine_policy_feedback | engine_policy_black_holes));
+
   /* Init the scheduler. */
   scheduler_init(&e->sched, e->s, maxtasks, nr_queues,
                  (e->policy & scheduler_flag_steal), e->nodeID, &e->threadpool);
@@ -5618,6 +5736,32 @@ void engine_config(int restart, int fof, struct engine *e,
   e->sched.mpi_message_limit =
       parser_get_opt_param_int(params, "Scheduler:mpi_message_limit", 4) * 1024;
 
+  /* Time, in micro-seconds, the runners and the threads of the threadpool
+   * keep polling for work before going to sleep. Can be changed on restart. */
+  const double spin_time =
+      parser_get_opt_param_double(params, "Scheduler:spin_time", 20.);
+  e->sched.spin_ticks = clocks_to_ticks(spin_time / 1000.);
+  e->threadpool.spin_ticks = e->sched.spin_ticks;
+
+  /* Calibrate the task weights using the measured task timings? */
+  cost_model_init(&e->sched.cost_model, params);
+
+  /* Extend the task weights along the dependencies into other ranks? */
+  e->sched.critical_path =
+      parser_get_opt_param_int(params, "Scheduler:critical_path", 0);
+
+#ifdef SWIFT_TASK_COUNTERS
+  /* Which hardware events should be counted around the tasks? */
+  task_counters_events_init(&e->task_counters_events, params, e->verbose);
+#endif
+
+  /* Profile the phases of each step? */
+  if (!fof)
+    step_profiler_init(&e->step_profiler, params, e->nr_threads, nr_queues,
+                       e->nodeID, nr_nodes, restart);
+  else
+    e->step_profiler.enabled = 0;
+
   /* Allocate and init the threads. */
   if (swift_memalign("runners", (void **)&e->runners, SWIFT_CACHE_ALIGNMENT,
                      e->nr_threads * sizeof(struct runner)) != 0)
@@ -6203,6 +6347,7 @@ void engine_clean(struct engine *e, const int fof) {
   scheduler_clean(&e->sched);
   space_clean(e->s);
   threadpool_clean(&e->threadpool);
+  step_profiler_clean(&e->step_profiler);
 
   /* Close files */
   if (!fof && e->nodeID == 0) {
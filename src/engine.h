@@ -49,6 +49,7 @@
 #include "scheduler.h"
 #include "space.h"
 #include "star_formation_logger.h"
+#include "step_profiler.h"
 #include "task.h"
 #include "units.h"
 #include "velociraptor_interface.h"
@@ -108,6 +109,7 @@ enum engine_step_properties {
 #define engine_max_proxy_centre_frac 0.2
 #define engine_redistribute_alloc_margin 1.2
 #define engine_rebuild_link_alloc_margin 1.2
+#define engine_rebuild_task_keep_margin 1.5
 #define engine_foreign_alloc_margin 1.05
 #define engine_default_energy_file_name "energy"
 #define engine_default_timesteps_file_name "timesteps"
@@ -287,6 +289,7 @@ struct engine {
 
   char snapshot_base_name[PARSER_MAX_LINE_SIZE];
   int snapshot_compression;
+  int snapshot_distributed;
   int snapshot_int_time_label_on;
   int snapshot_invoke_stf;
   struct unit_system *snapshot_units;
@@ -372,6 +375,16 @@ struct engine {
   /* Force the engine to rebuild? */
   int forcerebuild;
 
+  /* Did a top-level cell run out of spare #spart since the last rebuild? */
+  int forcerebuild_sparts;
+
+  /* Number of rebuilds since the start of the run */
+  int nr_rebuilds;
+
+  /* Number of rebuilds caused by a top-level cell running out of spare #spart
+   * (on this node) */
+  int nr_rebuilds_sparts;
+
   /* Force the engine to repartition ? */
   int forcerepart;
   struct repartition *reparttype;
@@ -396,6 +409,18 @@ struct engine {
      the creation of communication tasks so needs to be large enough. */
   size_t links_per_tasks;
 
+  /* Are the second half-kick, the time-step and the first half-kick done by
+   * a single task per super-cell? */
+  int fused_kick_timestep;
+
+#ifdef SWIFT_TASK_COUNTERS
+  /* The hardware events counted around each task. */
+  struct task_counters_events task_counters_events;
+#endif
+
+  /* Profile of the phases of the recent steps. */
+  struct step_profiler step_profiler;
+
   /* Are we talkative ? */
   int verbose;
 
@@ -536,6 +561,7 @@ void engine_unpin(void);
 void engine_clean(struct engine *e, const int fof);
 int engine_estimate_nr_tasks(const struct engine *e);
 void engine_print_task_counts(const struct engine *e);
+void engine_print_rebuild_stats(const struct engine *e);
 void engine_fof(struct engine *e, const int dump_results,
                 const int seed_black_holes);
 void engine_activate_gpart_comms(struct engine *e);
@@ -784,7 +784,23 @@ void engine_make_hierarchical_tasks_common(struct engine *e, struct cell *c) {
   if (c->super == c) {
 
     /* Local tasks only... */
-    if (c->nodeID == e->nodeID) {
+    if (c->nodeID == e->nodeID && e->fused_kick_timestep) {
+
+      /* A single task does the second half-kick, the time-step and the
+       * first half-kick of the next step. The three pointers are aliased so
+       * that the dependencies of any of them end up on the fused task. */
+      c->kick2 = scheduler_addtask(s, task_type_kick_timestep,
+                                   task_subtype_none, 0, 0, c, NULL);
+      c->timestep = c->kick2;
+      c->kick1 = c->kick2;
+
+#if defined(WITH_LOGGER)
+      c->logger = scheduler_addtask(s, task_type_logger, task_subtype_none, 0,
+                                    0, c, NULL);
+      scheduler_addunlock(s, c->kick1, c->logger);
+#endif
+
+    } else if (c->nodeID == e->nodeID) {
 
       /* Add the two half kicks */
       c->kick1 = scheduler_addtask(s, task_type_kick1, task_subtype_none, 0, 0,
@@ -1120,9 +1136,12 @@ void engine_make_hierarchical_tasks_mapper(void *map_data, int num_elements,
   const int with_hydro = (e->policy & engine_policy_hydro);
   const int with_self_gravity = (e->policy & engine_policy_self_gravity);
   const int with_ext_gravity = (e->policy & engine_policy_external_gravity);
+  const char *rebuilt = e->s->cells_rebuilt;
 
   for (int ind = 0; ind < num_elements; ind++) {
     struct cell *c = &((struct cell *)map_data)[ind];
+    /* Skip the cells whose tasks were kept */
+    if (rebuilt != NULL && !rebuilt[c - e->s->cells_top]) continue;
     /* Make the common tasks (time integration) */
     engine_make_hierarchical_tasks_common(e, c);
     /* Add the hydro stuff */
@@ -1155,6 +1174,7 @@ void engine_make_self_gravity_tasks_mapper(void *map_data, int num_elements,
   const double theta_crit = e->gravity_properties->theta_crit;
   const double max_distance = e->mesh->r_cut_max;
   const double max_distance2 = max_distance * max_distance;
+  const char *rebuilt = s->cells_rebuilt;
 
   /* Compute how many cells away we need to walk */
   const double distance = 2.5 * cells[0].width[0] / theta_crit;
@@ -1191,7 +1211,7 @@ void engine_make_self_gravity_tasks_mapper(void *map_data, int num_elements,
     if (ci->grav.count == 0) continue;
 
     /* If the cell is local build a self-interaction */
-    if (ci->nodeID == nodeID) {
+    if (ci->nodeID == nodeID && (rebuilt == NULL || rebuilt[cid])) {
       scheduler_addtask(sched, task_type_self, task_subtype_grav, 0, 0, ci,
                         NULL);
     }
@@ -1219,6 +1239,9 @@ void engine_make_self_gravity_tasks_mapper(void *map_data, int num_elements,
               (ci->nodeID != nodeID && cj->nodeID != nodeID))
             continue;
 
+          /* Skip the pairs whose tasks were kept */
+          if (rebuilt != NULL && !rebuilt[cid] && !rebuilt[cjd]) continue;
+
           /* Recover the multipole information */
           const struct gravity_tensors *multi_i = ci->grav.multipole;
           const struct gravity_tensors *multi_j = cj->grav.multipole;
@@ -1308,6 +1331,7 @@ void engine_make_external_gravity_tasks(struct engine *e) {
   const int nodeID = e->nodeID;
   struct cell *cells = s->cells_top;
   const int nr_cells = s->nr_cells;
+  const char *rebuilt = s->cells_rebuilt;
 
   for (int cid = 0; cid < nr_cells; ++cid) {
 
@@ -1319,6 +1343,9 @@ void engine_make_external_gravity_tasks(struct engine *e) {
     /* Is that neighbour local ? */
     if (ci->nodeID != nodeID) continue;
 
+    /* Were the tasks of this cell kept? */
+    if (rebuilt != NULL && !rebuilt[cid]) continue;
+
     /* If the cell is local, build a self-interaction */
     scheduler_addtask(sched, task_type_self, task_subtype_external_grav, 0, 0,
                       ci, NULL);
@@ -1478,14 +1505,15 @@ void engine_count_and_link_tasks_mapper(void *map_data, int num_elements,
  * @brief Creates all the task dependencies for the gravity
  *
  * @param e The #engine
+ * @param first The first task to create the dependencies of.
  */
-void engine_link_gravity_tasks(struct engine *e) {
+void engine_link_gravity_tasks(struct engine *e, const int first) {
 
   struct scheduler *sched = &e->sched;
   const int nodeID = e->nodeID;
   const int nr_tasks = sched->nr_tasks;
 
-  for (int k = 0; k < nr_tasks; k++) {
+  for (int k = first; k < nr_tasks; k++) {
 
     /* Get a pointer to the task. */
     struct task *t = &sched->tasks[k];
@@ -1993,6 +2021,16 @@ void engine_make_extra_hydroloop_tasks_mapper(void *map_data, int num_elements,
         }
       }
 
+      if (with_black_holes && (bcount_i > 0 || bcount_j > 0)) {
+        scheduler_addunlock(sched, ci->hydro.super->hydro.sorts,
+                            t_bh_density);
+
+        if (ci->hydro.super != cj->hydro.super) {
+          scheduler_addunlock(sched, cj->hydro.super->hydro.sorts,
+                              t_bh_density);
+        }
+      }
+
       if (ci->nodeID == nodeID) {
         scheduler_addunlock(sched, t_force, ci->hydro.super->hydro.end_force);
 
@@ -2249,6 +2287,7 @@ void engine_make_extra_hydroloop_tasks_mapper(void *map_data, int num_elements,
         scheduler_addunlock(sched, ci->hydro.super->black_holes.drift,
                             t_bh_density);
         scheduler_addunlock(sched, ci->hydro.super->hydro.drift, t_bh_density);
+        scheduler_addunlock(sched, ci->hydro.super->hydro.sorts, t_bh_density);
         scheduler_addunlock(sched, ci->hydro.super->black_holes.black_holes_in,
                             t_bh_density);
         scheduler_addunlock(sched, t_bh_density,
@@ -2404,6 +2443,15 @@ void engine_make_extra_hydroloop_tasks_mapper(void *map_data, int num_elements,
         }
       }
 
+      if (with_black_holes && (bcount_i > 0 || bcount_j > 0)) {
+        scheduler_addunlock(sched, ci->hydro.super->hydro.sorts,
+                            t_bh_density);
+        if (ci->hydro.super != cj->hydro.super) {
+          scheduler_addunlock(sched, cj->hydro.super->hydro.sorts,
+                              t_bh_density);
+        }
+      }
+
       if (ci->nodeID == nodeID) {
         scheduler_addunlock(sched, t_force, ci->hydro.super->hydro.end_force);
 
@@ -2576,6 +2624,7 @@ void engine_make_hydroloop_tasks_mapper(void *map_data, int num_elements,
   const int nodeID = e->nodeID;
   const int *cdim = s->cdim;
   struct cell *cells = s->cells_top;
+  const char *rebuilt = s->cells_rebuilt;
 
   /* Loop through the elements, which are just byte offsets from NULL. */
   for (int ind = 0; ind < num_elements; ind++) {
@@ -2597,7 +2646,7 @@ void engine_make_hydroloop_tasks_mapper(void *map_data, int num_elements,
       continue;
 
     /* If the cell is local build a self-interaction */
-    if (ci->nodeID == nodeID) {
+    if (ci->nodeID == nodeID && (rebuilt == NULL || rebuilt[cid])) {
       scheduler_addtask(sched, task_type_self, task_subtype_density, 0, 0, ci,
                         NULL);
     }
@@ -2628,6 +2677,9 @@ void engine_make_hydroloop_tasks_mapper(void *map_data, int num_elements,
               (ci->nodeID != nodeID && cj->nodeID != nodeID))
             continue;
 
+          /* Skip the pairs whose tasks were kept */
+          if (rebuilt != NULL && !rebuilt[cid] && !rebuilt[cjd]) continue;
+
           /* Construct the pair task */
           const int sid = sortlistID[(kk + 1) + 3 * ((jj + 1) + 3 * (ii + 1))];
           scheduler_addtask(sched, task_type_pair, task_subtype_density, sid, 0,
@@ -2901,6 +2953,161 @@ void engine_make_fof_tasks(struct engine *e) {
             clocks_from_ticks(getticks() - tic), clocks_getunit());
 }
 
+/**
+ * @brief Does a task act on a cell of a top-level cell re-built by the last
+ * rebuild of the space?
+ *
+ * The cells of the re-built trees that were recycled still point to their
+ * former top-level cell, which was re-built too.
+ *
+ * @param t The #task.
+ * @param cells_top The top-level cells.
+ * @param rebuilt Flags of the re-built top-level cells.
+ */
+static INLINE int engine_task_is_rebuilt(const struct task *t,
+                                         const struct cell *cells_top,
+                                         const char *rebuilt) {
+
+  const struct cell *ci = t->ci;
+  const struct cell *cj = t->cj;
+  return (ci != NULL && (ci->top == NULL || rebuilt[ci->top - cells_top])) ||
+         (cj != NULL && (cj->top == NULL || rebuilt[cj->top - cells_top]));
+}
+
+/**
+ * @brief Empties the tasks acting on a re-built top-level cell.
+ *
+ * The tasks are emptied the way scheduler_splittask_hydro() empties the
+ * tasks it does not need.
+ *
+ * @param map_data The tasks.
+ * @param num_elements The number of tasks.
+ * @param extra_data The #engine.
+ */
+void engine_remove_rebuilt_tasks_mapper(void *map_data, int num_elements,
+                                        void *extra_data) {
+
+  struct engine *e = (struct engine *)extra_data;
+  const struct cell *cells_top = e->s->cells_top;
+  const char *rebuilt = e->s->cells_rebuilt;
+
+  for (int ind = 0; ind < num_elements; ind++) {
+    struct task *t = &((struct task *)map_data)[ind];
+    if (t->type == task_type_none ||
+        !engine_task_is_rebuilt(t, cells_top, rebuilt))
+      continue;
+
+    t->type = task_type_none;
+    t->subtype = task_subtype_none;
+    t->cj = NULL;
+    t->skip = 1;
+  }
+}
+
+/**
+ * @brief Removes the links to the emptied tasks from the kept top-level cells.
+ *
+ * @param map_data The top-level cells.
+ * @param num_elements The number of cells.
+ * @param extra_data The #engine.
+ */
+void engine_clean_dead_links_mapper(void *map_data, int num_elements,
+                                    void *extra_data) {
+
+  struct engine *e = (struct engine *)extra_data;
+  const char *rebuilt = e->s->cells_rebuilt;
+
+  for (int ind = 0; ind < num_elements; ind++) {
+    struct cell *c = &((struct cell *)map_data)[ind];
+    if (!rebuilt[c - e->s->cells_top]) cell_clean_dead_links(c);
+  }
+}
+
+/**
+ * @brief Keep the tasks of the top-level cells that were not re-built by the
+ * last, incremental, rebuild of the space.
+ *
+ * The tasks involving a re-built cell are emptied and their dependencies and
+ * links removed. The other tasks stay where they are, such that only the
+ * tasks of the re-built cells have to be constructed.
+ *
+ * The tasks are only kept when running on a single node without FOF and
+ * when the task and link lists have room for the new tasks.
+ *
+ * @param e The #engine.
+ *
+ * @return 1 if the tasks were kept, 0 if they must all be re-built.
+ */
+static int engine_keep_tasks(struct engine *e) {
+
+  struct space *s = e->s;
+  struct scheduler *sched = &e->sched;
+  const char *rebuilt = s->cells_rebuilt;
+  const ticks tic = getticks();
+
+  if (e->nr_nodes > 1 || (e->policy & engine_policy_fof) ||
+      sched->tasks == NULL || sched->nr_tasks == 0 || e->links == NULL)
+    return 0;
+
+  /* How many tasks go? */
+  int nr_empty = 0;
+  int nr_removed = 0;
+  for (int k = 0; k < sched->nr_tasks; k++) {
+    const struct task *t = &sched->tasks[k];
+    if (t->type == task_type_none)
+      nr_empty++;
+    else if (engine_task_is_rebuilt(t, s->cells_top, rebuilt))
+      nr_removed++;
+  }
+
+  /* Leave room for twice as many new tasks and links. */
+  const int nr_live = sched->nr_tasks - nr_empty;
+  const size_t nr_links_needed =
+      nr_live > 0 ? 2 * (size_t)((double)e->nr_links * nr_removed / nr_live)
+                  : 0;
+  if (sched->size - sched->nr_tasks < 2 * nr_removed ||
+      e->size_links - e->nr_links < nr_links_needed) {
+    if (e->verbose)
+      message("Not enough room left to keep the tasks.");
+    return 0;
+  }
+
+  /* Empty the tasks of the re-built cells... */
+  threadpool_map(&e->threadpool, engine_remove_rebuilt_tasks_mapper,
+                 sched->tasks, sched->nr_tasks, sizeof(struct task), 0, e);
+
+  /* ...and remove their dependencies and links. */
+  scheduler_prune_unlocks(sched);
+  threadpool_map(&e->threadpool, engine_clean_dead_links_mapper, s->cells_top,
+                 s->nr_cells, sizeof(struct cell), 0, e);
+
+  if (e->verbose)
+    message("Keeping %d tasks and removing %d took %.3f %s.",
+            nr_live - nr_removed, nr_removed,
+            clocks_from_ticks(getticks() - tic), clocks_getunit());
+
+  return 1;
+}
+
+/**
+ * @brief Forget about the re-built cells of the last rebuild of the space and
+ * clean the kept ones of their tasks, such that all the tasks are re-built.
+ *
+ * @param e The #engine.
+ */
+static void engine_drop_kept_tasks(struct engine *e) {
+
+  struct space *s = e->s;
+
+  /* With MPI, the space already cleaned the kept cells and the foreign ones
+   * must keep the tags they were sent. */
+  if (e->nr_nodes == 1)
+    for (int k = 0; k < s->nr_cells; k++) cell_clean_tasks(&s->cells_top[k]);
+
+  swift_free("cells_rebuilt", s->cells_rebuilt);
+  s->cells_rebuilt = NULL;
+}
+
 /**
  * @brief Fill the #space's task list.
  *
@@ -2914,8 +3121,21 @@ void engine_maketasks(struct engine *e) {
   const int nr_cells = s->nr_cells;
   const ticks tic = getticks();
 
-  /* Re-set the scheduler. */
-  scheduler_reset(sched, engine_estimate_nr_tasks(e));
+  /* Keep the tasks of the cells the space did not re-build, if we can. */
+  if (s->cells_rebuilt != NULL && !engine_keep_tasks(e))
+    engine_drop_kept_tasks(e);
+
+  /* Re-set the scheduler, unless we only add the tasks of the re-built
+   * cells. */
+  if (s->cells_rebuilt == NULL) {
+    int nr_tasks = engine_estimate_nr_tasks(e);
+
+    /* Leave room for the tasks of the cells re-built by the next rebuilds. */
+    if (s->with_incremental_rebuild && e->nr_nodes == 1)
+      nr_tasks *= engine_rebuild_task_keep_margin;
+    scheduler_reset(sched, nr_tasks);
+  }
+  const int first = sched->nr_tasks;
 
   ticks tic2 = getticks();
 
@@ -2950,7 +3170,7 @@ void engine_maketasks(struct engine *e) {
   tic2 = getticks();
 
   /* Split the tasks. */
-  scheduler_splittasks(sched, /*fof_tasks=*/0);
+  scheduler_splittasks_from(sched, first);
 
   if (e->verbose)
     message("Splitting tasks took %.3f %s.",
@@ -2964,19 +3184,23 @@ void engine_maketasks(struct engine *e) {
   }
 #endif
 
-  /* Free the old list of cell-task links. */
-  if (e->links != NULL) swift_free("links", e->links);
-  e->size_links = e->sched.nr_tasks * e->links_per_tasks;
+  /* The kept tasks keep their links. */
+  if (first == 0) {
 
-  /* Make sure that we have space for more links than last time. */
-  if (e->size_links < e->nr_links * engine_rebuild_link_alloc_margin)
-    e->size_links = e->nr_links * engine_rebuild_link_alloc_margin;
+    /* Free the old list of cell-task links. */
+    if (e->links != NULL) swift_free("links", e->links);
+    e->size_links = e->sched.nr_tasks * e->links_per_tasks;
 
-  /* Allocate the new link list */
-  if ((e->links = (struct link *)swift_malloc(
-           "links", sizeof(struct link) * e->size_links)) == NULL)
-    error("Failed to allocate cell-task links.");
-  e->nr_links = 0;
+    /* Make sure that we have space for more links than last time. */
+    if (e->size_links < e->nr_links * engine_rebuild_link_alloc_margin)
+      e->size_links = e->nr_links * engine_rebuild_link_alloc_margin;
+
+    /* Allocate the new link list */
+    if ((e->links = (struct link *)swift_malloc(
+             "links", sizeof(struct link) * e->size_links)) == NULL)
+      error("Failed to allocate cell-task links.");
+    e->nr_links = 0;
+  }
 
   tic2 = getticks();
 
@@ -2984,12 +3208,32 @@ void engine_maketasks(struct engine *e) {
      store the density tasks in each cell, and make each sort
      depend on the sorts of its progeny. */
   threadpool_map(&e->threadpool, engine_count_and_link_tasks_mapper,
-                 sched->tasks, sched->nr_tasks, sizeof(struct task), 0, e);
+                 &sched->tasks[first], sched->nr_tasks - first,
+                 sizeof(struct task), 0, e);
 
   if (e->verbose)
     message("Counting and linking tasks took %.3f %s.",
             clocks_from_ticks(getticks() - tic2), clocks_getunit());
 
+  /* The kept tasks hang from the super-cells of the kept cells, which must
+   * thus not move with the new tasks. Otherwise, start again from scratch. */
+  if (first > 0) {
+    const int with_hydro = (e->policy & engine_policy_hydro);
+    const int with_grav = (e->policy & engine_policy_self_gravity) ||
+                          (e->policy & engine_policy_external_gravity);
+    for (int k = 0; k < nr_cells; k++) {
+      if (s->cells_rebuilt[k] ||
+          cell_check_supers(&cells[k], NULL, NULL, NULL, with_hydro, with_grav))
+        continue;
+      if (e->verbose)
+        message("The super-cells of the kept cells moved, re-building all the "
+                "tasks.");
+      engine_drop_kept_tasks(e);
+      engine_maketasks(e);
+      return;
+    }
+  }
+
   tic2 = getticks();
 
   /* Re-set the tag counter. MPI tags are defined for top-level cells in
@@ -3007,10 +3251,16 @@ void engine_maketasks(struct engine *e) {
     message("Setting super-pointers took %.3f %s.",
             clocks_from_ticks(getticks() - tic2), clocks_getunit());
 
+  tic2 = getticks();
+
   /* Append hierarchical tasks to each cell. */
   threadpool_map(&e->threadpool, engine_make_hierarchical_tasks_mapper, cells,
                  nr_cells, sizeof(struct cell), 0, e);
 
+  if (e->verbose)
+    message("Making hierarchical tasks took %.3f %s.",
+            clocks_from_ticks(getticks() - tic2), clocks_getunit());
+
   tic2 = getticks();
 
   /* Run through the tasks and make force tasks for each density task.
@@ -3018,7 +3268,8 @@ void engine_maketasks(struct engine *e) {
      of its super-cell. */
   if (e->policy & engine_policy_hydro)
     threadpool_map(&e->threadpool, engine_make_extra_hydroloop_tasks_mapper,
-                   sched->tasks, sched->nr_tasks, sizeof(struct task), 0, e);
+                   &sched->tasks[first], sched->nr_tasks - first,
+                   sizeof(struct task), 0, e);
 
   if (e->verbose)
     message("Making extra hydroloop tasks took %.3f %s.",
@@ -3028,7 +3279,7 @@ void engine_maketasks(struct engine *e) {
 
   /* Add the dependencies for the gravity stuff */
   if (e->policy & (engine_policy_self_gravity | engine_policy_external_gravity))
-    engine_link_gravity_tasks(e);
+    engine_link_gravity_tasks(e, first);
 
   if (e->verbose)
     message("Linking gravity tasks took %.3f %s.",
@@ -3129,6 +3380,9 @@ void engine_maketasks(struct engine *e) {
         e->sched.nr_tasks, e->sched.size,
         (float)e->sched.nr_tasks / (float)e->sched.size,
         e->sched.size * sizeof(struct task) / (1024 * 1024));
+  if (e->verbose && first > 0)
+    message("Nr. of tasks created: %d, after the %d kept or emptied ones.",
+            e->sched.nr_tasks - first, first);
 
   /* Report the number of links we actually used */
   if (e->verbose)
@@ -418,6 +418,18 @@ void engine_marktasks_mapper(void *map_data, int num_elements,
 
           if (cj_nodeID == nodeID) cell_activate_drift_part(cj, s);
           if (cj_nodeID == nodeID) cell_activate_drift_bpart(cj, s);
+
+          /* The BHs use the sorts of the local gas they interact with. */
+          if (ci_active_black_holes && cj_nodeID == nodeID) {
+            atomic_or(&cj->hydro.requires_sorts, 1 << t->flags);
+            cj->hydro.dx_max_sort_old = cj->hydro.dx_max_sort;
+            cell_activate_hydro_sorts(cj, t->flags, s);
+          }
+          if (cj_active_black_holes && ci_nodeID == nodeID) {
+            atomic_or(&ci->hydro.requires_sorts, 1 << t->flags);
+            ci->hydro.dx_max_sort_old = ci->hydro.dx_max_sort;
+            cell_activate_hydro_sorts(ci, t->flags, s);
+          }
         }
 
         /* Store current values of dx_max and h_max. */
@@ -451,7 +463,10 @@ void engine_marktasks_mapper(void *map_data, int num_elements,
       if (t_subtype == task_subtype_density) {
 
         /* Too much particle movement? */
-        if (cell_need_rebuild_for_hydro_pair(ci, cj)) *rebuild_space = 1;
+        if (cell_need_rebuild_for_hydro_pair(ci, cj)) {
+          *rebuild_space = 1;
+          cell_flag_pair_for_rebuild(ci, cj);
+        }
 
 #ifdef WITH_MPI
         /* Activate the send/recv tasks. */
@@ -581,8 +596,14 @@ void engine_marktasks_mapper(void *map_data, int num_elements,
       else if (t->subtype == task_subtype_stars_density) {
 
         /* Too much particle movement? */
-        if (cell_need_rebuild_for_stars_pair(ci, cj)) *rebuild_space = 1;
-        if (cell_need_rebuild_for_stars_pair(cj, ci)) *rebuild_space = 1;
+        if (cell_need_rebuild_for_stars_pair(ci, cj)) {
+          *rebuild_space = 1;
+          cell_flag_pair_for_rebuild(ci, cj);
+        }
+        if (cell_need_rebuild_for_stars_pair(cj, ci)) {
+          *rebuild_space = 1;
+          cell_flag_pair_for_rebuild(ci, cj);
+        }
 
 #ifdef WITH_MPI
         /* Activate the send/recv tasks. */
@@ -660,8 +681,14 @@ void engine_marktasks_mapper(void *map_data, int num_elements,
       else if (t->subtype == task_subtype_bh_density) {
 
         /* Too much particle movement? */
-        if (cell_need_rebuild_for_black_holes_pair(ci, cj)) *rebuild_space = 1;
-        if (cell_need_rebuild_for_black_holes_pair(cj, ci)) *rebuild_space = 1;
+        if (cell_need_rebuild_for_black_holes_pair(ci, cj)) {
+          *rebuild_space = 1;
+          cell_flag_pair_for_rebuild(ci, cj);
+        }
+        if (cell_need_rebuild_for_black_holes_pair(cj, ci)) {
+          *rebuild_space = 1;
+          cell_flag_pair_for_rebuild(ci, cj);
+        }
 
         scheduler_activate(s, ci->hydro.super->black_holes.swallow_ghost[0]);
         scheduler_activate(s, cj->hydro.super->black_holes.swallow_ghost[0]);
@@ -902,7 +929,8 @@ void engine_marktasks_mapper(void *map_data, int num_elements,
     }
 
     /* Time-step? */
-    else if (t_type == task_type_timestep) {
+    else if (t_type == task_type_timestep ||
+             t_type == task_type_kick_timestep) {
       t->ci->hydro.updated = 0;
       t->ci->grav.updated = 0;
       t->ci->stars.updated = 0;
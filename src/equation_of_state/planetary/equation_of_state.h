@@ -38,6 +38,7 @@
 #include "adiabatic_index.h"
 #include "common_io.h"
 #include "inline.h"
+#include "minmax.h"
 #include "physical_constants.h"
 #include "restart.h"
 #include "units.h"
@@ -114,6 +115,11 @@ enum eos_planetary_material_id {
       eos_planetary_type_SESAME * eos_planetary_type_factor + 3,
 };
 
+/*! Number of materials of each type (i.e. the number of unit IDs) */
+#define eos_planetary_Til_num_materials 3
+#define eos_planetary_HM80_num_materials 3
+#define eos_planetary_SESAME_num_materials 4
+
 /* Individual EOS function headers. */
 #include "hm80.h"
 #include "sesame.h"
@@ -123,11 +129,69 @@ enum eos_planetary_material_id {
  * @brief The parameters of the equation of state.
  */
 struct eos_parameters {
-  struct Til_params Til_iron, Til_granite, Til_water;
-  struct HM80_params HM80_HHe, HM80_ice, HM80_rock;
-  struct SESAME_params SESAME_iron, SESAME_basalt, SESAME_water, SS08_water;
+
+  /*! Tillotson materials, indexed by unit ID */
+  struct Til_params Til[eos_planetary_Til_num_materials];
+
+  /*! Hubbard & MacFarlane (1980) materials, indexed by unit ID */
+  struct HM80_params HM80[eos_planetary_HM80_num_materials];
+
+  /*! SESAME materials, indexed by unit ID */
+  struct SESAME_params SESAME[eos_planetary_SESAME_num_materials];
 };
 
+/**
+ * @brief Returns the unit ID of a material, i.e. its index within its type.
+ *
+ * @param mat_id The #eos_planetary_material_id.
+ */
+__attribute__((always_inline)) INLINE static int eos_planetary_unit_id(
+    enum eos_planetary_material_id mat_id) {
+  return mat_id % eos_planetary_type_factor;
+}
+
+/**
+ * @brief Returns the parameters of a Tillotson material.
+ *
+ * @param mat_id The #eos_planetary_material_id.
+ */
+__attribute__((always_inline)) INLINE static const struct Til_params *
+eos_planetary_Til_params(enum eos_planetary_material_id mat_id) {
+
+  const int unit_id = eos_planetary_unit_id(mat_id);
+  if (unit_id >= eos_planetary_Til_num_materials)
+    error("Unknown material ID! mat_id = %d", mat_id);
+  return &eos.Til[unit_id];
+}
+
+/**
+ * @brief Returns the parameters of a Hubbard & MacFarlane (1980) material.
+ *
+ * @param mat_id The #eos_planetary_material_id.
+ */
+__attribute__((always_inline)) INLINE static const struct HM80_params *
+eos_planetary_HM80_params(enum eos_planetary_material_id mat_id) {
+
+  const int unit_id = eos_planetary_unit_id(mat_id);
+  if (unit_id >= eos_planetary_HM80_num_materials)
+    error("Unknown material ID! mat_id = %d", mat_id);
+  return &eos.HM80[unit_id];
+}
+
+/**
+ * @brief Returns the parameters of a SESAME material.
+ *
+ * @param mat_id The #eos_planetary_material_id.
+ */
+__attribute__((always_inline)) INLINE static const struct SESAME_params *
+eos_planetary_SESAME_params(enum eos_planetary_material_id mat_id) {
+
+  const int unit_id = eos_planetary_unit_id(mat_id);
+  if (unit_id >= eos_planetary_SESAME_num_materials)
+    error("Unknown material ID! mat_id = %d", mat_id);
+  return &eos.SESAME[unit_id];
+}
+
 /**
  * @brief Returns the internal energy given density and entropy
  *
@@ -141,91 +205,23 @@ gas_internal_energy_from_entropy(float density, float entropy,
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_internal_energy_from_entropy(density, entropy,
-                                                  &eos.Til_iron);
-          break;
-
-        case eos_planetary_id_Til_granite:
-          return Til_internal_energy_from_entropy(density, entropy,
-                                                  &eos.Til_granite);
-          break;
-
-        case eos_planetary_id_Til_water:
-          return Til_internal_energy_from_entropy(density, entropy,
-                                                  &eos.Til_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return Til_internal_energy_from_entropy(
+          density, entropy, eos_planetary_Til_params(mat_id));
 
     /* Hubbard & MacFarlane (1980) EoS */
     case eos_planetary_type_HM80:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_internal_energy_from_entropy(density, entropy,
-                                                   &eos.HM80_HHe);
-          break;
-
-        case eos_planetary_id_HM80_ice:
-          return HM80_internal_energy_from_entropy(density, entropy,
-                                                   &eos.HM80_ice);
-          break;
-
-        case eos_planetary_id_HM80_rock:
-          return HM80_internal_energy_from_entropy(density, entropy,
-                                                   &eos.HM80_rock);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return HM80_internal_energy_from_entropy(
+          density, entropy, eos_planetary_HM80_params(mat_id));
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_internal_energy_from_entropy(density, entropy,
-                                                     &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_internal_energy_from_entropy(density, entropy,
-                                                     &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_internal_energy_from_entropy(density, entropy,
-                                                     &eos.SESAME_water);
-          break;
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_internal_energy_from_entropy(density, entropy,
-                                                     &eos.SS08_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+    case eos_planetary_type_SESAME:
+      return SESAME_internal_energy_from_entropy(
+          density, entropy, eos_planetary_SESAME_params(mat_id));
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
@@ -245,85 +241,23 @@ __attribute__((always_inline)) INLINE static float gas_pressure_from_entropy(
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_pressure_from_entropy(density, entropy, &eos.Til_iron);
-          break;
-
-        case eos_planetary_id_Til_granite:
-          return Til_pressure_from_entropy(density, entropy, &eos.Til_granite);
-          break;
-
-        case eos_planetary_id_Til_water:
-          return Til_pressure_from_entropy(density, entropy, &eos.Til_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return Til_pressure_from_entropy(
+          density, entropy, eos_planetary_Til_params(mat_id));
 
     /* Hubbard & MacFarlane (1980) EoS */
     case eos_planetary_type_HM80:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_pressure_from_entropy(density, entropy, &eos.HM80_HHe);
-          break;
-
-        case eos_planetary_id_HM80_ice:
-          return HM80_pressure_from_entropy(density, entropy, &eos.HM80_ice);
-          break;
-
-        case eos_planetary_id_HM80_rock:
-          return HM80_pressure_from_entropy(density, entropy, &eos.HM80_rock);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return HM80_pressure_from_entropy(
+          density, entropy, eos_planetary_HM80_params(mat_id));
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_pressure_from_entropy(density, entropy,
-                                              &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_pressure_from_entropy(density, entropy,
-                                              &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_pressure_from_entropy(density, entropy,
-                                              &eos.SESAME_water);
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_pressure_from_entropy(density, entropy,
-                                              &eos.SS08_water);
-          break;
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+    case eos_planetary_type_SESAME:
+      return SESAME_pressure_from_entropy(
+          density, entropy, eos_planetary_SESAME_params(mat_id));
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
@@ -344,81 +278,23 @@ __attribute__((always_inline)) INLINE static float gas_entropy_from_pressure(
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_entropy_from_pressure(density, P, &eos.Til_iron);
-          break;
-
-        case eos_planetary_id_Til_granite:
-          return Til_entropy_from_pressure(density, P, &eos.Til_granite);
-          break;
-
-        case eos_planetary_id_Til_water:
-          return Til_entropy_from_pressure(density, P, &eos.Til_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return Til_entropy_from_pressure(
+          density, P, eos_planetary_Til_params(mat_id));
 
     /* Hubbard & MacFarlane (1980) EoS */
     case eos_planetary_type_HM80:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_entropy_from_pressure(density, P, &eos.HM80_HHe);
-          break;
-
-        case eos_planetary_id_HM80_ice:
-          return HM80_entropy_from_pressure(density, P, &eos.HM80_ice);
-          break;
-
-        case eos_planetary_id_HM80_rock:
-          return HM80_entropy_from_pressure(density, P, &eos.HM80_rock);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return HM80_entropy_from_pressure(
+          density, P, eos_planetary_HM80_params(mat_id));
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_entropy_from_pressure(density, P, &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_entropy_from_pressure(density, P, &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_entropy_from_pressure(density, P, &eos.SESAME_water);
-          break;
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_entropy_from_pressure(density, P, &eos.SS08_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+    case eos_planetary_type_SESAME:
+      return SESAME_entropy_from_pressure(
+          density, P, eos_planetary_SESAME_params(mat_id));
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
@@ -438,86 +314,23 @@ __attribute__((always_inline)) INLINE static float gas_soundspeed_from_entropy(
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_soundspeed_from_entropy(density, entropy, &eos.Til_iron);
-          break;
-
-        case eos_planetary_id_Til_granite:
-          return Til_soundspeed_from_entropy(density, entropy,
-                                             &eos.Til_granite);
-          break;
-
-        case eos_planetary_id_Til_water:
-          return Til_soundspeed_from_entropy(density, entropy, &eos.Til_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return Til_soundspeed_from_entropy(
+          density, entropy, eos_planetary_Til_params(mat_id));
 
     /* Hubbard & MacFarlane (1980) EoS */
     case eos_planetary_type_HM80:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_soundspeed_from_entropy(density, entropy, &eos.HM80_HHe);
-          break;
-
-        case eos_planetary_id_HM80_ice:
-          return HM80_soundspeed_from_entropy(density, entropy, &eos.HM80_ice);
-          break;
-
-        case eos_planetary_id_HM80_rock:
-          return HM80_soundspeed_from_entropy(density, entropy, &eos.HM80_rock);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return HM80_soundspeed_from_entropy(
+          density, entropy, eos_planetary_HM80_params(mat_id));
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_soundspeed_from_entropy(density, entropy,
-                                                &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_soundspeed_from_entropy(density, entropy,
-                                                &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_soundspeed_from_entropy(density, entropy,
-                                                &eos.SESAME_water);
-          break;
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_soundspeed_from_entropy(density, entropy,
-                                                &eos.SS08_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+    case eos_planetary_type_SESAME:
+      return SESAME_soundspeed_from_entropy(
+          density, entropy, eos_planetary_SESAME_params(mat_id));
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
@@ -537,85 +350,23 @@ gas_entropy_from_internal_energy(float density, float u,
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_entropy_from_internal_energy(density, u, &eos.Til_iron);
-          break;
-
-        case eos_planetary_id_Til_granite:
-          return Til_entropy_from_internal_energy(density, u, &eos.Til_granite);
-          break;
-
-        case eos_planetary_id_Til_water:
-          return Til_entropy_from_internal_energy(density, u, &eos.Til_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return Til_entropy_from_internal_energy(
+          density, u, eos_planetary_Til_params(mat_id));
 
     /* Hubbard & MacFarlane (1980) EoS */
     case eos_planetary_type_HM80:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_entropy_from_internal_energy(density, u, &eos.HM80_HHe);
-          break;
-
-        case eos_planetary_id_HM80_ice:
-          return HM80_entropy_from_internal_energy(density, u, &eos.HM80_ice);
-          break;
-
-        case eos_planetary_id_HM80_rock:
-          return HM80_entropy_from_internal_energy(density, u, &eos.HM80_rock);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return HM80_entropy_from_internal_energy(
+          density, u, eos_planetary_HM80_params(mat_id));
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_entropy_from_internal_energy(density, u,
-                                                     &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_entropy_from_internal_energy(density, u,
-                                                     &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_entropy_from_internal_energy(density, u,
-                                                     &eos.SESAME_water);
-          break;
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_entropy_from_internal_energy(density, u,
-                                                     &eos.SS08_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+    case eos_planetary_type_SESAME:
+      return SESAME_entropy_from_internal_energy(
+          density, u, eos_planetary_SESAME_params(mat_id));
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
@@ -636,86 +387,23 @@ gas_pressure_from_internal_energy(float density, float u,
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_pressure_from_internal_energy(density, u, &eos.Til_iron);
-          break;
-
-        case eos_planetary_id_Til_granite:
-          return Til_pressure_from_internal_energy(density, u,
-                                                   &eos.Til_granite);
-          break;
-
-        case eos_planetary_id_Til_water:
-          return Til_pressure_from_internal_energy(density, u, &eos.Til_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return Til_pressure_from_internal_energy(
+          density, u, eos_planetary_Til_params(mat_id));
 
     /* Hubbard & MacFarlane (1980) EoS */
     case eos_planetary_type_HM80:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_pressure_from_internal_energy(density, u, &eos.HM80_HHe);
-          break;
-
-        case eos_planetary_id_HM80_ice:
-          return HM80_pressure_from_internal_energy(density, u, &eos.HM80_ice);
-          break;
-
-        case eos_planetary_id_HM80_rock:
-          return HM80_pressure_from_internal_energy(density, u, &eos.HM80_rock);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return HM80_pressure_from_internal_energy(
+          density, u, eos_planetary_HM80_params(mat_id));
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_pressure_from_internal_energy(density, u,
-                                                      &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_pressure_from_internal_energy(density, u,
-                                                      &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_pressure_from_internal_energy(density, u,
-                                                      &eos.SESAME_water);
-          break;
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_pressure_from_internal_energy(density, u,
-                                                      &eos.SS08_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+    case eos_planetary_type_SESAME:
+      return SESAME_pressure_from_internal_energy(
+          density, u, eos_planetary_SESAME_params(mat_id));
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
@@ -739,86 +427,23 @@ gas_internal_energy_from_pressure(float density, float P,
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_internal_energy_from_pressure(density, P, &eos.Til_iron);
-          break;
-
-        case eos_planetary_id_Til_granite:
-          return Til_internal_energy_from_pressure(density, P,
-                                                   &eos.Til_granite);
-          break;
-
-        case eos_planetary_id_Til_water:
-          return Til_internal_energy_from_pressure(density, P, &eos.Til_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return Til_internal_energy_from_pressure(
+          density, P, eos_planetary_Til_params(mat_id));
 
     /* Hubbard & MacFarlane (1980) EoS */
     case eos_planetary_type_HM80:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_internal_energy_from_pressure(density, P, &eos.HM80_HHe);
-          break;
-
-        case eos_planetary_id_HM80_ice:
-          return HM80_internal_energy_from_pressure(density, P, &eos.HM80_ice);
-          break;
-
-        case eos_planetary_id_HM80_rock:
-          return HM80_internal_energy_from_pressure(density, P, &eos.HM80_rock);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return HM80_internal_energy_from_pressure(
+          density, P, eos_planetary_HM80_params(mat_id));
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_internal_energy_from_pressure(density, P,
-                                                      &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_internal_energy_from_pressure(density, P,
-                                                      &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_internal_energy_from_pressure(density, P,
-                                                      &eos.SESAME_water);
-          break;
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_internal_energy_from_pressure(density, P,
-                                                      &eos.SS08_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+    case eos_planetary_type_SESAME:
+      return SESAME_internal_energy_from_pressure(
+          density, P, eos_planetary_SESAME_params(mat_id));
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
@@ -839,90 +464,23 @@ gas_soundspeed_from_internal_energy(float density, float u,
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_soundspeed_from_internal_energy(density, u, &eos.Til_iron);
-          break;
-
-        case eos_planetary_id_Til_granite:
-          return Til_soundspeed_from_internal_energy(density, u,
-                                                     &eos.Til_granite);
-          break;
-
-        case eos_planetary_id_Til_water:
-          return Til_soundspeed_from_internal_energy(density, u,
-                                                     &eos.Til_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return Til_soundspeed_from_internal_energy(
+          density, u, eos_planetary_Til_params(mat_id));
 
     /* Hubbard & MacFarlane (1980) EoS */
     case eos_planetary_type_HM80:
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_soundspeed_from_internal_energy(density, u,
-                                                      &eos.HM80_HHe);
-          break;
-
-        case eos_planetary_id_HM80_ice:
-          return HM80_soundspeed_from_internal_energy(density, u,
-                                                      &eos.HM80_ice);
-          break;
-
-        case eos_planetary_id_HM80_rock:
-          return HM80_soundspeed_from_internal_energy(density, u,
-                                                      &eos.HM80_rock);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+      return HM80_soundspeed_from_internal_energy(
+          density, u, eos_planetary_HM80_params(mat_id));
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_soundspeed_from_internal_energy(density, u,
-                                                        &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_soundspeed_from_internal_energy(density, u,
-                                                        &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_soundspeed_from_internal_energy(density, u,
-                                                        &eos.SESAME_water);
-          break;
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_soundspeed_from_internal_energy(density, u,
-                                                        &eos.SS08_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+    case eos_planetary_type_SESAME:
+      return SESAME_soundspeed_from_internal_energy(
+          density, u, eos_planetary_SESAME_params(mat_id));
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
@@ -942,89 +500,204 @@ __attribute__((always_inline)) INLINE static float gas_soundspeed_from_pressure(
   const enum eos_planetary_type_id type =
       (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-  /* Select the material base type */
+  /* Select the material base type and look up the material's parameters */
   switch (type) {
 
     /* Tillotson EoS */
     case eos_planetary_type_Til:
+      return Til_soundspeed_from_pressure(
+          density, P, eos_planetary_Til_params(mat_id));
 
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_Til_iron:
-          return Til_soundspeed_from_pressure(density, P, &eos.Til_iron);
-          break;
+    /* Hubbard & MacFarlane (1980) EoS */
+    case eos_planetary_type_HM80:
+      return HM80_soundspeed_from_pressure(
+          density, P, eos_planetary_HM80_params(mat_id));
 
-        case eos_planetary_id_Til_granite:
-          return Til_soundspeed_from_pressure(density, P, &eos.Til_granite);
-          break;
+    /* SESAME EoS */
+    case eos_planetary_type_SESAME:
+      return SESAME_soundspeed_from_pressure(
+          density, P, eos_planetary_SESAME_params(mat_id));
 
-        case eos_planetary_id_Til_water:
-          return Til_soundspeed_from_pressure(density, P, &eos.Til_water);
-          break;
+    default:
+      error("Unknown material type! mat_id = %d", mat_id);
+      return 0.f;
+  }
+}
 
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
-      break;
+/*! Quantities that can be evaluated for arrays of particles */
+enum eos_planetary_array_quantity {
+  eos_planetary_array_pressure,
+  eos_planetary_array_soundspeed
+};
 
-    /* Hubbard & MacFarlane (1980) EoS */
-    case eos_planetary_type_HM80:
+/*! Number of particles grouped by material at a time in the array functions */
+#define eos_planetary_array_batch_size 128
 
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_HM80_HHe:
-          return HM80_soundspeed_from_pressure(density, P, &eos.HM80_HHe);
-          break;
+/**
+ * @brief Evaluates a quantity for an array of particles of the same material.
+ *
+ * The material type and parameters are only looked up once, such that the
+ * loop only contains the table look-ups and interpolations.
+ *
+ * @param q The #eos_planetary_array_quantity to evaluate.
+ * @param mat_id The #eos_planetary_material_id of all the particles.
+ * @param count The number of particles.
+ * @param density The densities \f$\rho\f$.
+ * @param u The internal energies \f$u\f$.
+ * @param out (return) The evaluated quantity.
+ */
+INLINE static void eos_planetary_evaluate_material(
+    const enum eos_planetary_array_quantity q,
+    const enum eos_planetary_material_id mat_id, const int count,
+    const float *restrict density, const float *restrict u,
+    float *restrict out) {
 
-        case eos_planetary_id_HM80_ice:
-          return HM80_soundspeed_from_pressure(density, P, &eos.HM80_ice);
-          break;
+  const enum eos_planetary_type_id type =
+      (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
 
-        case eos_planetary_id_HM80_rock:
-          return HM80_soundspeed_from_pressure(density, P, &eos.HM80_rock);
-          break;
+  switch (type) {
+
+    /* Tillotson EoS */
+    case eos_planetary_type_Til: {
+      const struct Til_params *mat = eos_planetary_Til_params(mat_id);
+      if (q == eos_planetary_array_pressure)
+        for (int i = 0; i < count; ++i)
+          out[i] = Til_pressure_from_internal_energy(density[i], u[i], mat);
+      else
+        for (int i = 0; i < count; ++i)
+          out[i] = Til_soundspeed_from_internal_energy(density[i], u[i], mat);
+      break;
+    }
 
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
+    /* Hubbard & MacFarlane (1980) EoS */
+    case eos_planetary_type_HM80: {
+      const struct HM80_params *mat = eos_planetary_HM80_params(mat_id);
+      if (q == eos_planetary_array_pressure)
+        for (int i = 0; i < count; ++i)
+          out[i] = HM80_pressure_from_internal_energy(density[i], u[i], mat);
+      else
+        for (int i = 0; i < count; ++i)
+          out[i] = HM80_soundspeed_from_internal_energy(density[i], u[i], mat);
       break;
+    }
 
     /* SESAME EoS */
-    case eos_planetary_type_SESAME:;
-
-      /* Select the material */
-      switch (mat_id) {
-        case eos_planetary_id_SESAME_iron:
-          return SESAME_soundspeed_from_pressure(density, P, &eos.SESAME_iron);
-          break;
-
-        case eos_planetary_id_SESAME_basalt:
-          return SESAME_soundspeed_from_pressure(density, P,
-                                                 &eos.SESAME_basalt);
-          break;
-
-        case eos_planetary_id_SESAME_water:
-          return SESAME_soundspeed_from_pressure(density, P, &eos.SESAME_water);
-          break;
-
-        case eos_planetary_id_SS08_water:
-          return SESAME_soundspeed_from_pressure(density, P, &eos.SS08_water);
-          break;
-
-        default:
-          error("Unknown material ID! mat_id = %d", mat_id);
-          return 0.f;
-      };
+    case eos_planetary_type_SESAME: {
+      const struct SESAME_params *mat = eos_planetary_SESAME_params(mat_id);
+      if (q == eos_planetary_array_pressure)
+        for (int i = 0; i < count; ++i)
+          out[i] = SESAME_pressure_from_internal_energy(density[i], u[i], mat);
+      else
+        for (int i = 0; i < count; ++i)
+          out[i] =
+              SESAME_soundspeed_from_internal_energy(density[i], u[i], mat);
       break;
+    }
 
     default:
       error("Unknown material type! mat_id = %d", mat_id);
-      return 0.f;
   }
 }
 
+/**
+ * @brief Evaluates a quantity for an array of particles of any materials.
+ *
+ * The particles are processed in batches of #eos_planetary_array_batch_size.
+ * Within a batch, the particles of each material are gathered together,
+ * evaluated in one go and scattered back to their original position.
+ *
+ * @param q The #eos_planetary_array_quantity to evaluate.
+ * @param count The number of particles.
+ * @param density The densities \f$\rho\f$.
+ * @param u The internal energies \f$u\f$.
+ * @param mat_id The #eos_planetary_material_id of the particles.
+ * @param out (return) The evaluated quantity.
+ */
+INLINE static void eos_planetary_evaluate_array(
+    const enum eos_planetary_array_quantity q, const int count,
+    const float *restrict density, const float *restrict u,
+    const enum eos_planetary_material_id *restrict mat_id,
+    float *restrict out) {
+
+  float batch_density[eos_planetary_array_batch_size];
+  float batch_u[eos_planetary_array_batch_size];
+  float batch_out[eos_planetary_array_batch_size];
+  int batch_index[eos_planetary_array_batch_size];
+  char done[eos_planetary_array_batch_size];
+
+  for (int offset = 0; offset < count;
+       offset += eos_planetary_array_batch_size) {
+
+    const int batch_count = min(count - offset, eos_planetary_array_batch_size);
+    for (int i = 0; i < batch_count; ++i) done[i] = 0;
+
+    for (int first = 0; first < batch_count; ++first) {
+      if (done[first]) continue;
+
+      /* Gather all the remaining particles of this material */
+      const enum eos_planetary_material_id id = mat_id[offset + first];
+      int n = 0;
+      for (int i = first; i < batch_count; ++i) {
+        if (!done[i] && mat_id[offset + i] == id) {
+          batch_index[n] = offset + i;
+          batch_density[n] = density[offset + i];
+          batch_u[n] = u[offset + i];
+          done[i] = 1;
+          ++n;
+        }
+      }
+
+      eos_planetary_evaluate_material(q, id, n, batch_density, batch_u,
+                                      batch_out);
+
+      /* Scatter the results back */
+      for (int i = 0; i < n; ++i) out[batch_index[i]] = batch_out[i];
+    }
+  }
+}
+
+/**
+ * @brief Returns the pressure of an array of particles given their density
+ * and internal energy.
+ *
+ * Element i is identical to gas_pressure_from_internal_energy(density[i],
+ * u[i], mat_id[i]).
+ *
+ * @param count The number of particles.
+ * @param density The densities \f$\rho\f$.
+ * @param u The internal energies \f$u\f$.
+ * @param mat_id The #eos_planetary_material_id of the particles.
+ * @param P (return) The pressures.
+ */
+INLINE static void gas_pressure_from_internal_energy_array(
+    const int count, const float *restrict density, const float *restrict u,
+    const enum eos_planetary_material_id *restrict mat_id, float *restrict P) {
+
+  eos_planetary_evaluate_array(eos_planetary_array_pressure, count, density, u,
+                               mat_id, P);
+}
+
+/**
+ * @brief Returns the sound speed of an array of particles given their density
+ * and internal energy.
+ *
+ * Element i is identical to gas_soundspeed_from_internal_energy(density[i],
+ * u[i], mat_id[i]).
+ *
+ * @param count The number of particles.
+ * @param density The densities \f$\rho\f$.
+ * @param u The internal energies \f$u\f$.
+ * @param mat_id The #eos_planetary_material_id of the particles.
+ * @param c (return) The sound speeds.
+ */
+INLINE static void gas_soundspeed_from_internal_energy_array(
+    const int count, const float *restrict density, const float *restrict u,
+    const enum eos_planetary_material_id *restrict mat_id, float *restrict c) {
+
+  eos_planetary_evaluate_array(eos_planetary_array_soundspeed, count, density,
+                               u, mat_id, c);
+}
+
 /**
  * @brief Initialize the eos parameters
  *
@@ -1044,24 +717,46 @@ __attribute__((always_inline)) INLINE static void eos_init(
   char SESAME_water_table_file[PARSER_MAX_LINE_SIZE];
   char SS08_water_table_file[PARSER_MAX_LINE_SIZE];
 
+  // The parameters of each material
+  struct Til_params *Til_iron =
+      &e->Til[eos_planetary_unit_id(eos_planetary_id_Til_iron)];
+  struct Til_params *Til_granite =
+      &e->Til[eos_planetary_unit_id(eos_planetary_id_Til_granite)];
+  struct Til_params *Til_water =
+      &e->Til[eos_planetary_unit_id(eos_planetary_id_Til_water)];
+  struct HM80_params *HM80_HHe =
+      &e->HM80[eos_planetary_unit_id(eos_planetary_id_HM80_HHe)];
+  struct HM80_params *HM80_ice =
+      &e->HM80[eos_planetary_unit_id(eos_planetary_id_HM80_ice)];
+  struct HM80_params *HM80_rock =
+      &e->HM80[eos_planetary_unit_id(eos_planetary_id_HM80_rock)];
+  struct SESAME_params *SESAME_iron =
+      &e->SESAME[eos_planetary_unit_id(eos_planetary_id_SESAME_iron)];
+  struct SESAME_params *SESAME_basalt =
+      &e->SESAME[eos_planetary_unit_id(eos_planetary_id_SESAME_basalt)];
+  struct SESAME_params *SESAME_water =
+      &e->SESAME[eos_planetary_unit_id(eos_planetary_id_SESAME_water)];
+  struct SESAME_params *SS08_water =
+      &e->SESAME[eos_planetary_unit_id(eos_planetary_id_SS08_water)];
+
   // Set the parameters and material IDs, load tables, etc. for each material
   // and convert to internal units
   // Tillotson
   if (parser_get_opt_param_int(params, "EoS:planetary_use_Til", 0)) {
-    set_Til_iron(&e->Til_iron, eos_planetary_id_Til_iron);
-    set_Til_granite(&e->Til_granite, eos_planetary_id_Til_granite);
-    set_Til_water(&e->Til_water, eos_planetary_id_Til_water);
+    set_Til_iron(Til_iron, eos_planetary_id_Til_iron);
+    set_Til_granite(Til_granite, eos_planetary_id_Til_granite);
+    set_Til_water(Til_water, eos_planetary_id_Til_water);
 
-    convert_units_Til(&e->Til_iron, us);
-    convert_units_Til(&e->Til_granite, us);
-    convert_units_Til(&e->Til_water, us);
+    convert_units_Til(Til_iron, us);
+    convert_units_Til(Til_granite, us);
+    convert_units_Til(Til_water, us);
   }
 
   // Hubbard & MacFarlane (1980)
   if (parser_get_opt_param_int(params, "EoS:planetary_use_HM80", 0)) {
-    set_HM80_HHe(&e->HM80_HHe, eos_planetary_id_HM80_HHe);
-    set_HM80_ice(&e->HM80_ice, eos_planetary_id_HM80_ice);
-    set_HM80_rock(&e->HM80_rock, eos_planetary_id_HM80_rock);
+    set_HM80_HHe(HM80_HHe, eos_planetary_id_HM80_HHe);
+    set_HM80_ice(HM80_ice, eos_planetary_id_HM80_ice);
+    set_HM80_rock(HM80_rock, eos_planetary_id_HM80_rock);
 
     parser_get_param_string(params, "EoS:planetary_HM80_HHe_table_file",
                             HM80_HHe_table_file);
@@ -1070,25 +765,25 @@ __attribute__((always_inline)) INLINE static void eos_init(
     parser_get_param_string(params, "EoS:planetary_HM80_rock_table_file",
                             HM80_rock_table_file);
 
-    load_table_HM80(&e->HM80_HHe, HM80_HHe_table_file);
-    load_table_HM80(&e->HM80_ice, HM80_ice_table_file);
-    load_table_HM80(&e->HM80_rock, HM80_rock_table_file);
+    load_table_HM80(HM80_HHe, HM80_HHe_table_file);
+    load_table_HM80(HM80_ice, HM80_ice_table_file);
+    load_table_HM80(HM80_rock, HM80_rock_table_file);
 
-    prepare_table_HM80(&e->HM80_HHe);
-    prepare_table_HM80(&e->HM80_ice);
-    prepare_table_HM80(&e->HM80_rock);
+    prepare_table_HM80(HM80_HHe);
+    prepare_table_HM80(HM80_ice);
+    prepare_table_HM80(HM80_rock);
 
-    convert_units_HM80(&e->HM80_HHe, us);
-    convert_units_HM80(&e->HM80_ice, us);
-    convert_units_HM80(&e->HM80_rock, us);
+    convert_units_HM80(HM80_HHe, us);
+    convert_units_HM80(HM80_ice, us);
+    convert_units_HM80(HM80_rock, us);
   }
 
   // SESAME
   if (parser_get_opt_param_int(params, "EoS:planetary_use_SESAME", 0)) {
-    set_SESAME_iron(&e->SESAME_iron, eos_planetary_id_SESAME_iron);
-    set_SESAME_basalt(&e->SESAME_basalt, eos_planetary_id_SESAME_basalt);
-    set_SESAME_water(&e->SESAME_water, eos_planetary_id_SESAME_water);
-    set_SS08_water(&e->SESAME_water, eos_planetary_id_SS08_water);
+    set_SESAME_iron(SESAME_iron, eos_planetary_id_SESAME_iron);
+    set_SESAME_basalt(SESAME_basalt, eos_planetary_id_SESAME_basalt);
+    set_SESAME_water(SESAME_water, eos_planetary_id_SESAME_water);
+    set_SS08_water(SS08_water, eos_planetary_id_SS08_water);
 
     parser_get_param_string(params, "EoS:planetary_SESAME_iron_table_file",
                             SESAME_iron_table_file);
@@ -1099,20 +794,25 @@ __attribute__((always_inline)) INLINE static void eos_init(
     parser_get_param_string(params, "EoS:planetary_SS08_water_table_file",
                             SS08_water_table_file);
 
-    load_table_SESAME(&e->SESAME_iron, SESAME_iron_table_file);
-    load_table_SESAME(&e->SESAME_basalt, SESAME_basalt_table_file);
-    load_table_SESAME(&e->SESAME_water, SESAME_water_table_file);
-    load_table_SESAME(&e->SS08_water, SS08_water_table_file);
-
-    prepare_table_SESAME(&e->SESAME_iron);
-    prepare_table_SESAME(&e->SESAME_basalt);
-    prepare_table_SESAME(&e->SESAME_water);
-    prepare_table_SESAME(&e->SS08_water);
-
-    convert_units_SESAME(&e->SESAME_iron, us);
-    convert_units_SESAME(&e->SESAME_basalt, us);
-    convert_units_SESAME(&e->SESAME_water, us);
-    convert_units_SESAME(&e->SS08_water, us);
+    load_table_SESAME(SESAME_iron, SESAME_iron_table_file);
+    load_table_SESAME(SESAME_basalt, SESAME_basalt_table_file);
+    load_table_SESAME(SESAME_water, SESAME_water_table_file);
+    load_table_SESAME(SS08_water, SS08_water_table_file);
+
+    prepare_table_SESAME(SESAME_iron);
+    prepare_table_SESAME(SESAME_basalt);
+    prepare_table_SESAME(SESAME_water);
+    prepare_table_SESAME(SS08_water);
+
+    convert_units_SESAME(SESAME_iron, us);
+    convert_units_SESAME(SESAME_basalt, us);
+    convert_units_SESAME(SESAME_water, us);
+    convert_units_SESAME(SS08_water, us);
+
+    prepare_grid_SESAME(SESAME_iron);
+    prepare_grid_SESAME(SESAME_basalt);
+    prepare_grid_SESAME(SESAME_water);
+    prepare_grid_SESAME(SS08_water);
   }
 }
 
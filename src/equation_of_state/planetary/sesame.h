@@ -52,8 +52,18 @@ struct SESAME_params {
   int num_rho, num_T;
   float P_tiny, c_tiny;
   enum eos_planetary_material_id mat_id;
+
+  // Uniform grids in log(rho) and, at each density, in log(u) of the table
+  // indices, to find the interpolation bins without a binary search
+  int *grid_idx_rho, *grid_idx_u;
+  float *grid_log_u_min, *grid_inv_log_u_step;
+  float grid_log_rho_min, grid_inv_log_rho_step;
+  int num_grid_rho, num_grid_u;
 };
 
+/*! Number of points of the uniform index grids per table entry */
+#define SESAME_grid_points_per_entry 4
+
 // Parameter values for each material (cgs units)
 INLINE static void set_SESAME_iron(struct SESAME_params *mat,
                                    enum eos_planetary_material_id mat_id) {
@@ -252,6 +262,85 @@ INLINE static void convert_units_SESAME(struct SESAME_params *mat,
                  units_cgs_conversion_factor(us, UNIT_CONV_SPEED);
 }
 
+// Build the uniform grids of table indices (once in internal units)
+INLINE static void prepare_grid_SESAME(struct SESAME_params *mat) {
+
+  mat->num_grid_rho = SESAME_grid_points_per_entry * mat->num_rho;
+  mat->num_grid_u = SESAME_grid_points_per_entry * mat->num_T;
+
+  // Allocate grid memory
+  mat->grid_idx_rho = (int *)malloc(mat->num_grid_rho * sizeof(int));
+  mat->grid_idx_u =
+      (int *)malloc(mat->num_rho * mat->num_grid_u * sizeof(int));
+  mat->grid_log_u_min = (float *)malloc(mat->num_rho * sizeof(float));
+  mat->grid_inv_log_u_step = (float *)malloc(mat->num_rho * sizeof(float));
+
+  // Densities
+  init_monot_incr_array_grid(mat->table_log_rho, mat->num_rho,
+                             mat->grid_idx_rho, mat->num_grid_rho,
+                             &mat->grid_log_rho_min,
+                             &mat->grid_inv_log_rho_step);
+
+  // Sp. int. energies at each density
+  for (int i_rho = 0; i_rho < mat->num_rho; i_rho++) {
+    init_monot_incr_array_grid(
+        mat->table_log_u_rho_T + i_rho * mat->num_T, mat->num_T,
+        mat->grid_idx_u + i_rho * mat->num_grid_u, mat->num_grid_u,
+        &mat->grid_log_u_min[i_rho], &mat->grid_inv_log_u_step[i_rho]);
+  }
+}
+
+// Find the table bins and interpolation weights for (log(rho), log(u))
+INLINE static void SESAME_find_bins(const float log_rho, const float log_u,
+                                    const struct SESAME_params *mat,
+                                    int *idx_rho, int *idx_u_1, int *idx_u_2,
+                                    float *intp_rho, float *intp_u_1,
+                                    float *intp_u_2) {
+
+  // Density index
+  *idx_rho = find_value_in_monot_incr_array_grid(
+      log_rho, mat->table_log_rho, mat->num_rho, mat->grid_idx_rho,
+      mat->num_grid_rho, mat->grid_log_rho_min, mat->grid_inv_log_rho_step);
+
+  // If outside the table then extrapolate from the edge and edge-but-one values
+  if (*idx_rho <= -1) {
+    *idx_rho = 0;
+  } else if (*idx_rho >= mat->num_rho) {
+    *idx_rho = mat->num_rho - 2;
+  }
+
+  // Sp. int. energy at this and the next density (in relevant slice of u array)
+  const int i_rho_1 = *idx_rho, i_rho_2 = *idx_rho + 1;
+  const float *log_u_1 = mat->table_log_u_rho_T + i_rho_1 * mat->num_T;
+  const float *log_u_2 = mat->table_log_u_rho_T + i_rho_2 * mat->num_T;
+  *idx_u_1 = find_value_in_monot_incr_array_grid(
+      log_u, log_u_1, mat->num_T, mat->grid_idx_u + i_rho_1 * mat->num_grid_u,
+      mat->num_grid_u, mat->grid_log_u_min[i_rho_1],
+      mat->grid_inv_log_u_step[i_rho_1]);
+  *idx_u_2 = find_value_in_monot_incr_array_grid(
+      log_u, log_u_2, mat->num_T, mat->grid_idx_u + i_rho_2 * mat->num_grid_u,
+      mat->num_grid_u, mat->grid_log_u_min[i_rho_2],
+      mat->grid_inv_log_u_step[i_rho_2]);
+
+  if (*idx_u_1 <= -1) {
+    *idx_u_1 = 0;
+  } else if (*idx_u_1 >= mat->num_T) {
+    *idx_u_1 = mat->num_T - 2;
+  }
+  if (*idx_u_2 <= -1) {
+    *idx_u_2 = 0;
+  } else if (*idx_u_2 >= mat->num_T) {
+    *idx_u_2 = mat->num_T - 2;
+  }
+
+  *intp_rho = (log_rho - mat->table_log_rho[*idx_rho]) /
+              (mat->table_log_rho[*idx_rho + 1] - mat->table_log_rho[*idx_rho]);
+  *intp_u_1 = (log_u - log_u_1[*idx_u_1]) /
+              (log_u_1[*idx_u_1 + 1] - log_u_1[*idx_u_1]);
+  *intp_u_2 = (log_u - log_u_2[*idx_u_2]) /
+              (log_u_2[*idx_u_2 + 1] - log_u_2[*idx_u_2]);
+}
+
 // gas_internal_energy_from_entropy
 INLINE static float SESAME_internal_energy_from_entropy(
     float density, float entropy, const struct SESAME_params *mat) {
@@ -311,42 +400,8 @@ INLINE static float SESAME_pressure_from_internal_energy(
   const float log_u = logf(u);
 
   // 2D interpolation (bilinear with log(rho), log(u)) to find P(rho, u)
-  // Density index
-  idx_rho =
-      find_value_in_monot_incr_array(log_rho, mat->table_log_rho, mat->num_rho);
-
-  // Sp. int. energy at this and the next density (in relevant slice of u array)
-  idx_u_1 = find_value_in_monot_incr_array(
-      log_u, mat->table_log_u_rho_T + idx_rho * mat->num_T, mat->num_T);
-  idx_u_2 = find_value_in_monot_incr_array(
-      log_u, mat->table_log_u_rho_T + (idx_rho + 1) * mat->num_T, mat->num_T);
-
-  // If outside the table then extrapolate from the edge and edge-but-one values
-  if (idx_rho <= -1) {
-    idx_rho = 0;
-  } else if (idx_rho >= mat->num_rho) {
-    idx_rho = mat->num_rho - 2;
-  }
-  if (idx_u_1 <= -1) {
-    idx_u_1 = 0;
-  } else if (idx_u_1 >= mat->num_T) {
-    idx_u_1 = mat->num_T - 2;
-  }
-  if (idx_u_2 <= -1) {
-    idx_u_2 = 0;
-  } else if (idx_u_2 >= mat->num_T) {
-    idx_u_2 = mat->num_T - 2;
-  }
-
-  intp_rho = (log_rho - mat->table_log_rho[idx_rho]) /
-             (mat->table_log_rho[idx_rho + 1] - mat->table_log_rho[idx_rho]);
-  intp_u_1 = (log_u - mat->table_log_u_rho_T[idx_rho * mat->num_T + idx_u_1]) /
-             (mat->table_log_u_rho_T[idx_rho * mat->num_T + (idx_u_1 + 1)] -
-              mat->table_log_u_rho_T[idx_rho * mat->num_T + idx_u_1]);
-  intp_u_2 =
-      (log_u - mat->table_log_u_rho_T[(idx_rho + 1) * mat->num_T + idx_u_2]) /
-      (mat->table_log_u_rho_T[(idx_rho + 1) * mat->num_T + (idx_u_2 + 1)] -
-       mat->table_log_u_rho_T[(idx_rho + 1) * mat->num_T + idx_u_2]);
+  SESAME_find_bins(log_rho, log_u, mat, &idx_rho, &idx_u_1, &idx_u_2,
+                   &intp_rho, &intp_u_1, &intp_u_2);
 
   // Table values
   P_1 = mat->table_P_rho_T[idx_rho * mat->num_T + idx_u_1];
@@ -415,42 +470,8 @@ INLINE static float SESAME_soundspeed_from_internal_energy(
   const float log_u = logf(u);
 
   // 2D interpolation (bilinear with log(rho), log(u)) to find c(rho, u)
-  // Density index
-  idx_rho =
-      find_value_in_monot_incr_array(log_rho, mat->table_log_rho, mat->num_rho);
-
-  // Sp. int. energy at this and the next density (in relevant slice of u array)
-  idx_u_1 = find_value_in_monot_incr_array(
-      log_u, mat->table_log_u_rho_T + idx_rho * mat->num_T, mat->num_T);
-  idx_u_2 = find_value_in_monot_incr_array(
-      log_u, mat->table_log_u_rho_T + (idx_rho + 1) * mat->num_T, mat->num_T);
-
-  // If outside the table then extrapolate from the edge and edge-but-one values
-  if (idx_rho <= -1) {
-    idx_rho = 0;
-  } else if (idx_rho >= mat->num_rho) {
-    idx_rho = mat->num_rho - 2;
-  }
-  if (idx_u_1 <= -1) {
-    idx_u_1 = 0;
-  } else if (idx_u_1 >= mat->num_T) {
-    idx_u_1 = mat->num_T - 2;
-  }
-  if (idx_u_2 <= -1) {
-    idx_u_2 = 0;
-  } else if (idx_u_2 >= mat->num_T) {
-    idx_u_2 = mat->num_T - 2;
-  }
-
-  intp_rho = (log_rho - mat->table_log_rho[idx_rho]) /
-             (mat->table_log_rho[idx_rho + 1] - mat->table_log_rho[idx_rho]);
-  intp_u_1 = (log_u - mat->table_log_u_rho_T[idx_rho * mat->num_T + idx_u_1]) /
-             (mat->table_log_u_rho_T[idx_rho * mat->num_T + (idx_u_1 + 1)] -
-              mat->table_log_u_rho_T[idx_rho * mat->num_T + idx_u_1]);
-  intp_u_2 =
-      (log_u - mat->table_log_u_rho_T[(idx_rho + 1) * mat->num_T + idx_u_2]) /
-      (mat->table_log_u_rho_T[(idx_rho + 1) * mat->num_T + (idx_u_2 + 1)] -
-       mat->table_log_u_rho_T[(idx_rho + 1) * mat->num_T + idx_u_2]);
+  SESAME_find_bins(log_rho, log_u, mat, &idx_rho, &idx_u_1, &idx_u_2,
+                   &intp_rho, &intp_u_1, &intp_u_2);
 
   // Table values
   c_1 = mat->table_c_rho_T[idx_rho * mat->num_T + idx_u_1];
@@ -381,26 +381,208 @@ INLINE static void evolve_SNIa(const float log10_min_mass,
 }
 
 /**
- * @brief compute enrichment and feedback due to SNII. To do this, integrate the
- * IMF weighted by the yields read from tables for each of the quantities of
- * interest.
+ * @brief Find the bin and offset of a mass along the (regular) IMF mass axis.
  *
- * Note for Matthieu: This function is poorly written and needs improving.
+ * Masses outside the IMF range are clamped to its edges.
+ *
+ * @param log10_mass log10 of the mass (in solar masses).
+ * @param props The properties of the feedback model.
+ * @param index (return) Index of the IMF mass bin.
+ * @param offset (return) Offset of the mass within the bin.
+ */
+INLINE static void determine_imf_bin_offset(const double log10_mass,
+                                            const struct feedback_props* props,
+                                            int* index, double* offset) {
+
+  const int N_bins = eagle_feedback_N_imf_bins;
+  const float* imf_mass_bin_log10 = props->imf_mass_bin_log10;
+  const double imf_log10_mass_bin_size =
+      imf_mass_bin_log10[1] - imf_mass_bin_log10[0];
+
+  const double u =
+      (log10_mass - imf_mass_bin_log10[0]) / imf_log10_mass_bin_size;
+
+  if (u <= 0.) {
+    *index = 0;
+    *offset = 0.;
+  } else if (u >= N_bins - 1) {
+    *index = N_bins - 2;
+    *offset = 1.;
+  } else {
+    *index = (int)u;
+    *offset = u - *index;
+  }
+}
+
+/**
+ * @brief Integrate the IMF weighted by the yields, total metals and ejecta of
+ * one channel between two masses using the cumulative tables built by
+ * compute_cumulative_yields().
+ *
+ * The quantities are per unit initial stellar mass and do not include the
+ * metals already present in the star.
+ *
+ * @param log10_min_mass log10 of the lower mass bound (in solar masses).
+ * @param log10_max_mass log10 of the upper mass bound (in solar masses).
+ * @param table The #yield_table of the channel.
+ * @param N_metals The number of metallicity bins of the table.
+ * @param iz_low Lower index along the metallicity dimension.
+ * @param iz_high Higher index along the metallicity dimension.
+ * @param dz Offset between the metallicity bins.
+ * @param props The properties of the feedback model.
+ * @param integrals (return) The integrals of each field of the table.
+ */
+INLINE static void integrate_cumulative_yields(
+    const float log10_min_mass, const float log10_max_mass,
+    const struct yield_table* table, const int N_metals, const int iz_low,
+    const int iz_high, const float dz, const struct feedback_props* props,
+    double integrals[eagle_feedback_cumulative_N_fields]) {
+
+  const int N_bins = eagle_feedback_N_imf_bins;
+
+  int i_min, i_max;
+  double offset_min, offset_max;
+  determine_imf_bin_offset(log10_min_mass, props, &i_min, &offset_min);
+  determine_imf_bin_offset(log10_max_mass, props, &i_max, &offset_max);
+
+  for (int f = 0; f < eagle_feedback_cumulative_N_fields; f++) {
+
+    const double* cumulative_low =
+        table->cumulative_IMF_resampled +
+        row_major_index_3d(iz_low, f, 0, N_metals,
+                           eagle_feedback_cumulative_N_fields, N_bins);
+    const double* cumulative_high =
+        table->cumulative_IMF_resampled +
+        row_major_index_3d(iz_high, f, 0, N_metals,
+                           eagle_feedback_cumulative_N_fields, N_bins);
+
+    /* The tables hold the integral from each bin up to the maximal mass */
+    const double integral_low =
+        (1. - offset_min) * cumulative_low[i_min] +
+        offset_min * cumulative_low[i_min + 1] -
+        (1. - offset_max) * cumulative_low[i_max] -
+        offset_max * cumulative_low[i_max + 1];
+    const double integral_high =
+        (1. - offset_min) * cumulative_high[i_min] +
+        offset_min * cumulative_high[i_min + 1] -
+        (1. - offset_max) * cumulative_high[i_max] -
+        offset_max * cumulative_high[i_max + 1];
+
+    integrals[f] = (1. - dz) * integral_low + dz * integral_high;
+  }
+}
+
+/**
+ * @brief Integrate the IMF weighted by the yields, total metals and ejecta of
+ * one channel between two masses by summing over the IMF mass bins.
+ *
+ * This is the direct integration done by integrate_imf(). It is only used to
+ * check the accuracy of integrate_cumulative_yields() at start-up.
+ *
+ * @param log10_min_mass log10 of the lower mass bound (in solar masses).
+ * @param log10_max_mass log10 of the upper mass bound (in solar masses).
+ * @param table The #yield_table of the channel.
+ * @param N_metals The number of metallicity bins of the table.
+ * @param iz_low Lower index along the metallicity dimension.
+ * @param iz_high Higher index along the metallicity dimension.
+ * @param dz Offset between the metallicity bins.
+ * @param props The properties of the feedback model.
+ * @param integrals (return) The integrals of each field of the table.
+ */
+static void integrate_yields(
+    const float log10_min_mass, const float log10_max_mass,
+    const struct yield_table* table, const int N_metals, const int iz_low,
+    const int iz_high, const float dz, const struct feedback_props* props,
+    double integrals[eagle_feedback_cumulative_N_fields]) {
+
+  const int N_bins = eagle_feedback_N_imf_bins;
+  float stellar_yields[eagle_feedback_N_imf_bins];
+
+  int i_min, i_max;
+  determine_imf_bins(log10_min_mass, log10_max_mass, &i_min, &i_max, props);
+
+  for (int f = 0; f < eagle_feedback_cumulative_N_fields; f++) {
+    for (int k = i_min; k < i_max + 1; k++) {
+
+      const int low_index_2d = row_major_index_2d(iz_low, k, N_metals, N_bins);
+      const int high_index_2d =
+          row_major_index_2d(iz_high, k, N_metals, N_bins);
+
+      if (f == eagle_feedback_cumulative_total_metals) {
+        stellar_yields[k] =
+            (1 - dz) * table->total_metals_IMF_resampled[low_index_2d] +
+            dz * table->total_metals_IMF_resampled[high_index_2d];
+      } else if (f == eagle_feedback_cumulative_ejecta) {
+        stellar_yields[k] =
+            (1 - dz) * table->ejecta_IMF_resampled[low_index_2d] +
+            dz * table->ejecta_IMF_resampled[high_index_2d];
+      } else {
+        const int low_index_3d = row_major_index_3d(
+            iz_low, f, k, N_metals, chemistry_element_count, N_bins);
+        const int high_index_3d = row_major_index_3d(
+            iz_high, f, k, N_metals, chemistry_element_count, N_bins);
+        stellar_yields[k] =
+            (1 - dz) * table->yield_IMF_resampled[low_index_3d] +
+            dz * table->yield_IMF_resampled[high_index_3d];
+      }
+    }
+
+    integrals[f] = integrate_imf(log10_min_mass, log10_max_mass,
+                                 eagle_imf_integration_yield_weight,
+                                 stellar_yields, props);
+  }
+}
+
+/**
+ * @brief Compute the mass of each element, of the metals and the total mass
+ * released by a star through one channel from the integrated tables.
+ *
+ * The metals already present in the star are released along with the
+ * ejecta. Negative values are zeroed.
+ *
+ * @param integrals The integrals of each field of the channel's table.
+ * @param sp The #spart we are computing feedback from.
+ * @param metal_mass_released (return) The mass of each element released.
+ * @param metal_mass_released_total (return) The metal mass released.
+ * @param mass_ejected (return) The total mass ejected.
+ */
+INLINE static void compute_mass_released(
+    const double integrals[eagle_feedback_cumulative_N_fields],
+    const struct spart* sp, float metal_mass_released[chemistry_element_count],
+    float* metal_mass_released_total, float* mass_ejected) {
+
+  const double ejecta = integrals[eagle_feedback_cumulative_ejecta];
+
+  /* compute metals produced and zero all negative values */
+  for (int elem = 0; elem < chemistry_element_count; elem++) {
+    const float released =
+        integrals[elem] + sp->chemistry_data.metal_mass_fraction[elem] * ejecta;
+    metal_mass_released[elem] = max(released, 0.f);
+  }
+
+  const float released_total =
+      integrals[eagle_feedback_cumulative_total_metals] +
+      sp->chemistry_data.metal_mass_fraction_total * ejecta;
+  *metal_mass_released_total = max(released_total, 0.f);
+
+  /* total mass ejected from the star */
+  *mass_ejected = ejecta;
+}
+
+/**
+ * @brief compute enrichment and feedback due to SNII. To do this, take the
+ * difference of the IMF-weighted yields tabulated at the two masses bounding
+ * the stars that died during the step.
  *
  * @param log10_min_mass log10 mass at the end of step
  * @param log10_max_mass log10 mass at the beginning of step
- * @param stellar_yields array to store calculated yields for passing to
- * integrate_imf
  * @param props properties of the feedback model.
  * @param sp spart we are computing feedback from
  */
 INLINE static void evolve_SNII(float log10_min_mass, float log10_max_mass,
-                               float* stellar_yields,
                                const struct feedback_props* props,
                                struct spart* sp) {
 
-  int low_imf_mass_bin_index, high_imf_mass_bin_index, mass_bin_index;
-
   /* If mass at beginning of step is less than tabulated lower bound for IMF,
    * limit it.*/
   if (log10_min_mass < props->log10_SNII_min_mass_msun)
@@ -415,103 +597,29 @@ INLINE static void evolve_SNII(float log10_min_mass, float log10_max_mass,
    * step */
   if (log10_min_mass >= log10_max_mass) return;
 
-  /* determine which IMF mass bins contribute to the integral */
-  determine_imf_bins(log10_min_mass, log10_max_mass, &low_imf_mass_bin_index,
-                     &high_imf_mass_bin_index, props);
-
   /* determine which metallicity bin and offset this star belongs to */
-  int iz_low = 0, iz_high = 0, low_index_3d, high_index_3d, low_index_2d,
-      high_index_2d;
+  int iz_low = 0, iz_high = 0;
   float dz = 0.;
   determine_bin_yield_SNII(&iz_low, &iz_high, &dz,
                            log10(sp->chemistry_data.metal_mass_fraction_total),
                            props);
 
+  /* Integrate the IMF-weighted yields over the range of dying masses */
+  double integrals[eagle_feedback_cumulative_N_fields];
+  integrate_cumulative_yields(log10_min_mass, log10_max_mass,
+                              &props->yield_SNII, eagle_feedback_SNII_N_metals,
+                              iz_low, iz_high, dz, props, integrals);
+
   /* compute metals produced */
   float metal_mass_released[chemistry_element_count], metal_mass_released_total;
-  for (int elem = 0; elem < chemistry_element_count; elem++) {
-    for (mass_bin_index = low_imf_mass_bin_index;
-         mass_bin_index < high_imf_mass_bin_index + 1; mass_bin_index++) {
-      low_index_3d = row_major_index_3d(
-          iz_low, elem, mass_bin_index, eagle_feedback_SNII_N_metals,
-          chemistry_element_count, eagle_feedback_N_imf_bins);
-      high_index_3d = row_major_index_3d(
-          iz_high, elem, mass_bin_index, eagle_feedback_SNII_N_metals,
-          chemistry_element_count, eagle_feedback_N_imf_bins);
-      low_index_2d = row_major_index_2d(iz_low, mass_bin_index,
-                                        eagle_feedback_SNII_N_metals,
-                                        eagle_feedback_N_imf_bins);
-      high_index_2d = row_major_index_2d(iz_high, mass_bin_index,
-                                         eagle_feedback_SNII_N_metals,
-                                         eagle_feedback_N_imf_bins);
-      stellar_yields[mass_bin_index] =
-          (1 - dz) *
-              (props->yield_SNII.yield_IMF_resampled[low_index_3d] +
-               sp->chemistry_data.metal_mass_fraction[elem] *
-                   props->yield_SNII.ejecta_IMF_resampled[low_index_2d]) +
-          dz * (props->yield_SNII.yield_IMF_resampled[high_index_3d] +
-                sp->chemistry_data.metal_mass_fraction[elem] *
-                    props->yield_SNII.ejecta_IMF_resampled[high_index_2d]);
-    }
-
-    metal_mass_released[elem] = integrate_imf(
-        log10_min_mass, log10_max_mass, eagle_imf_integration_yield_weight,
-        stellar_yields, props);
-  }
-
-  /* Compute mass produced */
-  for (mass_bin_index = low_imf_mass_bin_index;
-       mass_bin_index < high_imf_mass_bin_index + 1; mass_bin_index++) {
-    low_index_2d =
-        row_major_index_2d(iz_low, mass_bin_index, eagle_feedback_SNII_N_metals,
-                           eagle_feedback_N_imf_bins);
-    high_index_2d = row_major_index_2d(iz_high, mass_bin_index,
-                                       eagle_feedback_SNII_N_metals,
-                                       eagle_feedback_N_imf_bins);
-    stellar_yields[mass_bin_index] =
-        (1 - dz) * (props->yield_SNII.total_metals_IMF_resampled[low_index_2d] +
-                    sp->chemistry_data.metal_mass_fraction_total *
-                        props->yield_SNII.ejecta_IMF_resampled[low_index_2d]) +
-        dz * (props->yield_SNII.total_metals_IMF_resampled[high_index_2d] +
-              sp->chemistry_data.metal_mass_fraction_total *
-                  props->yield_SNII.ejecta_IMF_resampled[high_index_2d]);
-  }
-
-  metal_mass_released_total =
-      integrate_imf(log10_min_mass, log10_max_mass,
-                    eagle_imf_integration_yield_weight, stellar_yields, props);
-
-  /* yield normalization */
-  float mass_ejected, mass_released;
-
-  /* zero all negative values */
-  for (int i = 0; i < chemistry_element_count; i++)
-    metal_mass_released[i] = max(metal_mass_released[i], 0.f);
-
-  metal_mass_released_total = max(metal_mass_released_total, 0.f);
-
-  /* compute the total metal mass ejected from the star*/
-  for (mass_bin_index = low_imf_mass_bin_index;
-       mass_bin_index < high_imf_mass_bin_index + 1; mass_bin_index++) {
-    low_index_2d =
-        row_major_index_2d(iz_low, mass_bin_index, eagle_feedback_SNII_N_metals,
-                           eagle_feedback_N_imf_bins);
-    high_index_2d = row_major_index_2d(iz_high, mass_bin_index,
-                                       eagle_feedback_SNII_N_metals,
-                                       eagle_feedback_N_imf_bins);
-    stellar_yields[mass_bin_index] =
-        (1 - dz) * props->yield_SNII.ejecta_IMF_resampled[low_index_2d] +
-        dz * props->yield_SNII.ejecta_IMF_resampled[high_index_2d];
-  }
-
-  mass_ejected =
-      integrate_imf(log10_min_mass, log10_max_mass,
-                    eagle_imf_integration_yield_weight, stellar_yields, props);
+  float mass_ejected;
+  compute_mass_released(integrals, sp, metal_mass_released,
+                        &metal_mass_released_total, &mass_ejected);
 
   /* compute the total mass released */
-  mass_released = metal_mass_released_total +
-                  metal_mass_released[chemistry_element_H] +
-                  metal_mass_released[chemistry_element_He];
+  const float mass_released = metal_mass_released_total +
+                              metal_mass_released[chemistry_element_H] +
+                              metal_mass_released[chemistry_element_He];
 
   /* normalize the yields */
   if (mass_released > 0) {
@@ -537,26 +645,19 @@ INLINE static void evolve_SNII(float log10_min_mass, float log10_max_mass,
 }
 
 /**
- * @brief compute enrichment and feedback due to AGB. To do this, integrate the
- * IMF weighted by the yields read from tables for each of the quantities of
- * interest.
- *
- * Note for Matthieu: This function is poorly written and needs improving.
+ * @brief compute enrichment and feedback due to AGB. To do this, take the
+ * difference of the IMF-weighted yields tabulated at the two masses bounding
+ * the stars that died during the step.
  *
  * @param log10_min_mass log10 mass at the end of step
  * @param log10_max_mass log10 mass at the beginning of step
- * @param stellar_yields array to store calculated yields for passing to
- * integrate_imf
  * @param props Properties of the feedback model.
  * @param sp spart we are computing feedback for.
  */
 INLINE static void evolve_AGB(const float log10_min_mass, float log10_max_mass,
-                              float* stellar_yields,
                               const struct feedback_props* props,
                               struct spart* sp) {
 
-  int low_imf_mass_bin_index, high_imf_mass_bin_index, mass_bin_index;
-
   /* If mass at end of step is greater than tabulated lower bound for IMF, limit
    * it.*/
   if (log10_max_mass > props->log10_SNII_min_mass_msun)
@@ -566,102 +667,29 @@ INLINE static void evolve_AGB(const float log10_min_mass, float log10_max_mass,
    * step */
   if (log10_min_mass >= log10_max_mass) return;
 
-  /* determine which IMF mass bins contribute to the integral */
-  determine_imf_bins(log10_min_mass, log10_max_mass, &low_imf_mass_bin_index,
-                     &high_imf_mass_bin_index, props);
-
   /* determine which metallicity bin and offset this star belongs to */
-  int iz_low = 0, iz_high = 0, low_index_3d, high_index_3d, low_index_2d,
-      high_index_2d;
+  int iz_low = 0, iz_high = 0;
   float dz = 0.f;
   determine_bin_yield_AGB(&iz_low, &iz_high, &dz,
                           log10(sp->chemistry_data.metal_mass_fraction_total),
                           props);
 
+  /* Integrate the IMF-weighted yields over the range of dying masses */
+  double integrals[eagle_feedback_cumulative_N_fields];
+  integrate_cumulative_yields(log10_min_mass, log10_max_mass, &props->yield_AGB,
+                              eagle_feedback_AGB_N_metals, iz_low, iz_high, dz,
+                              props, integrals);
+
   /* compute metals produced */
   float metal_mass_released[chemistry_element_count], metal_mass_released_total;
-  for (int elem = 0; elem < chemistry_element_count; elem++) {
-    for (mass_bin_index = low_imf_mass_bin_index;
-         mass_bin_index < high_imf_mass_bin_index + 1; mass_bin_index++) {
-      low_index_3d = row_major_index_3d(
-          iz_low, elem, mass_bin_index, eagle_feedback_AGB_N_metals,
-          chemistry_element_count, eagle_feedback_N_imf_bins);
-      high_index_3d = row_major_index_3d(
-          iz_high, elem, mass_bin_index, eagle_feedback_AGB_N_metals,
-          chemistry_element_count, eagle_feedback_N_imf_bins);
-      low_index_2d = row_major_index_2d(iz_low, mass_bin_index,
-                                        eagle_feedback_AGB_N_metals,
-                                        eagle_feedback_N_imf_bins);
-      high_index_2d = row_major_index_2d(iz_high, mass_bin_index,
-                                         eagle_feedback_AGB_N_metals,
-                                         eagle_feedback_N_imf_bins);
-      stellar_yields[mass_bin_index] =
-          (1 - dz) * (props->yield_AGB.yield_IMF_resampled[low_index_3d] +
-                      sp->chemistry_data.metal_mass_fraction[elem] *
-                          props->yield_AGB.ejecta_IMF_resampled[low_index_2d]) +
-          dz * (props->yield_AGB.yield_IMF_resampled[high_index_3d] +
-                sp->chemistry_data.metal_mass_fraction[elem] *
-                    props->yield_AGB.ejecta_IMF_resampled[high_index_2d]);
-    }
-
-    metal_mass_released[elem] = integrate_imf(
-        log10_min_mass, log10_max_mass, eagle_imf_integration_yield_weight,
-        stellar_yields, props);
-  }
-
-  /* Compute mass produced */
-  for (mass_bin_index = low_imf_mass_bin_index;
-       mass_bin_index < high_imf_mass_bin_index + 1; mass_bin_index++) {
-    low_index_2d =
-        row_major_index_2d(iz_low, mass_bin_index, eagle_feedback_AGB_N_metals,
-                           eagle_feedback_N_imf_bins);
-    high_index_2d =
-        row_major_index_2d(iz_high, mass_bin_index, eagle_feedback_AGB_N_metals,
-                           eagle_feedback_N_imf_bins);
-    stellar_yields[mass_bin_index] =
-        (1 - dz) * (props->yield_AGB.total_metals_IMF_resampled[low_index_2d] +
-                    sp->chemistry_data.metal_mass_fraction_total *
-                        props->yield_AGB.ejecta_IMF_resampled[low_index_2d]) +
-        dz * (props->yield_AGB.total_metals_IMF_resampled[high_index_2d] +
-              sp->chemistry_data.metal_mass_fraction_total *
-                  props->yield_AGB.ejecta_IMF_resampled[high_index_2d]);
-  }
-
-  metal_mass_released_total =
-      integrate_imf(log10_min_mass, log10_max_mass,
-                    eagle_imf_integration_yield_weight, stellar_yields, props);
-
-  /* yield normalization */
-  float mass_ejected, mass_released;
-
-  /* zero all negative values */
-  for (int i = 0; i < chemistry_element_count; i++)
-    metal_mass_released[i] = max(metal_mass_released[i], 0.f);
-
-  metal_mass_released_total = max(metal_mass_released_total, 0.f);
-
-  /* compute the total metal mass ejected from the star */
-  for (mass_bin_index = low_imf_mass_bin_index;
-       mass_bin_index < high_imf_mass_bin_index + 1; mass_bin_index++) {
-    low_index_2d =
-        row_major_index_2d(iz_low, mass_bin_index, eagle_feedback_AGB_N_metals,
-                           eagle_feedback_N_imf_bins);
-    high_index_2d =
-        row_major_index_2d(iz_high, mass_bin_index, eagle_feedback_AGB_N_metals,
-                           eagle_feedback_N_imf_bins);
-    stellar_yields[mass_bin_index] =
-        (1 - dz) * props->yield_AGB.ejecta_IMF_resampled[low_index_2d] +
-        dz * props->yield_AGB.ejecta_IMF_resampled[high_index_2d];
-  }
-
-  mass_ejected =
-      integrate_imf(log10_min_mass, log10_max_mass,
-                    eagle_imf_integration_yield_weight, stellar_yields, props);
+  float mass_ejected;
+  compute_mass_released(integrals, sp, metal_mass_released,
+                        &metal_mass_released_total, &mass_ejected);
 
   /* compute the total mass released */
-  mass_released = metal_mass_released_total +
-                  metal_mass_released[chemistry_element_H] +
-                  metal_mass_released[chemistry_element_He];
+  const float mass_released = metal_mass_released_total +
+                              metal_mass_released[chemistry_element_H] +
+                              metal_mass_released[chemistry_element_He];
 
   /* normalize the yields */
   if (mass_released > 0) {
@@ -707,9 +735,6 @@ void compute_stellar_evolution(const struct feedback_props* feedback_props,
   if (age < 0.f) error("Negative age for a star.");
 #endif
 
-  /* Allocate temporary array for calculating imf weights */
-  float stellar_yields[eagle_feedback_N_imf_bins];
-
   /* Convert dt and stellar age from internal units to Gyr. */
   const double Gyr_in_cgs = 1e9 * 365. * 24. * 3600.;
   const double time_to_cgs = units_cgs_conversion_factor(us, UNIT_CONV_TIME);
@@ -744,9 +769,9 @@ void compute_stellar_evolution(const struct feedback_props* feedback_props,
   /* Calculate mass of stars that has died from the star's birth up to the
    * beginning and end of timestep */
   const float max_dying_mass_Msun =
-      dying_mass_msun(star_age_Gyr, Z, feedback_props);
+      dying_mass_msun_tabulated(star_age_Gyr, Z, feedback_props);
   const float min_dying_mass_Msun =
-      dying_mass_msun(star_age_Gyr + dt_Gyr, Z, feedback_props);
+      dying_mass_msun_tabulated(star_age_Gyr + dt_Gyr, Z, feedback_props);
 
 #ifdef SWIFT_DEBUG_CHECK
   /* Sanity check. Worth investigating if necessary as functions for evaluating
@@ -772,11 +797,11 @@ void compute_stellar_evolution(const struct feedback_props* feedback_props,
   }
   if (feedback_props->with_SNII_enrichment) {
     evolve_SNII(log10_min_dying_mass_Msun, log10_max_dying_mass_Msun,
-                stellar_yields, feedback_props, sp);
+                feedback_props, sp);
   }
   if (feedback_props->with_AGB_enrichment) {
     evolve_AGB(log10_min_dying_mass_Msun, log10_max_dying_mass_Msun,
-               stellar_yields, feedback_props, sp);
+               feedback_props, sp);
   }
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -804,6 +829,124 @@ void compute_stellar_evolution(const struct feedback_props* feedback_props,
   TIMER_TOC(timer_do_star_evol);
 }
 
+/**
+ * @brief Compare the tabulated dying masses and yields to the direct
+ * integration of the IMF and report the differences.
+ *
+ * The stellar evolution of stars of a range of metallicities and ages is
+ * computed both ways for a few time-step sizes.
+ *
+ * @param fp The #feedback_props.
+ */
+static void feedback_report_tables_accuracy(const struct feedback_props* fp) {
+
+  const float Z_samples[7] = {0.f, 1e-4f, 1e-3f, 4e-3f, 0.01f, 0.02f, 0.04f};
+  const float dt_fractions[3] = {1e-3f, 1e-2f, 1e-1f};
+  const float log10_age_yr_min = 6.4f, log10_age_yr_max = 10.2f;
+  const float delta_log10_age_yr = 0.05f;
+
+  /* Only compare steps releasing a non-negligible fraction of the mass */
+  const double min_ejecta = 1e-8;
+
+  double max_diff_mass = 0.;
+  double max_diff_ejecta[2] = {0., 0.}, max_diff_metals[2] = {0., 0.};
+  double sum_diff_ejecta[2] = {0., 0.}, sum_diff_metals[2] = {0., 0.};
+  int count[2] = {0, 0};
+
+  for (int iZ = 0; iZ < 7; iZ++) {
+
+    const float Z = Z_samples[iZ];
+    const float log10_Z = Z > 0.f ? log10f(Z) : log10_min_metallicity;
+
+    for (float log10_age_yr = log10_age_yr_min;
+         log10_age_yr <= log10_age_yr_max; log10_age_yr += delta_log10_age_yr) {
+
+      const float age_Gyr = exp10f(log10_age_yr - 9.f);
+
+      /* Dying mass */
+      const float mass = dying_mass_msun(age_Gyr, Z, fp);
+      const float mass_tab = dying_mass_msun_tabulated(age_Gyr, Z, fp);
+      max_diff_mass = max(max_diff_mass, fabs(mass_tab - mass) / mass);
+
+      for (int idt = 0; idt < 3; idt++) {
+
+        const float dt_Gyr = dt_fractions[idt] * age_Gyr;
+
+        const float log10_max_mass = log10f(mass);
+        const float log10_min_mass =
+            log10f(dying_mass_msun(age_Gyr + dt_Gyr, Z, fp));
+        const float log10_max_mass_tab = log10f(mass_tab);
+        const float log10_min_mass_tab =
+            log10f(dying_mass_msun_tabulated(age_Gyr + dt_Gyr, Z, fp));
+
+        /* Loop over the SNII (0) and AGB (1) channels */
+        for (int c = 0; c < 2; c++) {
+
+          const struct yield_table* table =
+              (c == 0) ? &fp->yield_SNII : &fp->yield_AGB;
+          const int N_metals = (c == 0) ? eagle_feedback_SNII_N_metals
+                                        : eagle_feedback_AGB_N_metals;
+          const float lower = (c == 0) ? fp->log10_SNII_min_mass_msun
+                                       : fp->log10_imf_min_mass_msun;
+          const float upper = (c == 0) ? fp->log10_SNII_max_mass_msun
+                                       : fp->log10_SNII_min_mass_msun;
+
+          /* Restrict the masses to the channel as done by evolve_SNII() and
+           * evolve_AGB() */
+          const float m_min = max(log10_min_mass, lower);
+          const float m_max = min(log10_max_mass, upper);
+          const float m_min_tab = max(log10_min_mass_tab, lower);
+          const float m_max_tab = min(log10_max_mass_tab, upper);
+          if (m_min >= m_max || m_min_tab >= m_max_tab) continue;
+
+          int iz_low, iz_high;
+          float dz;
+          if (c == 0)
+            determine_bin_yield_SNII(&iz_low, &iz_high, &dz, log10_Z, fp);
+          else
+            determine_bin_yield_AGB(&iz_low, &iz_high, &dz, log10_Z, fp);
+
+          double ref[eagle_feedback_cumulative_N_fields];
+          double tab[eagle_feedback_cumulative_N_fields];
+          integrate_yields(m_min, m_max, table, N_metals, iz_low, iz_high, dz,
+                           fp, ref);
+          integrate_cumulative_yields(m_min_tab, m_max_tab, table, N_metals,
+                                      iz_low, iz_high, dz, fp, tab);
+
+          const double ejecta = ref[eagle_feedback_cumulative_ejecta];
+          const double metals =
+              ref[eagle_feedback_cumulative_total_metals] + Z * ejecta;
+          const double ejecta_tab = tab[eagle_feedback_cumulative_ejecta];
+          const double metals_tab =
+              tab[eagle_feedback_cumulative_total_metals] + Z * ejecta_tab;
+          if (ejecta < min_ejecta || metals <= 0.) continue;
+
+          const double diff_ejecta = fabs(ejecta_tab - ejecta) / ejecta;
+          const double diff_metals = fabs(metals_tab - metals) / metals;
+
+          max_diff_ejecta[c] = max(max_diff_ejecta[c], diff_ejecta);
+          max_diff_metals[c] = max(max_diff_metals[c], diff_metals);
+          sum_diff_ejecta[c] += diff_ejecta;
+          sum_diff_metals[c] += diff_metals;
+          count[c]++;
+        }
+      }
+    }
+  }
+
+  message("Tabulated dying mass: max. relative difference %.3e",
+          max_diff_mass);
+  for (int c = 0; c < 2; c++) {
+    const double norm = count[c] > 0 ? 1. / count[c] : 0.;
+    message(
+        "Tabulated %s yields: relative difference in ejecta max=%.3e "
+        "mean=%.3e, in metals max=%.3e mean=%.3e",
+        c == 0 ? "SNII" : "AGB", max_diff_ejecta[c],
+        sum_diff_ejecta[c] * norm, max_diff_metals[c],
+        sum_diff_metals[c] * norm);
+  }
+}
+
 /**
  * @brief Initialize the global properties of the feedback scheme.
  *
@@ -1019,6 +1162,12 @@ void feedback_props_init(struct feedback_props* fp,
    * mass bins used in IMF  */
   compute_ejecta(fp);
 
+  /* Tabulate the IMF-weighted yields and the dying masses */
+  compute_cumulative_yields(fp);
+  compute_dying_mass_table(fp);
+
+  if (engine_rank == 0) feedback_report_tables_accuracy(fp);
+
   message("initialized stellar feedback");
 }
 
@@ -1038,6 +1187,7 @@ void zero_yield_table_pointers(struct yield_table* table) {
   table->ejecta = NULL;
   table->total_metals_IMF_resampled = NULL;
   table->total_metals = NULL;
+  table->cumulative_IMF_resampled = NULL;
 }
 
 /**
@@ -1071,6 +1221,10 @@ void feedback_restore_tables(struct feedback_props* fp) {
   /* Resample ejecta contribution to enrichment from mass bins used in tables to
    * mass bins used in IMF  */
   compute_ejecta(fp);
+
+  /* Tabulate the IMF-weighted yields and the dying masses */
+  compute_cumulative_yields(fp);
+  compute_dying_mass_table(fp);
 }
 
 /**
@@ -1107,6 +1261,7 @@ void feedback_struct_dump(const struct feedback_props* feedback, FILE* stream) {
   feedback_copy.lifetimes.mass = NULL;
   feedback_copy.lifetimes.metallicity = NULL;
   feedback_copy.lifetimes.dyingtime = NULL;
+  feedback_copy.lifetimes.dying_mass = NULL;
 
   /* zero IMF tables */
   feedback_copy.imf = NULL;
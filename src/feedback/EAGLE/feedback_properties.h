@@ -50,6 +50,10 @@ struct yield_table {
 
   /* Array to store table of total mass released being read in */
   double *total_metals;
+
+  /* Array to store the yields, total metals and ejecta weighted by the IMF
+   * and integrated from each IMF mass bin up to the maximal IMF mass */
+  double *cumulative_IMF_resampled;
 };
 
 /**
@@ -66,6 +70,16 @@ struct lifetime_table {
 
   /* table of lifetimes depending on mass an metallicity */
   double **dyingtime;
+
+  /* table of the mass of the dying stars depending on metallicity and on a
+   * regular grid of log10(age) */
+  double *dying_mass;
+
+  /* log10 of the age (in years) of the first entry of dying_mass */
+  double log10_age_min_yr;
+
+  /* inverse of the log10(age) bin size of dying_mass */
+  double log10_age_bin_size_inv;
 };
 
 /**
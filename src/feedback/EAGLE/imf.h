@@ -395,6 +395,165 @@ INLINE static float dying_mass_msun(
   return mass;
 }
 
+/**
+ * @brief Tabulate the mass (in solar masses) of the stars dying at a given
+ * age for each metallicity bin of the lifetime tables on a regular grid of
+ * log10(age).
+ *
+ * The masses are not limited to the IMF range here such that the table can be
+ * interpolated in metallicity before the limit is applied, as done by
+ * dying_mass_msun().
+ *
+ * @param feedback_props the #feedback_props data structure.
+ */
+INLINE static void compute_dying_mass_table(
+    struct feedback_props *feedback_props) {
+
+  const double *lifetime_m = feedback_props->lifetimes.mass;
+  double **const dying_times = feedback_props->lifetimes.dyingtime;
+  const int n_Z = eagle_feedback_lifetime_N_metals;
+  const int n_m = eagle_feedback_lifetime_N_masses;
+  const int n_ages = eagle_feedback_dying_mass_N_ages;
+
+  /* Range of ages covered by the lifetime tables. The dying times decrease
+   * with the mass. */
+  double log10_age_min_yr = dying_times[0][n_m - 1];
+  double log10_age_max_yr = dying_times[0][0];
+  for (int j = 1; j < n_Z; j++) {
+    log10_age_min_yr = min(log10_age_min_yr, dying_times[j][n_m - 1]);
+    log10_age_max_yr = max(log10_age_max_yr, dying_times[j][0]);
+  }
+
+  const double delta_log10_age =
+      (log10_age_max_yr - log10_age_min_yr) / (double)(n_ages - 1);
+  feedback_props->lifetimes.log10_age_min_yr = log10_age_min_yr;
+  feedback_props->lifetimes.log10_age_bin_size_inv = 1. / delta_log10_age;
+
+  for (int j = 0; j < n_Z; j++) {
+    for (int i = 0; i < n_ages; i++) {
+
+      const double log10_age_yr = log10_age_min_yr + i * delta_log10_age;
+
+      double mass;
+      if (log10_age_yr >= dying_times[j][0]) {
+
+        /* Before start of the table */
+        mass = lifetime_m[0];
+
+      } else if (log10_age_yr <= dying_times[j][n_m - 1]) {
+
+        /* After end of the table */
+        mass = lifetime_m[n_m - 1];
+
+      } else {
+
+        /* Search the table starting from the largest masses */
+        int k = n_m - 2;
+        while (dying_times[j][k] < log10_age_yr) k--;
+
+        const float offset = (log10_age_yr - dying_times[j][k]) /
+                             (dying_times[j][k + 1] - dying_times[j][k]);
+        mass = interpolate_1d(lifetime_m, k, offset);
+      }
+
+      feedback_props->lifetimes.dying_mass[j * n_ages + i] = mass;
+    }
+  }
+}
+
+/**
+ * @brief Calculate mass (in solar masses) of stars that died from the star
+ * particle's birth up to its current age (in Gyr) using the table built by
+ * compute_dying_mass_table().
+ *
+ * Same as dying_mass_msun() without the search through the lifetime tables.
+ *
+ * @param age_Gyr age of star in Gyr.
+ * @param Z Star's metallicity (metal mass fraction).
+ * @param feedback_props the #feedback_props data structure.
+ * @return Mass of stars died up to that age in solar masses.
+ */
+INLINE static float dying_mass_msun_tabulated(
+    const float age_Gyr, const float Z,
+    const struct feedback_props *feedback_props) {
+
+  /* Pull out some common terms */
+  const double *lifetime_Z = feedback_props->lifetimes.metallicity;
+  const int n_Z = eagle_feedback_lifetime_N_metals;
+  const int n_ages = eagle_feedback_dying_mass_N_ages;
+
+  /* Early abort? */
+  if (age_Gyr <= 0.f) {
+    return feedback_props->imf_max_mass_msun;
+  }
+
+  const float log10_age_yr = log10f(age_Gyr * 1e9f);
+
+  /* Calculate index along the metallicity axis */
+  int Z_index;
+  float Z_offset;
+  if (Z <= lifetime_Z[0]) {
+
+    /* Before start of the table */
+    Z_index = 0;
+    Z_offset = 0.f;
+
+  } else if (Z >= lifetime_Z[n_Z - 1]) {
+
+    /* After end of the table */
+    Z_index = n_Z - 2;
+    Z_offset = 1.f;
+
+  } else {
+
+    /* Normal case: Somewhere inside the table */
+    for (Z_index = 0; Z_index < n_Z - 1; Z_index++) {
+      if (lifetime_Z[Z_index + 1] > Z) break;
+    }
+
+    Z_offset = (Z - lifetime_Z[Z_index]) /
+               (lifetime_Z[Z_index + 1] - lifetime_Z[Z_index]);
+  }
+
+  /* Calculate index along the (regular) age axis */
+  const float u = (log10_age_yr - feedback_props->lifetimes.log10_age_min_yr) *
+                  feedback_props->lifetimes.log10_age_bin_size_inv;
+  int age_index;
+  float age_offset;
+  if (u <= 0.f) {
+
+    /* Before start of the table */
+    age_index = 0;
+    age_offset = 0.f;
+
+  } else if (u >= n_ages - 1) {
+
+    /* After end of the table */
+    age_index = n_ages - 2;
+    age_offset = 1.f;
+
+  } else {
+
+    /* Normal case: Somewhere inside the table */
+    age_index = (int)u;
+    age_offset = u - age_index;
+  }
+
+  /* And now interpolate the solution */
+  const double *dying_mass = feedback_props->lifetimes.dying_mass;
+  const float mass_low_Z =
+      interpolate_1d(dying_mass + Z_index * n_ages, age_index, age_offset);
+  const float mass_high_Z = interpolate_1d(dying_mass + (Z_index + 1) * n_ages,
+                                           age_index, age_offset);
+
+  float mass = (1.f - Z_offset) * mass_low_Z + Z_offset * mass_high_Z;
+
+  /* Check that we haven't killed too many stars */
+  mass = min(mass, feedback_props->imf_max_mass_msun);
+
+  return mass;
+}
+
 /**
  * @brief Calculate lifetime of stellar population in Gyr for a given mass.
  *
@@ -58,6 +58,18 @@ static const float log10_min_metallicity = -20;
 /*! Number od mass bins along the metal axis of the lifetime table */
 #define eagle_feedback_lifetime_N_metals 6
 
+/*! Number of log10(age) bins of the tabulated mass of the dying stars */
+#define eagle_feedback_dying_mass_N_ages 4096
+
+/*! Index of the total metal mass in the cumulative yield tables */
+#define eagle_feedback_cumulative_total_metals chemistry_element_count
+
+/*! Index of the ejected mass in the cumulative yield tables */
+#define eagle_feedback_cumulative_ejecta (chemistry_element_count + 1)
+
+/*! Number of quantities stored in the cumulative yield tables */
+#define eagle_feedback_cumulative_N_fields (chemistry_element_count + 2)
+
 /**
  * @brief returns index of element_name within array of element names
  * (element_array)
@@ -477,6 +489,16 @@ INLINE static void allocate_yield_tables(
     error("Failed to allocate AGB total metals IMF resampled array");
   }
 
+  /* Allocate array to store the cumulative AGB yields */
+  if (swift_memalign(
+          "feedback-tables",
+          (void **)&feedback_props->yield_AGB.cumulative_IMF_resampled,
+          SWIFT_STRUCT_ALIGNMENT,
+          eagle_feedback_AGB_N_metals * eagle_feedback_cumulative_N_fields *
+              eagle_feedback_N_imf_bins * sizeof(double)) != 0) {
+    error("Failed to allocate AGB cumulative yields array");
+  }
+
   /* Allocate array for SNII mass bins */
   if (swift_memalign("feedback-tables",
                      (void **)&feedback_props->yield_SNII.mass,
@@ -549,6 +571,16 @@ INLINE static void allocate_yield_tables(
     error("Failed to allocate SNII total metals IMF resampled array");
   }
 
+  /* Allocate array to store the cumulative SNII yields */
+  if (swift_memalign(
+          "feedback-tables",
+          (void **)&feedback_props->yield_SNII.cumulative_IMF_resampled,
+          SWIFT_STRUCT_ALIGNMENT,
+          eagle_feedback_SNII_N_metals * eagle_feedback_cumulative_N_fields *
+              eagle_feedback_N_imf_bins * sizeof(double)) != 0) {
+    error("Failed to allocate SNII cumulative yields array");
+  }
+
   /* Allocate array for lifetimes mass bins */
   if (swift_memalign("feedback-tables",
                      (void **)&feedback_props->lifetimes.mass,
@@ -573,6 +605,16 @@ INLINE static void allocate_yield_tables(
         (double *)malloc(eagle_feedback_lifetime_N_masses * sizeof(double));
   }
 
+  /* Allocate array for the tabulated mass of the dying stars */
+  if (swift_memalign("feedback-tables",
+                     (void **)&feedback_props->lifetimes.dying_mass,
+                     SWIFT_STRUCT_ALIGNMENT,
+                     eagle_feedback_lifetime_N_metals *
+                         eagle_feedback_dying_mass_N_ages * sizeof(double)) !=
+      0) {
+    error("Failed to allocate dying mass array");
+  }
+
   /* Allocate arrays to store names of elements tracked for SNIa, SNII, AGB  */
   feedback_props->SNIa_element_names =
       (char **)malloc(eagle_feedback_SNIa_N_elements * sizeof(char *));
@@ -880,4 +922,77 @@ INLINE static void compute_ejecta(struct feedback_props *feedback_props) {
   }
 }
 
+/**
+ * @brief Integrate the IMF weighted by the resampled yields, total metals and
+ * ejecta of one channel from each IMF mass bin up to the maximal IMF mass.
+ *
+ * The integral between any two masses is then the difference of two
+ * interpolated entries of the table. The integration uses the same
+ * trapezoidal rule as integrate_imf().
+ *
+ * @param table The #yield_table of the channel (SNII or AGB).
+ * @param N_metals The number of metallicity bins of the table.
+ * @param feedback_props the #feedback_props data struct.
+ */
+INLINE static void compute_cumulative_yields_table(
+    struct yield_table *table, const int N_metals,
+    const struct feedback_props *feedback_props) {
+
+  const int N_bins = eagle_feedback_N_imf_bins;
+  const float *imf = feedback_props->imf;
+  const float *imf_mass_bin = feedback_props->imf_mass_bin;
+  const double imf_log10_mass_bin_size = feedback_props->imf_mass_bin_log10[1] -
+                                         feedback_props->imf_mass_bin_log10[0];
+
+  for (int i = 0; i < N_metals; i++) {
+    for (int f = 0; f < eagle_feedback_cumulative_N_fields; f++) {
+
+      /* Integrand of the IMF integral for this quantity */
+      double integrand[eagle_feedback_N_imf_bins];
+      for (int k = 0; k < N_bins; k++) {
+
+        double weight;
+        if (f == eagle_feedback_cumulative_total_metals)
+          weight = table->total_metals_IMF_resampled[row_major_index_2d(
+              i, k, N_metals, N_bins)];
+        else if (f == eagle_feedback_cumulative_ejecta)
+          weight = table->ejecta_IMF_resampled[row_major_index_2d(
+              i, k, N_metals, N_bins)];
+        else
+          weight = table->yield_IMF_resampled[row_major_index_3d(
+              i, f, k, N_metals, chemistry_element_count, N_bins)];
+
+        integrand[k] = weight * imf[k] * imf_mass_bin[k];
+      }
+
+      /* Integrate from the top of the IMF down */
+      double *cumulative =
+          table->cumulative_IMF_resampled +
+          row_major_index_3d(i, f, 0, N_metals,
+                             eagle_feedback_cumulative_N_fields, N_bins);
+
+      cumulative[N_bins - 1] = 0.;
+      for (int k = N_bins - 2; k >= 0; k--)
+        cumulative[k] = cumulative[k + 1] +
+                        0.5 * (integrand[k] + integrand[k + 1]) *
+                            imf_log10_mass_bin_size * M_LN10;
+    }
+  }
+}
+
+/**
+ * @brief Integrate the IMF weighted by the yields of the SNII and AGB channels
+ * once for all.
+ *
+ * @param feedback_props the #feedback_props data struct.
+ */
+INLINE static void compute_cumulative_yields(
+    struct feedback_props *feedback_props) {
+
+  compute_cumulative_yields_table(&feedback_props->yield_SNII,
+                                  eagle_feedback_SNII_N_metals, feedback_props);
+  compute_cumulative_yields_table(&feedback_props->yield_AGB,
+                                  eagle_feedback_AGB_N_metals, feedback_props);
+}
+
 #endif /* SWIFT_EAGLE_FEEDBACK_YIELD_TABLES_H */
@@ -0,0 +1,231 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  @file io_compression.c
+ *  @brief Per-field selection and lossy compression filters of the snapshots.
+ */
+
+/* Config parameters. */
+#include "../config.h"
+
+/* This object's header. */
+#include "io_compression.h"
+
+/* Local includes. */
+#include "error.h"
+#include "parser.h"
+
+/* Some standard headers. */
+#include <string.h>
+
+/**
+ * @brief Names of the compression schemes.
+ *
+ * "off" and "on" are equivalent to the historical 0 and 1 values.
+ */
+const char* lossy_compression_schemes_names[compression_write_count] = {
+    "off",     "on",      "DScale1",    "DScale2",     "DScale3",
+    "DScale4", "DScale5", "DScale6",    "FMantissa9",  "FMantissa13",
+    "IntScaleOffset"};
+
+/**
+ * @brief Returns the compression scheme corresponding to a name.
+ *
+ * Accepts the integers 0 and 1 as synonyms of "off" and "on".
+ *
+ * @param name The name of the scheme.
+ * @return The scheme or compression_write_count if the name is unknown.
+ */
+enum lossy_compression_schemes compression_scheme_from_name(const char* name) {
+
+  if (strcmp(name, "0") == 0) return compression_do_not_write;
+  if (strcmp(name, "1") == 0) return compression_write_lossless;
+
+  for (int i = 0; i < compression_write_count; ++i)
+    if (strcmp(name, lossy_compression_schemes_names[i]) == 0)
+      return (enum lossy_compression_schemes)i;
+
+  return compression_write_count;
+}
+
+/**
+ * @brief Can a given compression scheme be applied to a type of data?
+ *
+ * The D-scale and mantissa filters only make sense for floating-point
+ * numbers and the scale-offset filter for integers.
+ *
+ * @param comp The compression scheme.
+ * @param type The type of the field.
+ */
+int io_compression_is_compatible(const enum lossy_compression_schemes comp,
+                                 const enum IO_DATA_TYPE type) {
+
+  switch (comp) {
+    case compression_do_not_write:
+    case compression_write_lossless:
+      return 1;
+
+    case compression_write_d_scale_1:
+    case compression_write_d_scale_2:
+    case compression_write_d_scale_3:
+    case compression_write_d_scale_4:
+    case compression_write_d_scale_5:
+    case compression_write_d_scale_6:
+    case compression_write_f_mantissa_9:
+    case compression_write_f_mantissa_13:
+      return (type == FLOAT || type == DOUBLE);
+
+    case compression_write_int_scale_offset:
+      return (type == INT || type == LONG || type == LONGLONG ||
+              type == UINT || type == ULONG || type == ULONGLONG);
+
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Reads the compression scheme of a field from the parameter file.
+ *
+ * Fields that are not mentioned are written without lossy filter.
+ *
+ * @param params The #swift_params.
+ * @param field The full name of the parameter (e.g.
+ * "SelectOutput:Coordinates_Gas").
+ */
+enum lossy_compression_schemes io_get_field_compression(
+    struct swift_params* params, const char* field) {
+
+  char name[PARSER_MAX_LINE_SIZE];
+  parser_get_opt_param_string(
+      params, field, name,
+      lossy_compression_schemes_names[compression_write_lossless]);
+
+  const enum lossy_compression_schemes comp =
+      compression_scheme_from_name(name);
+  if (comp == compression_write_count)
+    error("Unknown output selection '%s' for field '%s'.", name, field);
+
+  return comp;
+}
+
+#if defined(HAVE_HDF5)
+
+/**
+ * @brief Adds the lossy filter of a field to the properties of its dataset.
+ *
+ * The filter must be added before any of the lossless filters (shuffle,
+ * deflate, checksum) as it relies on the data type of the elements. The
+ * dataset must be chunked.
+ *
+ * The mantissa filters modify the on-disk type of the field. h_type must
+ * hence be a copy of the memory type owned by the caller.
+ *
+ * @param h_prop The dataset creation property list.
+ * @param h_type The on-disk type of the dataset.
+ * @param comp The compression scheme.
+ * @param field_name The name of the field (for error messages).
+ */
+void io_set_hdf5_lossy_compression(hid_t h_prop, hid_t h_type,
+                                   const enum lossy_compression_schemes comp,
+                                   const char* field_name) {
+
+  herr_t h_err = 0;
+
+  /* Check that the filter matches the type of the field */
+  const H5T_class_t h_class = H5Tget_class(h_type);
+  if ((comp >= compression_write_d_scale_1 &&
+       comp <= compression_write_f_mantissa_13 && h_class != H5T_FLOAT) ||
+      (comp == compression_write_int_scale_offset && h_class != H5T_INTEGER))
+    error("Lossy compression scheme '%s' cannot be applied to field '%s'.",
+          lossy_compression_schemes_names[comp], field_name);
+
+  switch (comp) {
+
+    case compression_do_not_write:
+    case compression_write_lossless:
+      break;
+
+    case compression_write_d_scale_1:
+    case compression_write_d_scale_2:
+    case compression_write_d_scale_3:
+    case compression_write_d_scale_4:
+    case compression_write_d_scale_5:
+    case compression_write_d_scale_6: {
+
+      /* Keep the values to a fixed number of decimals in each chunk */
+      const int scale = 1 + (comp - compression_write_d_scale_1);
+      h_err = H5Pset_scaleoffset(h_prop, H5Z_SO_FLOAT_DSCALE, scale);
+    } break;
+
+    case compression_write_f_mantissa_9:
+    case compression_write_f_mantissa_13: {
+
+      /* Keep the sign and exponent but truncate the mantissa */
+      const size_t m_size = (comp == compression_write_f_mantissa_9) ? 9 : 13;
+      size_t s_pos, e_pos, e_size, m_pos, m_size_old;
+      h_err = H5Tget_fields(h_type, &s_pos, &e_pos, &e_size, &m_pos,
+                            &m_size_old);
+      if (h_err < 0) break;
+
+      h_err = H5Tset_fields(h_type, e_size + m_size, m_size, e_size, 0, m_size);
+      if (h_err < 0) break;
+
+      h_err = H5Tset_precision(h_type, 1 + e_size + m_size);
+      if (h_err < 0) break;
+
+      /* And only store the bits we kept */
+      h_err = H5Pset_nbit(h_prop);
+    } break;
+
+    case compression_write_int_scale_offset:
+
+      /* Store the offset to the minimum with as few bits as possible */
+      h_err = H5Pset_scaleoffset(h_prop, H5Z_SO_INT,
+                                 H5Z_SO_INT_MINBITS_DEFAULT);
+      break;
+
+    default:
+      error("Invalid compression scheme %d for field '%s'.", (int)comp,
+            field_name);
+  }
+
+  if (h_err < 0)
+    error("Error while setting lossy compression '%s' for field '%s'.",
+          lossy_compression_schemes_names[comp], field_name);
+}
+
+/**
+ * @brief Records the lossy filter applied to a dataset in its attributes.
+ *
+ * @param h_data The dataset.
+ * @param comp The compression scheme.
+ */
+void io_write_lossy_compression_attribute(
+    hid_t h_data, const enum lossy_compression_schemes comp) {
+
+  if (comp == compression_write_lossless)
+    io_write_attribute_s(h_data, "Lossy compression filter", "None");
+  else
+    io_write_attribute_s(h_data, "Lossy compression filter",
+                         lossy_compression_schemes_names[comp]);
+}
+
+#endif /* HAVE_HDF5 */
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_IO_COMPRESSION_H
+#define SWIFT_IO_COMPRESSION_H
+
+/* Config parameters. */
+#include "../config.h"
+
+/* Local includes. */
+#include "common_io.h"
+
+/* Forward declarations to avoid cyclic includes. */
+struct swift_params;
+
+/**
+ * @brief Selection and (lossy) compression of a field in the snapshots.
+ *
+ * Set per field in the SelectOutput section of the output selection file.
+ */
+enum lossy_compression_schemes {
+  compression_do_not_write = 0,       /*!< Do not write that field */
+  compression_write_lossless,         /*!< Do not apply any lossy filter */
+  compression_write_d_scale_1,        /*!< D-scale filter of magnitude 10^1 */
+  compression_write_d_scale_2,        /*!< D-scale filter of magnitude 10^2 */
+  compression_write_d_scale_3,        /*!< D-scale filter of magnitude 10^3 */
+  compression_write_d_scale_4,        /*!< D-scale filter of magnitude 10^4 */
+  compression_write_d_scale_5,        /*!< D-scale filter of magnitude 10^5 */
+  compression_write_d_scale_6,        /*!< D-scale filter of magnitude 10^6 */
+  compression_write_f_mantissa_9,     /*!< Keep 9 bits of the mantissa */
+  compression_write_f_mantissa_13,    /*!< Keep 13 bits of the mantissa */
+  compression_write_int_scale_offset, /*!< Integer offset + minimal bits */
+  /* Counts the number of schemes */
+  compression_write_count
+};
+
+/**
+ * @brief Names of the compression schemes, as used in the parameter files
+ * and in the snapshot attributes.
+ */
+extern const char* lossy_compression_schemes_names[compression_write_count];
+
+enum lossy_compression_schemes compression_scheme_from_name(const char* name);
+
+int io_compression_is_compatible(const enum lossy_compression_schemes comp,
+                                 const enum IO_DATA_TYPE type);
+
+enum lossy_compression_schemes io_get_field_compression(
+    struct swift_params* params, const char* field);
+
+#if defined(HAVE_HDF5)
+
+void io_set_hdf5_lossy_compression(hid_t h_prop, hid_t h_type,
+                                   const enum lossy_compression_schemes comp,
+                                   const char* field_name);
+
+void io_write_lossy_compression_attribute(
+    hid_t h_data, const enum lossy_compression_schemes comp);
+
+#endif /* HAVE_HDF5 */
+
+#endif /* SWIFT_IO_COMPRESSION_H */
@@ -49,11 +49,13 @@
 #include "gravity_properties.h"
 #include "hydro_io.h"
 #include "hydro_properties.h"
+#include "io_compression.h"
 #include "io_properties.h"
 #include "kernel_hydro.h"
 #include "memuse.h"
 #include "part.h"
 #include "part_type.h"
+#include "partition.h"
 #include "star_formation_io.h"
 #include "stars_io.h"
 #include "tracers_io.h"
@@ -67,14 +69,23 @@
 /* Are we timing the i/o? */
 //#define IO_SPEED_MEASUREMENT
 
+/**
+ * @brief A range of particles stored contiguously in the ICs.
+ */
+struct ic_range {
+  long long offset;
+  long long count;
+};
+
 /**
  * @brief Reads a chunk of data from an open HDF5 dataset
  *
  * @param h_data The HDF5 dataset to write to.
  * @param h_plist_id the parallel HDF5 properties.
  * @param props The #io_props of the field to read.
- * @param N The number of particles to write.
- * @param offset Offset in the array where this mpi task starts writing.
+ * @param N The number of particles to read.
+ * @param ranges The ranges of the array to read (summing to N elements).
+ * @param nr_ranges The number of ranges.
  * @param internal_units The #unit_system used internally.
  * @param ic_units The #unit_system used in the snapshots.
  * @param cleanup_h Are we removing h-factors from the ICs?
@@ -82,12 +93,15 @@
  * IC velocities?
  * @param h The value of the reduced Hubble constant to use for cleaning.
  * @param a The current value of the scale-factor.
+ * @param tp The #threadpool used for the unit conversion.
  */
 void readArray_chunk(hid_t h_data, hid_t h_plist_id,
-                     const struct io_props props, size_t N, long long offset,
+                     const struct io_props props, size_t N,
+                     const struct ic_range* ranges, int nr_ranges,
                      const struct unit_system* internal_units,
                      const struct unit_system* ic_units, int cleanup_h,
-                     int cleanup_sqrt_a, double h, double a) {
+                     int cleanup_sqrt_a, double h, double a,
+                     struct threadpool* tp) {
 
   const size_t typeSize = io_sizeof_type(props.type);
   const size_t copySize = typeSize * props.dimension;
@@ -97,10 +111,6 @@ void readArray_chunk(hid_t h_data, hid_t h_plist_id,
   if (N * props.dimension * typeSize > HDF5_PARALLEL_IO_MAX_BYTES)
     error("Dataset too large to be read in one pass!");
 
-  /* Allocate temporary buffer */
-  void* temp = malloc(num_elements * typeSize);
-  if (temp == NULL) error("Unable to allocate memory for temporary buffer");
-
   /* Prepare information for hyper-slab */
   hsize_t shape[2], offsets[2];
   int rank;
@@ -108,115 +118,55 @@ void readArray_chunk(hid_t h_data, hid_t h_plist_id,
     rank = 2;
     shape[0] = N;
     shape[1] = props.dimension;
-    offsets[0] = offset;
+    offsets[0] = 0;
     offsets[1] = 0;
   } else {
     rank = 2;
     shape[0] = N;
     shape[1] = 1;
-    offsets[0] = offset;
+    offsets[0] = 0;
     offsets[1] = 0;
   }
 
-  /* Create data space in memory */
-  const hid_t h_memspace = H5Screate_simple(rank, shape, NULL);
-
-  /* Select hyper-slab in file */
-  const hid_t h_filespace = H5Dget_space(h_data);
-  H5Sselect_hyperslab(h_filespace, H5S_SELECT_SET, offsets, NULL, shape, NULL);
-
-  /* Read HDF5 dataspace in temporary buffer */
-  /* Dirty version that happens to work for vectors but should be improved */
-  /* Using HDF5 dataspaces would be better */
-  const hid_t h_err = H5Dread(h_data, io_hdf5_type(props.type), h_memspace,
-                              h_filespace, h_plist_id, temp);
-  if (h_err < 0) error("Error while reading data array '%s'.", props.name);
-
-  /* Unit conversion if necessary */
-  const double factor =
-      units_conversion_factor(ic_units, internal_units, props.units);
-  if (factor != 1.) {
-
-    /* message("Converting ! factor=%e", factor); */
-
-    if (io_is_double_precision(props.type)) {
-      double* temp_d = (double*)temp;
-      for (size_t i = 0; i < num_elements; ++i) temp_d[i] *= factor;
-    } else {
-      float* temp_f = (float*)temp;
-
-#ifdef SWIFT_DEBUG_CHECKS
-      float maximum = 0.;
-      float minimum = FLT_MAX;
-#endif
-
-      /* Loop that converts the Units */
-      for (size_t i = 0; i < num_elements; ++i) {
-
-#ifdef SWIFT_DEBUG_CHECKS
-        /* Find the absolute minimum and maximum values */
-        const float abstemp_f = fabsf(temp_f[i]);
-        if (abstemp_f != 0.f) {
-          maximum = max(maximum, abstemp_f);
-          minimum = min(minimum, abstemp_f);
-        }
-#endif
-
-        /* Convert the float units */
-        temp_f[i] *= factor;
-      }
-
-#ifdef SWIFT_DEBUG_CHECKS
-      /* The two possible errors: larger than float or smaller
-       * than float precission. */
-      if (factor * maximum > FLT_MAX) {
-        error("Unit conversion results in numbers larger than floats");
-      } else if (factor * minimum < FLT_MIN) {
-        error("Numbers smaller than float precision");
-      }
-#endif
-    }
+  /* Create data space in memory, straight in the particles if possible */
+  void* temp = NULL;
+  hid_t h_memspace = io_field_memspace(props, N);
+  if (h_memspace < 0) {
+    temp = malloc(num_elements * typeSize);
+    if (temp == NULL) error("Unable to allocate memory for temporary buffer");
+    h_memspace = H5Screate_simple(rank, shape, NULL);
   }
 
-  /* Clean-up h if necessary */
-  const float h_factor_exp = units_h_factor(internal_units, props.units);
-  if (cleanup_h && h_factor_exp != 0.f) {
-
-    /* message("Multipltying '%s' by h^%f=%f", props.name, h_factor_exp,
-     * h_factor); */
-
-    if (io_is_double_precision(props.type)) {
-      double* temp_d = (double*)temp;
-      const double h_factor = pow(h, h_factor_exp);
-      for (size_t i = 0; i < num_elements; ++i) temp_d[i] *= h_factor;
-    } else {
-      float* temp_f = (float*)temp;
-      const float h_factor = pow(h, h_factor_exp);
-      for (size_t i = 0; i < num_elements; ++i) temp_f[i] *= h_factor;
-    }
+  /* Select the union of the hyper-slabs in file */
+  const hid_t h_filespace = H5Dget_space(h_data);
+  if (N == 0) H5Sselect_none(h_filespace);
+  for (int r = 0; r < nr_ranges && N > 0; ++r) {
+    offsets[0] = ranges[r].offset;
+    shape[0] = ranges[r].count;
+    H5Sselect_hyperslab(h_filespace, (r == 0) ? H5S_SELECT_SET : H5S_SELECT_OR,
+                        offsets, NULL, shape, NULL);
   }
 
-  /* Clean-up a if necessary */
-  if (cleanup_sqrt_a && a != 1. && (strcmp(props.name, "Velocities") == 0)) {
+  /* Read HDF5 dataspace in the particles or the temporary buffer */
+  const hid_t h_err =
+      H5Dread(h_data, io_hdf5_type(props.type), h_memspace, h_filespace,
+              h_plist_id, (temp != NULL) ? temp : (void*)props.field);
+  if (h_err < 0) error("Error while reading data array '%s'.", props.name);
 
-    if (io_is_double_precision(props.type)) {
-      double* temp_d = (double*)temp;
-      const double vel_factor = sqrt(a);
-      for (size_t i = 0; i < num_elements; ++i) temp_d[i] *= vel_factor;
-    } else {
-      float* temp_f = (float*)temp;
-      const float vel_factor = sqrt(a);
-      for (size_t i = 0; i < num_elements; ++i) temp_f[i] *= vel_factor;
-    }
+  /* Copy temporary buffer to particle data */
+  if (temp != NULL) {
+    char* temp_c = (char*)temp;
+    for (size_t i = 0; i < N; ++i)
+      memcpy(props.field + i * props.partSize, &temp_c[i * copySize],
+             copySize);
+    free(temp);
   }
 
-  /* Copy temporary buffer to particle data */
-  char* temp_c = (char*)temp;
-  for (size_t i = 0; i < N; ++i)
-    memcpy(props.field + i * props.partSize, &temp_c[i * copySize], copySize);
+  /* Unit conversion and clean-ups if necessary */
+  io_convert_read_field(tp, props, N, internal_units, ic_units, cleanup_h,
+                        cleanup_sqrt_a, h, a);
 
   /* Free and close everything */
-  free(temp);
   H5Sclose(h_filespace);
   H5Sclose(h_memspace);
 }
@@ -229,7 +179,8 @@ void readArray_chunk(hid_t h_data, hid_t h_plist_id,
  * @param N The number of particles on that rank.
  * @param N_total The total number of particles.
  * @param mpi_rank The MPI rank of this node.
- * @param offset The offset in the array on disk for this rank.
+ * @param ranges The ranges of the array on disk to read on this rank.
+ * @param nr_ranges The number of ranges to read on this rank.
  * @param internal_units The #unit_system used internally.
  * @param ic_units The #unit_system used in the ICs.
  * @param cleanup_h Are we removing h-factors from the ICs?
@@ -237,12 +188,13 @@ void readArray_chunk(hid_t h_data, hid_t h_plist_id,
  * IC velocities?
  * @param h The value of the reduced Hubble constant to use for cleaning.
  * @param a The current value of the scale-factor.
+ * @param tp The #threadpool used for the unit conversion.
  */
 void readArray(hid_t grp, struct io_props props, size_t N, long long N_total,
-               int mpi_rank, long long offset,
+               int mpi_rank, const struct ic_range* ranges, int nr_ranges,
                const struct unit_system* internal_units,
                const struct unit_system* ic_units, int cleanup_h,
-               int cleanup_sqrt_a, double h, double a) {
+               int cleanup_sqrt_a, double h, double a, struct threadpool* tp) {
 
   const size_t typeSize = io_sizeof_type(props.type);
   const size_t copySize = typeSize * props.dimension;
@@ -320,6 +272,14 @@ void readArray(hid_t grp, struct io_props props, size_t N, long long N_total,
   const hid_t h_plist_id = H5Pcreate(H5P_DATASET_XFER);
   H5Pset_dxpl_mpio(h_plist_id, H5FD_MPIO_COLLECTIVE);
 
+  /* The ranges making up the current chunk */
+  struct ic_range* chunk_ranges =
+      (struct ic_range*)malloc((nr_ranges + 1) * sizeof(struct ic_range));
+  if (chunk_ranges == NULL)
+    error("Unable to allocate memory for the chunk ranges");
+  int range = 0;
+  long long range_done = 0;
+
   /* Given the limitations of ROM-IO we will need to read the data in chunk of
      HDF5_PARALLEL_IO_MAX_BYTES bytes per node until all the nodes are done. */
   char redo = 1;
@@ -329,26 +289,39 @@ void readArray(hid_t grp, struct io_props props, size_t N, long long N_total,
     const size_t max_chunk_size =
         HDF5_PARALLEL_IO_MAX_BYTES / (props.dimension * typeSize);
 
-    /* Write the first chunk */
-    const size_t this_chunk = (N > max_chunk_size) ? max_chunk_size : N;
-    readArray_chunk(h_data, h_plist_id, props, this_chunk, offset,
-                    internal_units, ic_units, cleanup_h, cleanup_sqrt_a, h, a);
-
-    /* Compute how many items are left */
-    if (N > max_chunk_size) {
-      N -= max_chunk_size;
-      props.field += max_chunk_size * props.partSize; /* char* on the field */
-      props.parts += max_chunk_size;                  /* part* on the part */
-      props.xparts += max_chunk_size;                 /* xpart* on the xpart */
-      props.gparts += max_chunk_size;                 /* gpart* on the gpart */
-      offset += max_chunk_size;
-      redo = 1;
-    } else {
-      N = 0;
-      offset += 0;
-      redo = 0;
+    /* Collect the next ranges until the chunk is full */
+    size_t this_chunk = 0;
+    int nr_chunk_ranges = 0;
+    while (range < nr_ranges && this_chunk < max_chunk_size) {
+      const long long left = ranges[range].count - range_done;
+      const long long room = max_chunk_size - this_chunk;
+      const long long count = min(left, room);
+      if (count > 0) {
+        chunk_ranges[nr_chunk_ranges].offset =
+            ranges[range].offset + range_done;
+        chunk_ranges[nr_chunk_ranges].count = count;
+        nr_chunk_ranges++;
+      }
+      this_chunk += count;
+      range_done += count;
+      if (range_done == ranges[range].count) {
+        range++;
+        range_done = 0;
+      }
     }
 
+    /* Read the chunk */
+    readArray_chunk(h_data, h_plist_id, props, this_chunk, chunk_ranges,
+                    nr_chunk_ranges, internal_units, ic_units, cleanup_h,
+                    cleanup_sqrt_a, h, a, tp);
+
+    /* Move on to the next chunk if any items are left */
+    props.field += this_chunk * props.partSize; /* char* on the field */
+    props.parts += this_chunk;                  /* part* on the part */
+    props.xparts += this_chunk;                 /* xpart* on the xpart */
+    props.gparts += this_chunk;                 /* gpart* on the gpart */
+    redo = (range < nr_ranges);
+
     /* Do we need to run again ? */
     MPI_Allreduce(MPI_IN_PLACE, &redo, 1, MPI_SIGNED_CHAR, MPI_MAX,
                   MPI_COMM_WORLD);
@@ -358,6 +331,7 @@ void readArray(hid_t grp, struct io_props props, size_t N, long long N_total,
   }
 
   /* Close everything */
+  free(chunk_ranges);
   H5Pclose(h_plist_id);
   H5Dclose(h_data);
 }
@@ -373,10 +347,16 @@ void readArray(hid_t grp, struct io_props props, size_t N, long long N_total,
  * @param props The #io_props of the field to write.
  * @param N_total The total number of particles to write in this array.
  * @param snapshot_units The units used for the data in this snapshot.
+ * @param lossy_compression The lossy filter to apply to this field.
+ *
+ * The dataset is only chunked if some filter is applied to it. Filtered
+ * datasets can only be written in parallel from HDF5 1.10.2 onwards and we
+ * skip that version as it reads them back incorrectly.
  */
 void prepareArray(struct engine* e, hid_t grp, char* fileName, FILE* xmfFile,
                   char* partTypeGroupName, struct io_props props,
-                  long long N_total, const struct unit_system* snapshot_units) {
+                  long long N_total, const struct unit_system* snapshot_units,
+                  const enum lossy_compression_schemes lossy_compression) {
 
   /* Create data space */
   const hid_t h_space = H5Screate(H5S_SIMPLE);
@@ -412,17 +392,50 @@ void prepareArray(struct engine* e, hid_t grp, char* fileName, FILE* xmfFile,
   const hid_t h_plist_id = H5Pcreate(H5P_DATASET_XFER);
   H5Pset_dxpl_mpio(h_plist_id, H5FD_MPIO_COLLECTIVE);
 
-  /* Set chunk size */
-  /* h_err = H5Pset_chunk(h_prop, rank, chunk_shape); */
-  /* if (h_err < 0) { */
-  /*   error("Error while setting chunk size (%llu, %llu) for field '%s'.", */
-  /*         chunk_shape[0], chunk_shape[1], props.name); */
-  /* } */
+  /* Type of the data on disk (may be changed by the lossy filter) */
+  const hid_t h_type = H5Tcopy(io_hdf5_type(props.type));
+
+  /* Dataset properties */
+  const hid_t h_prop = H5Pcreate(H5P_DATASET_CREATE);
+
+#if H5_VERSION_GE(1, 10, 3)
+  if (N_total > 0 && (lossy_compression != compression_write_lossless ||
+                      e->snapshot_compression > 0)) {
+
+    /* Set chunk size */
+    h_err = H5Pset_chunk(h_prop, rank, chunk_shape);
+    if (h_err < 0)
+      error("Error while setting chunk size (%llu, %llu) for field '%s'.",
+            chunk_shape[0], chunk_shape[1], props.name);
+
+    /* Impose the lossy filter (must come before the lossless ones) */
+    io_set_hdf5_lossy_compression(h_prop, h_type, lossy_compression,
+                                  props.name);
+
+    /* Impose data compression */
+    if (e->snapshot_compression > 0) {
+      h_err = H5Pset_shuffle(h_prop);
+      if (h_err < 0)
+        error("Error while setting shuffling options for field '%s'.",
+              props.name);
+
+      h_err = H5Pset_deflate(h_prop, e->snapshot_compression);
+      if (h_err < 0)
+        error("Error while setting compression options for field '%s'.",
+              props.name);
+    }
+  }
+#else
+  if (lossy_compression != compression_write_lossless)
+    error(
+        "Lossy compression of field '%s' requires parallel-HDF5 1.10.3 or "
+        "later.",
+        props.name);
+#endif
 
   /* Create dataset */
-  const hid_t h_data =
-      H5Dcreate(grp, props.name, io_hdf5_type(props.type), h_space, H5P_DEFAULT,
-                H5P_DEFAULT, H5P_DEFAULT);
+  const hid_t h_data = H5Dcreate(grp, props.name, h_type, h_space,
+                                 H5P_DEFAULT, h_prop, H5P_DEFAULT);
   if (h_data < 0) error("Error while creating dataspace '%s'.", props.name);
 
   /* Write unit conversion factors for this data set */
@@ -452,12 +465,17 @@ void prepareArray(struct engine* e, hid_t grp, char* fileName, FILE* xmfFile,
       "Conversion factor to phyical CGS (including cosmological corrections)",
       factor * pow(e->cosmology->a, a_factor_exp));
 
+  /* Record the lossy filter applied to this field */
+  io_write_lossy_compression_attribute(h_data, lossy_compression);
+
   /* Add a line to the XMF */
   if (xmfFile != NULL)
     xmf_write_line(xmfFile, fileName, partTypeGroupName, props.name, N_total,
                    props.dimension, props.type);
 
   /* Close everything */
+  H5Tclose(h_type);
+  H5Pclose(h_prop);
   H5Pclose(h_plist_id);
   H5Dclose(h_data);
   H5Sclose(h_space);
@@ -468,13 +486,14 @@ void prepareArray(struct engine* e, hid_t grp, char* fileName, FILE* xmfFile,
  *
  * @param e The #engine we are writing from.
  * @param h_data The HDF5 dataset to write to.
+ * @param h_plist_id The HDF5 data transfer property list.
  * @param props The #io_props of the field to write.
  * @param N The number of particles to write.
  * @param offset Offset in the array where this mpi task starts writing.
  * @param internal_units The #unit_system used internally.
  * @param snapshot_units The #unit_system used in the snapshots.
  */
-void writeArray_chunk(struct engine* e, hid_t h_data,
+void writeArray_chunk(struct engine* e, hid_t h_data, hid_t h_plist_id,
                       const struct io_props props, size_t N, long long offset,
                       const struct unit_system* internal_units,
                       const struct unit_system* snapshot_units) {
@@ -488,19 +507,24 @@ void writeArray_chunk(struct engine* e, hid_t h_data,
 
   /* message("Writing '%s' array...", props.name); */
 
-  /* Allocate temporary buffer */
-  void* temp = NULL;
-  if (swift_memalign("writebuff", (void**)&temp, IO_BUFFER_ALIGNMENT,
-                     num_elements * typeSize) != 0)
-    error("Unable to allocate temporary i/o buffer");
+  /* Can we write straight from the particles? */
+  const hid_t h_fieldspace =
+      io_write_field_memspace(props, N, internal_units, snapshot_units);
 
 #ifdef IO_SPEED_MEASUREMENT
   MPI_Barrier(MPI_COMM_WORLD);
   ticks tic = getticks();
 #endif
 
-  /* Copy the particle data to the temporary buffer */
-  io_copy_temp_buffer(temp, e, props, N, internal_units, snapshot_units);
+  /* Otherwise, copy the particle data to a temporary buffer */
+  void* temp = NULL;
+  if (h_fieldspace < 0) {
+    if (swift_memalign("writebuff", (void**)&temp, IO_BUFFER_ALIGNMENT,
+                       num_elements * typeSize) != 0)
+      error("Unable to allocate temporary i/o buffer");
+
+    io_copy_temp_buffer(temp, e, props, N, internal_units, snapshot_units);
+  }
 
 #ifdef IO_SPEED_MEASUREMENT
   MPI_Barrier(MPI_COMM_WORLD);
@@ -556,9 +580,13 @@ void writeArray_chunk(struct engine* e, hid_t h_data,
   tic = getticks();
 #endif
 
-  /* Write temporary buffer to HDF5 dataspace */
-  h_err = H5Dwrite(h_data, io_hdf5_type(props.type), h_memspace, h_filespace,
-                   H5P_DEFAULT, temp);
+  /* Write the particles or the temporary buffer to HDF5 dataspace */
+  if (h_fieldspace >= 0)
+    h_err = H5Dwrite(h_data, io_hdf5_type(props.type), h_fieldspace,
+                     h_filespace, h_plist_id, props.field);
+  else
+    h_err = H5Dwrite(h_data, io_hdf5_type(props.type), h_memspace, h_filespace,
+                     h_plist_id, temp);
   if (h_err < 0) error("Error while writing data array '%s'.", props.name);
 
 #ifdef IO_SPEED_MEASUREMENT
@@ -574,7 +602,8 @@ void writeArray_chunk(struct engine* e, hid_t h_data,
 #endif
 
   /* Free and close everything */
-  swift_free("writebuff", temp);
+  if (temp != NULL) swift_free("writebuff", temp);
+  if (h_fieldspace >= 0) H5Sclose(h_fieldspace);
   H5Sclose(h_memspace);
   H5Sclose(h_filespace);
 }
@@ -611,6 +640,16 @@ void writeArray(struct engine* e, hid_t grp, char* fileName,
   const hid_t h_data = H5Dopen(grp, props.name, H5P_DEFAULT);
   if (h_data < 0) error("Error while opening dataset '%s'.", props.name);
 
+  /* Filtered datasets can only be written collectively */
+  const hid_t h_plist_id = H5Pcreate(H5P_DATASET_XFER);
+  const hid_t h_prop = H5Dget_create_plist(h_data);
+  if (H5Pget_nfilters(h_prop) > 0) {
+    const hid_t h_err = H5Pset_dxpl_mpio(h_plist_id, H5FD_MPIO_COLLECTIVE);
+    if (h_err < 0)
+      error("Error setting collective transfer for dataset '%s'.", props.name);
+  }
+  H5Pclose(h_prop);
+
   /* Given the limitations of ROM-IO we will need to write the data in chunk of
      HDF5_PARALLEL_IO_MAX_BYTES bytes per node until all the nodes are done. */
   char redo = 1;
@@ -622,8 +661,8 @@ void writeArray(struct engine* e, hid_t grp, char* fileName,
 
     /* Write the first chunk */
     const size_t this_chunk = (N > max_chunk_size) ? max_chunk_size : N;
-    writeArray_chunk(e, h_data, props, this_chunk, offset, internal_units,
-                     snapshot_units);
+    writeArray_chunk(e, h_data, h_plist_id, props, this_chunk, offset,
+                     internal_units, snapshot_units);
 
     /* Compute how many items are left */
     if (N > max_chunk_size) {
@@ -649,6 +688,7 @@ void writeArray(struct engine* e, hid_t grp, char* fileName,
   }
 
   /* Close everything */
+  H5Pclose(h_plist_id);
   H5Dclose(h_data);
 
 #ifdef IO_SPEED_MEASUREMENT
@@ -659,6 +699,257 @@ void writeArray(struct engine* e, hid_t grp, char* fileName,
 #endif
 }
 
+/**
+ * @brief qsort() comparison function for #ic_range sorted by offset.
+ */
+static int ic_range_cmp(const void* a, const void* b) {
+  const struct ic_range* ra = (const struct ic_range*)a;
+  const struct ic_range* rb = (const struct ic_range*)b;
+  return (ra->offset > rb->offset) - (ra->offset < rb->offset);
+}
+
+/**
+ * @brief Reads a per-cell array of long long from the "Cells" group of the
+ * ICs.
+ *
+ * @param h_cells The opened "Cells" group.
+ * @param name The name of the array (e.g. "Counts/PartType0").
+ * @param nr_cells The number of cells in the array.
+ * @param data (output) The array to fill.
+ *
+ * @return 1 if the array exists and was read, 0 otherwise.
+ */
+static int read_ic_cell_array(hid_t h_cells, const char* name, int nr_cells,
+                              long long* data) {
+
+  /* Check that the whole path exists */
+  char group_name[PARTICLE_GROUP_BUFFER_SIZE];
+  strncpy(group_name, name, PARTICLE_GROUP_BUFFER_SIZE - 1);
+  group_name[PARTICLE_GROUP_BUFFER_SIZE - 1] = '\0';
+  char* slash = strchr(group_name, '/');
+  if (slash != NULL) {
+    *slash = '\0';
+    if (H5Lexists(h_cells, group_name, H5P_DEFAULT) <= 0) return 0;
+  }
+  if (H5Lexists(h_cells, name, H5P_DEFAULT) <= 0) return 0;
+
+  const hid_t h_data = H5Dopen(h_cells, name, H5P_DEFAULT);
+  if (h_data < 0) error("Error while opening cell array '%s'.", name);
+
+  /* Check the size of the array */
+  const hid_t h_space = H5Dget_space(h_data);
+  const hssize_t size = H5Sget_simple_extent_npoints(h_space);
+  H5Sclose(h_space);
+
+  int ok = 0;
+  if (size == nr_cells) {
+    const herr_t h_err = H5Dread(h_data, io_hdf5_type(LONGLONG), H5S_ALL,
+                                 H5S_ALL, H5P_DEFAULT, data);
+    if (h_err < 0) error("Error while reading cell array '%s'.", name);
+    ok = 1;
+  }
+
+  H5Dclose(h_data);
+  return ok;
+}
+
+/**
+ * @brief Decides which particles of the ICs this rank reads, using the
+ * top-level cell meta-data written in snapshots, if present.
+ *
+ * The cells of the ICs are shared out between the ranks, using the geometric
+ * grid of the initial partition when that is in use and otherwise contiguous
+ * blocks of cells of roughly equal particle counts. Each rank then reads the
+ * particles of its own cells, so that the particles start close to the rank
+ * that will own them and the redistribution has little to do. Particle types
+ * without usable meta-data are read as a contiguous block per rank as usual.
+ *
+ * As the ranges of all the cells are checked to tile the arrays in the file,
+ * every particle is read by exactly one rank whatever the quality of the
+ * meta-data.
+ *
+ * @param h_file The opened ICs.
+ * @param initial_partition The #partition that will be used to split the
+ * space, can be NULL.
+ * @param mpi_rank The MPI rank of this node.
+ * @param mpi_size The number of MPI ranks.
+ * @param N_total The total number of particles of each type.
+ * @param N (output) The number of particles of each type to read here.
+ * @param ranges (output) The ranges to read of each type, to be freed.
+ * @param nr_ranges (output) The number of ranges of each type.
+ *
+ * @return The number of cells used, 0 if the ICs do not carry cell
+ * meta-data.
+ */
+static int read_ic_cell_ranges(hid_t h_file,
+                               const struct partition* initial_partition,
+                               int mpi_rank, int mpi_size,
+                               const long long N_total[swift_type_count],
+                               size_t N[swift_type_count],
+                               struct ic_range* ranges[swift_type_count],
+                               int nr_ranges[swift_type_count]) {
+
+  /* Do we have any cell meta-data? */
+  if (H5Lexists(h_file, "/Cells", H5P_DEFAULT) <= 0) return 0;
+  const hid_t h_cells = H5Gopen(h_file, "/Cells", H5P_DEFAULT);
+  if (h_cells < 0) error("Error while opening the cells group");
+  if (H5Lexists(h_cells, "Meta-data", H5P_DEFAULT) <= 0) {
+    H5Gclose(h_cells);
+    return 0;
+  }
+
+  int nr_cells = 0;
+  int cdim[3] = {0, 0, 0};
+  const hid_t h_meta = H5Gopen(h_cells, "Meta-data", H5P_DEFAULT);
+  if (h_meta < 0) error("Error while opening the cells meta-data group");
+  io_read_attribute(h_meta, "nr_cells", INT, &nr_cells);
+  io_read_attribute(h_meta, "dimension", INT, cdim);
+  H5Gclose(h_meta);
+  if (nr_cells <= 0 || nr_cells != cdim[0] * cdim[1] * cdim[2]) {
+    H5Gclose(h_cells);
+    return 0;
+  }
+
+  long long* counts[swift_type_count] = {NULL};
+  long long* offsets[swift_type_count] = {NULL};
+  long long* weights = (long long*)calloc(nr_cells, sizeof(long long));
+  struct ic_range* sorted =
+      (struct ic_range*)malloc(nr_cells * sizeof(struct ic_range));
+  if (weights == NULL || sorted == NULL)
+    error("Unable to allocate memory for the cell meta-data");
+
+  /* Read the counts and offsets of each particle type */
+  long long total_weight = 0;
+  for (int ptype = 0; ptype < swift_type_count; ++ptype) {
+    if (N_total[ptype] == 0) continue;
+
+    counts[ptype] = (long long*)malloc(nr_cells * sizeof(long long));
+    offsets[ptype] = (long long*)malloc(nr_cells * sizeof(long long));
+    if (counts[ptype] == NULL || offsets[ptype] == NULL)
+      error("Unable to allocate memory for the cell meta-data");
+
+    char name[PARTICLE_GROUP_BUFFER_SIZE];
+    snprintf(name, PARTICLE_GROUP_BUFFER_SIZE, "Counts/PartType%d", ptype);
+    int ok = read_ic_cell_array(h_cells, name, nr_cells, counts[ptype]);
+    snprintf(name, PARTICLE_GROUP_BUFFER_SIZE, "Offsets/PartType%d", ptype);
+    ok = ok && read_ic_cell_array(h_cells, name, nr_cells, offsets[ptype]);
+
+    /* Check that the cells tile the whole array */
+    if (ok) {
+      for (int k = 0; k < nr_cells; ++k) {
+        sorted[k].offset = offsets[ptype][k];
+        sorted[k].count = counts[ptype][k];
+      }
+      qsort(sorted, nr_cells, sizeof(struct ic_range), ic_range_cmp);
+      long long next = 0;
+      for (int k = 0; k < nr_cells && ok; ++k) {
+        if (sorted[k].count == 0) continue;
+        if (sorted[k].count < 0 || sorted[k].offset != next) ok = 0;
+        next += sorted[k].count;
+      }
+      if (next != N_total[ptype]) ok = 0;
+    }
+
+    if (!ok) {
+      if (mpi_rank == 0)
+        message(
+            "Cell meta-data of particle type %d does not match the "
+            "particles. Reading them as contiguous blocks.",
+            ptype);
+      free(counts[ptype]);
+      free(offsets[ptype]);
+      counts[ptype] = NULL;
+      offsets[ptype] = NULL;
+      continue;
+    }
+
+    for (int k = 0; k < nr_cells; ++k) weights[k] += counts[ptype][k];
+    total_weight += N_total[ptype];
+  }
+  H5Gclose(h_cells);
+
+  /* Nothing usable after all? */
+  if (total_weight == 0) {
+    free(sorted);
+    free(weights);
+    return 0;
+  }
+
+  /* Share the cells between the ranks */
+  int* owner = (int*)malloc(nr_cells * sizeof(int));
+  if (owner == NULL) error("Unable to allocate memory for the cell owners");
+  if (initial_partition != NULL &&
+      initial_partition->type == INITPART_GRID &&
+      initial_partition->grid[0] * initial_partition->grid[1] *
+              initial_partition->grid[2] ==
+          mpi_size) {
+
+    /* Same geometric split as partition_initial_partition() */
+    const int* grid = initial_partition->grid;
+    for (int i = 0; i < cdim[0]; ++i) {
+      for (int j = 0; j < cdim[1]; ++j) {
+        for (int k = 0; k < cdim[2]; ++k) {
+          const int ind[3] = {(int)((double)i / cdim[0] * grid[0]),
+                              (int)((double)j / cdim[1] * grid[1]),
+                              (int)((double)k / cdim[2] * grid[2])};
+          owner[cell_getid(cdim, i, j, k)] =
+              ind[0] + grid[0] * (ind[1] + grid[1] * ind[2]);
+        }
+      }
+    }
+  } else {
+
+    /* Contiguous blocks of cells with similar numbers of particles */
+    long long done = 0;
+    for (int k = 0; k < nr_cells; ++k) {
+      owner[k] = (total_weight > 0) ? (int)(done * mpi_size / total_weight) : 0;
+      done += weights[k];
+    }
+  }
+
+  /* Collect the ranges of the cells of this rank */
+  for (int ptype = 0; ptype < swift_type_count; ++ptype) {
+    if (counts[ptype] == NULL) continue;
+
+    int count = 0;
+    for (int k = 0; k < nr_cells; ++k) {
+      if (owner[k] != mpi_rank || counts[ptype][k] == 0) continue;
+      sorted[count].offset = offsets[ptype][k];
+      sorted[count].count = counts[ptype][k];
+      count++;
+    }
+
+    /* Merge the ranges that follow each other in the file */
+    qsort(sorted, count, sizeof(struct ic_range), ic_range_cmp);
+    int nr_merged = 0;
+    N[ptype] = 0;
+    for (int k = 0; k < count; ++k) {
+      if (nr_merged > 0 && sorted[nr_merged - 1].offset +
+                                   sorted[nr_merged - 1].count ==
+                               sorted[k].offset)
+        sorted[nr_merged - 1].count += sorted[k].count;
+      else
+        sorted[nr_merged++] = sorted[k];
+      N[ptype] += sorted[k].count;
+    }
+
+    ranges[ptype] =
+        (struct ic_range*)malloc(max(nr_merged, 1) * sizeof(struct ic_range));
+    if (ranges[ptype] == NULL)
+      error("Unable to allocate memory for the particle ranges");
+    memcpy(ranges[ptype], sorted, nr_merged * sizeof(struct ic_range));
+    nr_ranges[ptype] = nr_merged;
+
+    free(counts[ptype]);
+    free(offsets[ptype]);
+  }
+
+  free(owner);
+  free(sorted);
+  free(weights);
+  return nr_cells;
+}
+
 /**
  * @brief Reads an HDF5 initial condition file (GADGET-3 type) in parallel
  *
@@ -688,6 +979,9 @@ void writeArray(struct engine* e, hid_t grp, char* fileName,
  * @param mpi_size The number of MPI ranks
  * @param comm The MPI communicator
  * @param info The MPI information object
+ * @param initial_partition The #partition that will be used to split the
+ * space. Used to pick the particles of each rank when the ICs carry cell
+ * meta-data. Can be NULL.
  * @param n_threads The number of threads to use for local operations.
  * @param dry_run If 1, don't read the particle. Only allocates the arrays.
  *
@@ -700,7 +994,8 @@ void read_ic_parallel(char* fileName, const struct unit_system* internal_units,
                       int with_gravity, int with_stars, int with_black_holes,
                       int cleanup_h, int cleanup_sqrt_a, double h, double a,
                       int mpi_rank, int mpi_size, MPI_Comm comm, MPI_Info info,
-                      int n_threads, int dry_run) {
+                      const struct partition* initial_partition, int n_threads,
+                      int dry_run) {
 
   hid_t h_file = 0, h_grp = 0;
   /* GADGET has only cubic boxes (in cosmological mode) */
@@ -792,6 +1087,27 @@ void read_ic_parallel(char* fileName, const struct unit_system* internal_units,
     N[ptype] = (mpi_rank + 1) * N_total[ptype] / mpi_size - offset[ptype];
   }
 
+  /* If the ICs know where the particles are, read those of our cells */
+  struct ic_range* ranges[swift_type_count] = {NULL};
+  int nr_ranges[swift_type_count] = {0};
+  const int nr_cells_ics =
+      read_ic_cell_ranges(h_file, initial_partition, mpi_rank, mpi_size,
+                          N_total, N, ranges, nr_ranges);
+  if (nr_cells_ics > 0 && mpi_rank == 0)
+    message("Reading the particles of the %d top-level cells of the ICs.",
+            nr_cells_ics);
+
+  /* The other particles are read as one contiguous block per rank */
+  for (int ptype = 0; ptype < swift_type_count; ++ptype) {
+    if (ranges[ptype] != NULL) continue;
+    ranges[ptype] = (struct ic_range*)malloc(sizeof(struct ic_range));
+    if (ranges[ptype] == NULL)
+      error("Unable to allocate memory for the particle ranges");
+    ranges[ptype][0].offset = offset[ptype];
+    ranges[ptype][0].count = N[ptype];
+    nr_ranges[ptype] = 1;
+  }
+
   /* Close header */
   H5Gclose(h_grp);
 
@@ -883,6 +1199,10 @@ void read_ic_parallel(char* fileName, const struct unit_system* internal_units,
   /* message("BoxSize = %lf", dim[0]); */
   /* message("NumPart = [%zd, %zd] Total = %zd", *Ngas, Ndm, *Ngparts); */
 
+  /* Let's initialise a bit of thread parallelism here */
+  struct threadpool tp;
+  threadpool_init(&tp, n_threads);
+
   /* Loop over all particle types */
   for (int ptype = 0; ptype < swift_type_count; ptype++) {
 
@@ -943,8 +1263,8 @@ void read_ic_parallel(char* fileName, const struct unit_system* internal_units,
     if (!dry_run)
       for (int i = 0; i < num_fields; ++i)
         readArray(h_grp, list[i], Nparticles, N_total[ptype], mpi_rank,
-                  offset[ptype], internal_units, ic_units, cleanup_h,
-                  cleanup_sqrt_a, h, a);
+                  ranges[ptype], nr_ranges[ptype], internal_units, ic_units,
+                  cleanup_h, cleanup_sqrt_a, h, a, &tp);
 
     /* Close particle group */
     H5Gclose(h_grp);
@@ -952,10 +1272,6 @@ void read_ic_parallel(char* fileName, const struct unit_system* internal_units,
 
   if (!dry_run && with_gravity) {
 
-    /* Let's initialise a bit of thread parallelism here */
-    struct threadpool tp;
-    threadpool_init(&tp, n_threads);
-
     /* Prepare the DM particles */
     io_prepare_dm_gparts(&tp, *gparts, Ndm);
 
@@ -970,14 +1286,15 @@ void read_ic_parallel(char* fileName, const struct unit_system* internal_units,
     if (with_black_holes)
       io_duplicate_black_holes_gparts(&tp, *bparts, *gparts, *Nblackholes,
                                       Ndm + *Ngas + *Nstars);
-
-    threadpool_clean(&tp);
   }
 
+  threadpool_clean(&tp);
+
   /* message("Done Reading particles..."); */
 
   /* Clean up */
   free(ic_units);
+  for (int ptype = 0; ptype < swift_type_count; ++ptype) free(ranges[ptype]);
 
   /* Close property handler */
   H5Pclose(h_plist_id);
@@ -1245,15 +1562,16 @@ void prepare_file(struct engine* e, const char* baseName, long long N_total[6],
     /* Prepare everything that is not cancelled */
     for (int i = 0; i < num_fields; ++i) {
 
-      /* Did the user cancel this field? */
+      /* Did the user cancel or compress this field? */
       char field[PARSER_MAX_LINE_SIZE];
       sprintf(field, "SelectOutput:%s_%s", list[i].name,
               part_type_names[ptype]);
-      int should_write = parser_get_opt_param_int(params, field, 1);
+      const enum lossy_compression_schemes compression_level =
+          io_get_field_compression(params, field);
 
-      if (should_write)
+      if (compression_level != compression_do_not_write)
         prepareArray(e, h_grp, fileName, xmfFile, partTypeGroupName, list[i],
-                     N_total[ptype], snapshot_units);
+                     N_total[ptype], snapshot_units, compression_level);
     }
 
     /* Close particle group */
@@ -1718,9 +2036,10 @@ void write_output_parallel(struct engine* e, const char* baseName,
       char field[PARSER_MAX_LINE_SIZE];
       sprintf(field, "SelectOutput:%s_%s", list[i].name,
               part_type_names[ptype]);
-      int should_write = parser_get_opt_param_int(params, field, 1);
+      const enum lossy_compression_schemes compression_level =
+          io_get_field_compression(params, field);
 
-      if (should_write)
+      if (compression_level != compression_do_not_write)
         writeArray(e, h_grp, fileName, partTypeGroupName, list[i], Nparticles,
                    N_total[ptype], mpi_rank, offset[ptype], internal_units,
                    snapshot_units);
@@ -31,6 +31,7 @@
 #include "engine.h"
 #include "io_properties.h"
 #include "part.h"
+#include "partition.h"
 #include "units.h"
 
 void read_ic_parallel(char* fileName, const struct unit_system* internal_units,
@@ -41,7 +42,8 @@ void read_ic_parallel(char* fileName, const struct unit_system* internal_units,
                       int with_gravity, int with_stars, int with_black_holes,
                       int cleanup_h, int cleanup_sqrt_a, double h, double a,
                       int mpi_rank, int mpi_size, MPI_Comm comm, MPI_Info info,
-                      int nr_threads, int dry_run);
+                      const struct partition* initial_partition, int nr_threads,
+                      int dry_run);
 
 void write_output_parallel(struct engine* e, const char* baseName,
                            const struct unit_system* internal_units,
@@ -216,8 +216,9 @@ void parser_set_param(struct swift_params *params, const char *namevalue) {
       memcpy(name, namevalue, p2 - namevalue);
       name[p2 - namevalue] = '\0';
 
-      /* Value is rest after second colon. */
+      /* Value is rest after second colon, without leading spaces. */
       p2++;
+      while (*p2 == ' ') p2++;
       strcpy(value, p2);
     }
   }
@@ -750,7 +751,7 @@ void parser_get_opt_param_string(struct swift_params *params, const char *name,
       strcpy(retParam, params->data[i].value);
 
       /* Ensure same behavior if called multiple times for same parameter */
-      if (params->data[i].is_default && !strcmp(def, retParam))
+      if (params->data[i].is_default && strcmp(def, retParam))
         error(
             "Tried parsing %s again but cannot parse a parameter with "
             "two different default value ('%s' != '%s')",
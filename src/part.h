@@ -43,13 +43,20 @@
 #define gpart_align 128
 #define bpart_align 128
 
-/* Import the right hydro particle definition */
+/* Import the right hydro particle definition.
+ * HYDRO_VEC_DENSITY and HYDRO_VEC_FORCE flag the schemes whose neighbour loops
+ * have a hand-vectorised version in runner_doiact_vec.c. The scheme then
+ * provides the runner_iact_nonsym_[1,2]_vec_*() functions and the fields read
+ * into the #cache must exist in its #part. */
 #if defined(MINIMAL_SPH)
 #include "./hydro/Minimal/hydro_part.h"
 #define hydro_need_extra_init_loop 0
+#define HYDRO_VEC_DENSITY
 #elif defined(GADGET2_SPH)
 #include "./hydro/Gadget2/hydro_part.h"
 #define hydro_need_extra_init_loop 0
+#define HYDRO_VEC_DENSITY
+#define HYDRO_VEC_FORCE
 #elif defined(HOPKINS_PE_SPH)
 #include "./hydro/PressureEntropy/hydro_part.h"
 #define hydro_need_extra_init_loop 1
@@ -25,6 +25,8 @@
  *  these around a number of MPI nodes.
  *
  *  Currently supported partitioning types: grid, vectorise and METIS/ParMETIS.
+ *  Repartitioning can also be done without METIS by cutting a space-filling
+ *  curve through the top-level cells.
  */
 
 /* Config parameters. */
@@ -72,7 +74,8 @@ const char *initial_partition_name[] = {
 const char *repartition_name[] = {
     "none", "edge and vertex task cost weights", "task cost edge weights",
     "memory balanced, using particle vertex weights",
-    "vertex task costs and edge delta timebin weights"};
+    "vertex task costs and edge delta timebin weights",
+    "space-filling curve cut using task cost weights"};
 
 /* Local functions, if needed. */
 static int check_complete(struct space *s, int verbose, int nregions);
@@ -81,9 +84,15 @@ static int check_complete(struct space *s, int verbose, int nregions);
  * Repartition fixed costs per type/subtype. These are determined from the
  * statistics output produced when running with task debugging enabled.
  */
-#if defined(WITH_MPI) && (defined(HAVE_METIS) || defined(HAVE_PARMETIS))
+#if defined(WITH_MPI)
 static double repartition_costs[task_type_count][task_subtype_count];
 #endif
+
+/* Without METIS we still gather the task weights for the space-filling curve
+ * repartitioner, so need a type for the (unused) cell graph indices. */
+#if defined(WITH_MPI) && !(defined(HAVE_METIS) || defined(HAVE_PARMETIS))
+typedef int idx_t;
+#endif
 #if defined(WITH_MPI)
 static int repart_init_fixed_costs(void);
 #endif
@@ -468,7 +477,7 @@ static void split_metis(struct space *s, int nregions, int *celllist) {
 }
 #endif
 
-#if defined(WITH_MPI) && (defined(HAVE_METIS) || defined(HAVE_PARMETIS))
+#if defined(WITH_MPI)
 
 /* qsort support. */
 struct indexval {
@@ -1243,7 +1252,7 @@ static void pick_metis(int nodeID, struct space *s, int nregions,
 }
 #endif
 
-#if defined(WITH_MPI) && (defined(HAVE_METIS) || defined(HAVE_PARMETIS))
+#if defined(WITH_MPI)
 
 /* Helper struct for partition_gather weights. */
 struct weights_mapper_data {
@@ -1257,13 +1266,21 @@ struct weights_mapper_data {
   int nr_cells;
   int use_ticks;
   struct cell *cells;
+  const struct cost_model *cost_model;
 };
 
-#ifdef SWIFT_DEBUG_CHECKS
-static void check_weights(struct task *tasks, int nr_tasks,
-                          struct weights_mapper_data *weights_data,
-                          double *weights_v, double *weights_e);
-#endif
+/**
+ * @brief The cost model to use for the task weights, if any.
+ *
+ * @param s the space.
+ * @return the calibrated #cost_model of the scheduler, or NULL when that is
+ *         not in use or has no timings yet.
+ */
+static const struct cost_model *partition_cost_model(struct space *s) {
+  const struct cost_model *cm = &s->e->sched.cost_model;
+  if (cm->enabled && cm->coeff_all > 0.) return cm;
+  return NULL;
+}
 
 /**
  * @brief Threadpool mapper function to gather cell edge and vertex weights
@@ -1288,6 +1305,7 @@ static void partition_gather_weights(void *map_data, int num_elements,
   int timebins = mydata->timebins;
   int vweights = mydata->vweights;
   int use_ticks = mydata->use_ticks;
+  const struct cost_model *cost_model = mydata->cost_model;
 
   struct cell *cells = mydata->cells;
 
@@ -1300,9 +1318,12 @@ static void partition_gather_weights(void *map_data, int num_elements,
         t->type == task_type_logger || t->implicit || t->ci == NULL)
       continue;
 
-    /* Get weight for this task. Either based on fixed costs or task timings. */
+    /* Get weight for this task. Either based on the calibrated cost model,
+     * task timings or fixed costs. */
     double w = 0.0;
-    if (use_ticks) {
+    if (cost_model != NULL) {
+      w = cost_model_task_cost(cost_model, t, nodeID);
+    } else if (use_ticks) {
       w = (double)t->toc - (double)t->tic;
     } else {
       w = repartition_costs[t->type][t->subtype];
@@ -1329,7 +1350,8 @@ static void partition_gather_weights(void *map_data, int num_elements,
         t->type == task_type_end_hydro_force ||
         t->type == task_type_end_grav_force || t->type == task_type_cooling ||
         t->type == task_type_star_formation || t->type == task_type_timestep ||
-        t->type == task_type_init_grav || t->type == task_type_grav_down ||
+        t->type == task_type_kick_timestep || t->type == task_type_init_grav ||
+        t->type == task_type_grav_down ||
         t->type == task_type_grav_long_range) {
 
       /* Particle updates add only to vertex weight. */
@@ -1417,6 +1439,16 @@ static void partition_gather_weights(void *map_data, int num_elements,
   }
 }
 
+#endif
+
+#if defined(WITH_MPI) && (defined(HAVE_METIS) || defined(HAVE_PARMETIS))
+
+#ifdef SWIFT_DEBUG_CHECKS
+static void check_weights(struct task *tasks, int nr_tasks,
+                          struct weights_mapper_data *weights_data,
+                          double *weights_v, double *weights_e);
+#endif
+
 /**
  * @brief Repartition the cells amongst the nodes using weights of
  *        various kinds.
@@ -1478,6 +1510,7 @@ static void repart_edge_metis(int vweights, int eweights, int timebins,
   weights_data.weights_e = weights_e;
   weights_data.weights_v = weights_v;
   weights_data.use_ticks = repartition->use_ticks;
+  weights_data.cost_model = partition_cost_model(s);
 
   ticks tic = getticks();
 
@@ -1738,6 +1771,298 @@ static void repart_memory_metis(struct repartition *repartition, int nodeID,
 }
 #endif /* WITH_MPI && (HAVE_METIS || HAVE_PARMETIS) */
 
+  /* Space-filling curve support
+   * ===========================
+   *
+   * The top-level cells are ordered along a Hilbert curve, which keeps
+   * consecutive cells geometrically close, and the curve is then cut into
+   * segments of equal measured cost. This needs no external libraries and
+   * tends to produce compact regions whose boundaries move little between
+   * repartitions, so we also try to reuse the previous cuts when that costs
+   * little in balance.
+   */
+
+#if defined(WITH_MPI)
+/**
+ * @brief Compute the key of a cell along a 3D Hilbert curve.
+ *
+ * Uses the transpose algorithm of Skilling (2004, AIP Conf. Proc. 707, 381)
+ * to convert the integer coordinates into the transposed Hilbert index and
+ * then interleaves the bits into a single key.
+ *
+ * @param nbits the number of bits needed to represent any coordinate.
+ * @param loc the integer coordinates of the cell.
+ * @return the position of the cell along the curve.
+ */
+static unsigned long long hilbert_key(int nbits, const int loc[3]) {
+
+  unsigned int x[3] = {(unsigned int)loc[0], (unsigned int)loc[1],
+                       (unsigned int)loc[2]};
+  const unsigned int m = 1u << (nbits - 1);
+
+  /* Inverse undo excess work. */
+  for (unsigned int q = m; q > 1; q >>= 1) {
+    const unsigned int p = q - 1;
+    for (int i = 0; i < 3; i++) {
+      if (x[i] & q) {
+        x[0] ^= p;
+      } else {
+        const unsigned int t = (x[0] ^ x[i]) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+
+  /* Gray encode. */
+  for (int i = 1; i < 3; i++) x[i] ^= x[i - 1];
+  unsigned int t = 0;
+  for (unsigned int q = m; q > 1; q >>= 1)
+    if (x[2] & q) t ^= q - 1;
+  for (int i = 0; i < 3; i++) x[i] ^= t;
+
+  /* Interleave the transposed bits, most significant first. */
+  unsigned long long key = 0;
+  for (int b = nbits - 1; b >= 0; b--)
+    for (int i = 0; i < 3; i++) key = (key << 1) | ((x[i] >> b) & 1u);
+
+  return key;
+}
+
+/* qsort support. */
+struct sfc_key {
+  unsigned long long key;
+  int cid;
+};
+static int sfckeycmp(const void *p1, const void *p2) {
+  const struct sfc_key *k1 = (const struct sfc_key *)p1;
+  const struct sfc_key *k2 = (const struct sfc_key *)p2;
+  if (k1->key < k2->key) return -1;
+  if (k1->key > k2->key) return 1;
+  return 0;
+}
+
+/**
+ * @brief Partition the top-level cells by cutting a Hilbert curve into
+ *        segments of equal weight.
+ *
+ * Each cut is first placed where the cumulative weight along the curve
+ * crosses its ideal value. If a boundary of the old partition lies within
+ * the given fractional tolerance of that weight, the cut is moved there
+ * instead, so that cells only migrate when that noticeably improves the
+ * balance.
+ *
+ * @param s the space of cells, with their current nodeIDs.
+ * @param nregions the number of regions.
+ * @param weights the weight of each cell, NULL or all zero for equal weights.
+ * @param tolerance the fractional imbalance per region allowed to keep an
+ *                  old boundary.
+ * @param celllist on exit the region of each cell.
+ */
+static void pick_sfc(struct space *s, int nregions, const double *weights,
+                     float tolerance, int *celllist) {
+
+  const int nr_cells = s->nr_cells;
+  if (nregions > nr_cells)
+    error("Too few cells (%d) for this number of regions (%d)", nr_cells,
+          nregions);
+
+  /* Bits needed to hold the largest cell coordinate. */
+  const int cmax = max3(s->cdim[0], s->cdim[1], s->cdim[2]);
+  int nbits = 1;
+  while ((1 << nbits) < cmax) nbits++;
+
+  /* Order the cells along the curve. */
+  struct sfc_key *keys = NULL;
+  if ((keys = (struct sfc_key *)malloc(sizeof(struct sfc_key) * nr_cells)) ==
+      NULL)
+    error("Failed to allocate the curve keys");
+  for (int i = 0; i < s->cdim[0]; i++) {
+    for (int j = 0; j < s->cdim[1]; j++) {
+      for (int k = 0; k < s->cdim[2]; k++) {
+        const int loc[3] = {i, j, k};
+        const int cid = cell_getid(s->cdim, i, j, k);
+        keys[cid].key = hilbert_key(nbits, loc);
+        keys[cid].cid = cid;
+      }
+    }
+  }
+  qsort(keys, nr_cells, sizeof(struct sfc_key), sfckeycmp);
+
+  /* Cumulative weight along the curve, fall back to counting cells when
+   * there are no useful weights. */
+  double *cumw = NULL;
+  if ((cumw = (double *)malloc(sizeof(double) * (nr_cells + 1))) == NULL)
+    error("Failed to allocate the cumulative weights");
+  double wsum = 0.0;
+  if (weights != NULL)
+    for (int k = 0; k < nr_cells; k++) wsum += weights[k];
+  cumw[0] = 0.0;
+  for (int k = 0; k < nr_cells; k++) {
+    const double w = (wsum > 0.0) ? weights[keys[k].cid] : 1.0;
+    cumw[k + 1] = cumw[k] + w;
+  }
+  wsum = cumw[nr_cells];
+  const double wregion = wsum / nregions;
+
+  /* Place the cuts, each region covers [cuts[r], cuts[r+1]) on the curve. */
+  int *cuts = NULL;
+  if ((cuts = (int *)malloc(sizeof(int) * (nregions + 1))) == NULL)
+    error("Failed to allocate the curve cuts");
+  cuts[0] = 0;
+  cuts[nregions] = nr_cells;
+  int ind = 1;
+  for (int r = 1; r < nregions; r++) {
+    const double target = r * wregion;
+
+    /* Ideal cut, the first position at or beyond the target weight, or the
+     * one before if that is closer. */
+    while (ind < nr_cells && cumw[ind] < target) ind++;
+    int cut = ind;
+    if (cut > 1 && (target - cumw[cut - 1]) < (cumw[cut] - target)) cut--;
+
+    /* Look for the nearest old boundary within the tolerance. */
+    const int ideal = cut;
+    const double slack = tolerance * wregion;
+    double best = slack;
+    for (int k = ideal; k > 0 && target - cumw[k] <= slack; k--) {
+      if (k < nr_cells && s->cells_top[keys[k - 1].cid].nodeID !=
+                              s->cells_top[keys[k].cid].nodeID) {
+        if (fabs(cumw[k] - target) <= best) {
+          best = fabs(cumw[k] - target);
+          cut = k;
+        }
+      }
+    }
+    for (int k = ideal + 1; k < nr_cells && cumw[k] - target <= slack; k++) {
+      if (s->cells_top[keys[k - 1].cid].nodeID !=
+          s->cells_top[keys[k].cid].nodeID) {
+        if (fabs(cumw[k] - target) < best) {
+          best = fabs(cumw[k] - target);
+          cut = k;
+        }
+      }
+    }
+
+    /* Every region must get at least one cell. */
+    if (cut <= cuts[r - 1]) cut = cuts[r - 1] + 1;
+    if (cut > nr_cells - (nregions - r)) cut = nr_cells - (nregions - r);
+    cuts[r] = cut;
+  }
+
+  /* And assign the segments. */
+  for (int r = 0; r < nregions; r++)
+    for (int k = cuts[r]; k < cuts[r + 1]; k++) celllist[keys[k].cid] = r;
+
+  free(cuts);
+  free(cumw);
+  free(keys);
+}
+
+/**
+ * @brief Repartition the cells amongst the nodes by cutting a space-filling
+ *        curve using the measured or fixed task costs as weights.
+ *
+ * @param repartition the partition struct of the local engine.
+ * @param nodeID our nodeID.
+ * @param nr_nodes the number of nodes.
+ * @param s the space of cells holding our local particles.
+ * @param tasks the completed tasks from the last engine step for our node.
+ * @param nr_tasks the number of tasks.
+ */
+static void repart_sfc_costs(struct repartition *repartition, int nodeID,
+                             int nr_nodes, struct space *s, struct task *tasks,
+                             int nr_tasks) {
+
+  const int nr_cells = s->nr_cells;
+  struct cell *cells = s->cells_top;
+
+  /* Vertex weights only, there is no graph to cut. */
+  double *weights_v = NULL;
+  if ((weights_v = (double *)malloc(sizeof(double) * nr_cells)) == NULL)
+    error("Failed to allocate vertex weights arrays.");
+  bzero(weights_v, sizeof(double) * nr_cells);
+
+  struct weights_mapper_data weights_data;
+  weights_data.cells = cells;
+  weights_data.eweights = 0;
+  weights_data.inds = NULL;
+  weights_data.nodeID = nodeID;
+  weights_data.nr_cells = nr_cells;
+  weights_data.timebins = 0;
+  weights_data.vweights = 1;
+  weights_data.weights_e = NULL;
+  weights_data.weights_v = weights_v;
+  weights_data.use_ticks = repartition->use_ticks;
+  weights_data.cost_model = partition_cost_model(s);
+
+  ticks tic = getticks();
+
+  threadpool_map(&s->e->threadpool, partition_gather_weights, tasks, nr_tasks,
+                 sizeof(struct task), 0, &weights_data);
+  if (s->e->verbose)
+    message("weight mapper took %.3f %s.", clocks_from_ticks(getticks() - tic),
+            clocks_getunit());
+
+  /* Merge the weights arrays across all nodes. */
+  int res = MPI_Allreduce(MPI_IN_PLACE, weights_v, nr_cells, MPI_DOUBLE,
+                          MPI_SUM, MPI_COMM_WORLD);
+  if (res != MPI_SUCCESS) mpi_error(res, "Failed to allreduce vertex weights.");
+
+  /* Allocate cell list for the partition. If not already done. */
+  if (repartition->ncelllist != nr_cells) {
+    free(repartition->celllist);
+    repartition->ncelllist = 0;
+    if ((repartition->celllist = (int *)malloc(sizeof(int) * nr_cells)) == NULL)
+      error("Failed to allocate celllist");
+    repartition->ncelllist = nr_cells;
+  }
+
+  /* Cut the curve on one node, so that all nodes agree exactly, and then
+   * relabel the regions to keep as many cells as possible on their current
+   * node. */
+  if (nodeID == 0) {
+    int *newcelllist = NULL;
+    int *oldcelllist = NULL;
+    if ((newcelllist = (int *)malloc(sizeof(int) * nr_cells)) == NULL ||
+        (oldcelllist = (int *)malloc(sizeof(int) * nr_cells)) == NULL)
+      error("Failed to allocate new and old celllists");
+    for (int k = 0; k < nr_cells; k++) oldcelllist[k] = cells[k].nodeID;
+
+    pick_sfc(s, nr_nodes, weights_v, repartition->sfc_tolerance, newcelllist);
+    permute_regions(newcelllist, oldcelllist, nr_nodes, nr_cells,
+                    repartition->celllist);
+
+    if (s->e->verbose) {
+      int nmoved = 0;
+      for (int k = 0; k < nr_cells; k++)
+        if (repartition->celllist[k] != oldcelllist[k]) nmoved++;
+      message("%d of %d cells change node.", nmoved, nr_cells);
+    }
+    free(newcelllist);
+    free(oldcelllist);
+  }
+  res = MPI_Bcast(repartition->celllist, nr_cells, MPI_INT, 0, MPI_COMM_WORLD);
+  if (res != MPI_SUCCESS) mpi_error(res, "Failed to bcast new celllist");
+
+  /* Check that the partition is complete and all nodes have some work. */
+  int present[nr_nodes];
+  for (int i = 0; i < nr_nodes; i++) present[i] = 0;
+  for (int i = 0; i < nr_cells; i++) {
+    if (repartition->celllist[i] < 0 || repartition->celllist[i] >= nr_nodes)
+      error("Got bad nodeID %d for cell %i.", repartition->celllist[i], i);
+    present[repartition->celllist[i]]++;
+  }
+  for (int i = 0; i < nr_nodes; i++)
+    if (!present[i]) error("Node %d is not present after repartition", i);
+
+  /* And apply to our cells */
+  for (int k = 0; k < nr_cells; k++) cells[k].nodeID = repartition->celllist[k];
+
+  free(weights_v);
+}
+#endif /* WITH_MPI */
+
 /**
  * @brief Repartition the space using the given repartition type.
  *
@@ -1755,11 +2080,18 @@ void partition_repartition(struct repartition *reparttype, int nodeID,
                            int nr_nodes, struct space *s, struct task *tasks,
                            int nr_tasks) {
 
-#if defined(WITH_MPI) && (defined(HAVE_METIS) || defined(HAVE_PARMETIS))
+#if defined(WITH_MPI)
 
   ticks tic = getticks();
 
-  if (reparttype->type == REPART_METIS_VERTEX_EDGE_COSTS) {
+  if (reparttype->type == REPART_SFC_COSTS) {
+    repart_sfc_costs(reparttype, nodeID, nr_nodes, s, tasks, nr_tasks);
+
+  } else if (reparttype->type == REPART_NONE) {
+    /* Doing nothing. */
+
+#if defined(HAVE_METIS) || defined(HAVE_PARMETIS)
+  } else if (reparttype->type == REPART_METIS_VERTEX_EDGE_COSTS) {
     repart_edge_metis(1, 1, 0, reparttype, nodeID, nr_nodes, s, tasks,
                       nr_tasks);
 
@@ -1773,9 +2105,7 @@ void partition_repartition(struct repartition *reparttype, int nodeID,
 
   } else if (reparttype->type == REPART_METIS_VERTEX_COUNTS) {
     repart_memory_metis(reparttype, nodeID, nr_nodes, s);
-
-  } else if (reparttype->type == REPART_NONE) {
-    /* Doing nothing. */
+#endif
 
   } else {
     error("Impossible repartition type");
@@ -1785,7 +2115,7 @@ void partition_repartition(struct repartition *reparttype, int nodeID,
     message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
             clocks_getunit());
 #else
-  error("SWIFT was not compiled with METIS or ParMETIS support.");
+  error("SWIFT was not compiled with MPI support.");
 #endif
 }
 
@@ -2014,16 +2344,22 @@ void partition_init(struct partition *partition,
   } else if (strcmp("timecosts", part_type) == 0) {
     repartition->type = REPART_METIS_VERTEX_COSTS_TIMEBINS;
 
+  } else if (strcmp("sfccosts", part_type) == 0) {
+    repartition->type = REPART_SFC_COSTS;
+
   } else {
     message("Invalid choice of re-partition type '%s'.", part_type);
     error(
         "Permitted values are: 'none', 'fullcosts', 'edgecosts' "
-        "'memory' or 'timecosts'");
+        "'memory', 'timecosts' or 'sfccosts'");
 #else
+  } else if (strcmp("sfccosts", part_type) == 0) {
+    repartition->type = REPART_SFC_COSTS;
+
   } else {
     message("Invalid choice of re-partition type '%s'.", part_type);
     error(
-        "Permitted values are: 'none' when compiled without "
+        "Permitted values are: 'none' or 'sfccosts' when compiled without "
         "METIS or ParMETIS.");
 #endif
   }
@@ -2061,6 +2397,15 @@ void partition_init(struct partition *partition,
   repartition->itr =
       parser_get_opt_param_float(params, "DomainDecomposition:itr", 100.0f);
 
+  /* Fractional imbalance per region accepted to keep an old cut of the
+   * space-filling curve, rather than migrating cells. */
+  repartition->sfc_tolerance = parser_get_opt_param_float(
+      params, "DomainDecomposition:sfc_tolerance", 0.01f);
+  if (repartition->sfc_tolerance < 0.f || repartition->sfc_tolerance >= 1.f)
+    error(
+        "Invalid DomainDecomposition:sfc_tolerance, must be greater than or "
+        "equal to 0 and less than 1");
+
   /* Clear the celllist for use. */
   repartition->ncelllist = 0;
   repartition->celllist = NULL;
@@ -2105,7 +2450,7 @@ void partition_init(struct partition *partition,
  */
 static int repart_init_fixed_costs(void) {
 
-#if defined(WITH_MPI) && (defined(HAVE_METIS) || defined(HAVE_PARMETIS))
+#if defined(WITH_MPI)
   /* Set the default fixed cost. */
   for (int j = 0; j < task_type_count; j++) {
     for (int k = 0; k < task_subtype_count; k++) {
@@ -2181,6 +2526,7 @@ static void check_weights(struct task *tasks, int nr_tasks,
   int timebins = mydata->timebins;
   int vweights = mydata->vweights;
   int use_ticks = mydata->use_ticks;
+  const struct cost_model *cost_model = mydata->cost_model;
 
   struct cell *cells = mydata->cells;
 
@@ -2209,9 +2555,12 @@ static void check_weights(struct task *tasks, int nr_tasks,
         t->type == task_type_logger || t->implicit || t->ci == NULL)
       continue;
 
-    /* Get weight for this task. Either based on fixed costs or task timings. */
+    /* Get weight for this task. Either based on the calibrated cost model,
+     * task timings or fixed costs. */
     double w = 0.0;
-    if (use_ticks) {
+    if (cost_model != NULL) {
+      w = cost_model_task_cost(cost_model, t, nodeID);
+    } else if (use_ticks) {
       w = (double)t->toc - (double)t->tic;
     } else {
       w = repartition_costs[t->type][t->subtype];
@@ -2238,7 +2587,8 @@ static void check_weights(struct task *tasks, int nr_tasks,
         t->type == task_type_end_hydro_force ||
         t->type == task_type_end_grav_force || t->type == task_type_cooling ||
         t->type == task_type_star_formation || t->type == task_type_timestep ||
-        t->type == task_type_init_grav || t->type == task_type_grav_down ||
+        t->type == task_type_kick_timestep || t->type == task_type_init_grav ||
+        t->type == task_type_grav_down ||
         t->type == task_type_grav_long_range) {
 
       /* Particle updates add only to vertex weight. */
@@ -47,7 +47,8 @@ enum repartition_type {
   REPART_METIS_VERTEX_EDGE_COSTS,
   REPART_METIS_EDGE_COSTS,
   REPART_METIS_VERTEX_COUNTS,
-  REPART_METIS_VERTEX_COSTS_TIMEBINS
+  REPART_METIS_VERTEX_COSTS_TIMEBINS,
+  REPART_SFC_COSTS
 };
 
 /* Repartition preferences. */
@@ -56,6 +57,7 @@ struct repartition {
   float trigger;
   float minfrac;
   float itr;
+  float sfc_tolerance;
   int usemetis;
   int adaptive;
 
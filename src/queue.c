@@ -153,6 +153,7 @@ void queue_init(struct queue *q, struct task *tasks) {
   q->first_incoming = 0;
   q->last_incoming = 0;
   q->count_incoming = 0;
+  q->nr_steals = 0;
 }
 
 /**
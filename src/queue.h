@@ -58,6 +58,9 @@ struct queue {
   int *tid_incoming;
   volatile unsigned int first_incoming, last_incoming, count_incoming;
 
+  /* Number of tasks taken from other queues by the runners of this queue. */
+  int nr_steals;
+
 } __attribute__((aligned(queue_struct_align)));
 
 /* Function prototypes. */
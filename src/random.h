@@ -24,22 +24,16 @@
 #include "../config.h"
 
 /* Standard header */
+#include <stdint.h>
 #include <stdlib.h>
 
 /**
  * @brief The categories of random number generated.
  *
- * The values of the fields are carefully chose numbers
- * the numbers are very large primes such that the IDs
- * will not have a prime factorization with this coefficient
- * this results in a very high period for the random number
- * generator.
- * Only change when you know what you are doing, changing
- * the numbers to bad values will break the random number
- * generator.
- * In case new numbers need to be added other possible
- * numbers could be:
- * 5947309451, 6977309513
+ * The values are used as part of the counter of the generator such that
+ * the different categories produce independent streams of numbers for the
+ * same particle and time. They only need to be distinct; they are kept at
+ * the values used by earlier versions of the generator.
  */
 enum random_number_type {
   random_number_star_formation = 0LL,
@@ -49,6 +43,67 @@ enum random_number_type {
   random_number_BH_swallow = 4947009007LL
 };
 
+/*! Number of rounds of the Philox generator */
+#define random_philox_rounds 10
+
+/* Constants of the Philox-4x32 generator (Salmon et al. 2011, SC'11) */
+#define random_philox_M0 0xD2511F53u
+#define random_philox_M1 0xCD9E8D57u
+#define random_philox_W0 0x9E3779B9u
+#define random_philox_W1 0xBB67AE85u
+
+/**
+ * @brief Apply the Philox-4x32 bijection to a 128-bit counter using a 64-bit
+ * key.
+ *
+ * The output is a pseudo-random function of the counter and key. There is no
+ * internal state, so any number in the sequence can be generated directly,
+ * independently of all the others.
+ *
+ * @param ctr (in/out) The 4 words of the counter, replaced by the output.
+ * @param key The 2 words of the key.
+ */
+__attribute__((always_inline)) INLINE static void random_philox4x32(
+    uint32_t ctr[4], const uint32_t key[2]) {
+
+  uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  uint32_t k0 = key[0], k1 = key[1];
+
+  for (int r = 0; r < random_philox_rounds; ++r) {
+
+    const uint64_t p0 = (uint64_t)random_philox_M0 * c0;
+    const uint64_t p1 = (uint64_t)random_philox_M1 * c2;
+
+    c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    c1 = (uint32_t)p1;
+    c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c3 = (uint32_t)p0;
+
+    /* Bump the key */
+    k0 += random_philox_W0;
+    k1 += random_philox_W1;
+  }
+
+  ctr[0] = c0;
+  ctr[1] = c1;
+  ctr[2] = c2;
+  ctr[3] = c3;
+}
+
+/**
+ * @brief Convert two 32-bit random words into a double in the range [0, 1[
+ * with 53 random bits.
+ *
+ * @param a The first word.
+ * @param b The second word.
+ */
+__attribute__((always_inline)) INLINE static double random_words_to_double(
+    const uint32_t a, const uint32_t b) {
+
+  static const double two_m53 = 1. / 9007199254740992.; /* 2^-53 */
+  return ((uint64_t)(a >> 5) * 67108864ull + (b >> 6)) * two_m53;
+}
+
 /**
  * @brief Returns a pseudo-random number in the range [0, 1[.
  *
@@ -57,6 +112,11 @@ enum random_number_type {
  * time-step per particle is needed, additional randomness can be obtained by
  * using the type argument.
  *
+ * The number is obtained from a counter-based generator (Philox-4x32-10) keyed
+ * on the particle ID and fed the time and type as a counter, so the result does
+ * not depend on the order in which the numbers are drawn nor on which thread or
+ * rank draws them.
+ *
  * @param id The ID of the particle for which to generate a number.
  * @param ti_current The time (on the time-line) for which to generate a number.
  * @param type The #random_number_type to generate.
@@ -66,51 +126,41 @@ INLINE static double random_unit_interval(const long long int id,
                                           const integertime_t ti_current,
                                           const enum random_number_type type) {
 
-  /* Range used for the seeds. Best if prime */
-  static const long long seed_range = RAND_MAX;
-  static const double RAND_MAX_inv = 1. / ((double)RAND_MAX);
-  static const long long mwc_number = (1LL << 32) - 1LL;
-
-  /* Calculate the seed */
-  /* WARNING: Only change the math if you really know what you are doing!
-   * The numbers are carefully chosen prime numbers that prevent correlation
-   * with either the current integer time or the particle IDs. The current
-   * method also prevents any correlation between different random number
-   * types.
-   * The calculation overflows on purpose.
-   * 1. The first step is calculating the seed by using a multiply with carry
-   * (MWC) method, this method depends on the type of random number and
-   * this therefore also prevents that there is any correlation between
-   * the different types of random numbers.
-   * 2. After this we use the 64 bit Xorshift method to randomize the seeds
-   * even more.
-   * 3. We calculate a prime multiplication for the id with a quadratic
-   * term.
-   * 4. We calculate the seed by using a Quadratic congruential generator,
-   * in which we use the id part and the current time step bin.
-   */
-  unsigned long long number = ti_current;
-
-  /* Multiply with carry (MWC), (adviced variables by NR) */
-  number = 4294957665LL * (number & (mwc_number)) + (number >> 32);
-
-  /* 64-bit Xorshift (adviced variables by NR) */
-  number ^= number << 21;
-  number ^= number >> 35;
-  number ^= number << 4;
-
-  /* Add constant to ID */
-  const unsigned long long idt = id + type;
-
-  /* Nonlinear congruential generator */
-  const unsigned long long idpart =
-      3457LL * idt + 593LL * idt * ti_current + 5417LL * idt * idt;
-  unsigned int seed =
-      (937LL * number + 5171LL * number * number + idpart + 1109LL) %
-      9996361LL % seed_range;
-
-  /* Generate a random number between 0 and 1. */
-  return rand_r(&seed) * RAND_MAX_inv;
+  const unsigned long long uid = id;
+  const unsigned long long uti = ti_current;
+  const unsigned long long utype = type;
+
+  const uint32_t key[2] = {(uint32_t)uid, (uint32_t)(uid >> 32)};
+  uint32_t ctr[4] = {(uint32_t)uti, (uint32_t)(uti >> 32), (uint32_t)utype,
+                     (uint32_t)(utype >> 32)};
+
+  random_philox4x32(ctr, key);
+
+  return random_words_to_double(ctr[0], ctr[1]);
+}
+
+/**
+ * @brief Fills an array with the pseudo-random numbers in the range [0, 1[ of
+ * a list of particles.
+ *
+ * Element i is identical to random_unit_interval(id[i], ti_current, type). As
+ * the generator has no state, the iterations are independent and the loop is
+ * vectorised by the compiler.
+ *
+ * @param id The IDs of the particles for which to generate a number.
+ * @param count The number of particles.
+ * @param ti_current The time (on the time-line) for which to generate the
+ * numbers.
+ * @param type The #random_number_type to generate.
+ * @param r (return) The random numbers in the interval [0, 1.[.
+ */
+INLINE static void random_unit_interval_array(
+    const long long int *restrict id, const int count,
+    const integertime_t ti_current, const enum random_number_type type,
+    double *restrict r) {
+
+  for (int i = 0; i < count; ++i)
+    r[i] = random_unit_interval(id[i], ti_current, type);
 }
 
 #endif /* SWIFT_RANDOM_H */
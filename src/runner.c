@@ -1077,10 +1077,131 @@ void runner_do_cooling(struct runner *r, struct cell *c, int timer) {
   if (timer) TIMER_TOC(timer_do_cooling);
 }
 
+/*! Initial number of gas particles a star formation batch can hold */
+#define runner_star_formation_batch_size 64
+
 /**
+ * @brief The gas particles of a cell hierarchy that will be converted to stars
+ * by runner_do_star_formation().
+ */
+struct runner_star_formation_batch {
+
+  /*! The leaf-cells the particles are in */
+  struct cell **cells;
+
+  /*! The particles to convert */
+  struct part **parts;
+
+  /*! The extended data of the particles to convert */
+  struct xpart **xparts;
+
+  /*! The star particles created */
+  struct spart **sparts;
+
+  /*! The number of particles in the batch */
+  int count;
+
+  /*! The number of particles the batch can hold */
+  int size;
+};
+
+/**
+ * @brief Add a gas particle to a star formation batch, growing it if need be.
  *
+ * @param batch The #runner_star_formation_batch.
+ * @param c The leaf-cell the particle is in.
+ * @param p The #part.
+ * @param xp The #xpart of the particle.
  */
-void runner_do_star_formation(struct runner *r, struct cell *c, int timer) {
+static void runner_add_to_star_formation_batch(
+    struct runner_star_formation_batch *batch, struct cell *c, struct part *p,
+    struct xpart *xp) {
+
+  if (batch->count == batch->size) {
+    batch->size = max(2 * batch->size, runner_star_formation_batch_size);
+    batch->cells = (struct cell **)realloc(batch->cells,
+                                           batch->size * sizeof(struct cell *));
+    batch->parts = (struct part **)realloc(batch->parts,
+                                           batch->size * sizeof(struct part *));
+    batch->xparts = (struct xpart **)realloc(
+        batch->xparts, batch->size * sizeof(struct xpart *));
+    batch->sparts = (struct spart **)realloc(
+        batch->sparts, batch->size * sizeof(struct spart *));
+    if (batch->cells == NULL || batch->parts == NULL ||
+        batch->xparts == NULL || batch->sparts == NULL)
+      error("Failed to allocate the star formation batch.");
+  }
+
+  batch->cells[batch->count] = c;
+  batch->parts[batch->count] = p;
+  batch->xparts[batch->count] = xp;
+  batch->count++;
+}
+
+/**
+ * @brief Convert all the gas particles of a batch to stars.
+ *
+ * @param r The thread #runner.
+ * @param c The cell on which the star formation task runs.
+ * @param batch The #runner_star_formation_batch to convert.
+ */
+static void runner_convert_star_formation_batch(
+    struct runner *r, struct cell *c,
+    const struct runner_star_formation_batch *batch) {
+
+  struct engine *e = r->e;
+  const struct cosmology *cosmo = e->cosmology;
+  const struct star_formation *sf_props = e->star_formation;
+  const struct phys_const *phys_const = e->physical_constants;
+  const int with_cosmology = (e->policy & engine_policy_cosmology);
+  const struct hydro_props *restrict hydro_props = e->hydro_properties;
+  const struct unit_system *restrict us = e->internal_units;
+  struct cooling_function_data *restrict cooling = e->cooling_func;
+
+  TIMER_TIC;
+
+  /* Convert the gas particles to star particles, all at once */
+  const int count =
+      cell_convert_parts_to_sparts(e, batch->cells, batch->parts, batch->xparts,
+                                   batch->count, batch->sparts);
+
+  /* (The particles we could not convert, for lack of spare ones, are left
+   * untouched) */
+  for (int k = 0; k < count; k++) {
+
+    struct spart *sp = batch->sparts[k];
+
+    /* message("We formed a star id=%lld cellID=%d", sp->id,
+     * batch->cells[k]->cellID); */
+
+    /* Copy the properties of the gas particle to the star particle */
+    star_formation_copy_properties(batch->parts[k], batch->xparts[k], sp, e,
+                                   sf_props, cosmo, with_cosmology, phys_const,
+                                   hydro_props, us, cooling);
+
+    /* Update the Star formation history of the leaf-cell and of its parents,
+     * which have already collected the histories of their progenies */
+    for (struct cell *cp = batch->cells[k]; cp != c->parent; cp = cp->parent)
+      star_formation_logger_log_new_spart(sp, &cp->stars.sfh);
+  }
+
+  TIMER_TOC(timer_do_star_formation_convert);
+}
+
+/**
+ * @brief Decide which gas particles of a cell hierarchy form stars.
+ *
+ * The cells are not modified beyond the properties of their gas particles.
+ * The particles to convert are added to a batch, in the order in which they
+ * are located in memory.
+ *
+ * @param r The thread #runner.
+ * @param c The cell we are working on.
+ * @param batch The #runner_star_formation_batch of particles to convert.
+ */
+static void runner_do_star_formation_recursive(
+    struct runner *r, struct cell *c,
+    struct runner_star_formation_batch *batch) {
 
   struct engine *e = r->e;
   const struct cosmology *cosmo = e->cosmology;
@@ -1090,21 +1211,12 @@ void runner_do_star_formation(struct runner *r, struct cell *c, int timer) {
   struct part *restrict parts = c->hydro.parts;
   struct xpart *restrict xparts = c->hydro.xparts;
   const int with_cosmology = (e->policy & engine_policy_cosmology);
-  const int with_feedback = (e->policy & engine_policy_feedback);
   const struct hydro_props *restrict hydro_props = e->hydro_properties;
   const struct unit_system *restrict us = e->internal_units;
   struct cooling_function_data *restrict cooling = e->cooling_func;
   const struct entropy_floor_properties *entropy_floor = e->entropy_floor;
   const double time_base = e->time_base;
   const integertime_t ti_current = e->ti_current;
-  const int current_stars_count = c->stars.count;
-
-  TIMER_TIC;
-
-#ifdef SWIFT_DEBUG_CHECKS
-  if (c->nodeID != e->nodeID)
-    error("Running star formation task on a foreign node!");
-#endif
 
   /* Anything to do here? */
   if (c->hydro.count == 0 || !cell_is_active_hydro(c, e)) {
@@ -1123,7 +1235,7 @@ void runner_do_star_formation(struct runner *r, struct cell *c, int timer) {
         struct cell *restrict cp = c->progeny[k];
 
         /* Do the recursion */
-        runner_do_star_formation(r, cp, 0);
+        runner_do_star_formation_recursive(r, cp, batch);
 
         /* Update current cell using child cells */
         star_formation_logger_add(&c->stars.sfh, &cp->stars.sfh);
@@ -1170,23 +1282,9 @@ void runner_do_star_formation(struct runner *r, struct cell *c, int timer) {
           if (star_formation_should_convert_to_star(p, xp, sf_props, e,
                                                     dt_star)) {
 
-            /* Convert the gas particle to a star particle */
-            struct spart *sp = cell_convert_part_to_spart(e, c, p, xp);
-
-            /* Did we get a star? (Or did we run out of spare ones?) */
-            if (sp != NULL) {
-
-              /* message("We formed a star id=%lld cellID=%d", sp->id,
-               * c->cellID); */
-
-              /* Copy the properties of the gas particle to the star particle */
-              star_formation_copy_properties(p, xp, sp, e, sf_props, cosmo,
-                                             with_cosmology, phys_const,
-                                             hydro_props, us, cooling);
-
-              /* Update the Star formation history */
-              star_formation_logger_log_new_spart(sp, &c->stars.sfh);
-            }
+            /* Add the particle to the batch to convert to stars. (The cell's
+             * Star formation history is updated by the conversion) */
+            runner_add_to_star_formation_batch(batch, c, p, xp);
           }
 
         } else { /* Are we not star-forming? */
@@ -1206,6 +1304,46 @@ void runner_do_star_formation(struct runner *r, struct cell *c, int timer) {
       }
     } /* Loop over particles */
   }
+}
+
+/**
+ * @brief Converts the star-forming gas particles of a cell hierarchy to stars.
+ *
+ * This is done in two phases. We first decide which particles form stars,
+ * without modifying the cells' content. All the particles selected are then
+ * converted at once, such that the top-level cell is locked and its star
+ * particles shifted only once.
+ *
+ * @param r The thread #runner.
+ * @param c The cell.
+ * @param timer Are we timing this?
+ */
+void runner_do_star_formation(struct runner *r, struct cell *c, int timer) {
+
+  struct engine *e = r->e;
+  const int with_feedback = (e->policy & engine_policy_feedback);
+  const int current_stars_count = c->stars.count;
+
+  TIMER_TIC;
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (c->nodeID != e->nodeID)
+    error("Running star formation task on a foreign node!");
+#endif
+
+  /* Select the star-forming particles */
+  struct runner_star_formation_batch batch = {NULL, NULL, NULL, NULL, 0, 0};
+  runner_do_star_formation_recursive(r, c, &batch);
+
+  /* And convert them */
+  if (batch.count > 0) {
+    runner_convert_star_formation_batch(r, c, &batch);
+
+    free(batch.cells);
+    free(batch.parts);
+    free(batch.xparts);
+    free(batch.sparts);
+  }
 
   /* If we formed any stars, the star sorts are now invalid. We need to
    * re-compute them. */
@@ -1324,6 +1462,50 @@ void runner_do_sort_ascending(struct sort_entry *sort, int N) {
   }
 }
 
+/*! Number of moves per entry after which runner_do_resort_ascending() gives
+ * up and sorts from scratch */
+#define runner_resort_max_moves 8
+
+/**
+ * @brief Sort entries that are nearly in ascending order.
+ *
+ * Uses an insertion sort, whose cost is proportional to the number of pairs
+ * of entries in the wrong order, e.g. when re-sorting particles that only
+ * moved a little since the previous sort. Falls back to
+ * runner_do_sort_ascending() if the entries are too far from being sorted.
+ *
+ * @param sort The entries
+ * @param N The number of entries.
+ */
+void runner_do_resort_ascending(struct sort_entry *sort, int N) {
+
+  /* Number of moves after which a full sort is cheaper */
+  const long long max_moves = (long long)runner_resort_max_moves * N;
+  long long moves = 0;
+
+  for (int i = 1; i < N; i++) {
+
+    /* Already in order? */
+    if (sort[i - 1].d <= sort[i].d) continue;
+
+    /* Shift the larger entries to make space */
+    const struct sort_entry temp = sort[i];
+    int j = i - 1;
+    while (j >= 0 && sort[j].d > temp.d) {
+      sort[j + 1] = sort[j];
+      j--;
+    }
+    sort[j + 1] = temp;
+
+    /* Give up? */
+    moves += i - 1 - j;
+    if (moves > max_moves) {
+      runner_do_sort_ascending(sort, N);
+      return;
+    }
+  }
+}
+
 #ifdef SWIFT_DEBUG_CHECKS
 /**
  * @brief Recursively checks that the flags are consistent in a cell hierarchy.
@@ -1528,26 +1710,53 @@ void runner_do_hydro_sort(struct runner *r, struct cell *c, int flags,
       c->hydro.dx_max_sort = 0.f;
     }
 
+    /* The directions in which the previous order of the particles is still
+     * in the sort arrays. Since the particles moved little, it only needs to
+     * be repaired. */
+    const int flags_repair =
+        r->e->s->with_sort_repair ? (flags & c->hydro.sorted_old) : 0;
+    const int flags_new = flags & ~flags_repair;
+
     /* Fill the sort array. */
-    for (int k = 0; k < count; k++) {
-      const double px[3] = {parts[k].x[0], parts[k].x[1], parts[k].x[2]};
-      for (int j = 0; j < 13; j++)
-        if (flags & (1 << j)) {
-          c->hydro.sort[j][k].i = k;
-          c->hydro.sort[j][k].d = px[0] * runner_shift[j][0] +
-                                  px[1] * runner_shift[j][1] +
-                                  px[2] * runner_shift[j][2];
-        }
+    if (flags_new) {
+      for (int k = 0; k < count; k++) {
+        const double px[3] = {parts[k].x[0], parts[k].x[1], parts[k].x[2]};
+        for (int j = 0; j < 13; j++)
+          if (flags_new & (1 << j)) {
+            c->hydro.sort[j][k].i = k;
+            c->hydro.sort[j][k].d = px[0] * runner_shift[j][0] +
+                                    px[1] * runner_shift[j][1] +
+                                    px[2] * runner_shift[j][2];
+          }
+      }
     }
 
+    /* Update the distances in the previous order. */
+    for (int j = 0; j < 13; j++)
+      if (flags_repair & (1 << j)) {
+        struct sort_entry *sort = c->hydro.sort[j];
+        for (int k = 0; k < count; k++) {
+          const struct part *p = &parts[sort[k].i];
+          const double px[3] = {p->x[0], p->x[1], p->x[2]};
+          sort[k].d = px[0] * runner_shift[j][0] + px[1] * runner_shift[j][1] +
+                      px[2] * runner_shift[j][2];
+        }
+      }
+
     /* Add the sentinel and sort. */
     for (int j = 0; j < 13; j++)
       if (flags & (1 << j)) {
         c->hydro.sort[j][count].d = FLT_MAX;
         c->hydro.sort[j][count].i = 0;
-        runner_do_sort_ascending(c->hydro.sort[j], count);
+        if (flags_repair & (1 << j))
+          runner_do_resort_ascending(c->hydro.sort[j], count);
+        else
+          runner_do_sort_ascending(c->hydro.sort[j], count);
         atomic_or(&c->hydro.sorted, 1 << j);
       }
+
+    /* These orders can be repaired the next time around */
+    atomic_or(&c->hydro.sorted_old, flags);
   }
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -2075,7 +2284,10 @@ void runner_do_ghost(struct runner *r, struct cell *c, int timer) {
       error("Can't allocate memory for left.");
     if ((right = (float *)malloc(sizeof(float) * c->hydro.count)) == NULL)
       error("Can't allocate memory for right.");
-    for (int k = 0; k < c->hydro.count; k++)
+    const int *order = NULL;
+    const int num_visit = cell_get_active_hydro_order(c, e, &order);
+    for (int i = 0; i < num_visit; i++) {
+      const int k = (order != NULL) ? order[i] : i;
       if (part_is_active(&parts[k], e)) {
         pid[count] = k;
         h_0[count] = parts[k].h;
@@ -2083,6 +2295,7 @@ void runner_do_ghost(struct runner *r, struct cell *c, int timer) {
         right[count] = hydro_h_max;
         ++count;
       }
+    }
 
     /* While there are particles that need to be updated... */
     for (int num_reruns = 0; count > 0 && num_reruns < max_smoothing_iter;
@@ -2684,7 +2897,6 @@ void runner_do_kick1(struct runner *r, struct cell *c, int timer) {
   struct xpart *restrict xparts = c->hydro.xparts;
   struct gpart *restrict gparts = c->grav.parts;
   struct spart *restrict sparts = c->stars.parts;
-  const int count = c->hydro.count;
   const int gcount = c->grav.count;
   const int scount = c->stars.count;
   const integertime_t ti_current = e->ti_current;
@@ -2703,10 +2915,15 @@ void runner_do_kick1(struct runner *r, struct cell *c, int timer) {
       if (c->progeny[k] != NULL) runner_do_kick1(r, c->progeny[k], 0);
   } else {
 
+    /* Get the parts that may be starting their time-step. */
+    const int *order = NULL;
+    const int num_visit = cell_get_active_hydro_order(c, e, &order);
+
     /* Loop over the parts in this cell. */
-    for (int k = 0; k < count; k++) {
+    for (int i = 0; i < num_visit; i++) {
 
       /* Get a handle on the part. */
+      const int k = (order != NULL) ? order[i] : i;
       struct part *restrict p = &parts[k];
       struct xpart *restrict xp = &xparts[k];
 
@@ -2864,7 +3081,6 @@ void runner_do_kick2(struct runner *r, struct cell *c, int timer) {
   const struct hydro_props *hydro_props = e->hydro_properties;
   const struct entropy_floor_properties *entropy_floor = e->entropy_floor;
   const int with_cosmology = (e->policy & engine_policy_cosmology);
-  const int count = c->hydro.count;
   const int gcount = c->grav.count;
   const int scount = c->stars.count;
   struct part *restrict parts = c->hydro.parts;
@@ -2887,10 +3103,15 @@ void runner_do_kick2(struct runner *r, struct cell *c, int timer) {
       if (c->progeny[k] != NULL) runner_do_kick2(r, c->progeny[k], 0);
   } else {
 
+    /* Get the particles that may be active. */
+    const int *order = NULL;
+    const int num_visit = cell_get_active_hydro_order(c, e, &order);
+
     /* Loop over the particles in this cell. */
-    for (int k = 0; k < count; k++) {
+    for (int i = 0; i < num_visit; i++) {
 
       /* Get a handle on the part. */
+      const int k = (order != NULL) ? order[i] : i;
       struct part *restrict p = &parts[k];
       struct xpart *restrict xp = &xparts[k];
 
@@ -3049,15 +3270,46 @@ void runner_do_kick2(struct runner *r, struct cell *c, int timer) {
   if (timer) TIMER_TOC(timer_kick2);
 }
 
+/**
+ * @brief Finds the first particle that has not been removed in a range of a
+ * cell's time-bin ordering.
+ *
+ * @param parts The #part of the cell.
+ * @param order The time-bin ordering of the cell.
+ * @param start The first position of the range to search.
+ * @param end The position just past the end of the range to search. The
+ * range is searched backwards if it comes before @c start.
+ * @param with_gpart Only consider the particles with a #gpart counterpart?
+ * @return The index of the particle found or -1 if there is none.
+ */
+static int runner_find_part_in_bin_order(const struct part *restrict parts,
+                                         const int *restrict order,
+                                         const int start, const int end,
+                                         const int with_gpart) {
+
+  const int step = (end > start) ? 1 : -1;
+  for (int i = start; i != end; i += step) {
+    const struct part *p = &parts[order[i]];
+    if (p->time_bin <= num_time_bins && (!with_gpart || p->gpart != NULL))
+      return order[i];
+  }
+  return -1;
+}
+
 /**
  * @brief Computes the next time-step of all active particles in this cell
  * and update the cell's statistics.
  *
+ * When fusing the kicks, the leaf cells also receive their second half-kick
+ * just before the time-step calculation and the first half-kick of their
+ * next step just after it, while their particles are still in cache.
+ *
  * @param r The runner thread.
  * @param c The cell.
- * @param timer Are we timing this ?
+ * @param with_kicks Are we also doing the kicks of the leaf cells?
  */
-void runner_do_timestep(struct runner *r, struct cell *c, int timer) {
+static void runner_do_timestep_recursive(struct runner *r, struct cell *c,
+                                         const int with_kicks) {
 
   const struct engine *e = r->e;
   const integertime_t ti_current = e->ti_current;
@@ -3072,8 +3324,6 @@ void runner_do_timestep(struct runner *r, struct cell *c, int timer) {
   struct spart *restrict sparts = c->stars.parts;
   struct bpart *restrict bparts = c->black_holes.parts;
 
-  TIMER_TIC;
-
   /* Anything to do here? */
   if (!cell_is_active_hydro(c, e) && !cell_is_active_gravity(c, e) &&
       !cell_is_active_stars(c, e) && !cell_is_active_black_holes(c, e)) {
@@ -3097,10 +3347,18 @@ void runner_do_timestep(struct runner *r, struct cell *c, int timer) {
   /* No children? */
   if (!c->split) {
 
+    /* Finish the current step of the particles */
+    if (with_kicks) runner_do_kick2(r, c, 0);
+
+    /* Get the particles that may be active. */
+    const int *order = NULL;
+    const int num_visit = cell_get_active_hydro_order(c, e, &order);
+
     /* Loop over the particles in this cell. */
-    for (int k = 0; k < count; k++) {
+    for (int i = 0; i < num_visit; i++) {
 
       /* Get a handle on the part. */
+      const int k = (order != NULL) ? order[i] : i;
       struct part *restrict p = &parts[k];
       struct xpart *restrict xp = &xparts[k];
 
@@ -3182,6 +3440,50 @@ void runner_do_timestep(struct runner *r, struct cell *c, int timer) {
       }
     }
 
+    /* The particles that were not visited are inactive and ordered by
+     * time-bin, so the first and last of them bound the steps of all. */
+    if (order != NULL) {
+
+      const int first = runner_find_part_in_bin_order(
+          parts, order, num_visit, count, /*with_gpart=*/0);
+      if (first >= 0) {
+        const int last = runner_find_part_in_bin_order(
+            parts, order, count - 1, num_visit - 1, /*with_gpart=*/0);
+
+        ti_hydro_end_min = min(
+            get_integer_time_end(ti_current, parts[first].time_bin),
+            ti_hydro_end_min);
+        ti_hydro_end_max =
+            max(get_integer_time_end(ti_current, parts[last].time_bin),
+                ti_hydro_end_max);
+        ti_hydro_beg_max = max(
+            get_integer_time_begin(ti_current + 1, parts[first].time_bin),
+            ti_hydro_beg_max);
+      }
+
+      const int first_g =
+          (gcount > 0) ? runner_find_part_in_bin_order(parts, order, num_visit,
+                                                       count, /*with_gpart=*/1)
+                       : -1;
+      if (first_g >= 0) {
+        const int last_g = runner_find_part_in_bin_order(
+            parts, order, count - 1, num_visit - 1, /*with_gpart=*/1);
+
+        ti_gravity_end_min = min(
+            get_integer_time_end(ti_current, parts[first_g].time_bin),
+            ti_gravity_end_min);
+        ti_gravity_end_max =
+            max(get_integer_time_end(ti_current, parts[last_g].time_bin),
+                ti_gravity_end_max);
+        ti_gravity_beg_max = max(
+            get_integer_time_begin(ti_current + 1, parts[first_g].time_bin),
+            ti_gravity_beg_max);
+      }
+    }
+
+    /* Order the particles by their new time-bins */
+    cell_sort_hydro_bin_order(c, num_visit);
+
     /* Loop over the g-particles in this cell. */
     for (int k = 0; k < gcount; k++) {
 
@@ -3372,7 +3674,7 @@ void runner_do_timestep(struct runner *r, struct cell *c, int timer) {
         struct cell *restrict cp = c->progeny[k];
 
         /* Recurse */
-        runner_do_timestep(r, cp, 0);
+        runner_do_timestep_recursive(r, cp, with_kicks);
 
         /* And aggregate */
         updated += cp->hydro.updated;
@@ -3421,6 +3723,10 @@ void runner_do_timestep(struct runner *r, struct cell *c, int timer) {
   c->black_holes.ti_end_max = ti_black_holes_end_max;
   c->black_holes.ti_beg_max = ti_black_holes_beg_max;
 
+  /* Start the next step of the particles now that the cell knows which of
+   * them are starting */
+  if (with_kicks && !c->split) runner_do_kick1(r, c, 0);
+
 #ifdef SWIFT_DEBUG_CHECKS
   if (c->hydro.ti_end_min == e->ti_current &&
       c->hydro.ti_end_min < max_nr_timesteps)
@@ -3435,10 +3741,46 @@ void runner_do_timestep(struct runner *r, struct cell *c, int timer) {
       c->black_holes.ti_end_min < max_nr_timesteps)
     error("End of next black holes step is current time!");
 #endif
+}
+
+/**
+ * @brief Computes the next time-step of all active particles in this cell
+ * and update the cell's statistics.
+ *
+ * @param r The runner thread.
+ * @param c The cell.
+ * @param timer Are we timing this ?
+ */
+void runner_do_timestep(struct runner *r, struct cell *c, int timer) {
+
+  TIMER_TIC;
+
+  runner_do_timestep_recursive(r, c, /* with_kicks = */ 0);
 
   if (timer) TIMER_TOC(timer_timestep);
 }
 
+/**
+ * @brief Performs the second half-kick, computes the next time-step and
+ * performs the first half-kick of the next step of all the active particles
+ * in a cell, in a single recursion over the cell hierarchy.
+ *
+ * This replaces the kick2, timestep and kick1 tasks when no other task needs
+ * to run in-between them.
+ *
+ * @param r The runner thread.
+ * @param c The cell.
+ * @param timer Are we timing this ?
+ */
+void runner_do_kick_timestep(struct runner *r, struct cell *c, int timer) {
+
+  TIMER_TIC;
+
+  runner_do_timestep_recursive(r, c, /* with_kicks = */ 1);
+
+  if (timer) TIMER_TOC(timer_kick_timestep);
+}
+
 /**
  * @brief Apply the time-step limiter to all awaken particles in a cell
  * hierarchy.
@@ -3536,6 +3878,9 @@ void runner_do_limiter(struct runner *r, struct cell *c, int force, int timer) {
         /* Apply the limiter and get the new time-step size */
         const integertime_t ti_new_step = timestep_limit_part(p, xp, e);
 
+        /* The particle moved to a smaller time-bin */
+        c->hydro.bin_order_valid = 0;
+
         /* What is the next sync-point ? */
         ti_hydro_end_min = min(ti_current + ti_new_step, ti_hydro_end_min);
         ti_hydro_end_max = max(ti_current + ti_new_step, ti_hydro_end_max);
@@ -3601,14 +3946,17 @@ void runner_do_end_hydro_force(struct runner *r, struct cell *c, int timer) {
   } else {
 
     const struct cosmology *cosmo = e->cosmology;
-    const int count = c->hydro.count;
     struct part *restrict parts = c->hydro.parts;
 
+    /* Get the gas particles that may be active. */
+    const int *order = NULL;
+    const int num_visit = cell_get_active_hydro_order(c, e, &order);
+
     /* Loop over the gas particles in this cell. */
-    for (int k = 0; k < count; k++) {
+    for (int i = 0; i < num_visit; i++) {
 
       /* Get a handle on the part. */
-      struct part *restrict p = &parts[k];
+      struct part *restrict p = &parts[(order != NULL) ? order[i] : i];
 
       if (part_is_active(p, e)) {
 
@@ -4307,6 +4655,12 @@ void *runner_main(void *data) {
   struct scheduler *sched = &e->sched;
   unsigned int seed = r->id;
   pthread_setspecific(sched->local_seed_pointer, &seed);
+
+#ifdef SWIFT_TASK_COUNTERS
+  /* Start the hardware counters of this thread. */
+  task_counters_init(&r->counters, &e->task_counters_events);
+#endif
+
   /* Main loop. */
   while (1) {
 
@@ -4333,6 +4687,12 @@ void *runner_main(void *data) {
 
         /* Did I get anything? */
         if (t == NULL) break;
+
+        /* How much work is left in our queue? */
+        const int queue_depth = sched->queues[r->qid].count;
+        r->profile.queue_depth_sum += queue_depth;
+        if (queue_depth > r->profile.queue_depth_max)
+          r->profile.queue_depth_max = queue_depth;
       }
 
       /* Get the cells. */
@@ -4361,6 +4721,11 @@ void *runner_main(void *data) {
       r->t = t;
 #endif
 
+#ifdef SWIFT_TASK_COUNTERS
+      long long counters_start[task_counters_max];
+      task_counters_read(&r->counters, counters_start);
+#endif
+
       /* Different types of tasks... */
       switch (t->type) {
         case task_type_self:
@@ -4543,6 +4908,9 @@ void *runner_main(void *data) {
         case task_type_timestep:
           runner_do_timestep(r, ci, 1);
           break;
+        case task_type_kick_timestep:
+          runner_do_kick_timestep(r, ci, 1);
+          break;
         case task_type_timestep_limiter:
           runner_do_limiter(r, ci, 0, 1);
           break;
@@ -4656,13 +5024,29 @@ void *runner_main(void *data) {
       r->t = NULL;
 #endif
 
+#ifdef SWIFT_TASK_COUNTERS
+      /* Record the hardware events of this task. */
+      long long counters_end[task_counters_max];
+      task_counters_read(&r->counters, counters_end);
+      for (int k = 0; k < r->counters.nr_counters; k++)
+        t->counters[k] = counters_end[k] - counters_start[k];
+#endif
+
       /* We're done with this task, see if we get a next one. */
       prev = t;
       t = scheduler_done(sched, t);
 
+      /* Account for the time spent on it. */
+      r->profile.busy += prev->toc - prev->tic;
+      r->profile.nr_tasks++;
+
     } /* main loop. */
   }
 
+#ifdef SWIFT_TASK_COUNTERS
+  task_counters_clean(&r->counters);
+#endif
+
   /* Be kind, rewind. */
   return NULL;
 }
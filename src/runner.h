@@ -29,6 +29,7 @@
 /* Includes. */
 #include "cache.h"
 #include "gravity_cache.h"
+#include "step_profiler.h"
 #include "task.h"
 
 struct cell;
@@ -66,10 +67,18 @@ struct runner {
   struct cache cj_cache;
 #endif
 
+  /*! What this runner did during the current step. */
+  struct step_profiler_runner profile;
+
 #ifdef SWIFT_DEBUG_CHECKS
   /*! Pointer to the task this runner is currently performing */
   const struct task *t;
 #endif
+
+#ifdef SWIFT_TASK_COUNTERS
+  /*! The hardware counters of this thread. */
+  struct task_counters counters;
+#endif
 };
 
 /* Function prototypes. */
@@ -86,6 +95,7 @@ void runner_do_drift_gpart(struct runner *r, struct cell *c, int timer);
 void runner_do_drift_spart(struct runner *r, struct cell *c, int timer);
 void runner_do_kick1(struct runner *r, struct cell *c, int timer);
 void runner_do_kick2(struct runner *r, struct cell *c, int timer);
+void runner_do_kick_timestep(struct runner *r, struct cell *c, int timer);
 void runner_do_end_hydro_force(struct runner *r, struct cell *c, int timer);
 void runner_do_init(struct runner *r, struct cell *c, int timer);
 void runner_do_cooling(struct runner *r, struct cell *c, int timer);
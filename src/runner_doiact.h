@@ -849,7 +849,7 @@ void DOPAIR_SUBSET_BRANCH(struct runner *r, struct cell *restrict ci,
 
 #if defined(SWIFT_USE_NAIVE_INTERACTIONS)
   DOPAIR_SUBSET_NAIVE(r, ci, parts_i, ind, count, cj, shift);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY)
   if (sort_is_face(sid))
     runner_dopair_subset_density_vec(r, ci, parts_i, ind, count, cj, sid,
                                      flipped, shift);
@@ -955,7 +955,7 @@ void DOSELF_SUBSET_BRANCH(struct runner *r, struct cell *restrict ci,
                           struct part *restrict parts, int *restrict ind,
                           int count) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY)
   runner_doself_subset_density_vec(r, ci, parts, ind, count);
 #else
   DOSELF_SUBSET(r, ci, parts, ind, count);
@@ -1276,7 +1276,7 @@ void DOPAIR1_BRANCH(struct runner *r, struct cell *ci, struct cell *cj) {
 
 #if defined(SWIFT_USE_NAIVE_INTERACTIONS)
   DOPAIR1_NAIVE(r, ci, cj);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH) && \
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY) && \
     (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
   if (!sort_is_corner(sid))
     runner_dopair1_density_vec(r, ci, cj, sid, shift);
@@ -1842,7 +1842,7 @@ void DOPAIR2_BRANCH(struct runner *r, struct cell *ci, struct cell *cj) {
 
 #ifdef SWIFT_USE_NAIVE_INTERACTIONS
   DOPAIR2_NAIVE(r, ci, cj);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH) && \
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_FORCE) && \
     (FUNCTION_TASK_LOOP == TASK_LOOP_FORCE)
   if (!sort_is_corner(sid))
     runner_dopair2_force_vec(r, ci, cj, sid, shift);
@@ -2041,7 +2041,7 @@ void DOSELF1_BRANCH(struct runner *r, struct cell *c) {
 
 #if defined(SWIFT_USE_NAIVE_INTERACTIONS)
   DOSELF1_NAIVE(r, c);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH) && \
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY) && \
     (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
   runner_doself1_density_vec(r, c);
 #else
@@ -2221,7 +2221,7 @@ void DOSELF2_BRANCH(struct runner *r, struct cell *c) {
 
 #if defined(SWIFT_USE_NAIVE_INTERACTIONS)
   DOSELF2_NAIVE(r, c);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH) && \
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_FORCE) && \
     (FUNCTION_TASK_LOOP == TASK_LOOP_FORCE)
   runner_doself2_force_vec(r, c);
 #else
@@ -31,9 +31,15 @@
 #define _DO_SYM_PAIR1_BH(f) PASTE(runner_do_sym_pair_bh, f)
 #define DO_SYM_PAIR1_BH _DO_SYM_PAIR1_BH(FUNCTION)
 
+#define _DO_NONSYM_PAIR1_BH(f) PASTE(runner_do_nonsym_pair_bh, f)
+#define DO_NONSYM_PAIR1_BH _DO_NONSYM_PAIR1_BH(FUNCTION)
+
 #define _DO_NONSYM_PAIR1_BH_NAIVE(f) PASTE(runner_do_nonsym_pair_bh_naive, f)
 #define DO_NONSYM_PAIR1_BH_NAIVE _DO_NONSYM_PAIR1_BH_NAIVE(FUNCTION)
 
+#define _DOPAIR1_BH(f) PASTE(runner_dopair_bh, f)
+#define DOPAIR1_BH _DOPAIR1_BH(FUNCTION)
+
 #define _DOPAIR1_BH_NAIVE(f) PASTE(runner_dopair_bh_naive, f)
 #define DOPAIR1_BH_NAIVE _DOPAIR1_BH_NAIVE(FUNCTION)
 
@@ -246,6 +252,109 @@ void DO_NONSYM_PAIR1_BH_NAIVE(struct runner *r, struct cell *restrict ci,
   }   /* loop over the parts in ci. */
 }
 
+/**
+ * @brief Calculate the number density of cj #part around the ci #bpart
+ * using the sorted #part of cj.
+ *
+ * The #bpart are not sorted. Each of them is projected on the sorting axis
+ * and the #part of cj are visited in sorted order from the side facing ci
+ * until they are out of reach of its kernel.
+ *
+ * @param r runner task
+ * @param ci The #cell containing the #bpart.
+ * @param cj The #cell containing the #part.
+ * @param sid The direction of the pair.
+ * @param flipped Is cj on the left of ci along the sorting axis?
+ * @param shift The shift vector to apply to the particles in ci.
+ */
+void DO_NONSYM_PAIR1_BH(struct runner *r, struct cell *restrict ci,
+                        struct cell *restrict cj, const int sid,
+                        const int flipped, const double *shift) {
+
+#ifdef SWIFT_DEBUG_CHECKS
+#if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
+  if (ci->nodeID != engine_rank) error("Should be run on a different node");
+#elif (FUNCTION_TASK_LOOP == TASK_LOOP_FEEDBACK)
+  if (cj->nodeID != engine_rank) error("Should be run on a different node");
+#endif
+#endif
+
+  const struct engine *e = r->e;
+  const integertime_t ti_current = e->ti_current;
+  const struct cosmology *cosmo = e->cosmology;
+
+  /* Anything to do here? */
+  if (cj->hydro.count == 0 || ci->black_holes.count == 0) return;
+  if (!cell_is_active_black_holes(ci, e)) return;
+
+  const int bcount_i = ci->black_holes.count;
+  const int count_j = cj->hydro.count;
+  struct bpart *restrict bparts_i = ci->black_holes.parts;
+  struct part *restrict parts_j = cj->hydro.parts;
+  struct xpart *restrict xparts_j = cj->hydro.xparts;
+
+  /* Pick-out the sorted list. */
+  const struct sort_entry *restrict sort_j = cj->hydro.sort[sid];
+  const float dxj = cj->hydro.dx_max_sort;
+
+  /* Walk the sorted list starting from the side facing ci. */
+  const int pjd_first = flipped ? count_j - 1 : 0;
+  const int pjd_step = flipped ? -1 : 1;
+  const double sign = flipped ? -1. : 1.;
+
+  /* Loop over the bparts in ci. */
+  for (int bid = 0; bid < bcount_i; bid++) {
+
+    /* Get a hold of the ith bpart in ci. */
+    struct bpart *restrict bi = &bparts_i[bid];
+
+    /* Skip inactive particles */
+    if (!bpart_is_active(bi, e)) continue;
+
+    const float hi = bi->h;
+    const float hig2 = hi * hi * kernel_gamma2;
+    const float bix[3] = {(float)(bi->x[0] - (cj->loc[0] + shift[0])),
+                          (float)(bi->x[1] - (cj->loc[1] + shift[1])),
+                          (float)(bi->x[2] - (cj->loc[2] + shift[2]))};
+
+    /* How far along the axis can bi reach? */
+    const double di = sign * ((bi->x[0] - shift[0]) * runner_shift[sid][0] +
+                              (bi->x[1] - shift[1]) * runner_shift[sid][1] +
+                              (bi->x[2] - shift[2]) * runner_shift[sid][2]) +
+                      hi * kernel_gamma + dxj;
+
+    /* Loop over the parts in cj. */
+    for (int k = 0, pjd = pjd_first; k < count_j && sign * sort_j[pjd].d < di;
+         k++, pjd += pjd_step) {
+
+      /* Get a pointer to the jth particle. */
+      struct part *restrict pj = &parts_j[sort_j[pjd].i];
+      struct xpart *restrict xpj = &xparts_j[sort_j[pjd].i];
+      const float hj = pj->h;
+
+      /* Skip inhibited particles. */
+      if (part_is_inhibited(pj, e)) continue;
+
+      /* Compute the pairwise distance. */
+      const float pjx[3] = {(float)(pj->x[0] - cj->loc[0]),
+                            (float)(pj->x[1] - cj->loc[1]),
+                            (float)(pj->x[2] - cj->loc[2])};
+      float dx[3] = {bix[0] - pjx[0], bix[1] - pjx[1], bix[2] - pjx[2]};
+      const float r2 = dx[0] * dx[0] + dx[1] * dx[1] + dx[2] * dx[2];
+
+#ifdef SWIFT_DEBUG_CHECKS
+      /* Check that particles have been drifted to the current time */
+      if (pj->ti_drift != e->ti_current)
+        error("Particle pj not drifted to current time");
+#endif
+
+      if (r2 < hig2) {
+        IACT_BH(r2, dx, hi, hj, bi, pj, xpj, cosmo, ti_current);
+      }
+    } /* loop over the parts in cj. */
+  }   /* loop over the bparts in ci. */
+}
+
 void DOPAIR1_BH_NAIVE(struct runner *r, struct cell *restrict ci,
                       struct cell *restrict cj, int timer) {
 
@@ -272,6 +381,156 @@ void DOPAIR1_BH_NAIVE(struct runner *r, struct cell *restrict ci,
   TIMER_TOC(TIMER_DOPAIR_BH);
 }
 
+/**
+ * @brief Compute the interactions between a cell pair using the sorted
+ * #part of the local cells.
+ *
+ * The sorts of foreign cells are not kept up to date, so the #part of these
+ * are interacted with using the naive version.
+ *
+ * @param r The #runner.
+ * @param ci The first #cell.
+ * @param cj The second #cell.
+ * @param sid The direction of the pair.
+ * @param shift The shift vector to apply to the particles in ci.
+ */
+void DOPAIR1_BH(struct runner *r, struct cell *restrict ci,
+                struct cell *restrict cj, const int sid, const double *shift) {
+
+  TIMER_TIC;
+
+  const struct engine *e = r->e;
+
+#if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
+  const int do_ci_bh = ci->nodeID == e->nodeID;
+  const int do_cj_bh = cj->nodeID == e->nodeID;
+#elif (FUNCTION_TASK_LOOP == TASK_LOOP_FEEDBACK)
+  /* here we are updating the hydro -> switch ci, cj */
+  const int do_ci_bh = cj->nodeID == e->nodeID;
+  const int do_cj_bh = ci->nodeID == e->nodeID;
+#else
+  /* The swallow task is executed on both sides */
+  const int do_ci_bh = 1;
+  const int do_cj_bh = 1;
+#endif
+
+  if (do_ci_bh && ci->black_holes.count != 0 && cj->hydro.count != 0) {
+    if (cj->nodeID == e->nodeID)
+      DO_NONSYM_PAIR1_BH(r, ci, cj, sid, /*flipped=*/0, shift);
+    else
+      DO_NONSYM_PAIR1_BH_NAIVE(r, ci, cj);
+  }
+  if (do_cj_bh && cj->black_holes.count != 0 && ci->hydro.count != 0) {
+    const double shift_j[3] = {-shift[0], -shift[1], -shift[2]};
+    if (ci->nodeID == e->nodeID)
+      DO_NONSYM_PAIR1_BH(r, cj, ci, sid, /*flipped=*/1, shift_j);
+    else
+      DO_NONSYM_PAIR1_BH_NAIVE(r, cj, ci);
+  }
+
+  TIMER_TOC(TIMER_DOPAIR_BH);
+}
+
+/**
+ * @brief Compute the interactions between a cell pair, but only for the
+ *      given indices in ci.
+ *
+ * Version using the sorted #part of cj.
+ *
+ * @param r The #runner.
+ * @param ci The first #cell.
+ * @param bparts_i The #bpart to interact with @c cj.
+ * @param ind The list of indices of particles in @c ci to interact with.
+ * @param bcount The number of particles in @c ind.
+ * @param cj The second #cell.
+ * @param sid The direction of the pair.
+ * @param flipped Is cj on the left of ci along the sorting axis?
+ * @param shift The shift vector to apply to the particles in ci.
+ */
+void DOPAIR1_SUBSET_BH(struct runner *r, struct cell *restrict ci,
+                       struct bpart *restrict bparts_i, int *restrict ind,
+                       const int bcount, struct cell *restrict cj,
+                       const int sid, const int flipped, const double *shift) {
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (ci->nodeID != engine_rank) error("Should be run on a different node");
+#endif
+
+  const struct engine *e = r->e;
+  const integertime_t ti_current = e->ti_current;
+  const struct cosmology *cosmo = e->cosmology;
+
+  const int count_j = cj->hydro.count;
+  struct part *restrict parts_j = cj->hydro.parts;
+  struct xpart *restrict xparts_j = cj->hydro.xparts;
+
+  /* Early abort? */
+  if (count_j == 0) return;
+
+  /* Pick-out the sorted list. */
+  const struct sort_entry *restrict sort_j = cj->hydro.sort[sid];
+  const float dxj = cj->hydro.dx_max_sort;
+
+  /* Walk the sorted list starting from the side facing ci. */
+  const int pjd_first = flipped ? count_j - 1 : 0;
+  const int pjd_step = flipped ? -1 : 1;
+  const double sign = flipped ? -1. : 1.;
+
+  /* Loop over the parts_i. */
+  for (int bid = 0; bid < bcount; bid++) {
+
+    /* Get a hold of the ith part in ci. */
+    struct bpart *restrict bi = &bparts_i[ind[bid]];
+
+    const double bix = bi->x[0] - (shift[0]);
+    const double biy = bi->x[1] - (shift[1]);
+    const double biz = bi->x[2] - (shift[2]);
+    const float hi = bi->h;
+    const float hig2 = hi * hi * kernel_gamma2;
+    const double di = sign * (bix * runner_shift[sid][0] +
+                              biy * runner_shift[sid][1] +
+                              biz * runner_shift[sid][2]) +
+                      hi * kernel_gamma + dxj;
+
+#ifdef SWIFT_DEBUG_CHECKS
+    if (!bpart_is_active(bi, e))
+      error("Trying to correct smoothing length of inactive particle !");
+#endif
+
+    /* Loop over the parts in cj. */
+    for (int k = 0, pjd = pjd_first; k < count_j && sign * sort_j[pjd].d < di;
+         k++, pjd += pjd_step) {
+
+      /* Get a pointer to the jth particle. */
+      struct part *restrict pj = &parts_j[sort_j[pjd].i];
+      struct xpart *restrict xpj = &xparts_j[sort_j[pjd].i];
+
+      /* Skip inhibited particles */
+      if (part_is_inhibited(pj, e)) continue;
+
+      const double pjx = pj->x[0];
+      const double pjy = pj->x[1];
+      const double pjz = pj->x[2];
+      const float hj = pj->h;
+
+      /* Compute the pairwise distance. */
+      float dx[3] = {(float)(bix - pjx), (float)(biy - pjy),
+                     (float)(biz - pjz)};
+      const float r2 = dx[0] * dx[0] + dx[1] * dx[1] + dx[2] * dx[2];
+
+#ifdef SWIFT_DEBUG_CHECKS
+      /* Check that particles have been drifted to the current time */
+      if (pj->ti_drift != e->ti_current)
+        error("Particle pj not drifted to current time");
+#endif
+      /* Hit or miss? */
+      if (r2 < hig2) {
+        IACT_BH(r2, dx, hi, hj, bi, pj, xpj, cosmo, ti_current);
+      }
+    } /* loop over the parts in cj. */
+  }   /* loop over the parts in ci. */
+}
+
 /**
  * @brief Compute the interactions between a cell pair, but only for the
  *      given indices in ci.
@@ -479,7 +738,34 @@ void DOPAIR1_SUBSET_BRANCH_BH(struct runner *r, struct cell *restrict ci,
       shift[k] = -e->s->dim[k];
   }
 
+#ifdef SWIFT_USE_NAIVE_INTERACTIONS_BH
   DOPAIR1_SUBSET_BH_NAIVE(r, ci, bparts_i, ind, bcount, cj, shift);
+#else
+
+  /* The sorts of foreign cells are not kept up to date */
+  if (cj->nodeID != e->nodeID) {
+    DOPAIR1_SUBSET_BH_NAIVE(r, ci, bparts_i, ind, bcount, cj, shift);
+    return;
+  }
+
+  /* Get the sorting index. */
+  int sid = 0;
+  for (int k = 0; k < 3; k++)
+    sid = 3 * sid + ((cj->loc[k] - ci->loc[k] + shift[k] < 0)
+                         ? 0
+                         : (cj->loc[k] - ci->loc[k] + shift[k] > 0) ? 2 : 1);
+
+  /* Switch the cells around? */
+  const int flipped = runner_flip[sid];
+  sid = sortlistID[sid];
+
+  /* Has the cell cj been sorted? */
+  if (!(cj->hydro.sorted & (1 << sid)) ||
+      cj->hydro.dx_max_sort_old > space_maxreldx * cj->dmin)
+    error("Interacting unsorted cells.");
+
+  DOPAIR1_SUBSET_BH(r, ci, bparts_i, ind, bcount, cj, sid, flipped, shift);
+#endif
 }
 
 void DOSUB_SUBSET_BH(struct runner *r, struct cell *ci, struct bpart *bparts,
@@ -607,6 +893,10 @@ void DOPAIR1_BRANCH_BH(struct runner *r, struct cell *ci, struct cell *cj) {
 
   const struct engine *restrict e = r->e;
 
+  /* Get the sort ID. */
+  double shift[3] = {0.0, 0.0, 0.0};
+  const int sid = space_getsid(e->s, &ci, &cj, shift);
+
   const int ci_active = cell_is_active_black_holes(ci, e);
   const int cj_active = cell_is_active_black_holes(cj, e);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
@@ -639,8 +929,22 @@ void DOPAIR1_BRANCH_BH(struct runner *r, struct cell *ci, struct cell *cj) {
       (!cell_are_part_drifted(ci, e) || !cell_are_bpart_drifted(cj, e)))
     error("Interacting undrifted cells.");
 
-  /* No sorted intreactions here -> use the naive ones */
+  /* Have the local cells been sorted? */
+  if (do_ci && cj->nodeID == e->nodeID &&
+      (!(cj->hydro.sorted & (1 << sid)) ||
+       cj->hydro.dx_max_sort_old > space_maxreldx * cj->dmin))
+    error("Interacting unsorted cells.");
+
+  if (do_cj && ci->nodeID == e->nodeID &&
+      (!(ci->hydro.sorted & (1 << sid)) ||
+       ci->hydro.dx_max_sort_old > space_maxreldx * ci->dmin))
+    error("Interacting unsorted cells.");
+
+#ifdef SWIFT_USE_NAIVE_INTERACTIONS_BH
   DOPAIR1_BH_NAIVE(r, ci, cj, 1);
+#else
+  DOPAIR1_BH(r, ci, cj, sid, shift);
+#endif
 }
 
 /**
@@ -23,7 +23,8 @@
 /* This object's header. */
 #include "runner_doiact_vec.h"
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && \
+    (defined(HYDRO_VEC_DENSITY) || defined(HYDRO_VEC_FORCE))
 
 static const vector kernel_gamma2_vec = FILL_VEC(kernel_gamma2);
 
@@ -637,7 +638,7 @@ __attribute__((always_inline)) INLINE static int populate_max_index_subset(
   }
 }
 
-#endif /* WITH_VECTORIZATION && GADGET2_SPH */
+#endif /* WITH_VECTORIZATION && (HYDRO_VEC_DENSITY || HYDRO_VEC_FORCE) */
 
 /**
  * @brief Compute the cell self-interaction (non-symmetric) using vector
@@ -648,7 +649,7 @@ __attribute__((always_inline)) INLINE static int populate_max_index_subset(
  */
 void runner_doself1_density_vec(struct runner *r, struct cell *restrict c) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY)
 
   /* Get some local variables */
   const struct engine *e = r->e;
@@ -682,10 +683,15 @@ void runner_doself1_density_vec(struct runner *r, struct cell *restrict c) {
   /* Create secondary cache to store particle interactions. */
   struct c2_cache int_cache;
 
+  /* Get the particles that may be active. */
+  const int *order = NULL;
+  const int num_visit = cell_get_active_hydro_order(c, e, &order);
+
   /* Loop over the particles in the cell. */
-  for (int pid = 0; pid < count; pid++) {
+  for (int i = 0; i < num_visit; i++) {
 
     /* Get a pointer to the ith particle. */
+    const int pid = (order != NULL) ? order[i] : i;
     struct part *restrict pi = &parts[pid];
 
     /* Is the i^th particle active? */
@@ -866,7 +872,7 @@ void runner_doself1_density_vec(struct runner *r, struct cell *restrict c) {
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized functions for this SPH flavour!");
 
 #endif /* WITH_VECTORIZATION */
 }
@@ -885,7 +891,7 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
                                       struct part *restrict parts,
                                       int *restrict ind, int pi_count) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY)
 
   const int count = c->hydro.count;
 
@@ -1100,7 +1106,7 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized functions for this SPH flavour!");
 
 #endif /* WITH_VECTORIZATION */
 }
@@ -1114,7 +1120,7 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
  */
 void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_FORCE)
 
   const struct engine *e = r->e;
   const struct cosmology *restrict cosmo = e->cosmology;
@@ -1149,10 +1155,15 @@ void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
   const float a = cosmo->a;
   const float H = cosmo->H;
 
+  /* Get the particles that may be active. */
+  const int *order = NULL;
+  const int num_visit = cell_get_active_hydro_order(c, e, &order);
+
   /* Loop over the particles in the cell. */
-  for (int pid = 0; pid < count; pid++) {
+  for (int i = 0; i < num_visit; i++) {
 
     /* Get a pointer to the ith particle. */
+    const int pid = (order != NULL) ? order[i] : i;
     struct part *restrict pi = &parts[pid];
 
     /* Is the i^th particle active? */
@@ -1287,7 +1298,7 @@ void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized functions for this SPH flavour!");
 
 #endif /* WITH_VECTORIZATION */
 }
@@ -1306,7 +1317,7 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
                                 struct cell *cj, const int sid,
                                 const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY)
 
   const struct engine *restrict e = r->e;
   const timebin_t max_active_bin = e->max_active_bin;
@@ -1695,7 +1706,7 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized functions for this SPH flavour!");
 
 #endif /* WITH_VECTORIZATION */
 }
@@ -1721,7 +1732,7 @@ void runner_dopair_subset_density_vec(struct runner *r,
                                       struct cell *restrict cj, const int sid,
                                       const int flipped, const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY)
 
   TIMER_TIC;
 
@@ -2060,7 +2071,7 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
                               struct cell *cj, const int sid,
                               const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_FORCE)
 
   const struct engine *restrict e = r->e;
   const struct cosmology *restrict cosmo = e->cosmology;
@@ -2482,7 +2493,7 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized functions for this SPH flavour!");
 
 #endif /* WITH_VECTORIZATION */
 }
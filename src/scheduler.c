@@ -41,6 +41,7 @@
 
 /* Local headers. */
 #include "atomic.h"
+#include "backoff.h"
 #include "cycle.h"
 #include "engine.h"
 #include "error.h"
@@ -1040,6 +1041,18 @@ void scheduler_splittasks(struct scheduler *s, const int fof_tasks) {
   }
 }
 
+/**
+ * @brief Splits the regular tasks added to the scheduler since a given task.
+ *
+ * @param s The #scheduler.
+ * @param first The index of the first task to split.
+ */
+void scheduler_splittasks_from(struct scheduler *s, const int first) {
+
+  threadpool_map(s->threadpool, scheduler_splittasks_mapper, &s->tasks[first],
+                 s->nr_tasks - first, sizeof(struct task), 0, s);
+}
+
 /**
  * @brief Add a #task to the #scheduler.
  *
@@ -1183,6 +1196,44 @@ void scheduler_set_unlocks(struct scheduler *s) {
   swift_free("offsets", offsets);
 }
 
+/**
+ * @brief Drop the dependencies from and to the empty tasks.
+ *
+ * To be used on a set of tasks whose unlocks were set by
+ * scheduler_set_unlocks() and of which some were since emptied. The other
+ * dependencies are kept, new ones can be added and the unlocks must then be
+ * set again. All the tasks are left inactive, as new ones would be.
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_prune_unlocks(struct scheduler *s) {
+
+  /* The unlocks are stored by unlocking task, so they can be compacted in
+   * place. */
+  int nr_unlocks = 0;
+  for (int k = 0; k < s->nr_tasks; k++) {
+    struct task *t = &s->tasks[k];
+    if (t->type != task_type_none) {
+      for (int j = 0; j < t->nr_unlock_tasks; j++) {
+        struct task *u = t->unlock_tasks[j];
+        if (u->type == task_type_none) continue;
+        s->unlocks[nr_unlocks] = u;
+        s->unlock_ind[nr_unlocks] = k;
+        nr_unlocks++;
+      }
+    }
+    t->nr_unlock_tasks = 0;
+    t->wait = 0;
+    t->skip = 1;
+  }
+
+  /* Re-set the counters, the tasks have to be activated again. */
+  s->nr_unlocks = nr_unlocks;
+  s->completed_unlock_writes = nr_unlocks;
+  s->waiting = 0;
+  s->active_count = 0;
+}
+
 /**
  * @brief Sort the tasks in topological order over all queues.
  *
@@ -1286,236 +1337,254 @@ void scheduler_reset(struct scheduler *s, int size) {
 }
 
 /**
- * @brief Compute the task weights
+ * @brief Run through the tasks backwards and set their weights, that is the
+ *        cost of the task plus the largest weight of the tasks it unlocks.
  *
  * @param s The #scheduler.
- * @param verbose Are we talkative?
+ * @param remote_weights The weights of the remote tasks unlocked by each send
+ *                       task, indexed as the tasks, or NULL if not known.
  */
-void scheduler_reweight(struct scheduler *s, int verbose) {
+static void scheduler_reweight_pass(struct scheduler *s,
+                                    const float *remote_weights) {
   const int nr_tasks = s->nr_tasks;
   int *tid = s->tasks_ind;
   struct task *tasks = s->tasks;
   const int nodeID = s->nodeID;
-  const float wscale = 0.001f;
-  const ticks tic = getticks();
 
-  /* Run through the tasks backwards and set their weights. */
   for (int k = nr_tasks - 1; k >= 0; k--) {
     struct task *t = &tasks[tid[k]];
-    float cost = 0.f;
     t->weight = 0.f;
 
     for (int j = 0; j < t->nr_unlock_tasks; j++)
       if (t->unlock_tasks[j]->weight > t->weight)
         t->weight = t->unlock_tasks[j]->weight;
 
-    const float count_i = (t->ci != NULL) ? t->ci->hydro.count : 0.f;
-    const float count_j = (t->cj != NULL) ? t->cj->hydro.count : 0.f;
-    const float gcount_i = (t->ci != NULL) ? t->ci->grav.count : 0.f;
-    const float gcount_j = (t->cj != NULL) ? t->cj->grav.count : 0.f;
-    const float scount_i = (t->ci != NULL) ? t->ci->stars.count : 0.f;
-    const float scount_j = (t->cj != NULL) ? t->cj->stars.count : 0.f;
-    const float bcount_i = (t->ci != NULL) ? t->ci->black_holes.count : 0.f;
-    const float bcount_j = (t->cj != NULL) ? t->cj->black_holes.count : 0.f;
+    /* Sends also lead to the tasks waiting for them on the other rank. */
+    if (remote_weights != NULL && t->type == task_type_send &&
+        remote_weights[tid[k]] > t->weight)
+      t->weight = remote_weights[tid[k]];
 
-    switch (t->type) {
-      case task_type_sort:
-        cost = wscale * intrinsics_popcount(t->flags) * count_i *
-               (sizeof(int) * 8 - intrinsics_clz(t->ci->hydro.count));
-        break;
+    t->weight += cost_model_task_cost(&s->cost_model, t, nodeID);
+  }
+}
 
-      case task_type_stars_sort:
-        cost = wscale * intrinsics_popcount(t->flags) * scount_i *
-               (sizeof(int) * 8 - intrinsics_clz(t->ci->stars.count));
-        break;
+#ifdef WITH_MPI
 
-      case task_type_self:
-        if (t->subtype == task_subtype_grav) {
-          cost = 1.f * (wscale * gcount_i) * gcount_i;
-        } else if (t->subtype == task_subtype_external_grav)
-          cost = 1.f * wscale * gcount_i;
-        else if (t->subtype == task_subtype_stars_density)
-          cost = 1.f * wscale * scount_i * count_i;
-        else if (t->subtype == task_subtype_stars_feedback)
-          cost = 1.f * wscale * scount_i * count_i;
-        else if (t->subtype == task_subtype_bh_density)
-          cost = 1.f * wscale * bcount_i * count_i;
-        else if (t->subtype == task_subtype_bh_feedback)
-          cost = 1.f * wscale * bcount_i * count_i;
-        else  // hydro loops
-          cost = 1.f * (wscale * count_i) * count_i;
-        break;
+/* Weight of a recv task, as sent back to the rank of the matching send. */
+struct task_remote_weight {
+  int tag;
+  int subtype;
+  float weight;
+};
 
-      case task_type_pair:
-        if (t->subtype == task_subtype_grav) {
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
-            cost = 3.f * (wscale * gcount_i) * gcount_j;
-          else
-            cost = 2.f * (wscale * gcount_i) * gcount_j;
-
-        } else if (t->subtype == task_subtype_stars_density ||
-                   t->subtype == task_subtype_stars_feedback) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * count_i * scount_j * sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * scount_i * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_bh_density ||
-                   t->subtype == task_subtype_bh_feedback) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * count_i * bcount_j * sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * bcount_i * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
-                   sid_scale[t->flags];
+/* qsort support for the send tasks, ordered by destination rank, tag and
+ * subtype. Uses a file-scope pointer to the tasks, which is fine as this is
+ * only called from the engine thread. */
+static const struct task *send_sort_tasks = NULL;
+static int sendtaskcmp(const void *p1, const void *p2) {
+  const struct task *t1 = &send_sort_tasks[*(const int *)p1];
+  const struct task *t2 = &send_sort_tasks[*(const int *)p2];
+  if (t1->cj->nodeID != t2->cj->nodeID) return t1->cj->nodeID - t2->cj->nodeID;
+  if (t1->flags != t2->flags) return (t1->flags < t2->flags) ? -1 : 1;
+  return t1->subtype - t2->subtype;
+}
 
-        } else {  // hydro loops
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
-            cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-        }
-        break;
+/**
+ * @brief Extend the task weights into critical paths across all the ranks.
+ *
+ * The weights of the recv tasks, which are the lengths of the longest chains
+ * of work they lead to on their rank, are sent back to the ranks of the
+ * matching send tasks and the weights recomputed including them. This is
+ * repeated #scheduler_critical_path_iterations times, so that chains that
+ * cross between ranks more than once are also seen.
+ *
+ * @param s The #scheduler.
+ * @param nr_nodes The number of ranks.
+ */
+static void scheduler_reweight_critical_path(struct scheduler *s,
+                                             int nr_nodes) {
+  const int nr_tasks = s->nr_tasks;
+  struct task *tasks = s->tasks;
 
-      case task_type_sub_pair:
-#ifdef SWIFT_DEBUG_CHECKS
-        if (t->flags < 0) error("Negative flag value!");
-#endif
-        if (t->subtype == task_subtype_stars_density ||
-            t->subtype == task_subtype_stars_feedback) {
-          if (t->ci->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * scount_j * sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * scount_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
-                   sid_scale[t->flags];
-          }
+  /* Count the recvs by source and gather the sends. */
+  int *send_counts = (int *)calloc(nr_nodes, sizeof(int));
+  int *recv_counts = (int *)calloc(nr_nodes, sizeof(int));
+  int *send_offsets = (int *)calloc(nr_nodes, sizeof(int));
+  int *recv_offsets = (int *)calloc(nr_nodes, sizeof(int));
+  if (send_counts == NULL || recv_counts == NULL || send_offsets == NULL ||
+      recv_offsets == NULL)
+    error("Failed to allocate the remote weight counts.");
+
+  int nr_sends = 0;
+  for (int k = 0; k < nr_tasks; k++) {
+    if (tasks[k].type == task_type_recv) send_counts[tasks[k].ci->nodeID]++;
+    if (tasks[k].type == task_type_send) nr_sends++;
+  }
+  int *sends = (int *)malloc(sizeof(int) * (nr_sends + 1));
+  if (sends == NULL) error("Failed to allocate the send task index.");
+  nr_sends = 0;
+  for (int k = 0; k < nr_tasks; k++)
+    if (tasks[k].type == task_type_send) sends[nr_sends++] = k;
+  send_sort_tasks = tasks;
+  qsort(sends, nr_sends, sizeof(int), sendtaskcmp);
+
+  /* Exchange the counts, these are the same for all iterations. */
+  int res = MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT,
+                         MPI_COMM_WORLD);
+  if (res != MPI_SUCCESS) mpi_error(res, "Failed to exchange weight counts.");
+  int nr_out = 0, nr_in = 0;
+  for (int k = 0; k < nr_nodes; k++) {
+    send_offsets[k] = nr_out;
+    recv_offsets[k] = nr_in;
+    nr_out += send_counts[k];
+    nr_in += recv_counts[k];
+  }
 
-        } else if (t->subtype == task_subtype_bh_density ||
-                   t->subtype == task_subtype_bh_feedback) {
-          if (t->ci->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * bcount_j * sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * bcount_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
-                   sid_scale[t->flags];
-          }
+  /* We exchange bytes. */
+  const int size = sizeof(struct task_remote_weight);
+  int *send_bytes = (int *)malloc(sizeof(int) * 4 * nr_nodes);
+  if (send_bytes == NULL) error("Failed to allocate the remote weight counts.");
+  int *send_displs = &send_bytes[nr_nodes];
+  int *recv_bytes = &send_bytes[2 * nr_nodes];
+  int *recv_displs = &send_bytes[3 * nr_nodes];
+  for (int k = 0; k < nr_nodes; k++) {
+    send_bytes[k] = send_counts[k] * size;
+    send_displs[k] = send_offsets[k] * size;
+    recv_bytes[k] = recv_counts[k] * size;
+    recv_displs[k] = recv_offsets[k] * size;
+  }
 
-        } else {  // hydro loops
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
+  struct task_remote_weight *out = (struct task_remote_weight *)malloc(
+      sizeof(struct task_remote_weight) * (nr_out + 1));
+  struct task_remote_weight *in = (struct task_remote_weight *)malloc(
+      sizeof(struct task_remote_weight) * (nr_in + 1));
+  float *remote_weights = (float *)calloc(nr_tasks + 1, sizeof(float));
+  if (out == NULL || in == NULL || remote_weights == NULL)
+    error("Failed to allocate the remote weights.");
+
+  for (int iter = 0; iter < scheduler_critical_path_iterations; iter++) {
+
+    /* Pack the weights of our recvs. */
+    for (int k = 0; k < nr_nodes; k++) send_counts[k] = 0;
+    for (int k = 0; k < nr_tasks; k++) {
+      const struct task *t = &tasks[k];
+      if (t->type != task_type_recv) continue;
+      const int node = t->ci->nodeID;
+      struct task_remote_weight *w = &out[send_offsets[node] + send_counts[node]];
+      w->tag = t->flags;
+      w->subtype = t->subtype;
+      w->weight = t->weight;
+      send_counts[node]++;
+    }
+
+    res = MPI_Alltoallv(out, send_bytes, send_displs, MPI_BYTE, in, recv_bytes,
+                        recv_displs, MPI_BYTE, MPI_COMM_WORLD);
+    if (res != MPI_SUCCESS) mpi_error(res, "Failed to exchange task weights.");
+
+    /* Attach them to the matching sends. */
+    for (int node = 0; node < nr_nodes; node++) {
+      for (int k = 0; k < recv_counts[node]; k++) {
+        const struct task_remote_weight *w = &in[recv_offsets[node] + k];
+
+        /* Binary search of the sorted sends. */
+        int lo = 0, hi = nr_sends - 1, found = -1;
+        while (lo <= hi) {
+          const int mid = (lo + hi) / 2;
+          const struct task *t = &tasks[sends[mid]];
+          int cmp = node - t->cj->nodeID;
+          if (cmp == 0 && w->tag != t->flags)
+            cmp = (w->tag < t->flags) ? -1 : 1;
+          if (cmp == 0) cmp = w->subtype - (int)t->subtype;
+          if (cmp == 0) {
+            found = sends[mid];
+            break;
+          } else if (cmp < 0) {
+            hi = mid - 1;
           } else {
-            cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
+            lo = mid + 1;
           }
         }
-        break;
-
-      case task_type_sub_self:
-        if (t->subtype == task_subtype_stars_density) {
-          cost = 1.f * (wscale * scount_i) * count_i;
-        } else if (t->subtype == task_subtype_stars_feedback) {
-          cost = 1.f * (wscale * scount_i) * count_i;
-        } else if (t->subtype == task_subtype_bh_density) {
-          cost = 1.f * (wscale * bcount_i) * count_i;
-        } else if (t->subtype == task_subtype_bh_feedback) {
-          cost = 1.f * (wscale * bcount_i) * count_i;
-        } else {
-          cost = 1.f * (wscale * count_i) * count_i;
-        }
-        break;
-      case task_type_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
-        break;
-      case task_type_extra_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
-        break;
-      case task_type_stars_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * scount_i;
-        break;
-      case task_type_bh_density_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
-        break;
-      case task_type_drift_part:
-        cost = wscale * count_i;
-        break;
-      case task_type_drift_gpart:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_drift_spart:
-        cost = wscale * scount_i;
-        break;
-      case task_type_drift_bpart:
-        cost = wscale * bcount_i;
-        break;
-      case task_type_init_grav:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_down:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_long_range:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_mm:
-        cost = wscale * (gcount_i + gcount_j);
-        break;
-      case task_type_end_hydro_force:
-        cost = wscale * count_i;
-        break;
-      case task_type_end_grav_force:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_cooling:
-        cost = wscale * count_i;
-        break;
-      case task_type_star_formation:
-        cost = wscale * (count_i + scount_i);
-        break;
-      case task_type_kick1:
-        cost = wscale * (count_i + gcount_i + scount_i + bcount_i);
-        break;
-      case task_type_kick2:
-        cost = wscale * (count_i + gcount_i + scount_i + bcount_i);
-        break;
-      case task_type_timestep:
-        cost = wscale * (count_i + gcount_i + scount_i + bcount_i);
-        break;
-      case task_type_send:
-        if (count_i < 1e5)
-          cost = 10.f * (wscale * count_i) * count_i;
-        else
-          cost = 2e9;
-        break;
-      case task_type_recv:
-        if (count_i < 1e5)
-          cost = 5.f * (wscale * count_i) * count_i;
-        else
-          cost = 1e9;
-        break;
-      default:
-        cost = 0;
-        break;
+        if (found < 0)
+          error("No send task for tag %d subtype %s to rank %d.", w->tag,
+                subtaskID_names[w->subtype], node);
+        remote_weights[found] = w->weight;
+      }
     }
-    t->weight += cost;
+
+    /* And redo the weights. */
+    scheduler_reweight_pass(s, remote_weights);
   }
 
+  free(remote_weights);
+  free(in);
+  free(out);
+  free(send_bytes);
+  free(sends);
+  free(recv_offsets);
+  free(send_offsets);
+  free(recv_counts);
+  free(send_counts);
+}
+#endif /* WITH_MPI */
+
+/**
+ * @brief Compute the task weights
+ *
+ * @param s The #scheduler.
+ * @param verbose Are we talkative?
+ */
+void scheduler_reweight(struct scheduler *s, int verbose) {
+  const ticks tic = getticks();
+
+  scheduler_reweight_pass(s, NULL);
+
+#ifdef WITH_MPI
+  /* Follow the chains of tasks into the other ranks? */
+  const int nr_nodes = s->space->e->nr_nodes;
+  if (s->critical_path && nr_nodes > 1)
+    scheduler_reweight_critical_path(s, nr_nodes);
+#endif
+
   if (verbose)
     message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
             clocks_getunit());
+}
 
-  /* int min = tasks[0].weight, max = tasks[0].weight;
-  for ( int k = 1 ; k < nr_tasks ; k++ )
-      if ( tasks[k].weight < min )
-          min = tasks[k].weight;
-      else if ( tasks[k].weight > max )
-          max = tasks[k].weight;
-  message( "task weights are in [ %i , %i ]." , min , max ); */
+/**
+ * @brief Measure the critical path of the tasks run since a given time.
+ *
+ * This is the length of the longest chain of dependent tasks, using the
+ * times they actually took, so can be compared with the time taken by the
+ * step to see how well the tasks were scheduled.
+ *
+ * @param s The #scheduler.
+ * @param since Start of the step, tasks that last ran before are ignored.
+ * @return The critical path in ticks.
+ */
+ticks scheduler_critical_path(const struct scheduler *s, ticks since) {
+  const int nr_tasks = s->nr_tasks;
+  const int *tid = s->tasks_ind;
+  const struct task *tasks = s->tasks;
+
+  ticks *length = (ticks *)malloc(sizeof(ticks) * (nr_tasks + 1));
+  if (length == NULL) error("Failed to allocate the critical path lengths.");
+
+  ticks critical = 0;
+  for (int k = nr_tasks - 1; k >= 0; k--) {
+    const struct task *t = &tasks[tid[k]];
+    ticks longest = 0;
+    for (int j = 0; j < t->nr_unlock_tasks; j++) {
+      const ticks l = length[t->unlock_tasks[j] - tasks];
+      if (l > longest) longest = l;
+    }
+    if (!t->implicit && t->tic >= since && t->toc > t->tic)
+      longest += t->toc - t->tic;
+    length[tid[k]] = longest;
+    if (longest > critical) critical = longest;
+  }
+
+  free(length);
+  return critical;
 }
 
 /**
@@ -1662,6 +1731,7 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
       case task_type_logger:
       case task_type_stars_sort:
       case task_type_timestep:
+      case task_type_kick_timestep:
         qid = t->ci->super->owner;
         break;
       case task_type_pair:
@@ -1935,6 +2005,17 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
 
     /* Insert the task into that queue. */
     queue_insert(&s->queues[qid], t);
+
+    /* Wake up one sleeping runner to run it, or all of them if they cannot
+       take tasks from each other's queues. */
+    if (s->nr_sleeping > 0) {
+      pthread_mutex_lock(&s->sleep_mutex);
+      if (s->flags & scheduler_flag_steal)
+        pthread_cond_signal(&s->sleep_cond);
+      else
+        pthread_cond_broadcast(&s->sleep_cond);
+      pthread_mutex_unlock(&s->sleep_mutex);
+    }
   }
 }
 
@@ -1965,13 +2046,15 @@ struct task *scheduler_done(struct scheduler *s, struct task *t) {
     }
   }
 
-  /* Task definitely done, signal any sleeping runners. */
+  /* Task definitely done. Wake up the sleeping runners if this was the last
+     task or if some of them wait for the locks it released. */
   if (!t->implicit) {
     t->toc = getticks();
-    pthread_mutex_lock(&s->sleep_mutex);
-    atomic_dec(&s->waiting);
-    pthread_cond_broadcast(&s->sleep_cond);
-    pthread_mutex_unlock(&s->sleep_mutex);
+    if (atomic_dec(&s->waiting) == 1 || s->nr_blocked > 0) {
+      pthread_mutex_lock(&s->sleep_mutex);
+      pthread_cond_broadcast(&s->sleep_cond);
+      pthread_mutex_unlock(&s->sleep_mutex);
+    }
   }
 
   /* Mark the task as skip. */
@@ -2008,10 +2091,11 @@ struct task *scheduler_unlock(struct scheduler *s, struct task *t) {
   /* Task definitely done. */
   if (!t->implicit) {
     t->toc = getticks();
-    pthread_mutex_lock(&s->sleep_mutex);
-    atomic_dec(&s->waiting);
-    pthread_cond_broadcast(&s->sleep_cond);
-    pthread_mutex_unlock(&s->sleep_mutex);
+    if (atomic_dec(&s->waiting) == 1 || s->nr_blocked > 0) {
+      pthread_mutex_lock(&s->sleep_mutex);
+      pthread_cond_broadcast(&s->sleep_cond);
+      pthread_mutex_unlock(&s->sleep_mutex);
+    }
   }
 
   /* Return the next best task. Note that we currently do not
@@ -2020,6 +2104,22 @@ struct task *scheduler_unlock(struct scheduler *s, struct task *t) {
   return NULL;
 }
 
+/**
+ * @brief Are there no tasks that a runner of the given queue could run?
+ *
+ * @param s The #scheduler.
+ * @param qid The ID of the runner's #queue.
+ */
+static int scheduler_queues_empty(const struct scheduler *s, int qid) {
+
+  if (!(s->flags & scheduler_flag_steal))
+    return s->queues[qid].count == 0 && s->queues[qid].count_incoming == 0;
+
+  for (int k = 0; k < s->nr_queues; k++)
+    if (s->queues[k].count > 0 || s->queues[k].count_incoming > 0) return 0;
+  return 1;
+}
+
 /**
  * @brief Get a task, preferably from the given queue.
  *
@@ -2038,6 +2138,10 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
   /* Check qid. */
   if (qid >= nr_queues || qid < 0) error("Bad queue ID.");
 
+  /* Keep polling for a while before going to sleep. */
+  struct backoff backoff;
+  backoff_init(&backoff, s->spin_ticks);
+
   /* Loop as long as there are tasks... */
   while (s->waiting > 0 && res == NULL) {
     /* Try more than once before sleeping. */
@@ -2063,28 +2167,49 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
           TIMER_TIC
           res = queue_gettask(&s->queues[qids[ind]], prev, 0);
           TIMER_TOC(timer_qsteal);
-          if (res != NULL)
+          if (res != NULL) {
+            if (qids[ind] != qid) atomic_inc(&s->queues[qid].nr_steals);
             break;
-          else
+          } else {
             qids[ind] = qids[--count];
+          }
         }
         if (res != NULL) break;
       }
     }
 
-/* If we failed, take a short nap. */
+/* If we failed, spin for a bit and try again, then take a short nap. */
 #ifdef WITH_MPI
     if (res == NULL && qid > 1)
 #else
     if (res == NULL)
 #endif
     {
+      if (backoff_spin(&backoff)) continue;
+
+      /* Count ourselves as sleeping before the last look at the queues, so
+         that the tasks enqueued from now on wake us up. Until we know better,
+         assume that we wait for locked tasks. */
       pthread_mutex_lock(&s->sleep_mutex);
+      atomic_inc(&s->nr_sleeping);
+      atomic_inc(&s->nr_blocked);
+      int blocked = 1;
       res = queue_gettask(&s->queues[qid], prev, 1);
       if (res == NULL && s->waiting > 0) {
+
+        /* If there is nothing to run at all, only new tasks can wake us. */
+        if (scheduler_queues_empty(s, qid)) {
+          atomic_dec(&s->nr_blocked);
+          blocked = 0;
+        }
         pthread_cond_wait(&s->sleep_cond, &s->sleep_mutex);
       }
+      if (blocked) atomic_dec(&s->nr_blocked);
+      atomic_dec(&s->nr_sleeping);
       pthread_mutex_unlock(&s->sleep_mutex);
+
+      /* Start polling afresh. */
+      backoff_init(&backoff, s->spin_ticks);
     }
   }
 
@@ -2129,6 +2254,9 @@ void scheduler_init(struct scheduler *s, struct space *space, int nr_tasks,
   if (pthread_cond_init(&s->sleep_cond, NULL) != 0 ||
       pthread_mutex_init(&s->sleep_mutex, NULL) != 0)
     error("Failed to initialize sleep barrier.");
+  s->nr_sleeping = 0;
+  s->nr_blocked = 0;
+  s->spin_ticks = 0;
 
   /* Init the unlocks. */
   if ((s->unlocks = (struct task **)swift_malloc(
@@ -33,6 +33,7 @@
 
 /* Includes. */
 #include "cell.h"
+#include "cost_model.h"
 #include "inline.h"
 #include "lock.h"
 #include "queue.h"
@@ -45,6 +46,7 @@
 #define scheduler_dosub 1
 #define scheduler_maxsteal 10
 #define scheduler_maxtries 2
+#define scheduler_critical_path_iterations 2
 #define scheduler_doforcesplit            \
   0 /* Beware: switching this on can/will \
        break engine_addlink as it assumes \
@@ -93,6 +95,13 @@ struct scheduler {
   pthread_mutex_t sleep_mutex;
   pthread_cond_t sleep_cond;
 
+  /* Number of sleeping runners and, amongst them, of runners waiting for
+   * locked tasks rather than for new ones. */
+  volatile int nr_sleeping, nr_blocked;
+
+  /* Number of ticks a runner polls the queues before going to sleep. */
+  ticks spin_ticks;
+
   /* The space associated with this scheduler. */
   struct space *space;
 
@@ -108,6 +117,12 @@ struct scheduler {
 
   /* 'Pointer' to the seed for the random number generator */
   pthread_key_t local_seed_pointer;
+
+  /* Model of the task costs used for the weights. */
+  struct cost_model cost_model;
+
+  /* Extend the task weights into critical paths across ranks? */
+  int critical_path;
 };
 
 /* Inlined functions (for speed). */
@@ -187,14 +202,17 @@ void scheduler_start(struct scheduler *s);
 void scheduler_reset(struct scheduler *s, int nr_tasks);
 void scheduler_ranktasks(struct scheduler *s);
 void scheduler_reweight(struct scheduler *s, int verbose);
+ticks scheduler_critical_path(const struct scheduler *s, ticks since);
 struct task *scheduler_addtask(struct scheduler *s, enum task_types type,
                                enum task_subtypes subtype, int flags,
                                int implicit, struct cell *ci, struct cell *cj);
 void scheduler_splittasks(struct scheduler *s, const int fof_tasks);
+void scheduler_splittasks_from(struct scheduler *s, const int first);
 struct task *scheduler_done(struct scheduler *s, struct task *t);
 struct task *scheduler_unlock(struct scheduler *s, struct task *t);
 void scheduler_addunlock(struct scheduler *s, struct task *ta, struct task *tb);
 void scheduler_set_unlocks(struct scheduler *s);
+void scheduler_prune_unlocks(struct scheduler *s);
 void scheduler_dump_queue(struct scheduler *s);
 void scheduler_print_tasks(const struct scheduler *s, const char *fileName);
 void scheduler_clean(struct scheduler *s);
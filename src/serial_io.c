@@ -49,6 +49,7 @@
 #include "gravity_properties.h"
 #include "hydro_io.h"
 #include "hydro_properties.h"
+#include "io_compression.h"
 #include "io_properties.h"
 #include "kernel_hydro.h"
 #include "memuse.h"
@@ -76,15 +77,16 @@
  * IC velocities?
  * @param h The value of the reduced Hubble constant to use for cleaning.
  * @param a The current value of the scale-factor.
+ * @param tp The #threadpool used for the unit conversion.
  *
- * @todo A better version using HDF5 hyper-slabs to read the file directly into
- * the part array will be written once the structures have been stabilized.
+ * The data is read by HDF5 straight into the particles and converted to the
+ * internal units in place.
  */
 void readArray(hid_t grp, const struct io_props props, size_t N,
                long long N_total, long long offset,
                const struct unit_system* internal_units,
                const struct unit_system* ic_units, int cleanup_h,
-               int cleanup_sqrt_a, double h, double a) {
+               int cleanup_sqrt_a, double h, double a, struct threadpool* tp) {
 
   const size_t typeSize = io_sizeof_type(props.type);
   const size_t copySize = typeSize * props.dimension;
@@ -112,10 +114,6 @@ void readArray(hid_t grp, const struct io_props props, size_t N,
   const hid_t h_data = H5Dopen(grp, props.name, H5P_DEFAULT);
   if (h_data < 0) error("Error while opening data space '%s'.", props.name);
 
-  /* Allocate temporary buffer */
-  void* temp = malloc(num_elements * typeSize);
-  if (temp == NULL) error("Unable to allocate memory for temporary buffer");
-
   /* Prepare information for hyper-slab */
   hsize_t shape[2], offsets[2];
   int rank;
@@ -133,107 +131,52 @@ void readArray(hid_t grp, const struct io_props props, size_t N,
     offsets[1] = 0;
   }
 
-  /* Create data space in memory */
-  const hid_t h_memspace = H5Screate_simple(rank, shape, NULL);
-
   /* Select hyper-slab in file */
   const hid_t h_filespace = H5Dget_space(h_data);
   H5Sselect_hyperslab(h_filespace, H5S_SELECT_SET, offsets, NULL, shape, NULL);
 
-  /* Read HDF5 dataspace in temporary buffer */
-  /* Dirty version that happens to work for vectors but should be improved */
-  /* Using HDF5 dataspaces would be better */
-  const hid_t h_err = H5Dread(h_data, io_hdf5_type(props.type), h_memspace,
-                              h_filespace, H5P_DEFAULT, temp);
-  if (h_err < 0) error("Error while reading data array '%s'.", props.name);
-
-  /* Unit conversion if necessary */
-  const double factor =
-      units_conversion_factor(ic_units, internal_units, props.units);
-  if (factor != 1. && exist != 0) {
-
-    /* message("Converting ! factor=%e", factor); */
-
-    if (io_is_double_precision(props.type)) {
-      double* temp_d = (double*)temp;
-      for (size_t i = 0; i < num_elements; ++i) temp_d[i] *= factor;
-    } else {
-      float* temp_f = (float*)temp;
-
-#ifdef SWIFT_DEBUG_CHECKS
-      float maximum = 0.f;
-      float minimum = FLT_MAX;
-#endif
+  /* Where does the field live in the particles? */
+  const hid_t h_fieldspace = io_field_memspace(props, N);
 
-      /* Loop that converts the Units */
-      for (size_t i = 0; i < num_elements; ++i) {
+  if (h_fieldspace >= 0) {
 
-#ifdef SWIFT_DEBUG_CHECKS
-        /* Find the absolute minimum and maximum values */
-        const float abstemp_f = fabsf(temp_f[i]);
-        if (abstemp_f != 0.f) {
-          maximum = max(maximum, abstemp_f);
-          minimum = min(minimum, abstemp_f);
-        }
-#endif
+    /* Read HDF5 dataspace straight into the particles */
+    const hid_t h_err = H5Dread(h_data, io_hdf5_type(props.type), h_fieldspace,
+                                h_filespace, H5P_DEFAULT, props.field);
+    if (h_err < 0) error("Error while reading data array '%s'.", props.name);
 
-        /* Convert the float units */
-        temp_f[i] *= factor;
-      }
+    H5Sclose(h_fieldspace);
 
-#ifdef SWIFT_DEBUG_CHECKS
-      /* The two possible errors: larger than float or smaller
-       * than float precision. */
-      if (factor * maximum > FLT_MAX) {
-        error("Unit conversion results in numbers larger than floats");
-      } else if (factor * minimum < FLT_MIN) {
-        error("Numbers smaller than float precision");
-      }
-#endif
-    }
-  }
+  } else {
 
-  /* Clean-up h if necessary */
-  const float h_factor_exp = units_h_factor(internal_units, props.units);
-  if (cleanup_h && h_factor_exp != 0.f && exist != 0) {
+    /* Allocate temporary buffer */
+    void* temp = malloc(num_elements * typeSize);
+    if (temp == NULL) error("Unable to allocate memory for temporary buffer");
 
-    /* message("Multipltying '%s' by h^%f=%f", props.name, h_factor_exp,
-     * h_factor); */
+    /* Create data space in memory */
+    const hid_t h_memspace = H5Screate_simple(rank, shape, NULL);
 
-    if (io_is_double_precision(props.type)) {
-      double* temp_d = (double*)temp;
-      const double h_factor = pow(h, h_factor_exp);
-      for (size_t i = 0; i < num_elements; ++i) temp_d[i] *= h_factor;
-    } else {
-      float* temp_f = (float*)temp;
-      const float h_factor = pow(h, h_factor_exp);
-      for (size_t i = 0; i < num_elements; ++i) temp_f[i] *= h_factor;
-    }
-  }
+    /* Read HDF5 dataspace in temporary buffer */
+    const hid_t h_err = H5Dread(h_data, io_hdf5_type(props.type), h_memspace,
+                                h_filespace, H5P_DEFAULT, temp);
+    if (h_err < 0) error("Error while reading data array '%s'.", props.name);
 
-  /* Clean-up a if necessary */
-  if (cleanup_sqrt_a && a != 1. && (strcmp(props.name, "Velocities") == 0)) {
+    /* Copy temporary buffer to particle data */
+    char* temp_c = (char*)temp;
+    for (size_t i = 0; i < N; ++i)
+      memcpy(props.field + i * props.partSize, &temp_c[i * copySize],
+             copySize);
 
-    if (io_is_double_precision(props.type)) {
-      double* temp_d = (double*)temp;
-      const double vel_factor = sqrt(a);
-      for (size_t i = 0; i < num_elements; ++i) temp_d[i] *= vel_factor;
-    } else {
-      float* temp_f = (float*)temp;
-      const float vel_factor = sqrt(a);
-      for (size_t i = 0; i < num_elements; ++i) temp_f[i] *= vel_factor;
-    }
+    free(temp);
+    H5Sclose(h_memspace);
   }
 
-  /* Copy temporary buffer to particle data */
-  char* temp_c = (char*)temp;
-  for (size_t i = 0; i < N; ++i)
-    memcpy(props.field + i * props.partSize, &temp_c[i * copySize], copySize);
+  /* Unit conversion and clean-ups if necessary */
+  io_convert_read_field(tp, props, N, internal_units, ic_units, cleanup_h,
+                        cleanup_sqrt_a, h, a);
 
-  /* Free and close everything */
-  free(temp);
+  /* Close everything */
   H5Sclose(h_filespace);
-  H5Sclose(h_memspace);
   H5Dclose(h_data);
 }
 
@@ -241,7 +184,8 @@ void prepareArray(const struct engine* e, hid_t grp, char* fileName,
                   FILE* xmfFile, char* partTypeGroupName,
                   const struct io_props props, unsigned long long N_total,
                   const struct unit_system* internal_units,
-                  const struct unit_system* snapshot_units) {
+                  const struct unit_system* snapshot_units,
+                  const enum lossy_compression_schemes lossy_compression) {
 
   /* Create data space */
   const hid_t h_space = H5Screate(H5S_SIMPLE);
@@ -273,6 +217,9 @@ void prepareArray(const struct engine* e, hid_t grp, char* fileName,
   if (h_err < 0)
     error("Error while changing data space shape for field '%s'.", props.name);
 
+  /* Type of the data on disk (may be changed by the lossy filter) */
+  const hid_t h_type = H5Tcopy(io_hdf5_type(props.type));
+
   /* Dataset properties */
   const hid_t h_prop = H5Pcreate(H5P_DATASET_CREATE);
 
@@ -282,6 +229,9 @@ void prepareArray(const struct engine* e, hid_t grp, char* fileName,
     error("Error while setting chunk size (%llu, %llu) for field '%s'.",
           chunk_shape[0], chunk_shape[1], props.name);
 
+  /* Impose the lossy filter (must come before the lossless ones) */
+  io_set_hdf5_lossy_compression(h_prop, h_type, lossy_compression, props.name);
+
   /* Impose check-sum to verify data corruption */
   h_err = H5Pset_fletcher32(h_prop);
   if (h_err < 0)
@@ -301,8 +251,8 @@ void prepareArray(const struct engine* e, hid_t grp, char* fileName,
   }
 
   /* Create dataset */
-  const hid_t h_data = H5Dcreate(grp, props.name, io_hdf5_type(props.type),
-                                 h_space, H5P_DEFAULT, h_prop, H5P_DEFAULT);
+  const hid_t h_data = H5Dcreate(grp, props.name, h_type, h_space,
+                                 H5P_DEFAULT, h_prop, H5P_DEFAULT);
   if (h_data < 0) error("Error while creating dataspace '%s'.", props.name);
 
   /* Write XMF description for this data set */
@@ -337,7 +287,11 @@ void prepareArray(const struct engine* e, hid_t grp, char* fileName,
       "Conversion factor to phyical CGS (including cosmological corrections)",
       factor * pow(e->cosmology->a, a_factor_exp));
 
+  /* Record the lossy filter applied to this field */
+  io_write_lossy_compression_attribute(h_data, lossy_compression);
+
   /* Close everything */
+  H5Tclose(h_type);
   H5Pclose(h_prop);
   H5Dclose(h_data);
   H5Sclose(h_space);
@@ -359,16 +313,18 @@ void prepareArray(const struct engine* e, hid_t grp, char* fileName,
  * @param mpi_rank The MPI rank of this node
  * @param internal_units The #unit_system used internally
  * @param snapshot_units The #unit_system used in the snapshots
+ * @param lossy_compression The lossy filter to apply to this field.
  *
- * @todo A better version using HDF5 hyper-slabs to write the file directly from
- * the part array will be written once the structures have been stabilized.
+ * Fields that need neither a conversion function nor a change of units are
+ * written by HDF5 straight from the particles.
  */
 void writeArray(const struct engine* e, hid_t grp, char* fileName,
                 FILE* xmfFile, char* partTypeGroupName,
                 const struct io_props props, size_t N, long long N_total,
                 int mpi_rank, long long offset,
                 const struct unit_system* internal_units,
-                const struct unit_system* snapshot_units) {
+                const struct unit_system* snapshot_units,
+                const enum lossy_compression_schemes lossy_compression) {
 
   const size_t typeSize = io_sizeof_type(props.type);
   const size_t num_elements = N * props.dimension;
@@ -378,16 +334,21 @@ void writeArray(const struct engine* e, hid_t grp, char* fileName,
   /* Prepare the arrays in the file */
   if (mpi_rank == 0)
     prepareArray(e, grp, fileName, xmfFile, partTypeGroupName, props, N_total,
-                 internal_units, snapshot_units);
+                 internal_units, snapshot_units, lossy_compression);
+
+  /* Can we write straight from the particles? */
+  const hid_t h_fieldspace =
+      io_write_field_memspace(props, N, internal_units, snapshot_units);
 
-  /* Allocate temporary buffer */
+  /* Otherwise, copy the particle data to a temporary buffer */
   void* temp = NULL;
-  if (swift_memalign("writebuff", (void**)&temp, IO_BUFFER_ALIGNMENT,
-                     num_elements * typeSize) != 0)
-    error("Unable to allocate temporary i/o buffer");
+  if (h_fieldspace < 0) {
+    if (swift_memalign("writebuff", (void**)&temp, IO_BUFFER_ALIGNMENT,
+                       num_elements * typeSize) != 0)
+      error("Unable to allocate temporary i/o buffer");
 
-  /* Copy the particle data to the temporary buffer */
-  io_copy_temp_buffer(temp, e, props, N, internal_units, snapshot_units);
+    io_copy_temp_buffer(temp, e, props, N, internal_units, snapshot_units);
+  }
 
   /* Construct information for the hyper-slab */
   int rank;
@@ -427,13 +388,18 @@ void writeArray(const struct engine* e, hid_t grp, char* fileName,
   const hid_t h_filespace = H5Dget_space(h_data);
   H5Sselect_hyperslab(h_filespace, H5S_SELECT_SET, offsets, NULL, shape, NULL);
 
-  /* Write temporary buffer to HDF5 dataspace */
-  h_err = H5Dwrite(h_data, io_hdf5_type(props.type), h_memspace, h_filespace,
-                   H5P_DEFAULT, temp);
+  /* Write the particles or the temporary buffer to HDF5 dataspace */
+  if (h_fieldspace >= 0)
+    h_err = H5Dwrite(h_data, io_hdf5_type(props.type), h_fieldspace,
+                     h_filespace, H5P_DEFAULT, props.field);
+  else
+    h_err = H5Dwrite(h_data, io_hdf5_type(props.type), h_memspace, h_filespace,
+                     H5P_DEFAULT, temp);
   if (h_err < 0) error("Error while writing data array '%s'.", props.name);
 
   /* Free and close everything */
-  swift_free("writebuff", temp);
+  if (temp != NULL) swift_free("writebuff", temp);
+  if (h_fieldspace >= 0) H5Sclose(h_fieldspace);
   H5Dclose(h_data);
   H5Sclose(h_memspace);
   H5Sclose(h_filespace);
@@ -685,6 +651,10 @@ void read_ic_serial(char* fileName, const struct unit_system* internal_units,
   /* For dry runs, only need to do this on rank 0 */
   if (dry_run) mpi_size = 1;
 
+  /* Let's initialise a bit of thread parallelism here */
+  struct threadpool tp;
+  threadpool_init(&tp, n_threads);
+
   /* Now loop over ranks and read the data */
   for (int rank = 0; rank < mpi_size; ++rank) {
 
@@ -756,7 +726,7 @@ void read_ic_serial(char* fileName, const struct unit_system* internal_units,
           for (int i = 0; i < num_fields; ++i)
             readArray(h_grp, list[i], Nparticles, N_total[ptype], offset[ptype],
                       internal_units, ic_units, cleanup_h, cleanup_sqrt_a, h,
-                      a);
+                      a, &tp);
 
         /* Close particle group */
         H5Gclose(h_grp);
@@ -773,10 +743,6 @@ void read_ic_serial(char* fileName, const struct unit_system* internal_units,
   /* Duplicate the parts for gravity */
   if (!dry_run && with_gravity) {
 
-    /* Let's initialise a bit of thread parallelism here */
-    struct threadpool tp;
-    threadpool_init(&tp, n_threads);
-
     /* Prepare the DM particles */
     io_prepare_dm_gparts(&tp, *gparts, Ndm);
 
@@ -791,10 +757,10 @@ void read_ic_serial(char* fileName, const struct unit_system* internal_units,
     if (with_black_holes)
       io_duplicate_black_holes_gparts(&tp, *bparts, *gparts, *Nblackholes,
                                       Ndm + *Ngas + *Nstars);
-
-    threadpool_clean(&tp);
   }
 
+  threadpool_clean(&tp);
+
   /* message("Done Reading particles..."); */
 
   /* Clean up */
@@ -1357,16 +1323,17 @@ void write_output_serial(struct engine* e, const char* baseName,
         /* Write everything that is not cancelled */
         for (int i = 0; i < num_fields; ++i) {
 
-          /* Did the user cancel this field? */
+          /* Did the user cancel or compress this field? */
           char field[PARSER_MAX_LINE_SIZE];
           sprintf(field, "SelectOutput:%s_%s", list[i].name,
                   part_type_names[ptype]);
-          int should_write = parser_get_opt_param_int(params, field, 1);
+          const enum lossy_compression_schemes compression_level =
+              io_get_field_compression(params, field);
 
-          if (should_write)
+          if (compression_level != compression_do_not_write)
             writeArray(e, h_grp, fileName, xmfFile, partTypeGroupName, list[i],
                        Nparticles, N_total[ptype], mpi_rank, offset[ptype],
-                       internal_units, snapshot_units);
+                       internal_units, snapshot_units, compression_level);
         }
 
         /* Free temporary array */
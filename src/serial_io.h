@@ -31,6 +31,7 @@
 
 /* Includes. */
 #include "engine.h"
+#include "io_compression.h"
 #include "io_properties.h"
 #include "part.h"
 #include "units.h"
@@ -55,7 +56,8 @@ void writeArray(const struct engine* e, hid_t grp, char* fileName,
                 const struct io_props props, size_t N, long long N_total,
                 int mpi_rank, long long offset,
                 const struct unit_system* internal_units,
-                const struct unit_system* snapshot_units);
+                const struct unit_system* snapshot_units,
+                const enum lossy_compression_schemes lossy_compression);
 #endif
 
 #endif /* SWIFT_SERIAL_IO_H */
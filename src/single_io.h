@@ -26,6 +26,7 @@
 
 /* Includes. */
 #include "engine.h"
+#include "io_compression.h"
 #include "io_properties.h"
 #include "part.h"
 #include "units.h"
@@ -48,7 +49,8 @@ void writeArray(const struct engine* e, hid_t grp, char* fileName,
                 FILE* xmfFile, char* partTypeGroupName,
                 const struct io_props props, size_t N,
                 const struct unit_system* internal_units,
-                const struct unit_system* snapshot_units);
+                const struct unit_system* snapshot_units,
+                const enum lossy_compression_schemes lossy_compression);
 
 #endif /* HAVE_HDF5 && !WITH_MPI */
 
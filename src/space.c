@@ -179,123 +179,133 @@ void space_rebuild_recycle_rec(struct space *s, struct cell *c,
       }
 }
 
+/**
+ * @brief Dismantle the tree of a top-level cell and reset its data.
+ *
+ * @param s The #space.
+ * @param c The top-level #cell to recycle.
+ */
+static void space_rebuild_recycle_cell(struct space *s, struct cell *c) {
+
+  struct cell *cell_rec_begin = NULL, *cell_rec_end = NULL;
+  struct gravity_tensors *multipole_rec_begin = NULL,
+                         *multipole_rec_end = NULL;
+  space_rebuild_recycle_rec(s, c, &cell_rec_begin, &cell_rec_end,
+                            &multipole_rec_begin, &multipole_rec_end);
+  if (cell_rec_begin != NULL)
+    space_recycle_list(s, cell_rec_begin, cell_rec_end, multipole_rec_begin,
+                       multipole_rec_end);
+  c->hydro.sorts = NULL;
+  c->stars.sorts = NULL;
+  c->nr_tasks = 0;
+  c->grav.nr_mm_tasks = 0;
+  c->hydro.density = NULL;
+  c->hydro.gradient = NULL;
+  c->hydro.force = NULL;
+  c->hydro.limiter = NULL;
+  c->grav.grav = NULL;
+  c->grav.mm = NULL;
+  c->hydro.dx_max_part = 0.0f;
+  c->hydro.dx_max_sort = 0.0f;
+  c->stars.dx_max_part = 0.f;
+  c->stars.dx_max_sort = 0.f;
+  c->black_holes.dx_max_part = 0.f;
+  c->hydro.sorted = 0;
+  c->stars.sorted = 0;
+  c->hydro.count = 0;
+  c->hydro.count_total = 0;
+  c->hydro.updated = 0;
+  c->grav.count = 0;
+  c->grav.count_total = 0;
+  c->grav.updated = 0;
+  c->stars.count = 0;
+  c->stars.count_total = 0;
+  c->stars.updated = 0;
+  c->black_holes.count = 0;
+  c->black_holes.count_total = 0;
+  c->black_holes.updated = 0;
+  c->grav.init = NULL;
+  c->grav.init_out = NULL;
+  c->hydro.extra_ghost = NULL;
+  c->hydro.ghost_in = NULL;
+  c->hydro.ghost_out = NULL;
+  c->hydro.ghost = NULL;
+  c->hydro.star_formation = NULL;
+  c->hydro.stars_resort = NULL;
+  c->stars.ghost = NULL;
+  c->stars.density = NULL;
+  c->stars.feedback = NULL;
+  c->black_holes.density_ghost = NULL;
+  c->black_holes.swallow_ghost[0] = NULL;
+  c->black_holes.swallow_ghost[1] = NULL;
+  c->black_holes.density = NULL;
+  c->black_holes.swallow = NULL;
+  c->black_holes.do_swallow = NULL;
+  c->black_holes.feedback = NULL;
+  c->kick1 = NULL;
+  c->kick2 = NULL;
+  c->timestep = NULL;
+  c->timestep_limiter = NULL;
+  c->hydro.end_force = NULL;
+  c->hydro.drift = NULL;
+  c->stars.drift = NULL;
+  c->stars.stars_in = NULL;
+  c->stars.stars_out = NULL;
+  c->black_holes.drift = NULL;
+  c->black_holes.black_holes_in = NULL;
+  c->black_holes.black_holes_out = NULL;
+  c->grav.drift = NULL;
+  c->grav.drift_out = NULL;
+  c->hydro.cooling = NULL;
+  c->grav.long_range = NULL;
+  c->grav.down_in = NULL;
+  c->grav.down = NULL;
+  c->grav.mesh = NULL;
+  c->grav.end_force = NULL;
+  c->top = c;
+  c->super = c;
+  c->hydro.super = c;
+  c->grav.super = c;
+  c->hydro.parts = NULL;
+  c->hydro.xparts = NULL;
+  c->grav.parts = NULL;
+  c->stars.parts = NULL;
+  c->stars.parts_rebuild = NULL;
+  c->black_holes.parts = NULL;
+  c->flags = 0;
+  c->hydro.ti_end_min = -1;
+  c->hydro.ti_end_max = -1;
+  c->grav.ti_end_min = -1;
+  c->grav.ti_end_max = -1;
+  c->stars.ti_end_min = -1;
+  c->stars.ti_end_max = -1;
+  c->black_holes.ti_end_min = -1;
+  c->black_holes.ti_end_max = -1;
+  star_formation_logger_init(&c->stars.sfh);
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_CELL_GRAPH)
+  c->cellID = 0;
+#endif
+  if (s->with_self_gravity)
+    bzero(c->grav.multipole, sizeof(struct gravity_tensors));
+
+  cell_free_hydro_sorts(c);
+  cell_free_hydro_bin_order(c);
+  cell_free_stars_sorts(c);
+#if WITH_MPI
+  c->mpi.tag = -1;
+  c->mpi.recv = NULL;
+  c->mpi.send = NULL;
+#endif
+}
+
 void space_rebuild_recycle_mapper(void *map_data, int num_elements,
                                   void *extra_data) {
 
   struct space *s = (struct space *)extra_data;
   struct cell *cells = (struct cell *)map_data;
 
-  for (int k = 0; k < num_elements; k++) {
-    struct cell *c = &cells[k];
-    struct cell *cell_rec_begin = NULL, *cell_rec_end = NULL;
-    struct gravity_tensors *multipole_rec_begin = NULL,
-                           *multipole_rec_end = NULL;
-    space_rebuild_recycle_rec(s, c, &cell_rec_begin, &cell_rec_end,
-                              &multipole_rec_begin, &multipole_rec_end);
-    if (cell_rec_begin != NULL)
-      space_recycle_list(s, cell_rec_begin, cell_rec_end, multipole_rec_begin,
-                         multipole_rec_end);
-    c->hydro.sorts = NULL;
-    c->stars.sorts = NULL;
-    c->nr_tasks = 0;
-    c->grav.nr_mm_tasks = 0;
-    c->hydro.density = NULL;
-    c->hydro.gradient = NULL;
-    c->hydro.force = NULL;
-    c->hydro.limiter = NULL;
-    c->grav.grav = NULL;
-    c->grav.mm = NULL;
-    c->hydro.dx_max_part = 0.0f;
-    c->hydro.dx_max_sort = 0.0f;
-    c->stars.dx_max_part = 0.f;
-    c->stars.dx_max_sort = 0.f;
-    c->black_holes.dx_max_part = 0.f;
-    c->hydro.sorted = 0;
-    c->stars.sorted = 0;
-    c->hydro.count = 0;
-    c->hydro.count_total = 0;
-    c->hydro.updated = 0;
-    c->grav.count = 0;
-    c->grav.count_total = 0;
-    c->grav.updated = 0;
-    c->stars.count = 0;
-    c->stars.count_total = 0;
-    c->stars.updated = 0;
-    c->black_holes.count = 0;
-    c->black_holes.count_total = 0;
-    c->black_holes.updated = 0;
-    c->grav.init = NULL;
-    c->grav.init_out = NULL;
-    c->hydro.extra_ghost = NULL;
-    c->hydro.ghost_in = NULL;
-    c->hydro.ghost_out = NULL;
-    c->hydro.ghost = NULL;
-    c->hydro.star_formation = NULL;
-    c->hydro.stars_resort = NULL;
-    c->stars.ghost = NULL;
-    c->stars.density = NULL;
-    c->stars.feedback = NULL;
-    c->black_holes.density_ghost = NULL;
-    c->black_holes.swallow_ghost[0] = NULL;
-    c->black_holes.swallow_ghost[1] = NULL;
-    c->black_holes.density = NULL;
-    c->black_holes.swallow = NULL;
-    c->black_holes.do_swallow = NULL;
-    c->black_holes.feedback = NULL;
-    c->kick1 = NULL;
-    c->kick2 = NULL;
-    c->timestep = NULL;
-    c->timestep_limiter = NULL;
-    c->hydro.end_force = NULL;
-    c->hydro.drift = NULL;
-    c->stars.drift = NULL;
-    c->stars.stars_in = NULL;
-    c->stars.stars_out = NULL;
-    c->black_holes.drift = NULL;
-    c->black_holes.black_holes_in = NULL;
-    c->black_holes.black_holes_out = NULL;
-    c->grav.drift = NULL;
-    c->grav.drift_out = NULL;
-    c->hydro.cooling = NULL;
-    c->grav.long_range = NULL;
-    c->grav.down_in = NULL;
-    c->grav.down = NULL;
-    c->grav.mesh = NULL;
-    c->grav.end_force = NULL;
-    c->top = c;
-    c->super = c;
-    c->hydro.super = c;
-    c->grav.super = c;
-    c->hydro.parts = NULL;
-    c->hydro.xparts = NULL;
-    c->grav.parts = NULL;
-    c->stars.parts = NULL;
-    c->stars.parts_rebuild = NULL;
-    c->black_holes.parts = NULL;
-    c->flags = 0;
-    c->hydro.ti_end_min = -1;
-    c->hydro.ti_end_max = -1;
-    c->grav.ti_end_min = -1;
-    c->grav.ti_end_max = -1;
-    c->stars.ti_end_min = -1;
-    c->stars.ti_end_max = -1;
-    c->black_holes.ti_end_min = -1;
-    c->black_holes.ti_end_max = -1;
-    star_formation_logger_init(&c->stars.sfh);
-#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_CELL_GRAPH)
-    c->cellID = 0;
-#endif
-    if (s->with_self_gravity)
-      bzero(c->grav.multipole, sizeof(struct gravity_tensors));
-
-    cell_free_hydro_sorts(c);
-    cell_free_stars_sorts(c);
-#if WITH_MPI
-    c->mpi.tag = -1;
-    c->mpi.recv = NULL;
-    c->mpi.send = NULL;
-#endif
-  }
+  for (int k = 0; k < num_elements; k++)
+    space_rebuild_recycle_cell(s, &cells[k]);
 }
 
 /**
@@ -350,10 +360,15 @@ void space_free_foreign_parts(struct space *s) {
 /**
  * @brief Re-build the top-level cell grid.
  *
+ * The trees of the existing top-level cells are left untouched if the grid
+ * does not change, the caller is responsible for recycling them.
+ *
  * @param s The #space.
  * @param verbose Print messages to stdout or not.
+ *
+ * @return 1 if new top-level cells were constructed, 0 otherwise.
  */
-void space_regrid(struct space *s, int verbose) {
+int space_regrid(struct space *s, int verbose) {
 
   const size_t nr_parts = s->nr_parts;
   const size_t nr_sparts = s->nr_sparts;
@@ -678,16 +693,15 @@ void space_regrid(struct space *s, int verbose) {
     // message( "rebuilding upper-level cells took %.3f %s." ,
     // clocks_from_ticks(double)(getticks() - tic), clocks_getunit());
 
-  }      /* re-build upper-level cells? */
-  else { /* Otherwise, just clean up the cells. */
+    if (verbose)
+      message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
+              clocks_getunit());
 
-    /* Free the old cells, if they were allocated. */
-    space_free_cells(s);
-  }
+    return 1;
 
-  if (verbose)
-    message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
-            clocks_getunit());
+  } /* re-build upper-level cells? */
+
+  return 0;
 }
 
 /**
@@ -748,10 +762,45 @@ void space_allocate_extras(struct space *s, int verbose) {
     }
   }
 
+  /* Number of extra #spart we want in each local cell. This is at least the
+   * default number. The cells that used more than a fraction 1/growth of their
+   * spare particles since the last rebuild get growth times more of them, the
+   * ones that used less than 1/growth^2 of them get growth times fewer. */
+  int *extra_sparts_in_cell = (int *)malloc(sizeof(int) * nr_local_cells);
+  if (extra_sparts_in_cell == NULL)
+    error("Failed to allocate list of extra sparts per top-level cell");
+  const float growth = s->extra_sparts_growth;
+  size_t expected_num_extra_sparts = 0;
+  int max_extra_sparts_in_cell = 0;
+  for (int i = 0; i < nr_local_cells; ++i) {
+    const struct cell *c = &cells[local_cells[i]];
+    int count = space_extra_sparts;
+    if (space_extra_sparts > 0 && growth > 1.f) {
+      const int count_extra = c->stars.count_extra;
+      const int count_formed = c->stars.count_formed;
+      float count_wanted = count_extra;
+      if (count_formed * growth > count_extra)
+        count_wanted = growth * count_extra;
+      else if (count_formed * growth * growth < count_extra)
+        count_wanted = count_extra / growth;
+      count = max(count, (int)ceilf(count_wanted));
+    }
+    extra_sparts_in_cell[i] = count;
+    expected_num_extra_sparts += count;
+    max_extra_sparts_in_cell = max(max_extra_sparts_in_cell, count);
+  }
+
+  /* Record the new reservoirs and start counting the stars created afresh */
+  for (int i = 0; i < s->nr_cells; ++i) {
+    s->cells_top[i].stars.count_formed = 0;
+    s->cells_top[i].stars.count_extra = 0;
+  }
+  for (int i = 0; i < nr_local_cells; ++i)
+    s->cells_top[local_cells[i]].stars.count_extra = extra_sparts_in_cell[i];
+
   /* Number of extra particles we want for each type */
   const size_t expected_num_extra_parts = nr_local_cells * space_extra_parts;
   const size_t expected_num_extra_gparts = nr_local_cells * space_extra_gparts;
-  const size_t expected_num_extra_sparts = nr_local_cells * space_extra_sparts;
   const size_t expected_num_extra_bparts = nr_local_cells * space_extra_bparts;
 
   if (verbose) {
@@ -764,14 +813,14 @@ void space_allocate_extras(struct space *s, int verbose) {
         "Requesting space for future %zd/%zd/%zd/%zd part/gpart/sparts/bparts.",
         expected_num_extra_parts, expected_num_extra_gparts,
         expected_num_extra_sparts, expected_num_extra_bparts);
+    message("Largest number of spare sparts in a top-level cell: %d (min=%d).",
+            max_extra_sparts_in_cell, space_extra_sparts);
   }
 
   if (expected_num_extra_parts < s->nr_extra_parts)
     error("Reduction in top-level cells number not handled.");
   if (expected_num_extra_gparts < s->nr_extra_gparts)
     error("Reduction in top-level cells number not handled.");
-  if (expected_num_extra_sparts < s->nr_extra_sparts)
-    error("Reduction in top-level cells number not handled.");
 
   /* Do we have enough space for the extra gparts (i.e. we haven't used up any)
    * ? */
@@ -959,75 +1008,75 @@ void space_allocate_extras(struct space *s, int verbose) {
     s->nr_extra_parts = expected_num_extra_parts;
   }
 
-  /* Do we have enough space for the extra sparts (i.e. we haven't used up any)
-   * ? */
-  if (nr_actual_sparts + expected_num_extra_sparts > nr_sparts) {
+  /* The number of spare sparts of each cell changes at every rebuild, so we
+   * always re-distribute them. */
+  if (expected_num_extra_sparts > 0 || s->nr_extra_sparts > 0) {
 
-    /* Ok... need to put some more in the game */
+    /* Do we need more spare sparts than we have? */
+    if (nr_actual_sparts + expected_num_extra_sparts > nr_sparts) {
 
-    /* Do we need to reallocate? */
-    if (nr_actual_sparts + expected_num_extra_sparts > size_sparts) {
+      /* Do we need to reallocate? */
+      if (nr_actual_sparts + expected_num_extra_sparts > size_sparts) {
 
-      size_sparts = (nr_actual_sparts + expected_num_extra_sparts) *
-                    engine_redistribute_alloc_margin;
+        size_sparts = (nr_actual_sparts + expected_num_extra_sparts) *
+                      engine_redistribute_alloc_margin;
 
-      if (verbose)
-        message("Re-allocating sparts array from %zd to %zd", s->size_sparts,
-                size_sparts);
+        if (verbose)
+          message("Re-allocating sparts array from %zd to %zd",
+                  s->size_sparts, size_sparts);
 
-      /* Create more space for parts */
-      struct spart *sparts_new = NULL;
-      if (swift_memalign("sparts", (void **)&sparts_new, spart_align,
-                         sizeof(struct spart) * size_sparts) != 0)
-        error("Failed to allocate new spart data");
-      memcpy(sparts_new, s->sparts, sizeof(struct spart) * s->size_sparts);
-      swift_free("sparts", s->sparts);
-      s->sparts = sparts_new;
+        /* Create more space for parts */
+        struct spart *sparts_new = NULL;
+        if (swift_memalign("sparts", (void **)&sparts_new, spart_align,
+                           sizeof(struct spart) * size_sparts) != 0)
+          error("Failed to allocate new spart data");
+        memcpy(sparts_new, s->sparts, sizeof(struct spart) * s->size_sparts);
+        swift_free("sparts", s->sparts);
+        s->sparts = sparts_new;
 
-      /* Update the counter */
-      s->size_sparts = size_sparts;
-    }
+        /* Update the counter */
+        s->size_sparts = size_sparts;
+      }
 
-    /* Turn some of the allocated spares into particles we can use */
-    for (size_t i = nr_sparts; i < nr_actual_sparts + expected_num_extra_sparts;
-         ++i) {
-      bzero(&s->sparts[i], sizeof(struct spart));
-      s->sparts[i].time_bin = time_bin_not_created;
-      s->sparts[i].id = -42;
+      /* Turn some of the allocated spares into particles we can use */
+      for (size_t i = nr_sparts;
+           i < nr_actual_sparts + expected_num_extra_sparts; ++i) {
+        bzero(&s->sparts[i], sizeof(struct spart));
+        s->sparts[i].time_bin = time_bin_not_created;
+        s->sparts[i].id = -42;
+      }
+
+      nr_sparts = nr_actual_sparts + expected_num_extra_sparts;
     }
 
-    /* Put the spare particles in their correct cell */
+    /* Put the spare particles in their correct cell. The ones we no longer
+     * need are inhibited such that the rebuild removes them. */
     int local_cell_id = 0;
-    int current_cell = local_cells[local_cell_id];
     int count_in_cell = 0;
     size_t count_extra_sparts = 0;
-    for (size_t i = 0; i < nr_actual_sparts + expected_num_extra_sparts; ++i) {
+    for (size_t i = 0; i < nr_sparts; ++i) {
 
-#ifdef SWIFT_DEBUG_CHECKS
-      if (current_cell == s->nr_cells)
-        error("Cell counter beyond the maximal nr. cells.");
-#endif
+      if (s->sparts[i].time_bin != time_bin_not_created) continue;
 
-      if (s->sparts[i].time_bin == time_bin_not_created) {
-
-        /* We want the extra particles to be at the centre of their cell */
-        s->sparts[i].x[0] = cells[current_cell].loc[0] + half_cell_width[0];
-        s->sparts[i].x[1] = cells[current_cell].loc[1] + half_cell_width[1];
-        s->sparts[i].x[2] = cells[current_cell].loc[2] + half_cell_width[2];
-        ++count_in_cell;
-        count_extra_sparts++;
-      }
-
-      /* Once we have reached the number of extra spart per cell, we move to the
-       * next */
-      if (count_in_cell == space_extra_sparts) {
+      /* Skip the cells that are already full */
+      while (local_cell_id < nr_local_cells &&
+             count_in_cell == extra_sparts_in_cell[local_cell_id]) {
         ++local_cell_id;
-
-        if (local_cell_id == nr_local_cells) break;
-
-        current_cell = local_cells[local_cell_id];
         count_in_cell = 0;
       }
+
+      if (local_cell_id == nr_local_cells) {
+        s->sparts[i].time_bin = time_bin_inhibited;
+        continue;
+      }
+
+      /* We want the extra particles to be at the centre of their cell */
+      const int current_cell = local_cells[local_cell_id];
+      s->sparts[i].x[0] = cells[current_cell].loc[0] + half_cell_width[0];
+      s->sparts[i].x[1] = cells[current_cell].loc[1] + half_cell_width[1];
+      s->sparts[i].x[2] = cells[current_cell].loc[2] + half_cell_width[2];
+      ++count_in_cell;
+      ++count_extra_sparts;
     }
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -1037,7 +1086,7 @@ void space_allocate_extras(struct space *s, int verbose) {
 #endif
 
     /* Update the counters */
-    s->nr_sparts = nr_actual_sparts + expected_num_extra_sparts;
+    s->nr_sparts = nr_sparts;
     s->nr_extra_sparts = expected_num_extra_sparts;
   }
 
@@ -1133,6 +1182,905 @@ void space_allocate_extras(struct space *s, int verbose) {
 
   /* Free the list of local cells */
   free(local_cells);
+  free(extra_sparts_in_cell);
+}
+
+/*! The particle arrays re-binned by an incremental rebuild, in the order in
+ * which they are moved. The #gpart come last such that their links can be
+ * updated once the other particles are in their final place. */
+enum space_rebuild_array {
+  space_rebuild_parts = 0,
+  space_rebuild_sparts,
+  space_rebuild_bparts,
+  space_rebuild_gparts,
+  space_rebuild_array_count
+};
+
+/*! Pointers to the particles of a cell in each of the arrays. */
+struct space_rebuild_cell_parts {
+  struct part *parts;
+  struct xpart *xparts;
+  struct gpart *gparts;
+  struct spart *sparts;
+  struct bpart *bparts;
+};
+
+/*! Data needed to recycle the cells after an incremental re-binning. */
+struct space_rebuild_recycle_data {
+  struct space *s;
+  const char *dirty;
+};
+
+/**
+ * @brief Size of the elements of one of the particle arrays.
+ *
+ * @param a The #space_rebuild_array.
+ */
+static size_t space_rebuild_elem_size(const int a) {
+  switch (a) {
+    case space_rebuild_parts:
+      return sizeof(struct part);
+    case space_rebuild_sparts:
+      return sizeof(struct spart);
+    case space_rebuild_bparts:
+      return sizeof(struct bpart);
+    default:
+      return sizeof(struct gpart);
+  }
+}
+
+/**
+ * @brief Start of one of the particle arrays of the #space.
+ *
+ * @param s The #space.
+ * @param a The #space_rebuild_array.
+ */
+static char *space_rebuild_base(const struct space *s, const int a) {
+  switch (a) {
+    case space_rebuild_parts:
+      return (char *)s->parts;
+    case space_rebuild_sparts:
+      return (char *)s->sparts;
+    case space_rebuild_bparts:
+      return (char *)s->bparts;
+    default:
+      return (char *)s->gparts;
+  }
+}
+
+/**
+ * @brief Number of particles in one of the particle arrays of the #space.
+ *
+ * @param s The #space.
+ * @param a The #space_rebuild_array.
+ */
+static size_t *space_rebuild_nr(struct space *s, const int a) {
+  switch (a) {
+    case space_rebuild_parts:
+      return &s->nr_parts;
+    case space_rebuild_sparts:
+      return &s->nr_sparts;
+    case space_rebuild_bparts:
+      return &s->nr_bparts;
+    default:
+      return &s->nr_gparts;
+  }
+}
+
+/**
+ * @brief Number of particles of a cell in one of the particle arrays.
+ *
+ * @param c The #cell.
+ * @param a The #space_rebuild_array.
+ */
+static int space_rebuild_cell_count(const struct cell *c, const int a) {
+  switch (a) {
+    case space_rebuild_parts:
+      return c->hydro.count;
+    case space_rebuild_sparts:
+      return c->stars.count;
+    case space_rebuild_bparts:
+      return c->black_holes.count;
+    default:
+      return c->grav.count;
+  }
+}
+
+/**
+ * @brief Position of the first particle of a cell in one of the particle
+ * arrays.
+ *
+ * @param s The #space.
+ * @param c The #cell.
+ * @param a The #space_rebuild_array.
+ */
+static size_t space_rebuild_cell_offset(const struct space *s,
+                                        const struct cell *c, const int a) {
+  switch (a) {
+    case space_rebuild_parts:
+      return c->hydro.parts - s->parts;
+    case space_rebuild_sparts:
+      return c->stars.parts - s->sparts;
+    case space_rebuild_bparts:
+      return c->black_holes.parts - s->bparts;
+    default:
+      return c->grav.parts - s->gparts;
+  }
+}
+
+/**
+ * @brief Restore the links between a range of particles that moved and their
+ * partners in the other arrays.
+ *
+ * @param s The #space.
+ * @param a The #space_rebuild_array the particles are in.
+ * @param first Index of the first particle that moved.
+ * @param n Number of particles that moved.
+ */
+static void space_rebuild_relink(struct space *s, const int a,
+                                 const size_t first, const size_t n) {
+  switch (a) {
+    case space_rebuild_parts:
+      for (size_t k = first; k < first + n; k++)
+        if (s->parts[k].gpart != NULL)
+          s->parts[k].gpart->id_or_neg_offset = -k;
+      break;
+    case space_rebuild_sparts:
+      for (size_t k = first; k < first + n; k++)
+        if (s->sparts[k].gpart != NULL)
+          s->sparts[k].gpart->id_or_neg_offset = -k;
+      break;
+    case space_rebuild_bparts:
+      for (size_t k = first; k < first + n; k++)
+        if (s->bparts[k].gpart != NULL)
+          s->bparts[k].gpart->id_or_neg_offset = -k;
+      break;
+    default:
+      for (size_t k = first; k < first + n; k++) {
+        struct gpart *gp = &s->gparts[k];
+        if (gp->type == swift_type_gas) {
+          s->parts[-gp->id_or_neg_offset].gpart = gp;
+        } else if (gp->type == swift_type_stars) {
+          s->sparts[-gp->id_or_neg_offset].gpart = gp;
+        } else if (gp->type == swift_type_black_hole) {
+          s->bparts[-gp->id_or_neg_offset].gpart = gp;
+        }
+      }
+  }
+}
+
+/**
+ * @brief Move a range of particles within one of the arrays.
+ *
+ * @param s The #space.
+ * @param a The #space_rebuild_array.
+ * @param to Where the first particle goes.
+ * @param from Where the first particle is.
+ * @param n The number of particles to move.
+ */
+static void space_rebuild_move(struct space *s, const int a, const size_t to,
+                               const size_t from, const size_t n) {
+  if (to == from || n == 0) return;
+  const size_t size = space_rebuild_elem_size(a);
+  char *base = space_rebuild_base(s, a);
+  memmove(base + to * size, base + from * size, n * size);
+  if (a == space_rebuild_parts)
+    memmove(&s->xparts[to], &s->xparts[from], n * sizeof(struct xpart));
+  space_rebuild_relink(s, a, to, n);
+}
+
+/**
+ * @brief Copy one particle out of one of the arrays into a buffer.
+ *
+ * @param s The #space.
+ * @param a The #space_rebuild_array.
+ * @param buff The buffer.
+ * @param xbuff The buffer for the #xpart (only used for the #part).
+ * @param slot The position in the buffer.
+ * @param k The position of the particle in its array.
+ */
+static void space_rebuild_store(const struct space *s, const int a,
+                                char *buff, struct xpart *xbuff,
+                                const size_t slot, const size_t k) {
+  const size_t size = space_rebuild_elem_size(a);
+  memcpy(buff + slot * size, space_rebuild_base(s, a) + k * size, size);
+  if (a == space_rebuild_parts) xbuff[slot] = s->xparts[k];
+}
+
+/**
+ * @brief Copy a range of particles from a buffer back into one of the
+ * arrays.
+ *
+ * @param s The #space.
+ * @param a The #space_rebuild_array.
+ * @param buff The buffer.
+ * @param xbuff The buffer for the #xpart (only used for the #part).
+ * @param slot The position of the first particle in the buffer.
+ * @param k Where the first particle goes in the array.
+ * @param n The number of particles to copy.
+ */
+static void space_rebuild_load(struct space *s, const int a, const char *buff,
+                               const struct xpart *xbuff, const size_t slot,
+                               const size_t k, const size_t n) {
+  if (n == 0) return;
+  const size_t size = space_rebuild_elem_size(a);
+  memcpy(space_rebuild_base(s, a) + k * size, buff + slot * size, n * size);
+  if (a == space_rebuild_parts)
+    memcpy(&s->xparts[k], &xbuff[slot], n * sizeof(struct xpart));
+  space_rebuild_relink(s, a, k, n);
+}
+
+/**
+ * @brief Gather the particles leaving their top-level cell at the end of one
+ * of the arrays.
+ *
+ * The particles staying in their cell keep their order, such that the trees
+ * of the cells that lost nothing remain valid. The leaving particles are
+ * placed after them, those staying on this node first.
+ *
+ * @param s The #space.
+ * @param a The #space_rebuild_array.
+ * @param ind The top-level cell index of each particle.
+ * @param offset The position of the first particle of each cell.
+ * @param stay The number of particles staying in each cell.
+ * @param nr_stay The total number of particles staying in their cell.
+ * @param nr_move The number of leaving particles staying on this node.
+ */
+static void space_rebuild_compact(struct space *s, const int a, int *ind,
+                                  const size_t *offset, const int *stay,
+                                  const size_t nr_stay, const size_t nr_move) {
+
+  const size_t nr_leave = *space_rebuild_nr(s, a) - nr_stay;
+  if (nr_leave == 0) return;
+
+  const struct cell *cells_top = s->cells_top;
+  const int local_nodeID = s->e->nodeID;
+  const size_t size = space_rebuild_elem_size(a);
+
+  char *buff = (char *)swift_malloc("rebuild_buff", size * nr_leave);
+  int *ibuff = (int *)swift_malloc("rebuild_ibuff", sizeof(int) * nr_leave);
+  struct xpart *xbuff = NULL;
+  if (a == space_rebuild_parts)
+    xbuff = (struct xpart *)swift_malloc("rebuild_xbuff",
+                                         sizeof(struct xpart) * nr_leave);
+  if (buff == NULL || ibuff == NULL ||
+      (a == space_rebuild_parts && xbuff == NULL))
+    error("Failed to allocate the buffer of leaving particles.");
+
+  size_t w = 0;
+  size_t slot_move = 0, slot_out = nr_move;
+  for (int i = 0; i < s->nr_local_cells; i++) {
+    const int k = s->local_cells_top[i];
+    const size_t off = offset[k];
+    const int count = space_rebuild_cell_count(&cells_top[k], a);
+
+    /* Nobody left, shift the whole cell. */
+    if (stay[k] == count) {
+      space_rebuild_move(s, a, w, off, count);
+      memmove(&ind[w], &ind[off], sizeof(int) * count);
+      w += count;
+      continue;
+    }
+
+    /* Otherwise, sort the particles out one by one. */
+    for (size_t j = off; j < off + count; j++) {
+      if (ind[j] == k) {
+        space_rebuild_move(s, a, w, j, 1);
+        ind[w] = k;
+        w++;
+      } else {
+        const int local =
+            (ind[j] >= 0 && cells_top[ind[j]].nodeID == local_nodeID);
+        const size_t slot = local ? slot_move++ : slot_out++;
+        space_rebuild_store(s, a, buff, xbuff, slot, j);
+        ibuff[slot] = ind[j];
+      }
+    }
+  }
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (w != nr_stay || slot_move != nr_move || slot_out != nr_leave)
+    error("Inconsistent number of particles leaving their cell.");
+#endif
+
+  /* Put the leaving particles back behind the others. */
+  space_rebuild_load(s, a, buff, xbuff, 0, nr_stay, nr_leave);
+  memcpy(&ind[nr_stay], ibuff, sizeof(int) * nr_leave);
+
+  swift_free("rebuild_buff", buff);
+  swift_free("rebuild_ibuff", ibuff);
+  if (xbuff != NULL) swift_free("rebuild_xbuff", xbuff);
+}
+
+/**
+ * @brief Insert the particles arriving in a top-level cell behind the ones
+ * that stayed in it.
+ *
+ * On entry the particles that stayed in their cell are at the start of the
+ * array in cell order and the arriving ones after them. On exit every cell
+ * has its staying particles followed by its new ones.
+ *
+ * @param s The #space.
+ * @param a The #space_rebuild_array.
+ * @param ind The top-level cell index of each particle.
+ * @param stay The number of particles staying in each cell.
+ * @param arrive The number of particles arriving in each cell.
+ * @param nr_stay The total number of particles staying in their cell.
+ * @param new_offset (return) The new position of the first particle of each
+ * cell.
+ */
+static void space_rebuild_expand(struct space *s, const int a, const int *ind,
+                                 const int *stay, const int *arrive,
+                                 const size_t nr_stay, size_t *new_offset) {
+
+  const size_t nr = *space_rebuild_nr(s, a);
+  const size_t nr_arrive = nr - nr_stay;
+  const size_t size = space_rebuild_elem_size(a);
+
+  /* Sort the arriving particles by cell into a buffer. */
+  char *buff = NULL;
+  struct xpart *xbuff = NULL;
+  size_t *cursor = NULL;
+  if (nr_arrive > 0) {
+    buff = (char *)swift_malloc("rebuild_buff", size * nr_arrive);
+    cursor = (size_t *)swift_malloc("rebuild_cursor",
+                                    sizeof(size_t) * s->nr_cells);
+    if (a == space_rebuild_parts)
+      xbuff = (struct xpart *)swift_malloc("rebuild_xbuff",
+                                           sizeof(struct xpart) * nr_arrive);
+    if (buff == NULL || cursor == NULL ||
+        (a == space_rebuild_parts && xbuff == NULL))
+      error("Failed to allocate the buffer of arriving particles.");
+
+    size_t first = 0;
+    for (int i = 0; i < s->nr_local_cells; i++) {
+      const int k = s->local_cells_top[i];
+      cursor[k] = first;
+      first += arrive[k];
+    }
+    for (size_t j = nr_stay; j < nr; j++)
+      space_rebuild_store(s, a, buff, xbuff, cursor[ind[j]]++, j);
+  }
+
+  /* Open the gaps from the end of the array, where there is room. */
+  size_t w = nr;
+  size_t stay_end = nr_stay;
+  for (int i = s->nr_local_cells - 1; i >= 0; i--) {
+    const int k = s->local_cells_top[i];
+
+    /* The cursor now points at the end of this cell's new particles. */
+    if (arrive[k] > 0) {
+      space_rebuild_load(s, a, buff, xbuff, cursor[k] - arrive[k],
+                         w - arrive[k], arrive[k]);
+      w -= arrive[k];
+    }
+
+    stay_end -= stay[k];
+    space_rebuild_move(s, a, w - stay[k], stay_end, stay[k]);
+    w -= stay[k];
+    new_offset[k] = w;
+  }
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (w != 0 || stay_end != 0)
+    error("Inconsistent number of particles arriving in cells.");
+#endif
+
+  if (buff != NULL) swift_free("rebuild_buff", buff);
+  if (xbuff != NULL) swift_free("rebuild_xbuff", xbuff);
+  if (cursor != NULL) swift_free("rebuild_cursor", cursor);
+}
+
+/**
+ * @brief Re-point a kept cell tree to the new location of its particles.
+ *
+ * @param c The #cell.
+ * @param from The particles of the top-level cell before the move.
+ * @param to The particles of the top-level cell after the move.
+ */
+static void space_rebuild_move_tree(
+    struct cell *c, const struct space_rebuild_cell_parts *from,
+    const struct space_rebuild_cell_parts *to) {
+
+  c->hydro.parts = to->parts + (c->hydro.parts - from->parts);
+  c->hydro.xparts = to->xparts + (c->hydro.xparts - from->xparts);
+  c->grav.parts = to->gparts + (c->grav.parts - from->gparts);
+  c->stars.parts = to->sparts + (c->stars.parts - from->sparts);
+  c->black_holes.parts = to->bparts + (c->black_holes.parts - from->bparts);
+  c->stars.parts_rebuild = c->stars.parts;
+
+  if (c->split)
+    for (int k = 0; k < 8; k++)
+      if (c->progeny[k] != NULL)
+        space_rebuild_move_tree(c->progeny[k], from, to);
+}
+
+/**
+ * @brief #threadpool mapper function to recycle the trees of the cells that
+ * are re-built and clean the others of their sorts.
+ *
+ * @param map_data Pointer towards the top-level cells.
+ * @param num_elements The number of cells to treat.
+ * @param extra_data Pointer to a #space_rebuild_recycle_data.
+ */
+static void space_rebuild_recycle_incremental_mapper(void *map_data,
+                                                     int num_elements,
+                                                     void *extra_data) {
+
+  struct space_rebuild_recycle_data *data =
+      (struct space_rebuild_recycle_data *)extra_data;
+  struct space *s = data->s;
+  struct cell *cells = (struct cell *)map_data;
+
+  for (int k = 0; k < num_elements; k++) {
+    struct cell *c = &cells[k];
+    if (c->nodeID == engine_rank && !data->dirty[c - s->cells_top]) {
+      cell_clean_sorts(c);
+
+      /* The tasks are only ever re-used without MPI. */
+      if (s->e->nr_nodes > 1) cell_clean_tasks(c);
+    } else
+      space_rebuild_recycle_cell(s, c);
+  }
+}
+
+/**
+ * @brief Flag the top-level cells whose tree cannot be kept because the
+ * particles moved too much for the tasks built on it.
+ *
+ * The tasks are created assuming that the particles have not moved since
+ * the trees were built. A kept tree carries the displacement accumulated
+ * since it was built, so it is only kept if that displacement, added to that
+ * of its neighbours, still fits in the leeway given to the splitting of the
+ * pair tasks. The cells bordering a foreign cell are always re-built as the
+ * state of the foreign trees after the rebuild is not known here.
+ *
+ * @param s The #space.
+ * @param dirty (return) The top-level cells to re-build.
+ * @param h_arrive The largest smoothing length of the particles arriving in
+ * each cell.
+ */
+static void space_rebuild_flag_unsafe_cells(const struct space *s, char *dirty,
+                                            const float *h_arrive) {
+
+  const struct cell *cells_top = s->cells_top;
+  const int *cdim = s->cdim;
+  const int periodic = s->periodic;
+  const int local_nodeID = s->e->nodeID;
+
+  for (int ind = 0; ind < s->nr_local_cells; ind++) {
+    const int cid = s->local_cells_top[ind];
+    if (dirty[cid]) continue;
+    const struct cell *c = &cells_top[cid];
+
+    const float h_c = max3(c->hydro.h_max, c->stars.h_max, c->black_holes.h_max);
+    const float dx_c = max3(c->hydro.dx_max_part, c->stars.dx_max_part,
+                            c->black_holes.dx_max_part);
+
+    /* Size of the smallest cells pair tasks can be split down to. */
+    const float dmin_leaf = c->dmin / (float)(1 << c->maxdepth);
+    const float leeway = (1.f - 1.f / space_stretch) * dmin_leaf;
+
+    int unsafe = (2.f * dx_c > leeway);
+
+    const int i = cid / (cdim[1] * cdim[2]);
+    const int j = (cid / cdim[2]) % cdim[1];
+    const int k = cid % cdim[2];
+    for (int ii = i - 1; ii <= i + 1 && !unsafe; ii++) {
+      if (!periodic && (ii < 0 || ii >= cdim[0])) continue;
+      for (int jj = j - 1; jj <= j + 1 && !unsafe; jj++) {
+        if (!periodic && (jj < 0 || jj >= cdim[1])) continue;
+        for (int kk = k - 1; kk <= k + 1 && !unsafe; kk++) {
+          if (!periodic && (kk < 0 || kk >= cdim[2])) continue;
+
+          const int cjd = cell_getid(cdim, (ii + cdim[0]) % cdim[0],
+                                     (jj + cdim[1]) % cdim[1],
+                                     (kk + cdim[2]) % cdim[2]);
+          if (cjd == cid) continue;
+          const struct cell *cj = &cells_top[cjd];
+
+          if (cj->nodeID != local_nodeID) {
+            unsafe = 1;
+            break;
+          }
+
+          /* The re-built neighbours have not moved but may have received
+           * particles with a larger smoothing length. */
+          const float h_cj = max4(cj->hydro.h_max, cj->stars.h_max,
+                                  cj->black_holes.h_max, h_arrive[cjd]);
+          const float dx_cj =
+              dirty[cjd] ? 0.f
+                         : max3(cj->hydro.dx_max_part, cj->stars.dx_max_part,
+                                cj->black_holes.dx_max_part);
+
+          if (kernel_gamma * max(h_c, h_cj) + dx_c + dx_cj > c->dmin ||
+              dx_c + dx_cj > leeway)
+            unsafe = 1;
+        }
+      }
+    }
+
+    if (unsafe) dirty[cid] = 1;
+  }
+}
+
+/**
+ * @brief Can the next rebuild keep the trees of the top-level cells whose
+ * particles did not change?
+ *
+ * This is not possible when the particles were redistributed or when the
+ * cells carry spare particles for on-the-fly creation.
+ *
+ * @param s The #space.
+ * @param repartitioned Did we just repartition?
+ */
+static int space_rebuild_incremental_allowed(const struct space *s,
+                                             const int repartitioned) {
+  return s->with_incremental_rebuild && !repartitioned &&
+         !s->force_full_rebuild && !s->with_star_formation &&
+         space_extra_parts == 0 && space_extra_gparts == 0 &&
+         space_extra_sparts == 0 && space_extra_bparts == 0 &&
+         s->local_cells_top != NULL && s->nr_local_cells > 0;
+}
+
+/**
+ * @brief Re-build only the top-level cells whose particles changed.
+ *
+ * The particles that are still in their top-level cell keep their place in
+ * memory. Only the ones that left their cell are moved, through the stray
+ * list at the end of the arrays, and only the cells that lost or gained
+ * particles, or that were flagged as having moved too much, are re-split.
+ * The other trees are kept and simply cleaned of their sorts. Their tasks
+ * may be re-used by engine_maketasks(), which finds the re-built cells in
+ * space::cells_rebuilt.
+ *
+ * Nothing is changed if the particles are not laid out as the last rebuild
+ * left them or if too many cells changed, in which case the caller must do a
+ * full rebuild.
+ *
+ * @param s The #space.
+ * @param h_index The top-level cell index of the #part.
+ * @param g_index The top-level cell index of the #gpart.
+ * @param s_index The top-level cell index of the #spart.
+ * @param b_index The top-level cell index of the #bpart.
+ * @param h_index_size The allocated size of h_index.
+ * @param g_index_size The allocated size of g_index.
+ * @param s_index_size The allocated size of s_index.
+ * @param b_index_size The allocated size of b_index.
+ * @param verbose Are we talkative?
+ *
+ * @return 1 if the space was re-built, 0 if a full rebuild is needed.
+ */
+static int space_rebuild_incremental(struct space *s, int **h_index,
+                                     int **g_index, int **s_index,
+                                     int **b_index, const size_t h_index_size,
+                                     const size_t g_index_size,
+                                     const size_t s_index_size,
+                                     const size_t b_index_size,
+                                     const int verbose) {
+
+  const ticks tic = getticks();
+
+  struct cell *cells_top = s->cells_top;
+  const int nr_cells = s->nr_cells;
+  const int local_nodeID = s->e->nodeID;
+  const integertime_t ti_current = s->e->ti_current;
+  int **ind[space_rebuild_array_count] = {h_index, s_index, b_index, g_index};
+
+  /* Per cell and per array bookkeeping. */
+  size_t *offset = (size_t *)swift_malloc(
+      "rebuild_offset", sizeof(size_t) * space_rebuild_array_count * nr_cells);
+  int *stay = (int *)swift_malloc(
+      "rebuild_stay", sizeof(int) * space_rebuild_array_count * nr_cells);
+  int *arrive = (int *)swift_malloc(
+      "rebuild_arrive", sizeof(int) * space_rebuild_array_count * nr_cells);
+  char *dirty = (char *)swift_malloc("cells_rebuilt", nr_cells);
+  if (offset == NULL || stay == NULL || arrive == NULL || dirty == NULL)
+    error("Failed to allocate the incremental rebuild counters.");
+  bzero(arrive, sizeof(int) * space_rebuild_array_count * nr_cells);
+  bzero(dirty, nr_cells);
+
+  /* Count the particles that stay in their cell, checking on the way that
+   * the cells are still laid out as the last rebuild left them. */
+  size_t nr_stay[space_rebuild_array_count] = {0};
+  size_t nr_move[space_rebuild_array_count] = {0};
+  int layout_ok = 1;
+  for (int a = 0; a < space_rebuild_array_count && layout_ok; a++) {
+    const int *restrict index = *ind[a];
+    size_t off = 0;
+    for (int i = 0; i < s->nr_local_cells && layout_ok; i++) {
+      const int k = s->local_cells_top[i];
+      const struct cell *c = &cells_top[k];
+      const int count = space_rebuild_cell_count(c, a);
+      if (count > 0 && space_rebuild_cell_offset(s, c, a) != off) {
+        layout_ok = 0;
+        break;
+      }
+
+      int n = 0;
+      for (size_t j = off; j < off + count; j++) {
+        const int cid = index[j];
+        if (cid == k) {
+          n++;
+        } else if (cid >= 0 && cells_top[cid].nodeID == local_nodeID) {
+          arrive[a * nr_cells + cid]++;
+          dirty[cid] = 1;
+          nr_move[a]++;
+        }
+      }
+      if (n < count) dirty[k] = 1;
+      offset[a * nr_cells + k] = off;
+      stay[a * nr_cells + k] = n;
+      nr_stay[a] += n;
+      off += count;
+    }
+    if (off != *space_rebuild_nr(s, a)) layout_ok = 0;
+  }
+
+  /* Add the cells that moved too much and see whether it is worth it. */
+  int nr_dirty = 0;
+  for (int i = 0; i < s->nr_local_cells; i++) {
+    const int k = s->local_cells_top[i];
+    if (cell_get_flag(&cells_top[k], cell_flag_rebuild)) dirty[k] = 1;
+    nr_dirty += dirty[k];
+  }
+  if (!layout_ok ||
+      nr_dirty > space_incremental_rebuild_max_frac * s->nr_local_cells) {
+    if (verbose)
+      message("%s, doing a full rebuild.",
+              layout_ok ? "too many cells changed" : "particles were re-ordered");
+    swift_free("rebuild_offset", offset);
+    swift_free("rebuild_stay", stay);
+    swift_free("rebuild_arrive", arrive);
+    swift_free("cells_rebuilt", dirty);
+    return 0;
+  }
+
+  /* Move the leaving particles to the end of the arrays. */
+  for (int a = 0; a < space_rebuild_array_count; a++)
+    space_rebuild_compact(s, a, *ind[a], &offset[a * nr_cells],
+                          &stay[a * nr_cells], nr_stay[a], nr_move[a]);
+
+  const size_t nr_keep[space_rebuild_array_count] = {
+      nr_stay[0] + nr_move[0], nr_stay[1] + nr_move[1],
+      nr_stay[2] + nr_move[2], nr_stay[3] + nr_move[3]};
+
+#ifdef WITH_MPI
+
+  /* Exchange the strays, note that this potentially re-allocates the
+     particle arrays. */
+  size_t nr_exchanged[space_rebuild_array_count];
+  for (int a = 0; a < space_rebuild_array_count; a++)
+    nr_exchanged[a] = *space_rebuild_nr(s, a) - nr_keep[a];
+  engine_exchange_strays(
+      s->e, nr_keep[space_rebuild_parts],
+      &(*h_index)[nr_keep[space_rebuild_parts]],
+      &nr_exchanged[space_rebuild_parts], nr_keep[space_rebuild_gparts],
+      &(*g_index)[nr_keep[space_rebuild_gparts]],
+      &nr_exchanged[space_rebuild_gparts], nr_keep[space_rebuild_sparts],
+      &(*s_index)[nr_keep[space_rebuild_sparts]],
+      &nr_exchanged[space_rebuild_sparts], nr_keep[space_rebuild_bparts],
+      &(*b_index)[nr_keep[space_rebuild_bparts]],
+      &nr_exchanged[space_rebuild_bparts]);
+
+  /* Assign each received particle to its cell. */
+  const size_t index_size[space_rebuild_array_count] = {
+      h_index_size, s_index_size, b_index_size, g_index_size};
+  const int cdim[3] = {s->cdim[0], s->cdim[1], s->cdim[2]};
+  const double ih[3] = {s->iwidth[0], s->iwidth[1], s->iwidth[2]};
+  for (int a = 0; a < space_rebuild_array_count; a++) {
+    const size_t nr = nr_keep[a] + nr_exchanged[a];
+    *space_rebuild_nr(s, a) = nr;
+
+    /* Re-allocate the index array if needed. */
+    if (nr > index_size[a]) {
+      int *ind_new = (int *)swift_malloc("rebuild_index", sizeof(int) * nr);
+      if (ind_new == NULL)
+        error("Failed to allocate temporary particle indices.");
+      memcpy(ind_new, *ind[a], sizeof(int) * nr_keep[a]);
+      swift_free("rebuild_index", *ind[a]);
+      *ind[a] = ind_new;
+    }
+
+    int *index = *ind[a];
+    for (size_t j = nr_keep[a]; j < nr; j++) {
+      const double *x;
+      switch (a) {
+        case space_rebuild_parts:
+          x = s->parts[j].x;
+          break;
+        case space_rebuild_sparts:
+          x = s->sparts[j].x;
+          break;
+        case space_rebuild_bparts:
+          x = s->bparts[j].x;
+          break;
+        default:
+          x = s->gparts[j].x;
+      }
+      index[j] = cell_getid(cdim, x[0] * ih[0], x[1] * ih[1], x[2] * ih[2]);
+#ifdef SWIFT_DEBUG_CHECKS
+      if (cells_top[index[j]].nodeID != local_nodeID)
+        error("Received particle that does not belong to me (nodeID=%i).",
+              cells_top[index[j]].nodeID);
+#endif
+      arrive[a * nr_cells + index[j]]++;
+      dirty[index[j]] = 1;
+    }
+  }
+
+#else
+
+  /* Forget about the inhibited particles. */
+  for (int a = 0; a < space_rebuild_array_count; a++)
+    *space_rebuild_nr(s, a) = nr_keep[a];
+
+#endif /* WITH_MPI */
+
+  /* Largest smoothing length arriving in each cell. */
+  float *h_arrive =
+      (float *)swift_malloc("rebuild_h_arrive", sizeof(float) * nr_cells);
+  if (h_arrive == NULL) error("Failed to allocate arriving smoothing lengths.");
+  bzero(h_arrive, sizeof(float) * nr_cells);
+  for (size_t j = nr_stay[space_rebuild_parts]; j < s->nr_parts; j++) {
+    const int cid = (*h_index)[j];
+    h_arrive[cid] = max(h_arrive[cid], s->parts[j].h);
+  }
+  for (size_t j = nr_stay[space_rebuild_sparts]; j < s->nr_sparts; j++) {
+    const int cid = (*s_index)[j];
+    h_arrive[cid] = max(h_arrive[cid], s->sparts[j].h);
+  }
+  for (size_t j = nr_stay[space_rebuild_bparts]; j < s->nr_bparts; j++) {
+    const int cid = (*b_index)[j];
+    h_arrive[cid] = max(h_arrive[cid], s->bparts[j].h);
+  }
+
+  /* Only keep the trees that are still good enough for the tasks. */
+  space_rebuild_flag_unsafe_cells(s, dirty, h_arrive);
+  swift_free("rebuild_h_arrive", h_arrive);
+  nr_dirty = 0;
+  for (int i = 0; i < s->nr_local_cells; i++)
+    nr_dirty += dirty[s->local_cells_top[i]];
+
+  /* Recycle the trees that change and clean the others of their tasks. */
+  struct space_rebuild_recycle_data recycle_data = {s, dirty};
+  threadpool_map(&s->e->threadpool, space_rebuild_recycle_incremental_mapper,
+                 cells_top, nr_cells, sizeof(struct cell), 0, &recycle_data);
+
+  /* Let the kept multipoles catch up with the particles. */
+  if (s->with_self_gravity)
+    for (int i = 0; i < s->nr_local_cells; i++) {
+      const int k = s->local_cells_top[i];
+      if (!dirty[k]) cell_drift_all_multipoles(&cells_top[k], s->e);
+    }
+
+  /* Slot the arriving particles in behind the ones that stayed. */
+  for (int a = 0; a < space_rebuild_array_count; a++)
+    space_rebuild_expand(s, a, *ind[a], &stay[a * nr_cells],
+                         &arrive[a * nr_cells], nr_stay[a],
+                         &offset[a * nr_cells]);
+
+  /* Hook the cells up to the particles and make the lists of local and
+   * non-empty cells. */
+  int *split_cells =
+      (int *)swift_malloc("rebuild_split_cells", sizeof(int) * nr_cells);
+  if (split_cells == NULL) error("Failed to allocate list of cells to split.");
+  int nr_split_cells = 0;
+  s->nr_cells_with_particles = 0;
+  s->nr_local_cells_with_particles = 0;
+  s->nr_local_cells = 0;
+  s->maxdepth = 0;
+  for (int k = 0; k < nr_cells; k++) {
+    struct cell *restrict c = &cells_top[k];
+    c->hydro.ti_old_part = ti_current;
+    c->grav.ti_old_part = ti_current;
+    c->grav.ti_old_multipole = ti_current;
+    c->stars.ti_old_part = ti_current;
+    c->black_holes.ti_old_part = ti_current;
+
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_CELL_GRAPH)
+    c->cellID = -last_cell_id;
+    last_cell_id++;
+#endif
+
+    if (c->nodeID != local_nodeID) continue;
+
+    const struct space_rebuild_cell_parts to = {
+        &s->parts[offset[space_rebuild_parts * nr_cells + k]],
+        &s->xparts[offset[space_rebuild_parts * nr_cells + k]],
+        &s->gparts[offset[space_rebuild_gparts * nr_cells + k]],
+        &s->sparts[offset[space_rebuild_sparts * nr_cells + k]],
+        &s->bparts[offset[space_rebuild_bparts * nr_cells + k]]};
+
+    if (dirty[k]) {
+      c->hydro.parts = to.parts;
+      c->hydro.xparts = to.xparts;
+      c->grav.parts = to.gparts;
+      c->stars.parts = to.sparts;
+      c->black_holes.parts = to.bparts;
+      c->stars.parts_rebuild = c->stars.parts;
+      c->hydro.count = stay[space_rebuild_parts * nr_cells + k] +
+                       arrive[space_rebuild_parts * nr_cells + k];
+      c->grav.count = stay[space_rebuild_gparts * nr_cells + k] +
+                      arrive[space_rebuild_gparts * nr_cells + k];
+      c->stars.count = stay[space_rebuild_sparts * nr_cells + k] +
+                       arrive[space_rebuild_sparts * nr_cells + k];
+      c->black_holes.count = stay[space_rebuild_bparts * nr_cells + k] +
+                             arrive[space_rebuild_bparts * nr_cells + k];
+      c->hydro.count_total = c->hydro.count;
+      c->grav.count_total = c->grav.count;
+      c->stars.count_total = c->stars.count;
+      c->black_holes.count_total = c->black_holes.count;
+    } else {
+      const struct space_rebuild_cell_parts from = {
+          c->hydro.parts, c->hydro.xparts, c->grav.parts, c->stars.parts,
+          c->black_holes.parts};
+      space_rebuild_move_tree(c, &from, &to);
+      if (c->maxdepth > s->maxdepth) s->maxdepth = c->maxdepth;
+    }
+
+    /* Add this cell to the list of local cells */
+    s->local_cells_top[s->nr_local_cells] = k;
+    s->nr_local_cells++;
+
+    if ((c->hydro.count > 0) || (c->grav.count > 0) || (c->stars.count > 0) ||
+        (c->black_holes.count > 0)) {
+
+      /* Add this cell to the list of non-empty cells */
+      s->local_cells_with_particles_top[s->nr_local_cells_with_particles] = k;
+      s->nr_local_cells_with_particles++;
+
+      if (dirty[k]) split_cells[nr_split_cells++] = k;
+    }
+  }
+
+  /* Mark that there are no inhibited particles left */
+  s->nr_inhibited_parts = 0;
+  s->nr_inhibited_gparts = 0;
+  s->nr_inhibited_sparts = 0;
+  s->nr_inhibited_bparts = 0;
+
+#ifdef SWIFT_DEBUG_CHECKS
+  /* Verify that the links are correct */
+  part_verify_links(s->parts, s->gparts, s->sparts, s->bparts, s->nr_parts,
+                    s->nr_gparts, s->nr_sparts, s->nr_bparts, verbose);
+#endif
+
+  /* Re-split the trees of the cells that changed. */
+  threadpool_map(&s->e->threadpool, space_split_mapper, split_cells,
+                 nr_split_cells, sizeof(int), 0, s);
+
+#ifdef SWIFT_DEBUG_CHECKS
+  /* Check that the multipole construction went OK */
+  if (s->with_self_gravity)
+    for (int i = 0; i < nr_split_cells; i++)
+      cell_check_multipole(&cells_top[split_cells[i]]);
+#endif
+
+  /* Clean up any stray sort indices in the cell buffer. */
+  space_free_buff_sort_indices(s);
+
+  if (verbose)
+    message(
+        "re-built %d of %d local top-level cells, moved %zu/%zu/%zu/%zu "
+        "parts/gparts/sparts/bparts, took %.3f %s.",
+        nr_dirty, s->nr_local_cells,
+        nr_move[space_rebuild_parts] + (s->nr_parts - nr_keep[0]),
+        nr_move[space_rebuild_gparts] + (s->nr_gparts - nr_keep[3]),
+        nr_move[space_rebuild_sparts] + (s->nr_sparts - nr_keep[1]),
+        nr_move[space_rebuild_bparts] + (s->nr_bparts - nr_keep[2]),
+        clocks_from_ticks(getticks() - tic), clocks_getunit());
+
+  swift_free("rebuild_split_cells", split_cells);
+  swift_free("rebuild_offset", offset);
+  swift_free("rebuild_stay", stay);
+  swift_free("rebuild_arrive", arrive);
+
+  /* Keep track of the re-built cells for the construction of the tasks. */
+  if (s->cells_rebuilt != NULL) swift_free("cells_rebuilt", s->cells_rebuilt);
+  s->cells_rebuilt = dirty;
+  s->last_rebuild_incremental = 1;
+  return 1;
 }
 
 /**
@@ -1155,8 +2103,15 @@ void space_rebuild(struct space *s, int repartitioned, int verbose) {
   last_cell_id = 1;
 #endif
 
-  /* Re-grid if necessary, or just re-set the cell data. */
-  space_regrid(s, verbose);
+  /* Re-grid if necessary. */
+  const int regridded = space_regrid(s, verbose);
+
+  /* Can we keep the trees of the top-level cells that did not change? */
+  int incremental =
+      !regridded && space_rebuild_incremental_allowed(s, repartitioned);
+
+  /* Otherwise, just clean up the cells. */
+  if (!regridded && !incremental) space_free_cells(s);
 
   /* Allocate extra space for particles that will be created */
   if (s->with_star_formation) space_allocate_extras(s, verbose);
@@ -1273,6 +2228,29 @@ void space_rebuild(struct space *s, int repartitioned, int verbose) {
         "counter.");
 #endif
 
+  /* Only move the particles that left their top-level cell if we can. */
+  if (incremental) {
+    incremental = space_rebuild_incremental(
+        s, &h_index, &g_index, &s_index, &b_index, h_index_size, g_index_size,
+        s_index_size, b_index_size, verbose);
+    if (!incremental) space_free_cells(s);
+  }
+  if (incremental) {
+    swift_free("h_index", h_index);
+    swift_free("g_index", g_index);
+    swift_free("s_index", s_index);
+    swift_free("b_index", b_index);
+    swift_free("cell_part_counts", cell_part_counts);
+    swift_free("cell_gpart_counts", cell_gpart_counts);
+    swift_free("cell_spart_counts", cell_spart_counts);
+    swift_free("cell_bpart_counts", cell_bpart_counts);
+
+    if (verbose)
+      message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
+              clocks_getunit());
+    return;
+  }
+
   /* Move non-local parts and inhibited parts to the end of the list. */
   if (!repartitioned && (s->e->nr_nodes > 1 || count_inhibited_parts > 0)) {
     for (size_t k = 0; k < nr_parts; /* void */) {
@@ -1718,14 +2696,18 @@ void space_rebuild(struct space *s, int repartitioned, int verbose) {
   }
 
   /* Extract the cell counts from the sorted indices. Deduct the extra
-   * particles. */
+   * particles, whose number varies from cell to cell. */
   size_t last_sindex = 0;
+  int count_extra_in_cell = 0;
   s_index[nr_sparts] = s->nr_cells;  // sentinel.
   for (size_t k = 0; k < nr_sparts; k++) {
+    if (s->sparts[k].time_bin == time_bin_not_created) ++count_extra_in_cell;
     if (s_index[k] < s_index[k + 1]) {
+      cells_top[s_index[k]].stars.count_total = k - last_sindex + 1;
       cells_top[s_index[k]].stars.count =
-          k - last_sindex + 1 - space_extra_sparts;
+          k - last_sindex + 1 - count_extra_in_cell;
       last_sindex = k + 1;
+      count_extra_in_cell = 0;
     }
   }
 
@@ -1884,7 +2866,7 @@ void space_rebuild(struct space *s, int repartitioned, int verbose) {
 
       c->hydro.count_total = c->hydro.count + space_extra_parts;
       c->grav.count_total = c->grav.count + space_extra_gparts;
-      c->stars.count_total = c->stars.count + space_extra_sparts;
+      /* (The stars' count_total was set when extracting the counts) */
       c->black_holes.count_total = c->black_holes.count + space_extra_bparts;
 
       finger = &finger[c->hydro.count_total];
@@ -1932,6 +2914,12 @@ void space_rebuild(struct space *s, int repartitioned, int verbose) {
   /* Clean up any stray sort indices in the cell buffer. */
   space_free_buff_sort_indices(s);
 
+  /* All the trees are new. */
+  s->force_full_rebuild = 0;
+  s->last_rebuild_incremental = 0;
+  if (s->cells_rebuilt != NULL) swift_free("cells_rebuilt", s->cells_rebuilt);
+  s->cells_rebuilt = NULL;
+
   if (verbose)
     message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
             clocks_getunit());
@@ -3854,6 +4842,7 @@ void space_getcells(struct space *s, int nr_cells, struct cell **cells) {
   /* Init some things in the cell we just got. */
   for (int j = 0; j < nr_cells; j++) {
     cell_free_hydro_sorts(cells[j]);
+    cell_free_hydro_bin_order(cells[j]);
     cell_free_stars_sorts(cells[j]);
 
     struct gravity_tensors *temp = cells[j]->grav.multipole;
@@ -3879,6 +4868,7 @@ void space_free_buff_sort_indices(struct space *s) {
   for (struct cell *finger = s->cells_sub; finger != NULL;
        finger = finger->next) {
     cell_free_hydro_sorts(finger);
+    cell_free_hydro_bin_order(finger);
     cell_free_stars_sorts(finger);
   }
 }
@@ -4662,6 +5652,17 @@ void space_init(struct space *s, struct swift_params *params,
       params, "Scheduler:cell_extra_gparts", space_extra_gparts_default);
   space_extra_bparts = parser_get_opt_param_int(
       params, "Scheduler:cell_extra_bparts", space_extra_bparts_default);
+  s->extra_sparts_growth =
+      parser_get_opt_param_float(params, "Scheduler:cell_extra_sparts_growth",
+                                 space_extra_sparts_growth_default);
+
+  /* Do we keep the trees of the cells that did not change when rebuilding? */
+  s->with_incremental_rebuild =
+      parser_get_opt_param_int(params, "Scheduler:incremental_rebuild", 0);
+
+  /* Do we start from the previous order of the particles when re-sorting? */
+  s->with_sort_repair =
+      parser_get_opt_param_int(params, "Scheduler:repair_sorts", 1);
 
   engine_max_parts_per_ghost =
       parser_get_opt_param_int(params, "Scheduler:engine_max_parts_per_ghost",
@@ -5340,6 +6341,7 @@ void space_clean(struct space *s) {
   swift_free("xparts", s->xparts);
   swift_free("gparts", s->gparts);
   swift_free("sparts", s->sparts);
+  if (s->cells_rebuilt != NULL) swift_free("cells_rebuilt", s->cells_rebuilt);
 }
 
 /**
@@ -5451,6 +6453,8 @@ void space_struct_restore(struct space *s, FILE *stream) {
   s->local_cells_with_particles_top = NULL;
   s->nr_local_cells_with_tasks = 0;
   s->nr_cells_with_particles = 0;
+  s->cells_rebuilt = NULL;
+  s->last_rebuild_incremental = 0;
 #ifdef WITH_MPI
   s->parts_foreign = NULL;
   s->size_parts_foreign = 0;
@@ -48,6 +48,7 @@ struct cosmology;
 #define space_extra_parts_default 0
 #define space_extra_gparts_default 0
 #define space_extra_sparts_default 100
+#define space_extra_sparts_growth_default 2.f
 #define space_extra_bparts_default 0
 #define space_expected_max_nr_strays_default 100
 #define space_subsize_pair_hydro_default 256000000
@@ -60,6 +61,7 @@ struct cosmology;
 #define space_max_top_level_cells_default 12
 #define space_stretch 1.10f
 #define space_maxreldx 0.1f
+#define space_incremental_rebuild_max_frac 0.5f
 
 /* Maximum allowed depth of cell splits. */
 #define space_cell_maxdepth 52
@@ -103,6 +105,26 @@ struct space {
   /*! Are we doing star formation? */
   int with_star_formation;
 
+  /*! Do we only re-build the top-level cells whose particles changed? */
+  int with_incremental_rebuild;
+
+  /*! Do we repair the previous sorts of the leaf-cells instead of sorting
+   * their particles from scratch? */
+  int with_sort_repair;
+
+  /*! Must the next rebuild re-build all the top-level cells? */
+  int force_full_rebuild;
+
+  /*! Factor by which the number of spare #spart of a top-level cell is grown
+   * or shrunk at a rebuild depending on how many it used (<= 1 to disable). */
+  float extra_sparts_growth;
+
+  /*! Did the last rebuild keep the trees of some top-level cells? */
+  int last_rebuild_incremental;
+
+  /*! Top-level cells re-built by the last incremental rebuild. */
+  char *cells_rebuilt;
+
   /*! Width of the top-level cells. */
   double width[3];
 
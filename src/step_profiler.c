@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  @file step_profiler.c
+ *  @brief Cheap per-step profile of the engine phases and of the runners,
+ *  written to a binary file as the run goes.
+ *
+ *  The file is made of blocks, one per start or restart of the run. Each block
+ *  starts with a header:
+ *
+ *    char magic[16], int version, int nr_phases, int nr_runners,
+ *    int nr_queues, int nodeID, int record_size, double cpufreq,
+ *    char phase_names[nr_phases][16],
+ *
+ *  followed by one record of record_size bytes per step: a
+ *  #step_profiler_step, nr_runners #step_profiler_runner and nr_queues ints
+ *  giving the number of steals of each queue, padded to a multiple of 8 bytes.
+ *  tools/read_step_profile.py reads these files.
+ */
+
+/* Config parameters. */
+#include "../config.h"
+
+/* Standard headers. */
+#include <stdlib.h>
+#include <string.h>
+
+/* This object's header. */
+#include "step_profiler.h"
+
+/* Local headers. */
+#include "clocks.h"
+#include "engine.h"
+#include "error.h"
+#include "parser.h"
+
+/*! Names of the phases, as written to the file. */
+const char *step_profiler_phase_names[step_profiler_phase_count] = {
+    "drift",   "marktasks", "fof",     "repartition",
+    "rebuild", "launch",    "collect", "io"};
+
+/*! Marker of the start of a block of records. */
+static const char step_profiler_magic[16] = "SWIFT_STEP_PROF";
+
+/**
+ * @brief Write the header of a new block of records.
+ *
+ * @param p The #step_profiler.
+ * @param nodeID The rank we are on.
+ */
+static void step_profiler_write_header(struct step_profiler *p, int nodeID) {
+
+  const int version = step_profiler_version;
+  const int nr_phases = step_profiler_phase_count;
+  const int record_size = (int)p->record_size;
+  const double cpufreq = (double)clocks_get_cpufreq();
+
+  fwrite(step_profiler_magic, sizeof(char), 16, p->file);
+  fwrite(&version, sizeof(int), 1, p->file);
+  fwrite(&nr_phases, sizeof(int), 1, p->file);
+  fwrite(&p->nr_runners, sizeof(int), 1, p->file);
+  fwrite(&p->nr_queues, sizeof(int), 1, p->file);
+  fwrite(&nodeID, sizeof(int), 1, p->file);
+  fwrite(&record_size, sizeof(int), 1, p->file);
+  fwrite(&cpufreq, sizeof(double), 1, p->file);
+  for (int k = 0; k < step_profiler_phase_count; k++) {
+    char name[step_profiler_name_length] = {0};
+    strncpy(name, step_profiler_phase_names[k], step_profiler_name_length - 1);
+    fwrite(name, sizeof(char), step_profiler_name_length, p->file);
+  }
+  fflush(p->file);
+}
+
+/**
+ * @brief Initialise the step profiler and open its file.
+ *
+ * The profile goes to step_profile.dat, or to one step_profile_XXXX.dat per
+ * rank when running over MPI. On restarts the records are appended to the
+ * existing file, after a new header.
+ *
+ * @param p The #step_profiler.
+ * @param params The parsed parameter file.
+ * @param nr_runners The number of runner threads.
+ * @param nr_queues The number of task queues.
+ * @param nodeID The rank we are on.
+ * @param nr_nodes The number of ranks.
+ * @param restart Are we restarting a run?
+ */
+void step_profiler_init(struct step_profiler *p, struct swift_params *params,
+                        int nr_runners, int nr_queues, int nodeID, int nr_nodes,
+                        int restart) {
+
+  bzero(p, sizeof(struct step_profiler));
+
+  p->enabled = parser_get_opt_param_int(params, "StepProfiler:enabled", 1);
+  if (!p->enabled) return;
+
+  p->size = parser_get_opt_param_int(params, "StepProfiler:buffer_size", 64);
+  if (p->size < 1) error("StepProfiler:buffer_size must be positive.");
+  const double flush_interval =
+      parser_get_opt_param_double(params, "StepProfiler:flush_interval", 60.);
+  p->flush_interval = clocks_to_ticks(flush_interval * 1000.);
+
+  p->nr_runners = nr_runners;
+  p->nr_queues = nr_queues;
+  p->record_size = sizeof(struct step_profiler_step) +
+                   nr_runners * sizeof(struct step_profiler_runner) +
+                   nr_queues * sizeof(int);
+  p->record_size = (p->record_size + 7) & ~((size_t)7);
+
+  if ((p->records = (char *)calloc(p->size, p->record_size)) == NULL)
+    error("Failed to allocate the step profiler buffer.");
+
+  char fileName[200];
+  if (nr_nodes > 1)
+    sprintf(fileName, "step_profile_%04d.dat", nodeID);
+  else
+    sprintf(fileName, "step_profile.dat");
+  if ((p->file = fopen(fileName, restart ? "ab" : "wb")) == NULL)
+    error("Failed to open the step profile file '%s'.", fileName);
+
+  step_profiler_write_header(p, nodeID);
+  p->last_flush = getticks();
+}
+
+/**
+ * @brief Reset the profile of the engine and of the runners at the start of a
+ * step.
+ *
+ * @param e The #engine.
+ */
+void step_profiler_start_step(struct engine *e) {
+
+  struct step_profiler *p = &e->step_profiler;
+  if (!p->enabled) return;
+
+  p->tic_step = getticks();
+  for (int k = 0; k < step_profiler_phase_count; k++) p->phases[k] = 0;
+
+  /* The runners are all waiting at the barrier. */
+  for (int k = 0; k < e->nr_threads; k++)
+    bzero(&e->runners[k].profile, sizeof(struct step_profiler_runner));
+  for (int k = 0; k < e->sched.nr_queues; k++) e->sched.queues[k].nr_steals = 0;
+}
+
+/**
+ * @brief Store the profile of the step that just ended in the buffer and
+ * write the buffer out if it is full or old enough.
+ *
+ * @param e The #engine.
+ */
+void step_profiler_end_step(struct engine *e) {
+
+  struct step_profiler *p = &e->step_profiler;
+  if (!p->enabled) return;
+
+  char *record = p->records + p->count * p->record_size;
+
+  struct step_profiler_step *step = (struct step_profiler_step *)record;
+  step->step = e->step;
+  step->step_props = e->step_props;
+  step->time = e->time;
+  step->total = getticks() - p->tic_step;
+  memcpy(step->phases, p->phases, sizeof(p->phases));
+
+  struct step_profiler_runner *runners =
+      (struct step_profiler_runner *)(record +
+                                      sizeof(struct step_profiler_step));
+  for (int k = 0; k < p->nr_runners; k++) {
+    runners[k] = e->runners[k].profile;
+    runners[k].qid = e->runners[k].qid;
+  }
+
+  int *steals = (int *)(runners + p->nr_runners);
+  for (int k = 0; k < p->nr_queues; k++)
+    steals[k] = e->sched.queues[k].nr_steals;
+
+  p->count++;
+  if (p->count == p->size || getticks() - p->last_flush > p->flush_interval)
+    step_profiler_flush(p);
+}
+
+/**
+ * @brief Write the records held in the buffer to the file.
+ *
+ * @param p The #step_profiler.
+ */
+void step_profiler_flush(struct step_profiler *p) {
+
+  if (!p->enabled) return;
+
+  if (p->count > 0) {
+    if (fwrite(p->records, p->record_size, p->count, p->file) !=
+        (size_t)p->count)
+      error("Failed to write the step profile.");
+    fflush(p->file);
+  }
+  p->count = 0;
+  p->last_flush = getticks();
+}
+
+/**
+ * @brief Write out the remaining records and close the file.
+ *
+ * @param p The #step_profiler.
+ */
+void step_profiler_clean(struct step_profiler *p) {
+
+  if (!p->enabled) return;
+
+  step_profiler_flush(p);
+  fclose(p->file);
+  free(p->records);
+  p->enabled = 0;
+}
@@ -0,0 +1,173 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_STEP_PROFILER_H
+#define SWIFT_STEP_PROFILER_H
+
+/* Config parameters. */
+#include "../config.h"
+
+/* Standard headers. */
+#include <stdio.h>
+
+/* Local headers. */
+#include "cycle.h"
+#include "inline.h"
+
+/* Forward declarations to avoid cyclic includes. */
+struct engine;
+struct swift_params;
+
+/*! Version of the binary format of the step profiles. */
+#define step_profiler_version 1
+
+/*! Length of the phase names stored in the file header. */
+#define step_profiler_name_length 16
+
+/**
+ * @brief The phases of a time-step that are timed separately.
+ *
+ * The phases do not overlap; the time not covered by any of them (e.g. the
+ * time-step bookkeeping and the cost model) is the difference between the
+ * total and their sum.
+ */
+enum step_profiler_phase {
+  step_profiler_phase_drift,
+  step_profiler_phase_marktasks,
+  step_profiler_phase_fof,
+  step_profiler_phase_repartition,
+  step_profiler_phase_rebuild,
+  step_profiler_phase_launch,
+  step_profiler_phase_collect,
+  step_profiler_phase_io,
+  step_profiler_phase_count
+};
+
+extern const char *step_profiler_phase_names[step_profiler_phase_count];
+
+/**
+ * @brief What one runner did during the task phase of a step.
+ *
+ * The layout is the one written to the file.
+ */
+struct step_profiler_runner {
+
+  /*! Ticks spent running tasks. */
+  ticks busy;
+
+  /*! Sum of the lengths of the runner's queue seen when getting a task. */
+  long long queue_depth_sum;
+
+  /*! Number of tasks run. */
+  int nr_tasks;
+
+  /*! Longest queue seen when getting a task. */
+  int queue_depth_max;
+
+  /*! The queue of this runner. */
+  int qid;
+};
+
+/**
+ * @brief The header of the record of one step.
+ *
+ * It is followed in the buffer and in the file by one #step_profiler_runner
+ * per runner and by the number of tasks the runners of each queue stole from
+ * the other queues.
+ */
+struct step_profiler_step {
+
+  /*! The step number. */
+  int step;
+
+  /*! The properties of the step (rebuild, snapshot, ...). */
+  int step_props;
+
+  /*! The simulation time at the end of the step. */
+  double time;
+
+  /*! Ticks spent in the whole step. */
+  ticks total;
+
+  /*! Ticks spent in each phase. */
+  ticks phases[step_profiler_phase_count];
+};
+
+/**
+ * @brief Records the time spent in the phases of every step.
+ *
+ * The records are kept in a buffer of fixed size, which is written to the
+ * profile file when it is full or when the last write is older than the
+ * flush interval, so that long runs can be followed as they go.
+ */
+struct step_profiler {
+
+  /*! Is the profiler in use? */
+  int enabled;
+
+  /*! Number of runners and queues of each record. */
+  int nr_runners, nr_queues;
+
+  /*! Size in bytes of one record. */
+  size_t record_size;
+
+  /*! Number of records the buffer can hold and number held at the moment. */
+  int size, count;
+
+  /*! The buffer of records. */
+  char *records;
+
+  /*! Ticks at the start of the current step. */
+  ticks tic_step;
+
+  /*! Ticks spent so far in each phase of the current step. */
+  ticks phases[step_profiler_phase_count];
+
+  /*! Ticks at the last write to the file. */
+  ticks last_flush;
+
+  /*! Maximal time between two writes, in ticks. */
+  ticks flush_interval;
+
+  /*! The profile file. */
+  FILE *file;
+};
+
+/**
+ * @brief Add the ticks elapsed since tic to a phase of the current step.
+ *
+ * @param p The #step_profiler.
+ * @param phase The #step_profiler_phase.
+ * @param tic The ticks at the start of the phase.
+ */
+__attribute__((always_inline)) INLINE static void step_profiler_add(
+    struct step_profiler *p, const enum step_profiler_phase phase,
+    const ticks tic) {
+
+  p->phases[phase] += getticks() - tic;
+}
+
+void step_profiler_init(struct step_profiler *p, struct swift_params *params,
+                        int nr_runners, int nr_queues, int nodeID, int nr_nodes,
+                        int restart);
+void step_profiler_start_step(struct engine *e);
+void step_profiler_end_step(struct engine *e);
+void step_profiler_flush(struct step_profiler *p);
+void step_profiler_clean(struct step_profiler *p);
+
+#endif /* SWIFT_STEP_PROFILER_H */
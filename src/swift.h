@@ -37,6 +37,7 @@
 #include "cosmology.h"
 #include "cycle.h"
 #include "debug.h"
+#include "distributed_io.h"
 #include "dump.h"
 #include "engine.h"
 #include "entropy_floor.h"
@@ -70,6 +70,7 @@ const char *taskID_names[task_type_count] = {"none",
                                              "kick2",
                                              "timestep",
                                              "timestep_limiter",
+                                             "kick_timestep",
                                              "send",
                                              "recv",
                                              "grav_long_range",
@@ -229,6 +230,7 @@ __attribute__((always_inline)) INLINE static enum task_actions task_acts_on(
     case task_type_fof_self:
     case task_type_fof_pair:
     case task_type_timestep:
+    case task_type_kick_timestep:
     case task_type_send:
     case task_type_recv:
       if (t->ci->hydro.count > 0 && t->ci->grav.count > 0)
@@ -414,6 +416,7 @@ void task_unlock(struct task *t) {
     case task_type_kick2:
     case task_type_logger:
     case task_type_timestep:
+    case task_type_kick_timestep:
       cell_unlocktree(ci);
       cell_gunlocktree(ci);
       break;
@@ -550,6 +553,7 @@ int task_lock(struct task *t) {
     case task_type_kick2:
     case task_type_logger:
     case task_type_timestep:
+    case task_type_kick_timestep:
       if (ci->hydro.hold || ci->grav.phold) return 0;
       if (cell_locktree(ci) != 0) return 0;
       if (cell_glocktree(ci) != 0) {
@@ -893,11 +897,15 @@ void task_dump_all(struct engine *e, int step) {
       file_thread = fopen(dumpfile, "a");
 
       /* Add some information to help with the plots and conversion of ticks to
-       * seconds. */
-      fprintf(file_thread, " %03d 0 0 0 0 %lld %lld %lld %lld %lld 0 0 %lld\n",
+       * seconds. Also the critical path of the tasks, to compare with the
+       * step time. */
+      fprintf(file_thread,
+              " %03d 0 0 0 0 %lld %lld %lld %lld %lld %lld 0 %lld\n",
               engine_rank, (long long int)e->tic_step,
               (long long int)e->toc_step, e->updates, e->g_updates,
-              e->s_updates, cpufreq);
+              e->s_updates,
+              (long long int)scheduler_critical_path(&e->sched, e->tic_step),
+              cpufreq);
       int count = 0;
       for (int l = 0; l < e->sched.nr_tasks; l++) {
         if (!e->sched.tasks[l].implicit && e->sched.tasks[l].toc != 0) {
@@ -934,11 +942,14 @@ void task_dump_all(struct engine *e, int step) {
   file_thread = fopen(dumpfile, "w");
 
   /* Add some information to help with the plots and conversion of ticks to
-   * seconds. */
-  fprintf(file_thread, " %d %d %d %d %lld %lld %lld %lld %lld %d %lld\n", -2,
+   * seconds. Also the critical path of the tasks, to compare with the step
+   * time. */
+  fprintf(file_thread, " %d %d %d %d %lld %lld %lld %lld %lld %lld %lld\n", -2,
           -1, -1, 1, (unsigned long long)e->tic_step,
           (unsigned long long)e->toc_step, e->updates, e->g_updates,
-          e->s_updates, 0, cpufreq);
+          e->s_updates,
+          (unsigned long long)scheduler_critical_path(&e->sched, e->tic_step),
+          cpufreq);
   for (int l = 0; l < e->sched.nr_tasks; l++) {
     if (!e->sched.tasks[l].implicit && e->sched.tasks[l].toc != 0) {
       fprintf(
@@ -958,6 +969,11 @@ void task_dump_all(struct engine *e, int step) {
   }
   fclose(file_thread);
 #endif  // WITH_MPI
+
+#ifdef SWIFT_TASK_COUNTERS
+  /* And the hardware counts of the tasks next to it. */
+  task_counters_dump(e, step);
+#endif
 #endif  // SWIFT_DEBUG_TASKS
 }
 
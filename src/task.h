@@ -28,6 +28,7 @@
 /* Includes. */
 #include "align.h"
 #include "cycle.h"
+#include "task_counters.h"
 #include "timeline.h"
 
 /* Forward declarations to avoid circular inclusion dependencies. */
@@ -65,6 +66,7 @@ enum task_types {
   task_type_kick2,
   task_type_timestep,
   task_type_timestep_limiter,
+  task_type_kick_timestep,
   task_type_send,
   task_type_recv,
   task_type_grav_long_range,
@@ -219,6 +221,11 @@ struct task {
   /*! Start and end time of this task */
   ticks tic, toc;
 
+#ifdef SWIFT_TASK_COUNTERS
+  /*! Counts of the hardware events during this task */
+  long long counters[task_counters_max];
+#endif
+
 #ifdef SWIFT_DEBUG_CHECKS
   /* When was this task last run? */
   integertime_t ti_run;
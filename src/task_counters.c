@@ -0,0 +1,404 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  @file task_counters.c
+ *  @brief Hardware performance counters recorded around each task, using
+ *  the Linux perf_event interface.
+ */
+
+/* Config parameters. */
+#include "../config.h"
+
+#ifdef SWIFT_TASK_COUNTERS
+
+/* Standard headers. */
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* MPI headers. */
+#ifdef WITH_MPI
+#include <mpi.h>
+#endif
+
+/* This object's header. */
+#include "task_counters.h"
+
+/* Local headers. */
+#include "cell.h"
+#include "clocks.h"
+#include "engine.h"
+#include "error.h"
+#include "parser.h"
+#include "space.h"
+#include "task.h"
+
+/* Names of the events, as used in the parameter file and the dumps. */
+const char *task_counters_event_names[task_counters_event_count] = {
+    "cycles",
+    "instructions",
+    "llc_references",
+    "llc_misses",
+    "stalled_cycles_frontend",
+    "stalled_cycles_backend",
+    "branch_misses",
+    "task_clock",
+    "page_faults",
+    "context_switches"};
+
+/**
+ * @brief Open a counter of a hardware event for the calling thread.
+ *
+ * Only the user-space part of the thread is counted by the hardware events.
+ * The group leader is created disabled and the whole group is enabled at
+ * once.
+ *
+ * @param event The #task_counters_event to count.
+ * @param group_fd The file descriptor of the group leader, -1 to create a new
+ * group.
+ * @return The file descriptor of the counter, -1 on failure.
+ */
+static int task_counters_open(enum task_counters_event event, int group_fd) {
+
+  struct perf_event_attr attr;
+  bzero(&attr, sizeof(struct perf_event_attr));
+  attr.size = sizeof(struct perf_event_attr);
+  attr.type = PERF_TYPE_HARDWARE;
+
+  switch (event) {
+    case task_counters_event_cycles:
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case task_counters_event_instructions:
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case task_counters_event_llc_references:
+      attr.config = PERF_COUNT_HW_CACHE_REFERENCES;
+      break;
+    case task_counters_event_llc_misses:
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case task_counters_event_stalled_cycles_frontend:
+      attr.config = PERF_COUNT_HW_STALLED_CYCLES_FRONTEND;
+      break;
+    case task_counters_event_stalled_cycles_backend:
+      attr.config = PERF_COUNT_HW_STALLED_CYCLES_BACKEND;
+      break;
+    case task_counters_event_branch_misses:
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    case task_counters_event_task_clock:
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_TASK_CLOCK;
+      break;
+    case task_counters_event_page_faults:
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+      break;
+    case task_counters_event_context_switches:
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+      break;
+    default:
+      error("Unknown hardware event %d.", event);
+  }
+
+  /* The software events all happen in the kernel. */
+  attr.disabled = (group_fd == -1);
+  attr.exclude_kernel = (attr.type == PERF_TYPE_HARDWARE);
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+
+  /* No glibc wrapper for this one. Count this thread on any CPU. */
+  return syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, group_fd,
+                 0);
+}
+
+/**
+ * @brief Read the list of hardware events to count from the parameter file.
+ *
+ * The events this machine cannot count are dropped with a warning.
+ *
+ * @param events The #task_counters_events to fill.
+ * @param params The run-time parameters.
+ * @param verbose Are we talkative?
+ */
+void task_counters_events_init(struct task_counters_events *events,
+                               struct swift_params *params, int verbose) {
+
+  const char *def[task_counters_max] = {"cycles", "instructions", "llc_misses",
+                                        "stalled_cycles_backend"};
+  int nr_names = 0;
+  char **names = NULL;
+  parser_get_opt_param_string_array(params, "Scheduler:task_counters",
+                                    &nr_names, &names, task_counters_max, def);
+  if (nr_names > task_counters_max)
+    error("Can only record up to %d hardware counters per task, not %d.",
+          task_counters_max, nr_names);
+
+  events->nr_events = 0;
+  for (int k = 0; k < nr_names; k++) {
+
+    /* Which event is that? */
+    int event = -1;
+    for (int j = 0; j < task_counters_event_count; j++)
+      if (strcmp(names[k], task_counters_event_names[j]) == 0) event = j;
+    if (event < 0) error("Unknown hardware counter '%s'.", names[k]);
+
+    /* Can we count it on this machine? */
+    const int fd = task_counters_open((enum task_counters_event)event, -1);
+    if (fd < 0) {
+      if (engine_rank == 0)
+        message("WARNING: The hardware counter '%s' is not available (%s).",
+                names[k], strerror(errno));
+      continue;
+    }
+    close(fd);
+
+    events->events[events->nr_events++] = (enum task_counters_event)event;
+  }
+  parser_free_param_string_array(nr_names, names);
+
+  if (verbose && engine_rank == 0) {
+    char list[200] = "";
+    for (int k = 0; k < events->nr_events; k++) {
+      strcat(list, " ");
+      strcat(list, task_counters_event_names[events->events[k]]);
+    }
+    message("Recording the hardware counters:%s", list);
+  }
+}
+
+/**
+ * @brief Open and start the hardware counters of the calling thread.
+ *
+ * Needs to be called by the thread whose tasks are counted.
+ *
+ * @param tc The #task_counters of the thread.
+ * @param events The events to count.
+ */
+void task_counters_init(struct task_counters *tc,
+                        const struct task_counters_events *events) {
+
+  tc->nr_counters = 0;
+  for (int k = 0; k < events->nr_events; k++) {
+    const int fd =
+        task_counters_open(events->events[k], (k == 0) ? -1 : tc->fd[0]);
+    if (fd < 0)
+      error("Failed to open the hardware counter '%s' (%s).",
+            task_counters_event_names[events->events[k]], strerror(errno));
+    tc->fd[tc->nr_counters++] = fd;
+  }
+
+  if (tc->nr_counters > 0) {
+    if (ioctl(tc->fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) != 0 ||
+        ioctl(tc->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0)
+      error("Failed to start the hardware counters (%s).", strerror(errno));
+  }
+}
+
+/**
+ * @brief Read the current values of the hardware counters of a thread.
+ *
+ * @param tc The #task_counters of the calling thread.
+ * @param values (return) The counts, in the order of the events.
+ */
+void task_counters_read(const struct task_counters *tc, long long *values) {
+
+  if (tc->nr_counters == 0) return;
+
+  /* The group is read in one go as {nr, value[0], value[1], ...}. */
+  uint64_t buffer[task_counters_max + 1];
+  const ssize_t size = (tc->nr_counters + 1) * sizeof(uint64_t);
+  if (read(tc->fd[0], buffer, size) != size)
+    error("Failed to read the hardware counters (%s).", strerror(errno));
+
+  for (int k = 0; k < tc->nr_counters; k++) values[k] = buffer[k + 1];
+}
+
+/**
+ * @brief Close the hardware counters of a thread.
+ *
+ * @param tc The #task_counters.
+ */
+void task_counters_clean(struct task_counters *tc) {
+  for (int k = 0; k < tc->nr_counters; k++) close(tc->fd[k]);
+  tc->nr_counters = 0;
+}
+
+/**
+ * @brief The hardware counts summed over a group of tasks.
+ */
+struct task_counters_sum {
+
+  /*! Number of tasks. */
+  long long count;
+
+  /*! Time spent in the tasks. */
+  long long ticks;
+
+  /*! Counts of the hardware events. */
+  long long counts[task_counters_max];
+};
+
+/**
+ * @brief Sum the hardware counts of the tasks run in this step by type,
+ * subtype and depth of their (first) cell.
+ *
+ * @param e The #engine.
+ * @return The sums, to be freed by the caller.
+ */
+static struct task_counters_sum *task_counters_sum_tasks(
+    const struct engine *e) {
+
+  const int nr_depths = space_cell_maxdepth + 1;
+  struct task_counters_sum *sums = (struct task_counters_sum *)calloc(
+      task_type_count * task_subtype_count * nr_depths,
+      sizeof(struct task_counters_sum));
+  if (sums == NULL) error("Failed to allocate the hardware counter sums.");
+
+  for (int l = 0; l < e->sched.nr_tasks; l++) {
+    const struct task *t = &e->sched.tasks[l];
+    if (t->implicit || t->toc == 0) continue;
+
+    const int depth = (t->ci != NULL) ? t->ci->depth : 0;
+    struct task_counters_sum *sum =
+        &sums[(t->type * task_subtype_count + t->subtype) * nr_depths + depth];
+    sum->count++;
+    sum->ticks += t->toc - t->tic;
+    for (int k = 0; k < e->task_counters_events.nr_events; k++)
+      sum->counts[k] += t->counters[k];
+  }
+
+  return sums;
+}
+
+/**
+ * @brief Write the non-empty sums of the hardware counts to a file.
+ *
+ * @param file The file to write to.
+ * @param e The #engine.
+ * @param sums The sums to write.
+ * @param rank The rank to prefix the lines with, -1 for none.
+ */
+static void task_counters_write_sums(FILE *file, const struct engine *e,
+                                     const struct task_counters_sum *sums,
+                                     int rank) {
+
+  const int nr_depths = space_cell_maxdepth + 1;
+  for (int type = 0; type < task_type_count; type++) {
+    for (int subtype = 0; subtype < task_subtype_count; subtype++) {
+      for (int depth = 0; depth < nr_depths; depth++) {
+        const struct task_counters_sum *sum =
+            &sums[(type * task_subtype_count + subtype) * nr_depths + depth];
+        if (sum->count == 0) continue;
+
+        if (rank >= 0) fprintf(file, "%i ", rank);
+        fprintf(file, "%s %s %i %lld %lld", taskID_names[type],
+                subtaskID_names[subtype], depth, sum->count, sum->ticks);
+        for (int k = 0; k < e->task_counters_events.nr_events; k++)
+          fprintf(file, " %lld", sum->counts[k]);
+        fprintf(file, "\n");
+      }
+    }
+  }
+}
+
+/**
+ * @brief Write the header of the hardware counter dumps.
+ *
+ * @param file The file to write to.
+ * @param e The #engine.
+ * @param step The current step.
+ * @param with_rank Is there a rank column?
+ */
+static void task_counters_write_header(FILE *file, const struct engine *e,
+                                       int step, int with_rank) {
+
+  fprintf(file, "# Hardware counters of the tasks of step %d\n", step);
+  fprintf(file, "# CPU frequency: %llu\n", clocks_get_cpufreq());
+  fprintf(file, "#%s type subtype depth count ticks",
+          with_rank ? " rank" : "");
+  for (int k = 0; k < e->task_counters_events.nr_events; k++)
+    fprintf(file, " %s",
+            task_counters_event_names[e->task_counters_events.events[k]]);
+  fprintf(file, "\n");
+}
+
+/**
+ * @brief Dump the hardware counts of the tasks of this step, summed by task
+ * type, subtype and cell depth.
+ *
+ * Dumps the information to a file "task_counters-stepn.dat" where n is the
+ * given step value, or "task_counters_MPI-stepn.dat", if we are running
+ * under MPI. Under MPI all the ranks are dumped into this one file, which has
+ * an additional field to identify the rank.
+ *
+ * @param e The #engine.
+ * @param step The current step.
+ */
+void task_counters_dump(struct engine *e, int step) {
+
+  struct task_counters_sum *sums = task_counters_sum_tasks(e);
+
+#ifdef WITH_MPI
+  /* Make sure output file is empty and has a header, only on one rank. */
+  char dumpfile[40];
+  snprintf(dumpfile, sizeof(dumpfile), "task_counters_MPI-step%d.dat", step);
+  FILE *file;
+  if (engine_rank == 0) {
+    file = fopen(dumpfile, "w");
+    if (file == NULL) error("Could not create file '%s'.", dumpfile);
+    task_counters_write_header(file, e, step, /*with_rank=*/1);
+    fclose(file);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  /* Each rank appends its own sums in turn. */
+  for (int i = 0; i < e->nr_nodes; i++) {
+    if (i == engine_rank) {
+      file = fopen(dumpfile, "a");
+      if (file == NULL) error("Could not open file '%s'.", dumpfile);
+      task_counters_write_sums(file, e, sums, engine_rank);
+      fclose(file);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+#else
+  char dumpfile[40];
+  snprintf(dumpfile, sizeof(dumpfile), "task_counters-step%d.dat", step);
+  FILE *file = fopen(dumpfile, "w");
+  if (file == NULL) error("Could not create file '%s'.", dumpfile);
+  task_counters_write_header(file, e, step, /*with_rank=*/0);
+  task_counters_write_sums(file, e, sums, /*rank=*/-1);
+  fclose(file);
+#endif
+
+  free(sums);
+}
+
+#endif /* SWIFT_TASK_COUNTERS */
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_TASK_COUNTERS_H
+#define SWIFT_TASK_COUNTERS_H
+
+/* Config parameters. */
+#include "../config.h"
+
+#ifdef SWIFT_TASK_COUNTERS
+
+/* Forward declarations to avoid cyclic includes. */
+struct engine;
+struct swift_params;
+
+/*! Maximal number of hardware counters recorded at the same time. Most CPUs
+ * cannot count many more events without multiplexing them. */
+#define task_counters_max 4
+
+/**
+ * @brief The hardware events that can be counted around the tasks.
+ *
+ * The last three are counted by the kernel and are also available on machines
+ * without access to the hardware counters (e.g. most virtual machines).
+ */
+enum task_counters_event {
+  task_counters_event_cycles,
+  task_counters_event_instructions,
+  task_counters_event_llc_references,
+  task_counters_event_llc_misses,
+  task_counters_event_stalled_cycles_frontend,
+  task_counters_event_stalled_cycles_backend,
+  task_counters_event_branch_misses,
+  task_counters_event_task_clock,
+  task_counters_event_page_faults,
+  task_counters_event_context_switches,
+  task_counters_event_count
+} __attribute__((packed));
+
+extern const char *task_counters_event_names[task_counters_event_count];
+
+/**
+ * @brief The set of events counted by all the runners.
+ */
+struct task_counters_events {
+
+  /*! Number of events in use. */
+  int nr_events;
+
+  /*! The events, in the order of the counters stored in the tasks. */
+  enum task_counters_event events[task_counters_max];
+};
+
+/**
+ * @brief The hardware counters of one runner thread.
+ */
+struct task_counters {
+
+  /*! Number of open counters. */
+  int nr_counters;
+
+  /*! File descriptors of the counters, the first one leads the group. */
+  int fd[task_counters_max];
+};
+
+void task_counters_events_init(struct task_counters_events *events,
+                               struct swift_params *params, int verbose);
+void task_counters_init(struct task_counters *tc,
+                        const struct task_counters_events *events);
+void task_counters_read(const struct task_counters *tc, long long *values);
+void task_counters_clean(struct task_counters *tc);
+void task_counters_dump(struct engine *e, int step);
+
+#endif /* SWIFT_TASK_COUNTERS */
+
+#endif /* SWIFT_TASK_COUNTERS_H */
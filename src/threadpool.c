@@ -35,6 +35,7 @@
 
 /* Local headers. */
 #include "atomic.h"
+#include "backoff.h"
 #include "clocks.h"
 #include "error.h"
 #include "minmax.h"
@@ -160,26 +161,95 @@ void threadpool_chomp(struct threadpool *tp, int tid) {
   }
 }
 
+/**
+ * @brief Let the threads loose on the map data set by the controller.
+ *
+ * @param tp The #threadpool.
+ */
+static void threadpool_start(struct threadpool *tp) {
+
+  tp->num_threads_running = 0;
+  tp->num_threads_done = 0;
+  atomic_inc(&tp->map_generation);
+
+  /* Only the threads that stopped polling need waking up. */
+  if (tp->num_sleeping > 0) {
+    pthread_mutex_lock(&tp->sleep_mutex);
+    pthread_cond_broadcast(&tp->run_cond);
+    pthread_mutex_unlock(&tp->sleep_mutex);
+  }
+}
+
+/**
+ * @brief Wait for all the threads to be done with the current map.
+ *
+ * @param tp The #threadpool.
+ */
+static void threadpool_wait(struct threadpool *tp) {
+
+  const int num_workers = tp->num_threads - 1;
+
+  /* Poll for a while before going to sleep. */
+  struct backoff backoff;
+  backoff_init(&backoff, tp->spin_ticks);
+  while (tp->num_threads_done < num_workers && backoff_spin(&backoff))
+    ;
+
+  if (tp->num_threads_done < num_workers) {
+    pthread_mutex_lock(&tp->sleep_mutex);
+    while (tp->num_threads_done < num_workers)
+      pthread_cond_wait(&tp->done_cond, &tp->sleep_mutex);
+    pthread_mutex_unlock(&tp->sleep_mutex);
+  }
+
+  /* Make sure we see everything the threads wrote. */
+  __sync_synchronize();
+}
+
 void *threadpool_runner(void *data) {
 
   /* Our threadpool. */
   struct threadpool *tp = (struct threadpool *)data;
 
+  /* The last map this thread worked on. */
+  int generation = 0;
+
   /* Main loop. */
   while (1) {
 
-    /* Let the controller know that this thread is waiting. */
-    swift_barrier_wait(&tp->wait_barrier);
+    /* Wait for the controller, polling for a while before going to sleep. */
+    struct backoff backoff;
+    backoff_init(&backoff, tp->spin_ticks);
+    while (tp->map_generation == generation && backoff_spin(&backoff))
+      ;
+
+    if (tp->map_generation == generation) {
+      pthread_mutex_lock(&tp->sleep_mutex);
+      atomic_inc(&tp->num_sleeping);
+      while (tp->map_generation == generation)
+        pthread_cond_wait(&tp->run_cond, &tp->sleep_mutex);
+      atomic_dec(&tp->num_sleeping);
+      pthread_mutex_unlock(&tp->sleep_mutex);
+    }
+    generation = tp->map_generation;
 
-    /* Wait for the controller. */
-    swift_barrier_wait(&tp->run_barrier);
+    /* Make sure we see the map data set by the controller. */
+    __sync_synchronize();
 
     /* If no map function is specified, just die. We use this as a mechanism
-       to shut down threads without leaving the barriers in an invalid state. */
+       to shut down threads. */
     if (tp->map_function == NULL) pthread_exit(NULL);
 
     /* Do actual work. */
     threadpool_chomp(tp, atomic_inc(&tp->num_threads_running));
+
+    /* Let the controller know that this thread is done, waking it up if we
+       are the last one. */
+    if (atomic_inc(&tp->num_threads_done) == tp->num_threads - 2) {
+      pthread_mutex_lock(&tp->sleep_mutex);
+      pthread_cond_signal(&tp->done_cond);
+      pthread_mutex_unlock(&tp->sleep_mutex);
+    }
   }
 }
 
@@ -193,6 +263,7 @@ void threadpool_init(struct threadpool *tp, int num_threads) {
 
   /* Initialize the thread counters. */
   tp->num_threads = num_threads;
+  tp->spin_ticks = 0;
 
 #ifdef SWIFT_DEBUG_THREADPOOL
   if ((tp->logs = (struct mapper_log *)malloc(sizeof(struct mapper_log) *
@@ -211,10 +282,14 @@ void threadpool_init(struct threadpool *tp, int num_threads) {
      we will just do work in the (blocked) calling thread. */
   if (num_threads == 1) return;
 
-  /* Init the barriers. */
-  if (swift_barrier_init(&tp->wait_barrier, NULL, num_threads) != 0 ||
-      swift_barrier_init(&tp->run_barrier, NULL, num_threads) != 0)
-    error("Failed to initialize barriers.");
+  /* Init the sleep mutex and conditions. */
+  if (pthread_mutex_init(&tp->sleep_mutex, NULL) != 0 ||
+      pthread_cond_init(&tp->run_cond, NULL) != 0 ||
+      pthread_cond_init(&tp->done_cond, NULL) != 0)
+    error("Failed to initialize the threadpool sleep conditions.");
+  tp->map_generation = 0;
+  tp->num_threads_done = 0;
+  tp->num_sleeping = 0;
 
   /* Set the task counter to zero. */
   tp->map_data_size = 0;
@@ -235,9 +310,6 @@ void threadpool_init(struct threadpool *tp, int num_threads) {
     if (pthread_create(&tp->threads[k], NULL, &threadpool_runner, tp) != 0)
       error("Failed to create threadpool runner thread.");
   }
-
-  /* Wait for all the threads to be up and running. */
-  swift_barrier_wait(&tp->wait_barrier);
 }
 
 /**
@@ -287,14 +359,14 @@ void threadpool_map(struct threadpool *tp, threadpool_map_function map_function,
   tp->map_extra_data = extra_data;
   tp->num_threads_running = 0;
 
-  /* Wait for all the threads to be up and running. */
-  swift_barrier_wait(&tp->run_barrier);
+  /* Wake up the threads. */
+  threadpool_start(tp);
 
   /* Do some work while I'm at it. */
   threadpool_chomp(tp, tp->num_threads - 1);
 
   /* Wait for all threads to be done. */
-  swift_barrier_wait(&tp->wait_barrier);
+  threadpool_wait(tp);
 
 #ifdef SWIFT_DEBUG_THREADPOOL
   /* Log the total call time to thread id -1. */
@@ -319,18 +391,19 @@ void threadpool_clean(struct threadpool *tp) {
   if (tp->num_threads > 1) {
     /* Destroy the runner threads by calling them with a NULL mapper function
      * and waiting for all the threads to terminate. This ensures that no
-     * thread is still waiting at a barrier. */
+     * thread is still waiting for work. */
     tp->map_function = NULL;
-    swift_barrier_wait(&tp->run_barrier);
+    threadpool_start(tp);
     for (int k = 0; k < tp->num_threads - 1; k++) {
       void *retval;
       pthread_join(tp->threads[k], &retval);
     }
 
-    /* Release the barriers. */
-    if (swift_barrier_destroy(&tp->wait_barrier) != 0 ||
-        swift_barrier_destroy(&tp->run_barrier) != 0)
-      error("Failed to destroy threadpool barriers.");
+    /* Release the sleep mutex and conditions. */
+    if (pthread_cond_destroy(&tp->run_cond) != 0 ||
+        pthread_cond_destroy(&tp->done_cond) != 0 ||
+        pthread_mutex_destroy(&tp->sleep_mutex) != 0)
+      error("Failed to destroy the threadpool sleep conditions.");
 
     /* Clean up memory. */
     free(tp->threads);
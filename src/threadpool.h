@@ -26,7 +26,6 @@
 #include <pthread.h>
 
 /* Local includes. */
-#include "barrier.h"
 #include "cycle.h"
 
 /* Local defines. */
@@ -71,8 +70,8 @@ struct threadpool {
   pthread_t *threads;
 
   /* This is where threads go to rest. */
-  swift_barrier_t wait_barrier;
-  swift_barrier_t run_barrier;
+  pthread_mutex_t sleep_mutex;
+  pthread_cond_t run_cond, done_cond;
 
   /* Current map data and count. */
   void *map_data, *map_extra_data;
@@ -86,6 +85,15 @@ struct threadpool {
   /* Counter for the number of threads that are done. */
   volatile int num_threads_running;
 
+  /* Number of the current map and number of threads that finished it. */
+  volatile int map_generation, num_threads_done;
+
+  /* Number of threads sleeping until the next map. */
+  volatile int num_sleeping;
+
+  /* Number of ticks the threads poll for work before going to sleep. */
+  ticks spin_ticks;
+
 #ifdef SWIFT_DEBUG_THREADPOOL
   struct mapper_log *logs;
 #endif
@@ -47,6 +47,7 @@ const char* timers_names[timer_count] = {
     "kick1",
     "kick2",
     "timestep",
+    "kick_timestep",
     "end_hydro_force",
     "end_grav_force",
     "dosort",
@@ -56,6 +57,9 @@ const char* timers_names[timer_count] = {
     "doself_limiter",
     "doself_stars_density",
     "doself_stars_feedback",
+    "doself_bh_density",
+    "doself_bh_swallow",
+    "doself_bh_feedback",
     "doself_grav_pp",
     "dopair_density",
     "dopair_gradient",
@@ -63,6 +67,9 @@ const char* timers_names[timer_count] = {
     "dopair_limiter",
     "dopair_stars_density",
     "dopair_stars_feedback",
+    "dopair_bh_density",
+    "dopair_bh_swallow",
+    "dopair_bh_feedback",
     "dopair_grav_mm",
     "dopair_grav_pp",
     "dograv_external",
@@ -76,6 +83,9 @@ const char* timers_names[timer_count] = {
     "dosub_self_limiter",
     "dosub_self_stars_density",
     "dosub_self_stars_feedback",
+    "dosub_self_bh_density",
+    "dosub_self_bh_swallow",
+    "dosub_self_bh_feedback",
     "dosub_self_grav",
     "dosub_pair_density",
     "dosub_pair_gradient",
@@ -83,6 +93,9 @@ const char* timers_names[timer_count] = {
     "dosub_pair_limiter",
     "dosub_pair_stars_density",
     "dosub_pair_stars_feedback",
+    "dosub_pair_bh_density",
+    "dosub_pair_bh_swallow",
+    "dosub_pair_bh_feedback",
     "dosub_pair_grav",
     "doself_subset",
     "dopair_subset",
@@ -91,12 +104,14 @@ const char* timers_names[timer_count] = {
     "do_ghost",
     "do_extra_ghost",
     "do_stars_ghost",
+    "do_black_holes_ghost",
     "dorecv_part",
     "dorecv_gpart",
     "dorecv_spart",
     "do_limiter",
     "do_cooling",
     "do_star_formation",
+    "do_star_formation_convert",
     "do_star_evol",
     "gettask",
     "qget",
@@ -106,6 +121,7 @@ const char* timers_names[timer_count] = {
     "step",
     "logger",
     "do_stars_sort",
+    "do_stars_resort",
     "fof_self",
     "fof_pair",
 };
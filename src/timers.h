@@ -48,6 +48,7 @@ enum {
   timer_kick1,
   timer_kick2,
   timer_timestep,
+  timer_kick_timestep,
   timer_end_hydro_force,
   timer_end_grav_force,
   timer_dosort,
@@ -57,6 +58,9 @@ enum {
   timer_doself_limiter,
   timer_doself_stars_density,
   timer_doself_stars_feedback,
+  timer_doself_bh_density,
+  timer_doself_bh_swallow,
+  timer_doself_bh_feedback,
   timer_doself_grav_pp,
   timer_dopair_density,
   timer_dopair_gradient,
@@ -64,6 +68,9 @@ enum {
   timer_dopair_limiter,
   timer_dopair_stars_density,
   timer_dopair_stars_feedback,
+  timer_dopair_bh_density,
+  timer_dopair_bh_swallow,
+  timer_dopair_bh_feedback,
   timer_dopair_grav_mm,
   timer_dopair_grav_pp,
   timer_dograv_external,
@@ -77,6 +84,9 @@ enum {
   timer_dosub_self_limiter,
   timer_dosub_self_stars_density,
   timer_dosub_self_stars_feedback,
+  timer_dosub_self_bh_density,
+  timer_dosub_self_bh_swallow,
+  timer_dosub_self_bh_feedback,
   timer_dosub_self_grav,
   timer_dosub_pair_density,
   timer_dosub_pair_gradient,
@@ -84,6 +94,9 @@ enum {
   timer_dosub_pair_limiter,
   timer_dosub_pair_stars_density,
   timer_dosub_pair_stars_feedback,
+  timer_dosub_pair_bh_density,
+  timer_dosub_pair_bh_swallow,
+  timer_dosub_pair_bh_feedback,
   timer_dosub_pair_grav,
   timer_doself_subset,
   timer_dopair_subset,
@@ -92,12 +105,14 @@ enum {
   timer_do_ghost,
   timer_do_extra_ghost,
   timer_do_stars_ghost,
+  timer_do_black_holes_ghost,
   timer_dorecv_part,
   timer_dorecv_gpart,
   timer_dorecv_spart,
   timer_do_limiter,
   timer_do_cooling,
   timer_do_star_formation,
+  timer_do_star_formation_convert,
   timer_do_star_evol,
   timer_gettask,
   timer_qget,
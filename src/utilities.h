@@ -56,4 +56,72 @@ INLINE static int find_value_in_monot_incr_array(const float x,
     return index_low;
 }
 
+/**
+ * @brief Build a uniform grid spanning a monotonically increasing array that
+ *      stores at each grid point the index given by
+ *      find_value_in_monot_incr_array() for that point
+ *
+ * @param array The array to index
+ * @param n The length of the array
+ * @param grid The grid of indices to fill
+ * @param num_grid The number of grid points
+ * @param grid_min (return) The value at the first grid point
+ * @param grid_inv_step (return) The inverse of the grid spacing
+ *
+ * Used with find_value_in_monot_incr_array_grid() to replace the binary
+ * search by a look-up and a short linear search.
+ */
+INLINE static void init_monot_incr_array_grid(const float *array, const int n,
+                                              int *grid, const int num_grid,
+                                              float *grid_min,
+                                              float *grid_inv_step) {
+
+  const float step = (array[n - 1] - array[0]) / (num_grid - 1);
+
+  *grid_min = array[0];
+  *grid_inv_step = (step > 0.f) ? 1.f / step : 0.f;
+
+  for (int i = 0; i < num_grid; i++) {
+    int index = find_value_in_monot_incr_array(array[0] + i * step, array, n);
+
+    // Keep the indices inside the array
+    if (index < 0) index = 0;
+    if (index > n - 2) index = n - 2;
+    grid[i] = index;
+  }
+}
+
+/**
+ * @brief Same as find_value_in_monot_incr_array() using the uniform grid of
+ *      indices built by init_monot_incr_array_grid()
+ *
+ * @param x The value to find
+ * @param array The array to search
+ * @param n The length of the array
+ * @param grid The grid of indices
+ * @param num_grid The number of grid points
+ * @param grid_min The value at the first grid point
+ * @param grid_inv_step The inverse of the grid spacing
+ *
+ * Return -1 and n for x below and above the array edge values respectively.
+ */
+INLINE static int find_value_in_monot_incr_array_grid(
+    const float x, const float *array, const int n, const int *grid,
+    const int num_grid, const float grid_min, const float grid_inv_step) {
+
+  if (x < array[0]) return -1;
+  if (array[n - 1] <= x) return n;
+
+  int i_grid = (int)((x - grid_min) * grid_inv_step);
+  if (i_grid > num_grid - 1) i_grid = num_grid - 1;
+  int index = grid[i_grid];
+
+  // Walk to the index such that array[index] <= x < array[index + 1], the
+  // nearest grid point can be on either side of x
+  while (array[index] > x) index--;
+  while (array[index + 1] <= x) index++;
+
+  return index;
+}
+
 #endif /* SWIFT_UTILITIES_H */
@@ -0,0 +1,802 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include "../config.h"
+
+/* Some standard headers. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Local headers. */
+#include "runner_doiact_grav.h"
+#include "swift.h"
+
+#define NODE_ID 0
+
+/* Time-bin of the inactive particles (the active ones are in bin 1). */
+#define INACTIVE_BIN 10
+
+/* Number of M2L kernel calls per run. */
+#define NUM_M2L 1000
+
+/* Just a forward declaration... */
+void runner_dopair1_branch_density(struct runner *r, struct cell *ci,
+                                   struct cell *cj);
+void runner_doself1_branch_density(struct runner *r, struct cell *c);
+void runner_dopair_subset_branch_density(struct runner *r,
+                                         struct cell *restrict ci,
+                                         struct part *restrict parts_i,
+                                         int *restrict ind, int count,
+                                         struct cell *restrict cj);
+void runner_doself_subset_branch_density(struct runner *r,
+                                         struct cell *restrict ci,
+                                         struct part *restrict parts,
+                                         int *restrict ind, int count);
+#ifdef EXTRA_HYDRO_LOOP
+void runner_dopair1_branch_gradient(struct runner *r, struct cell *ci,
+                                    struct cell *cj);
+void runner_doself1_branch_gradient(struct runner *r, struct cell *c);
+#endif /* EXTRA_HYDRO LOOP */
+void runner_dopair2_branch_force(struct runner *r, struct cell *ci,
+                                 struct cell *cj);
+void runner_doself2_branch_force(struct runner *r, struct cell *c);
+#ifdef HAVE_FFTW
+void cell_gpart_to_mesh_CIC(const struct cell *c, double *rho, int N,
+                            double fac, const double dim[3]);
+#endif
+
+/**
+ * @brief The time spent in one of the benchmarked kernels.
+ */
+struct bench_timing {
+
+  /*! Name of the kernel. */
+  const char *name;
+
+  /*! What one unit of work of the kernel is. */
+  const char *unit;
+
+  /*! Units of work done by the kernel in each run. */
+  long long work;
+
+  /*! Time spent in the kernel over all the runs. */
+  ticks time;
+};
+
+/**
+ * @brief Draws the time-bins of the particles of a cell such that a given
+ * fraction of them is active.
+ */
+void set_active_hydro(struct cell *c, double active_frac) {
+  for (int k = 0; k < c->hydro.count; k++)
+    c->hydro.parts[k].time_bin =
+        (random_uniform(0., 1.) < active_frac) ? 1 : INACTIVE_BIN;
+}
+
+/**
+ * @brief Constructs a cell and all of its gas particles in a valid state
+ * prior to a density loop.
+ *
+ * @param n The cube root of the number of particles.
+ * @param offset The position of the cell offset from (0,0,0).
+ * @param size The cell size.
+ * @param h The smoothing length of the particles in units of the inter-particle
+ * separation.
+ * @param h_pert The random fractional increase of h, h=h*random(1,h_pert).
+ * @param pert The perturbation to apply to the particles in the cell in units
+ * of the inter-particle separation.
+ * @param density The density of the fluid.
+ * @param partId The running counter of IDs.
+ */
+struct cell *make_hydro_cell(size_t n, const double offset[3], double size,
+                             double h, double h_pert, double pert,
+                             double density, long long *partId) {
+
+  const size_t count = n * n * n;
+  const double volume = size * size * size;
+  float h_max = 0.f;
+  struct cell *cell = NULL;
+  if (posix_memalign((void **)&cell, cell_align, sizeof(struct cell)) != 0)
+    error("couldn't allocate the cell");
+  bzero(cell, sizeof(struct cell));
+
+  if (posix_memalign((void **)&cell->hydro.parts, part_align,
+                     count * sizeof(struct part)) != 0)
+    error("couldn't allocate particles, no. of particles: %d", (int)count);
+  if (posix_memalign((void **)&cell->hydro.xparts, xpart_align,
+                     count * sizeof(struct xpart)) != 0)
+    error("couldn't allocate particles, no. of x-particles: %d", (int)count);
+  bzero(cell->hydro.parts, count * sizeof(struct part));
+  bzero(cell->hydro.xparts, count * sizeof(struct xpart));
+
+  /* Construct the parts */
+  struct part *part = cell->hydro.parts;
+  struct xpart *xpart = cell->hydro.xparts;
+  for (size_t x = 0; x < n; ++x) {
+    for (size_t y = 0; y < n; ++y) {
+      for (size_t z = 0; z < n; ++z) {
+        part->x[0] =
+            offset[0] +
+            size * (x + 0.5 + random_uniform(-0.5, 0.5) * pert) / (float)n;
+        part->x[1] =
+            offset[1] +
+            size * (y + 0.5 + random_uniform(-0.5, 0.5) * pert) / (float)n;
+        part->x[2] =
+            offset[2] +
+            size * (z + 0.5 + random_uniform(-0.5, 0.5) * pert) / (float)n;
+        part->v[0] = random_uniform(-0.05, 0.05);
+        part->v[1] = random_uniform(-0.05, 0.05);
+        part->v[2] = random_uniform(-0.05, 0.05);
+        if (h_pert > 1.)
+          part->h = size * h * random_uniform(1.f, h_pert) / (float)n;
+        else
+          part->h = size * h / (float)n;
+        h_max = fmaxf(h_max, part->h);
+        part->id = ++(*partId);
+
+#if defined(GIZMO_MFV_SPH) || defined(SHADOWFAX_SPH)
+        part->conserved.mass = density * volume / count;
+#else
+        part->mass = density * volume / count;
+#endif
+
+        hydro_set_init_internal_energy(part, 1.f);
+        hydro_first_init_part(part, xpart);
+
+#ifdef SWIFT_DEBUG_CHECKS
+        part->ti_drift = 8;
+        part->ti_kick = 8;
+#endif
+
+        ++part;
+        ++xpart;
+      }
+    }
+  }
+
+  /* Cell properties */
+  cell->split = 0;
+  cell->hydro.h_max = h_max;
+  cell->hydro.count = count;
+  cell->hydro.dx_max_part = 0.;
+  cell->hydro.dx_max_sort = 0.;
+  cell->width[0] = size;
+  cell->width[1] = size;
+  cell->width[2] = size;
+  cell->loc[0] = offset[0];
+  cell->loc[1] = offset[1];
+  cell->loc[2] = offset[2];
+
+  cell->hydro.super = cell;
+  cell->hydro.ti_old_part = 8;
+  cell->hydro.ti_end_min = 8;
+  cell->hydro.ti_end_max = 8;
+  cell->nodeID = NODE_ID;
+
+  shuffle_particles(cell->hydro.parts, cell->hydro.count);
+
+  return cell;
+}
+
+/**
+ * @brief Constructs a cell and all of its gravity particles, as well as
+ * their multipole.
+ *
+ * @param n The cube root of the number of particles.
+ * @param offset The position of the cell offset from (0,0,0).
+ * @param size The cell size.
+ * @param pert The perturbation to apply to the particles in the cell in units
+ * of the inter-particle separation.
+ * @param density The density of the matter.
+ * @param active_frac The fraction of active particles.
+ * @param partId The running counter of IDs.
+ */
+struct cell *make_grav_cell(size_t n, const double offset[3], double size,
+                            double pert, double density, double active_frac,
+                            long long *partId) {
+
+  const size_t count = n * n * n;
+  const double volume = size * size * size;
+  struct cell *cell = NULL;
+  if (posix_memalign((void **)&cell, cell_align, sizeof(struct cell)) != 0)
+    error("couldn't allocate the cell");
+  bzero(cell, sizeof(struct cell));
+
+  if (posix_memalign((void **)&cell->grav.parts, gpart_align,
+                     count * sizeof(struct gpart)) != 0)
+    error("couldn't allocate g-particles, no. of particles: %d", (int)count);
+  bzero(cell->grav.parts, count * sizeof(struct gpart));
+
+  /* Construct the gparts */
+  struct gpart *gp = cell->grav.parts;
+  for (size_t x = 0; x < n; ++x) {
+    for (size_t y = 0; y < n; ++y) {
+      for (size_t z = 0; z < n; ++z) {
+        gp->x[0] = offset[0] +
+                   size * (x + 0.5 + random_uniform(-0.5, 0.5) * pert) / n;
+        gp->x[1] = offset[1] +
+                   size * (y + 0.5 + random_uniform(-0.5, 0.5) * pert) / n;
+        gp->x[2] = offset[2] +
+                   size * (z + 0.5 + random_uniform(-0.5, 0.5) * pert) / n;
+        gp->mass = density * volume / count;
+        gp->time_bin =
+            (random_uniform(0., 1.) < active_frac) ? 1 : INACTIVE_BIN;
+        gp->type = swift_type_dark_matter;
+        gp->id_or_neg_offset = ++(*partId);
+#ifdef SWIFT_DEBUG_CHECKS
+        gp->ti_drift = 8;
+        gp->initialised = 1;
+#endif
+        ++gp;
+      }
+    }
+  }
+
+  /* Cell properties */
+  cell->split = 0;
+  cell->grav.count = count;
+  cell->width[0] = size;
+  cell->width[1] = size;
+  cell->width[2] = size;
+  cell->loc[0] = offset[0];
+  cell->loc[1] = offset[1];
+  cell->loc[2] = offset[2];
+
+  cell->grav.super = cell;
+  cell->grav.ti_old_part = 8;
+  cell->grav.ti_old_multipole = 8;
+  cell->grav.ti_end_min = 8;
+  cell->grav.ti_end_max = 8;
+  cell->nodeID = NODE_ID;
+
+  /* And the multipole */
+  if (posix_memalign((void **)&cell->grav.multipole, multipole_align,
+                     sizeof(struct gravity_tensors)) != 0)
+    error("couldn't allocate the multipole");
+  bzero(cell->grav.multipole, sizeof(struct gravity_tensors));
+  gravity_P2M(cell->grav.multipole, cell->grav.parts, cell->grav.count);
+
+  return cell;
+}
+
+void clean_up(struct cell *c) {
+  free(c->hydro.parts);
+  free(c->hydro.xparts);
+  cell_free_hydro_sorts(c);
+  free(c->grav.parts);
+  free(c->grav.multipole);
+  free(c);
+}
+
+/**
+ * @brief Counts the interactions of the active #part of a cell with the
+ * #part of another (or the same) cell.
+ *
+ * @param ci The #cell with the active particles.
+ * @param cj The #cell with the neighbours.
+ * @param e The #engine.
+ * @param symmetric_h Use the largest of the two smoothing lengths as in the
+ * force loop (1) or the one of the active particle as in the density loop
+ * (0)?
+ */
+long long count_hydro_interactions(const struct cell *ci,
+                                   const struct cell *cj,
+                                   const struct engine *e,
+                                   const int symmetric_h) {
+
+  long long count = 0;
+  for (int i = 0; i < ci->hydro.count; i++) {
+    const struct part *pi = &ci->hydro.parts[i];
+    if (!part_is_active(pi, e)) continue;
+    for (int j = 0; j < cj->hydro.count; j++) {
+      const struct part *pj = &cj->hydro.parts[j];
+      if (pi == pj) continue;
+      const float h = symmetric_h ? max(pi->h, pj->h) : pi->h;
+      const float dx[3] = {pi->x[0] - pj->x[0], pi->x[1] - pj->x[1],
+                           pi->x[2] - pj->x[2]};
+      const float r2 = dx[0] * dx[0] + dx[1] * dx[1] + dx[2] * dx[2];
+      if (r2 < h * h * kernel_gamma2) count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Counts the active #gpart of a cell.
+ */
+int count_active_gparts(const struct cell *c, const struct engine *e) {
+  int count = 0;
+  for (int k = 0; k < c->grav.count; k++)
+    if (gpart_is_active(&c->grav.parts[k], e)) count++;
+  return count;
+}
+
+/**
+ * @brief Resets the density fields of the active #part of a cell.
+ */
+void init_active_parts(struct cell *c, const struct engine *e) {
+  for (int k = 0; k < c->hydro.count; k++)
+    if (part_is_active(&c->hydro.parts[k], e))
+      hydro_init_part(&c->hydro.parts[k], &e->s->hs);
+}
+
+/**
+ * @brief Runs the density and ghost (and gradient) loops on a 3x3x3 block of
+ * cells such that all the particles are ready for a force loop.
+ */
+void prepare_force(struct runner *r, struct cell **cells) {
+
+  for (int j = 0; j < 27; ++j) init_active_parts(cells[j], r->e);
+  for (int j = 0; j < 27; ++j) {
+    runner_doself1_branch_density(r, cells[j]);
+    if (j != 13) runner_dopair1_branch_density(r, cells[13], cells[j]);
+  }
+  for (int j = 0; j < 27; ++j) runner_do_ghost(r, cells[j], 0);
+
+#ifdef EXTRA_HYDRO_LOOP
+  for (int j = 0; j < 27; ++j) {
+    runner_doself1_branch_gradient(r, cells[j]);
+    if (j != 13) runner_dopair1_branch_gradient(r, cells[13], cells[j]);
+  }
+  for (int j = 0; j < 27; ++j) runner_do_extra_ghost(r, cells[j], 0);
+#endif
+}
+
+/* And go... */
+int main(int argc, char *argv[]) {
+
+#ifdef HAVE_SETAFFINITY
+  engine_pin();
+#endif
+
+  size_t runs = 100, particles = 8;
+  double h = 1.2348, h_pert = 0., perturbation = 0.1, rho = 1.;
+  double active_frac = 1.;
+  int mesh_size = 64;
+  char outputFileName[200] = "";
+
+  /* Initialize CPU frequency, this also starts time. */
+  unsigned long long cpufreq = 0;
+  clocks_set_cpufreq(cpufreq);
+
+  /* Get some randomness going */
+  srand(0);
+
+  char c;
+  while ((c = getopt(argc, argv, "n:r:h:p:d:m:a:g:o:")) != -1) {
+    switch (c) {
+      case 'n':
+        sscanf(optarg, "%zu", &particles);
+        break;
+      case 'r':
+        sscanf(optarg, "%zu", &runs);
+        break;
+      case 'h':
+        sscanf(optarg, "%lf", &h);
+        break;
+      case 'p':
+        sscanf(optarg, "%lf", &h_pert);
+        break;
+      case 'd':
+        sscanf(optarg, "%lf", &perturbation);
+        break;
+      case 'm':
+        sscanf(optarg, "%lf", &rho);
+        break;
+      case 'a':
+        sscanf(optarg, "%lf", &active_frac);
+        break;
+      case 'g':
+        sscanf(optarg, "%d", &mesh_size);
+        break;
+      case 'o':
+        strcpy(outputFileName, optarg);
+        break;
+      case '?':
+        error("Unknown option.");
+        break;
+    }
+  }
+
+  if (h <= 0. || particles == 0 || runs == 0 || active_frac <= 0. ||
+      active_frac > 1. || mesh_size <= 0) {
+    printf(
+        "\nUsage: %s [OPTIONS...]\n"
+        "\nTimes the particle interaction kernels of this build on synthetic"
+        "\ncells and writes the results as CSV."
+        "\n\nOptions:"
+        "\n-n PARTICLES=8     - Particles per axis in each cell"
+        "\n-r RUNS=100        - Number of runs to average over"
+        "\n-h DISTANCE=1.2348 - Smoothing length in units of <x>"
+        "\n-p h_pert          - Random fractional change in h, h=h*random(1,p)"
+        "\n-d pert=0.1        - Perturbation to apply to the particles [0,1["
+        "\n-m rho=1           - Physical density in the cells"
+        "\n-a fraction=1      - Fraction of active particles ]0,1]"
+        "\n-g N=64            - Size of the mesh for the CIC assignment"
+        "\n-o fileName        - Write the results to this file instead of "
+        "stdout\n",
+        argv[0]);
+    exit(1);
+  }
+
+  const double size = 1.;
+
+  /* Build the infrastructure */
+  struct space space;
+  bzero(&space, sizeof(struct space));
+  space.periodic = 0;
+  space.dim[0] = 3. * size;
+  space.dim[1] = 3. * size;
+  space.dim[2] = 3. * size;
+
+  struct hydro_props hp;
+  hydro_props_init_no_hydro(&hp);
+  hp.eta_neighbours = h;
+  hp.h_tolerance = 1e0;
+  hp.h_max = FLT_MAX;
+  hp.h_min = 0.f;
+  hp.max_smoothing_iterations = 10;
+  hp.CFL_condition = 0.1;
+
+  struct gravity_props gp;
+  bzero(&gp, sizeof(struct gravity_props));
+  gp.theta_crit = 0.7;
+  gp.theta_crit2 = gp.theta_crit * gp.theta_crit;
+  gp.theta_crit_inv = 1. / gp.theta_crit;
+  gp.epsilon_cur = 0.05 * size / particles;
+  gp.epsilon_cur2 = gp.epsilon_cur * gp.epsilon_cur;
+  gp.epsilon_cur_inv = 1.f / gp.epsilon_cur;
+  gp.epsilon_cur_inv3 = gp.epsilon_cur_inv * gp.epsilon_cur_inv *
+                        gp.epsilon_cur_inv;
+
+  struct pm_mesh mesh;
+  bzero(&mesh, sizeof(struct pm_mesh));
+  mesh.periodic = 0;
+  mesh.dim[0] = 100. * size;
+  mesh.dim[1] = 100. * size;
+  mesh.dim[2] = 100. * size;
+  mesh.r_s = FLT_MAX;
+  mesh.r_s_inv = 0.;
+  mesh.r_cut_min = 0.;
+  mesh.r_cut_max = FLT_MAX;
+
+  struct cosmology cosmo;
+  cosmology_init_no_cosmo(&cosmo);
+
+  struct chemistry_global_data chemistry;
+  bzero(&chemistry, sizeof(struct chemistry_global_data));
+  struct star_formation star_formation;
+  bzero(&star_formation, sizeof(struct star_formation));
+
+  struct engine engine;
+  bzero(&engine, sizeof(struct engine));
+  engine.s = &space;
+  engine.time = 0.1f;
+  engine.time_base = 1e-3;
+  engine.ti_current = 8;
+  engine.max_active_bin = get_max_active_bin(engine.ti_current);
+  engine.hydro_properties = &hp;
+  engine.gravity_properties = &gp;
+  engine.mesh = &mesh;
+  engine.cosmology = &cosmo;
+  engine.chemistry = &chemistry;
+  engine.star_formation = &star_formation;
+  engine.nodeID = NODE_ID;
+
+  struct runner runner;
+  bzero(&runner, sizeof(struct runner));
+  runner.e = &engine;
+
+  /* Construct a 3x3x3 block of gas cells */
+  struct cell *cells[27];
+  long long partId = 0;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      for (int k = 0; k < 3; ++k) {
+        const double offset[3] = {i * size, j * size, k * size};
+        cells[i * 9 + j * 3 + k] = make_hydro_cell(
+            particles, offset, size, h, h_pert, perturbation, rho, &partId);
+      }
+    }
+  }
+  struct cell *main_cell = cells[13];
+
+#ifdef WITH_VECTORIZATION
+  cache_init(&runner.ci_cache, main_cell->hydro.count);
+  cache_init(&runner.cj_cache, main_cell->hydro.count);
+#endif
+
+  /* Prepare all the particles for a force loop with everybody active, such
+   * that the inactive particles hold valid data as well. */
+  for (int j = 0; j < 27; ++j) {
+    set_active_hydro(cells[j], 1.);
+    runner_do_hydro_sort(&runner, cells[j], 0x1FFF, 0, 0);
+  }
+  prepare_force(&runner, cells);
+  for (int j = 0; j < 27; ++j) {
+    for (int k = 0; k < cells[j]->hydro.count; k++)
+      hydro_convert_quantities(&cells[j]->hydro.parts[k],
+                               &cells[j]->hydro.xparts[k], &cosmo, &hp);
+  }
+  prepare_force(&runner, cells);
+
+  /* Now only keep the requested fraction active */
+  for (int j = 0; j < 27; ++j) set_active_hydro(cells[j], active_frac);
+
+  /* The active particles of the main cell for the subset loops */
+  int *pid = (int *)malloc(sizeof(int) * main_cell->hydro.count);
+  if (pid == NULL) error("Can't allocate memory for pid.");
+  int pid_count = 0;
+  for (int k = 0; k < main_cell->hydro.count; k++)
+    if (part_is_active(&main_cell->hydro.parts[k], &engine))
+      pid[pid_count++] = k;
+
+  /* Construct the gravity cells: two neighbours and a distant one. */
+  const double offset_i[3] = {0., 0., 0.};
+  const double offset_j[3] = {size, 0., 0.};
+  const double offset_far[3] = {10. * size, 10. * size, 10. * size};
+  struct cell *ci_grav = make_grav_cell(particles, offset_i, size,
+                                        perturbation, rho, active_frac, &partId);
+  struct cell *cj_grav = make_grav_cell(particles, offset_j, size,
+                                        perturbation, rho, active_frac, &partId);
+  struct cell *cf_grav = make_grav_cell(particles, offset_far, size,
+                                        perturbation, rho, active_frac, &partId);
+  gravity_cache_init(&runner.ci_gravity_cache, ci_grav->grav.count);
+  gravity_cache_init(&runner.cj_gravity_cache, ci_grav->grav.count);
+
+#ifdef HAVE_FFTW
+  const double mesh_dim[3] = {2. * size, size, size};
+  double *rho_mesh = NULL;
+  if ((rho_mesh = (double *)calloc(
+           (size_t)mesh_size * mesh_size * mesh_size, sizeof(double))) == NULL)
+    error("Can't allocate memory for the CIC mesh.");
+#endif
+
+  /* Count the work done by each kernel */
+  long long density_pair_work = 0, force_pair_work = 0,
+            density_subset_work = 0;
+  for (int j = 0; j < 27; ++j) {
+    if (j == 13) continue;
+    density_pair_work += count_hydro_interactions(main_cell, cells[j], &engine,
+                                                  /*symmetric_h=*/0) +
+                         count_hydro_interactions(cells[j], main_cell, &engine,
+                                                  /*symmetric_h=*/0);
+    force_pair_work += count_hydro_interactions(main_cell, cells[j], &engine,
+                                                /*symmetric_h=*/1) +
+                       count_hydro_interactions(cells[j], main_cell, &engine,
+                                                /*symmetric_h=*/1);
+    density_subset_work += count_hydro_interactions(main_cell, cells[j],
+                                                    &engine, /*symmetric_h=*/0);
+  }
+  const int gcount_i = ci_grav->grav.count, gcount_j = cj_grav->grav.count;
+  const int gactive_i = count_active_gparts(ci_grav, &engine);
+  const int gactive_j = count_active_gparts(cj_grav, &engine);
+
+  enum {
+    bench_sort,
+    bench_self_density,
+    bench_pair_density,
+    bench_self_subset_density,
+    bench_pair_subset_density,
+    bench_ghost,
+    bench_self_force,
+    bench_pair_force,
+    bench_self_grav_pp,
+    bench_pair_grav_pp,
+    bench_m2p,
+    bench_m2l,
+    bench_cic,
+    bench_count
+  };
+
+  struct bench_timing timings[bench_count] = {
+      {"sort", "particles", main_cell->hydro.count, 0},
+      {"self_density", "interactions",
+       count_hydro_interactions(main_cell, main_cell, &engine, 0), 0},
+      {"pair_density", "interactions", density_pair_work, 0},
+      {"self_subset_density", "interactions",
+       count_hydro_interactions(main_cell, main_cell, &engine, 0), 0},
+      {"pair_subset_density", "interactions", density_subset_work, 0},
+      {"ghost", "particles", pid_count, 0},
+      {"self_force", "interactions",
+       count_hydro_interactions(main_cell, main_cell, &engine, 1), 0},
+      {"pair_force", "interactions", force_pair_work, 0},
+      {"self_grav_pp", "interactions", (long long)gactive_i * (gcount_i - 1),
+       0},
+      {"pair_grav_pp", "interactions",
+       (long long)gactive_i * gcount_j + (long long)gactive_j * gcount_i, 0},
+      {"m2p", "interactions", gactive_i, 0},
+      {"m2l", "interactions", NUM_M2L, 0},
+#ifdef HAVE_FFTW
+      {"cic", "particles", gcount_i + gcount_j, 0},
+#else
+      {"cic", "particles", 0, 0},
+#endif
+  };
+
+  for (size_t n = 0; n < runs; ++n) {
+
+    ticks tic;
+
+    /* Sort the main cell from scratch */
+    cell_free_hydro_sorts(main_cell);
+    main_cell->hydro.sorted = 0;
+    tic = getticks();
+    runner_do_hydro_sort(&runner, main_cell, 0x1FFF, 0, 0);
+    timings[bench_sort].time += getticks() - tic;
+
+    /* Density loop */
+    for (int j = 0; j < 27; ++j) init_active_parts(cells[j], &engine);
+
+    tic = getticks();
+    runner_doself1_branch_density(&runner, main_cell);
+    timings[bench_self_density].time += getticks() - tic;
+
+    tic = getticks();
+    for (int j = 0; j < 27; ++j)
+      if (j != 13) runner_dopair1_branch_density(&runner, main_cell, cells[j]);
+    timings[bench_pair_density].time += getticks() - tic;
+
+    /* The neighbours need the rest of their density loop for the ghost */
+    for (int j = 0; j < 27; ++j)
+      if (j != 13) runner_doself1_branch_density(&runner, cells[j]);
+
+    /* Ghost */
+    tic = getticks();
+    runner_do_ghost(&runner, main_cell, 0);
+    timings[bench_ghost].time += getticks() - tic;
+
+    for (int j = 0; j < 27; ++j)
+      if (j != 13) runner_do_ghost(&runner, cells[j], 0);
+
+#ifdef EXTRA_HYDRO_LOOP
+    for (int j = 0; j < 27; ++j) {
+      runner_doself1_branch_gradient(&runner, cells[j]);
+      if (j != 13)
+        runner_dopair1_branch_gradient(&runner, main_cell, cells[j]);
+    }
+    for (int j = 0; j < 27; ++j) runner_do_extra_ghost(&runner, cells[j], 0);
+#endif
+
+    /* Force loop */
+    tic = getticks();
+    runner_doself2_branch_force(&runner, main_cell);
+    timings[bench_self_force].time += getticks() - tic;
+
+    tic = getticks();
+    for (int j = 0; j < 27; ++j)
+      if (j != 13) runner_dopair2_branch_force(&runner, main_cell, cells[j]);
+    timings[bench_pair_force].time += getticks() - tic;
+
+    /* Density loops over the subset of active particles, as used by the
+     * ghost to re-compute the density of particles whose h changed */
+    init_active_parts(main_cell, &engine);
+
+    tic = getticks();
+    runner_doself_subset_branch_density(&runner, main_cell,
+                                        main_cell->hydro.parts, pid, pid_count);
+    timings[bench_self_subset_density].time += getticks() - tic;
+
+    tic = getticks();
+    for (int j = 0; j < 27; ++j)
+      if (j != 13)
+        runner_dopair_subset_branch_density(&runner, main_cell,
+                                            main_cell->hydro.parts, pid,
+                                            pid_count, cells[j]);
+    timings[bench_pair_subset_density].time += getticks() - tic;
+
+    /* Gravity particle-particle interactions */
+    for (int k = 0; k < gcount_i; k++)
+      gravity_init_gpart(&ci_grav->grav.parts[k]);
+    for (int k = 0; k < gcount_j; k++)
+      gravity_init_gpart(&cj_grav->grav.parts[k]);
+
+    tic = getticks();
+    runner_doself_grav_pp(&runner, ci_grav);
+    timings[bench_self_grav_pp].time += getticks() - tic;
+
+    tic = getticks();
+    runner_dopair_grav_pp(&runner, ci_grav, cj_grav, /*symmetric=*/1,
+                          /*allow_mpole=*/0);
+    timings[bench_pair_grav_pp].time += getticks() - tic;
+
+    /* Multipole-particle interactions with the distant cell */
+    tic = getticks();
+    runner_dopair_grav_pp(&runner, ci_grav, cf_grav, /*symmetric=*/0,
+                          /*allow_mpole=*/1);
+    timings[bench_m2p].time += getticks() - tic;
+
+    /* Multipole-multipole interactions */
+    struct grav_tensor l;
+    bzero(&l, sizeof(struct grav_tensor));
+    const double dim[3] = {mesh.dim[0], mesh.dim[1], mesh.dim[2]};
+    tic = getticks();
+    for (int k = 0; k < NUM_M2L; k++) {
+      gravity_M2L_nonsym(&l, &cf_grav->grav.multipole->m_pole,
+                         ci_grav->grav.multipole->CoM,
+                         cf_grav->grav.multipole->CoM, &gp, /*periodic=*/0,
+                         dim, /*rs_inv=*/0.f);
+
+      /* Stop the compiler from merging or dropping the repeated calls */
+      __asm__ __volatile__("" : : "g"(&l) : "memory");
+    }
+    timings[bench_m2l].time += getticks() - tic;
+
+#ifdef HAVE_FFTW
+    /* Mesh assignment */
+    tic = getticks();
+    cell_gpart_to_mesh_CIC(ci_grav, rho_mesh, mesh_size,
+                           mesh_size / mesh_dim[0], mesh_dim);
+    cell_gpart_to_mesh_CIC(cj_grav, rho_mesh, mesh_size,
+                           mesh_size / mesh_dim[0], mesh_dim);
+    timings[bench_cic].time += getticks() - tic;
+#endif
+  }
+
+  /* Output the results */
+  FILE *file = stdout;
+  if (strlen(outputFileName) > 0 && (file = fopen(outputFileName, "w")) == NULL)
+    error("Could not open the output file '%s'.", outputFileName);
+
+  fprintf(file, "# Hydro implementation: %s\n", SPH_IMPLEMENTATION);
+  fprintf(file, "# Hydro kernel: %s\n", kernel_name);
+  fprintf(file, "# Gravity implementation: %s\n", GRAVITY_IMPLEMENTATION);
+#ifdef WITH_VECTORIZATION
+  fprintf(file, "# Vectorisation: yes (vector size %d)\n", VEC_SIZE);
+#else
+  fprintf(file, "# Vectorisation: no\n");
+#endif
+  fprintf(file,
+          "# Particles per cell: %zu, h: %g, h_pert: %g, pert: %g, rho: %g, "
+          "active fraction: %g, mesh size: %d, runs: %zu\n",
+          particles * particles * particles, h, h_pert, perturbation, rho,
+          active_frac, mesh_size, runs);
+  fprintf(file, "kernel,unit,work_per_run,ns_per_run,ns_per_unit,units_per_s\n");
+  for (int k = 0; k < bench_count; k++) {
+    if (timings[k].work == 0) continue;
+    const double ns_per_run =
+        clocks_from_ticks(timings[k].time) * 1e6 / runs;
+    const double ns_per_unit = ns_per_run / timings[k].work;
+    fprintf(file, "%s,%s,%lld,%.1f,%.4f,%.6e\n", timings[k].name,
+            timings[k].unit, timings[k].work, ns_per_run, ns_per_unit,
+            1e9 / ns_per_unit);
+  }
+  if (file != stdout) fclose(file);
+
+  /* Be clean */
+  for (int j = 0; j < 27; ++j) clean_up(cells[j]);
+  clean_up(ci_grav);
+  clean_up(cj_grav);
+  clean_up(cf_grav);
+  free(pid);
+#ifdef HAVE_FFTW
+  free(rho_mesh);
+#endif
+  gravity_cache_clean(&runner.ci_gravity_cache);
+  gravity_cache_clean(&runner.cj_gravity_cache);
+#ifdef WITH_VECTORIZATION
+  cache_clean(&runner.ci_cache);
+  cache_clean(&runner.cj_cache);
+#endif
+
+  return 0;
+}
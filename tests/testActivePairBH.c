@@ -0,0 +1,391 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2019 The SWIFT Collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "../config.h"
+
+/* Some standard headers. */
+#include <fenv.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Local headers. */
+#include "black_holes.h"
+#include "swift.h"
+
+#define NODE_ID 0
+
+/* Relative tolerance on the neighbour counts. */
+#define TOLERANCE 1e-5
+
+/**
+ * @brief Constructs a cell with gas particles on a perturbed grid and black
+ * holes at random positions, in a valid state prior to a BH DOPAIR.
+ *
+ * @param n The cube root of the number of #part.
+ * @param bcount The number of #bpart.
+ * @param offset The position of the cell offset from (0,0,0).
+ * @param size The cell size.
+ * @param h The smoothing length of the #part in units of the inter-particle
+ * separation.
+ * @param h_bh The maximal smoothing length of the #bpart in units of the
+ * cell size.
+ * @param partId The running counter of IDs.
+ * @param fraction_active The fraction of #bpart that should be active.
+ */
+struct cell *make_cell(size_t n, int bcount, double *offset, double size,
+                       double h, double h_bh, long long *partId,
+                       double fraction_active) {
+
+  const size_t count = n * n * n;
+  struct cell *cell = NULL;
+  if (posix_memalign((void **)&cell, SWIFT_STRUCT_ALIGNMENT,
+                     sizeof(struct cell)) != 0)
+    error("couldn't allocate cell");
+  bzero(cell, sizeof(struct cell));
+
+  if (posix_memalign((void **)&cell->hydro.parts, part_align,
+                     count * sizeof(struct part)) != 0)
+    error("couldn't allocate particles, no. of particles: %d", (int)count);
+  if (posix_memalign((void **)&cell->hydro.xparts, xpart_align,
+                     count * sizeof(struct xpart)) != 0)
+    error("couldn't allocate particles, no. of particles: %d", (int)count);
+  if (posix_memalign((void **)&cell->black_holes.parts, bpart_align,
+                     bcount * sizeof(struct bpart)) != 0)
+    error("couldn't allocate particles, no. of particles: %d", bcount);
+  bzero(cell->hydro.parts, count * sizeof(struct part));
+  bzero(cell->hydro.xparts, count * sizeof(struct xpart));
+  bzero(cell->black_holes.parts, bcount * sizeof(struct bpart));
+
+  /* Construct the parts */
+  float h_max = 0.f;
+  struct part *part = cell->hydro.parts;
+  for (size_t x = 0; x < n; ++x) {
+    for (size_t y = 0; y < n; ++y) {
+      for (size_t z = 0; z < n; ++z) {
+        part->x[0] =
+            offset[0] + size * (x + 0.5 + random_uniform(-0.4, 0.4)) / n;
+        part->x[1] =
+            offset[1] + size * (y + 0.5 + random_uniform(-0.4, 0.4)) / n;
+        part->x[2] =
+            offset[2] + size * (z + 0.5 + random_uniform(-0.4, 0.4)) / n;
+        part->h = size * h / n;
+        h_max = fmaxf(h_max, part->h);
+        part->id = ++(*partId);
+        part->time_bin = 1;
+#ifdef SWIFT_DEBUG_CHECKS
+        part->ti_drift = 8;
+        part->ti_kick = 8;
+#endif
+        ++part;
+      }
+    }
+  }
+
+  /* Construct the bparts */
+  float bh_h_max = 0.f;
+  for (int k = 0; k < bcount; ++k) {
+    struct bpart *bp = &cell->black_holes.parts[k];
+    for (int i = 0; i < 3; i++)
+      bp->x[i] = offset[i] + size * random_uniform(0., 1.);
+    bp->h = size * h_bh * random_uniform(0.1, 1.);
+    bh_h_max = fmaxf(bh_h_max, bp->h);
+    bp->id = ++(*partId);
+
+    /* Set the time-bin */
+    if (random_uniform(0., 1.) < fraction_active)
+      bp->time_bin = 1;
+    else
+      bp->time_bin = num_time_bins + 1;
+
+#ifdef SWIFT_DEBUG_CHECKS
+    bp->ti_drift = 8;
+    bp->ti_kick = 8;
+#endif
+  }
+
+  /* Cell properties */
+  cell->split = 0;
+  cell->hydro.h_max = h_max;
+  cell->hydro.count = count;
+  cell->black_holes.h_max = bh_h_max;
+  cell->black_holes.count = bcount;
+  for (int i = 0; i < 3; i++) {
+    cell->width[i] = size;
+    cell->loc[i] = offset[i];
+  }
+  cell->dmin = size;
+
+  cell->hydro.ti_old_part = 8;
+  cell->hydro.ti_end_min = 8;
+  cell->hydro.ti_end_max = 8;
+  cell->black_holes.ti_old_part = 8;
+  cell->black_holes.ti_end_min = 8;
+  cell->black_holes.ti_end_max = 8;
+  cell->nodeID = NODE_ID;
+  cell->super = cell;
+  cell->hydro.super = cell;
+
+  shuffle_particles(cell->hydro.parts, cell->hydro.count);
+
+  cell->hydro.sorted = 0;
+  for (int k = 0; k < 13; k++) cell->hydro.sort[k] = NULL;
+
+  return cell;
+}
+
+void clean_up(struct cell *c) {
+  cell_free_hydro_sorts(c);
+  free(c->hydro.parts);
+  free(c->hydro.xparts);
+  free(c->black_holes.parts);
+  free(c);
+}
+
+/**
+ * @brief Resets the density fields of all the #bpart of a cell.
+ */
+void zero_bparts_density(struct cell *c) {
+  for (int k = 0; k < c->black_holes.count; k++)
+    black_holes_init_bpart(&c->black_holes.parts[k]);
+}
+
+/**
+ * @brief Copies the neighbour counts of all the #bpart of a cell.
+ */
+void save_bparts_density(const struct cell *c, float *wcount) {
+  for (int k = 0; k < c->black_holes.count; k++)
+    wcount[k] = c->black_holes.parts[k].density.wcount;
+}
+
+/**
+ * @brief Compares the neighbour counts of the #bpart of a cell with the
+ * reference ones.
+ *
+ * @return The number of #bpart whose counts differ.
+ */
+int check_bparts_density(const struct cell *c, const float *wcount_ref,
+                         const char *name) {
+  int errors = 0;
+  for (int k = 0; k < c->black_holes.count; k++) {
+    const float w = c->black_holes.parts[k].density.wcount;
+    const float w_ref = wcount_ref[k];
+    if (fabsf(w - w_ref) > TOLERANCE * fabsf(w_ref)) {
+      message("%s: bpart %lld has wcount=%e, brute force gives %e", name,
+              c->black_holes.parts[k].id, w, w_ref);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+/* Just a forward declaration... */
+void runner_dopair_branch_bh_density(struct runner *r, struct cell *ci,
+                                     struct cell *cj);
+void runner_dopair_bh_naive_density(struct runner *r, struct cell *ci,
+                                    struct cell *cj, int timer);
+void runner_dopair_subset_branch_bh_density(struct runner *r, struct cell *ci,
+                                            struct bpart *bparts_i, int *ind,
+                                            int bcount, struct cell *cj);
+void runner_dopair_subset_bh_naive_density(struct runner *r, struct cell *ci,
+                                           struct bpart *bparts_i, int *ind,
+                                           const int bcount, struct cell *cj,
+                                           const double *shift);
+
+/**
+ * @brief Interacts the BHs of a pair of cells with the gas using the sorted
+ * and brute-force versions of the pair and subset functions and compares the
+ * results.
+ *
+ * @return The number of #bpart whose results differ.
+ */
+int test_pair_interactions(struct runner *r, struct cell *ci,
+                           struct cell *cj) {
+
+  int errors = 0;
+  const int bcount_i = ci->black_holes.count;
+  const int bcount_j = cj->black_holes.count;
+  float *wcount_i = (float *)malloc(bcount_i * sizeof(float));
+  float *wcount_j = (float *)malloc(bcount_j * sizeof(float));
+  int *ind = (int *)malloc(bcount_i * sizeof(int));
+
+  runner_do_hydro_sort(r, ci, 0x1FFF, 0, 0);
+  runner_do_hydro_sort(r, cj, 0x1FFF, 0, 0);
+
+  /* Brute-force pair */
+  zero_bparts_density(ci);
+  zero_bparts_density(cj);
+  runner_dopair_bh_naive_density(r, ci, cj, 1);
+  save_bparts_density(ci, wcount_i);
+  save_bparts_density(cj, wcount_j);
+
+  /* Sorted pair */
+  zero_bparts_density(ci);
+  zero_bparts_density(cj);
+  runner_dopair_branch_bh_density(r, ci, cj);
+  errors += check_bparts_density(ci, wcount_i, "pair (ci)");
+  errors += check_bparts_density(cj, wcount_j, "pair (cj)");
+
+  /* Collect the active BHs of ci */
+  int count = 0;
+  for (int k = 0; k < bcount_i; k++)
+    if (bpart_is_active(&ci->black_holes.parts[k], r->e)) ind[count++] = k;
+
+  if (count > 0) {
+
+    /* Brute-force subset (the cells are not periodically wrapped) */
+    const double shift[3] = {0., 0., 0.};
+    zero_bparts_density(ci);
+    runner_dopair_subset_bh_naive_density(r, ci, ci->black_holes.parts, ind,
+                                          count, cj, shift);
+    save_bparts_density(ci, wcount_i);
+
+    /* Sorted subset */
+    zero_bparts_density(ci);
+    runner_dopair_subset_branch_bh_density(r, ci, ci->black_holes.parts, ind,
+                                           count, cj);
+    errors += check_bparts_density(ci, wcount_i, "subset");
+  }
+
+  free(wcount_i);
+  free(wcount_j);
+  free(ind);
+  return errors;
+}
+
+int main(int argc, char *argv[]) {
+  size_t particles = 6;
+  int bcount = 20;
+  double h = 1.23485, h_bh = 0.8, size = 1., fraction_active = 0.8;
+  struct space space;
+  struct engine engine;
+  struct cosmology cosmo;
+  struct runner *runner;
+  char c;
+  static long long partId = 0;
+
+  /* Initialize CPU frequency, this also starts time. */
+  unsigned long long cpufreq = 0;
+  clocks_set_cpufreq(cpufreq);
+
+/* Choke on FP-exceptions */
+#ifdef HAVE_FE_ENABLE_EXCEPT
+  feenableexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW);
+#endif
+
+  /* Generate a RNG seed from time. */
+  unsigned int seed = time(NULL);
+
+  while ((c = getopt(argc, argv, "h:b:n:m:a:s:")) != -1) {
+    switch (c) {
+      case 'h':
+        sscanf(optarg, "%lf", &h);
+        break;
+      case 'b':
+        sscanf(optarg, "%lf", &h_bh);
+        break;
+      case 'n':
+        sscanf(optarg, "%zu", &particles);
+        break;
+      case 'm':
+        sscanf(optarg, "%d", &bcount);
+        break;
+      case 'a':
+        sscanf(optarg, "%lf", &fraction_active);
+        break;
+      case 's':
+        sscanf(optarg, "%u", &seed);
+        break;
+      case '?':
+        printf(
+            "\nUsage: %s [OPTIONS...]\n"
+            "\nGenerates a cell and each of its 26 neighbours, filled with gas"
+            "\non a perturbed grid and with randomly placed black holes."
+            "\nThe BH density loop is then run with the sorted and the"
+            "\nbrute-force pair functions and the results are compared."
+            "\n\nOptions:"
+            "\n-n PARTICLES=6     - cube root of the number of gas particles"
+            "\n-m BHS=20          - number of black holes per cell"
+            "\n-h DISTANCE=1.2348 - gas smoothing length"
+            "\n-b DISTANCE=0.8    - max. BH smoothing length (cell size units)"
+            "\n-a FRACTION=0.8    - fraction of active black holes"
+            "\n-s seed            - seed for RNG\n",
+            argv[0]);
+        exit(1);
+    }
+  }
+
+  /* Seed RNG. */
+  message("Seed used for RNG: %d", seed);
+  srand(seed);
+
+  bzero(&space, sizeof(struct space));
+  space.periodic = 0;
+  space.dim[0] = 3.;
+  space.dim[1] = 3.;
+  space.dim[2] = 3.;
+
+  bzero(&engine, sizeof(struct engine));
+  engine.s = &space;
+  engine.time = 0.1f;
+  engine.ti_current = 8;
+  engine.max_active_bin = num_time_bins;
+  engine.nodeID = NODE_ID;
+
+  cosmology_init_no_cosmo(&cosmo);
+  engine.cosmology = &cosmo;
+
+  if (posix_memalign((void **)&runner, SWIFT_STRUCT_ALIGNMENT,
+                     sizeof(struct runner)) != 0)
+    error("couldn't allocate runner");
+  bzero(runner, sizeof(struct runner));
+  runner->e = &engine;
+
+  /* Interact the central cell with each of its neighbours, in both orders
+   * to exercise both directions of the sorted lists. */
+  int errors = 0;
+  double offset_i[3] = {1., 1., 1.};
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      for (int k = 0; k < 3; k++) {
+        if (i == 1 && j == 1 && k == 1) continue;
+
+        double offset_j[3] = {i * size, j * size, k * size};
+        struct cell *ci = make_cell(particles, bcount, offset_i, size, h, h_bh,
+                                    &partId, fraction_active);
+        struct cell *cj = make_cell(particles, bcount, offset_j, size, h, h_bh,
+                                    &partId, fraction_active);
+
+        errors += test_pair_interactions(runner, ci, cj);
+        errors += test_pair_interactions(runner, cj, ci);
+
+        clean_up(ci);
+        clean_up(cj);
+      }
+    }
+  }
+
+  free(runner);
+
+  if (errors) error("%d black hole neighbour counts differ!", errors);
+  message("All black hole neighbour counts agree.");
+
+  return 0;
+}
@@ -28,10 +28,10 @@
 /* Local includes */
 #include "swift.h"
 
-/* Other schemes need to be added here if they are not vectorized, otherwise
- * this test will simply not compile. */
+/* Only the schemes declaring vectorised loops in part.h are tested here,
+ * otherwise this test will simply not compile. */
 
-#if defined(GADGET2_SPH) && defined(WITH_VECTORIZATION)
+#if defined(HYDRO_VEC_DENSITY) && defined(WITH_VECTORIZATION)
 
 #define array_align sizeof(float) * VEC_SIZE
 #define ACC_THRESHOLD 1e-5
@@ -414,6 +414,8 @@ void test_interactions(struct part test_part, struct part *parts, size_t count,
   message("Speed up: %15fx.", (double)(serial_time) / vec_time);
 }
 
+#ifdef HYDRO_VEC_FORCE
+
 /*
  * @brief Calls the serial and vectorised version of the non-symmetrical force
  * interaction.
@@ -686,6 +688,8 @@ void test_force_interactions(struct part test_part, struct part *parts,
   message("Speed up: %15fx.", (double)(serial_time) / vec_time);
 }
 
+#endif /* HYDRO_VEC_FORCE */
+
 /* And go... */
 int main(int argc, char *argv[]) {
   size_t runs = 10000;
@@ -748,12 +752,14 @@ int main(int argc, char *argv[]) {
   test_interactions(test_particle, &particles[1], count - 1, IACT_NAME, runs,
                     2);
 
+#ifdef HYDRO_VEC_FORCE
   prepare_force(particles, count);
 
   test_force_interactions(test_particle, &particles[1], count - 1,
                           "test_nonsym_force", runs, 1);
   test_force_interactions(test_particle, &particles[1], count - 1,
                           "test_nonsym_force", runs, 2);
+#endif
 
   return 0;
 }
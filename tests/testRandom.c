@@ -57,6 +57,121 @@ double pearsonfunc(double mean1, double mean2, double total12, double var1,
   return fabs(correlation);
 }
 
+/**
+ * @brief Check the Philox generator against the known-answer vectors of its
+ * reference implementation (Random123).
+ *
+ * @return 0 if the generator reproduces the vectors, 1 otherwise.
+ */
+int check_known_answers(void) {
+
+  const uint32_t ctr_in[3][4] = {
+      {0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+      {0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu},
+      {0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}};
+  const uint32_t key_in[3][2] = {{0x00000000u, 0x00000000u},
+                                 {0xffffffffu, 0xffffffffu},
+                                 {0xa4093822u, 0x299f31d0u}};
+  const uint32_t expected[3][4] = {
+      {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u},
+      {0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu},
+      {0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}};
+
+  for (int i = 0; i < 3; ++i) {
+    uint32_t ctr[4] = {ctr_in[i][0], ctr_in[i][1], ctr_in[i][2], ctr_in[i][3]};
+    random_philox4x32(ctr, key_in[i]);
+
+    for (int j = 0; j < 4; ++j) {
+      if (ctr[j] != expected[i][j]) {
+        message("Known-answer test %d failed: word %d is %08x instead of %08x",
+                i, j, ctr[j], expected[i][j]);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Check that the batched generator reproduces the scalar one, that
+ * its output is uniform (chi-square test over equal-size bins) and report the
+ * time spent per number by both.
+ *
+ * @param ti_current The time on the time-line to use.
+ * @return 0 if everything is fine, 1 otherwise.
+ */
+int check_batched_generator(const integertime_t ti_current) {
+
+  const int count = 10000000;
+  const int num_bins = 100;
+
+  long long* ids = (long long*)malloc(count * sizeof(long long));
+  double* r = (double*)malloc(count * sizeof(double));
+  if (ids == NULL || r == NULL) error("Failed to allocate test arrays");
+
+  /* Consecutive IDs starting from a random one */
+  const long long first_id = rand() * (1LL << 31) + rand();
+  for (int i = 0; i < count; ++i) ids[i] = first_id + i;
+  bzero(r, count * sizeof(double));
+
+  ticks tic = getticks();
+  random_unit_interval_array(ids, count, ti_current, random_number_BH_swallow,
+                             r);
+  const double time_batch = clocks_from_ticks(getticks() - tic);
+
+  /* Compare with the scalar version */
+  tic = getticks();
+  double sum = 0.;
+  for (int i = 0; i < count; ++i)
+    sum += random_unit_interval(ids[i], ti_current, random_number_BH_swallow);
+  const double time_scalar = clocks_from_ticks(getticks() - tic);
+
+  double sum_batch = 0.;
+  for (int i = 0; i < count; ++i) {
+    if (r[i] != random_unit_interval(ids[i], ti_current,
+                                     random_number_BH_swallow)) {
+      message("Batched and scalar numbers differ for id=%lld", ids[i]);
+      return 1;
+    }
+    sum_batch += r[i];
+  }
+  if (sum != sum_batch) error("Inconsistent sums!");
+
+  message("Time per number: scalar=%.3f ns batched=%.3f ns",
+          time_scalar * 1e6 / count, time_batch * 1e6 / count);
+
+  /* Chi-square test of uniformity */
+  int* bins = (int*)calloc(num_bins, sizeof(int));
+  if (bins == NULL) error("Failed to allocate bins");
+  for (int i = 0; i < count; ++i) {
+    if (r[i] < 0. || r[i] >= 1.) {
+      message("Number out of range: %e", r[i]);
+      return 1;
+    }
+    bins[(int)(r[i] * num_bins)]++;
+  }
+
+  const double expected = count / (double)num_bins;
+  double chi2 = 0.;
+  for (int i = 0; i < num_bins; ++i)
+    chi2 += (bins[i] - expected) * (bins[i] - expected) / expected;
+
+  /* Mean of chi2 is num_bins - 1 and its standard deviation is
+   * sqrt(2 * (num_bins - 1)). Allow for 6 standard deviations. */
+  const double dof = num_bins - 1;
+  message("Chi-square over %d bins: %f (expected %f +- %f)", num_bins, chi2,
+          dof, sqrt(2. * dof));
+  if (chi2 > dof + 6. * sqrt(2. * dof)) {
+    message("Batched numbers are not uniform!");
+    return 1;
+  }
+
+  free(bins);
+  free(ids);
+  free(r);
+  return 0;
+}
+
 /**
  * @brief Test to check that the pseodo-random numbers in SWIFT are random
  * enough for our purpose.
@@ -80,6 +195,10 @@ double pearsonfunc(double mean1, double mean2, double total12, double var1,
  * More information about the Pearson correlation coefficient can be found in
  * the function pearsonfunc above this function.
  *
+ * Before that, the generator is checked against known answers and the batched
+ * version against the scalar one (see check_known_answers() and
+ * check_batched_generator()).
+ *
  * @param argc Unused
  * @param argv Unused
  * @return 0 if everything is fine, 1 if random numbers are not random enough.
@@ -100,6 +219,13 @@ int main(int argc, char* argv[]) {
   message("Seed = %d", seed);
   srand(seed);
 
+  /* Check the generator itself */
+  if (check_known_answers()) return 1;
+
+  /* Check the batched version */
+  const integertime_t ti_test = rand() * (1LL << 31) + rand();
+  if (check_batched_generator(ti_test)) return 1;
+
   /* Time-step size */
   const int time_bin = 29;
 
@@ -0,0 +1,319 @@
+#!/usr/bin/env python
+
+################################################################################
+# This file is part of SWIFT.
+# Copyright (c) 2019 The SWIFT Collaboration
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published
+# by the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+"""
+Usage:
+    read_step_profile.py [options] step_profile.dat
+
+Read the per-step profile written by SWIFT (see src/step_profiler.c) and
+print, for each step, the time spent in the phases of the engine and how
+busy the runners were while the tasks ran. With --follow the file is watched
+and new steps are printed as the run writes them.
+
+The module can also be imported: read_step_profile() returns the records as
+numpy structured arrays.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import numpy as np
+
+MAGIC = b"SWIFT_STEP_PROF\x00"
+NAME_LENGTH = 16
+
+# Header: magic, version, nr_phases, nr_runners, nr_queues, nodeID,
+# record_size, cpufreq.
+HEADER_FORMAT = "=16s6id"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+
+# struct step_profiler_runner.
+RUNNER_DTYPE = np.dtype(
+    {
+        "names": ["busy", "queue_depth_sum", "nr_tasks", "queue_depth_max", "qid"],
+        "formats": ["u8", "i8", "i4", "i4", "i4"],
+        "offsets": [0, 8, 16, 20, 24],
+        "itemsize": 32,
+    }
+)
+
+
+def record_dtype(nr_phases, nr_runners, nr_queues, record_size):
+    """
+    The numpy type of one step record, following struct step_profiler_step.
+    """
+    offset_runners = 24 + 8 * nr_phases
+    offset_steals = offset_runners + RUNNER_DTYPE.itemsize * nr_runners
+    return np.dtype(
+        {
+            "names": [
+                "step",
+                "step_props",
+                "time",
+                "total",
+                "phases",
+                "runners",
+                "steals",
+            ],
+            "formats": [
+                "i4",
+                "i4",
+                "f8",
+                "u8",
+                ("u8", nr_phases),
+                (RUNNER_DTYPE, nr_runners),
+                ("i4", nr_queues),
+            ],
+            "offsets": [0, 4, 8, 16, 24, offset_runners, offset_steals],
+            "itemsize": record_size,
+        }
+    )
+
+
+def read_blocks(data):
+    """
+    Split the content of a profile file into its blocks (one per start or
+    restart of the run). Incomplete records at the end are left out.
+    """
+    blocks = []
+    offset = 0
+    while offset + HEADER_SIZE <= len(data):
+        (
+            magic,
+            version,
+            nr_phases,
+            nr_runners,
+            nr_queues,
+            nodeID,
+            record_size,
+            cpufreq,
+        ) = struct.unpack_from(HEADER_FORMAT, data, offset)
+        if magic != MAGIC:
+            raise ValueError("Corrupted step profile at byte %d" % offset)
+        if version != 1:
+            raise ValueError("Unsupported step profile version %d" % version)
+        offset += HEADER_SIZE
+
+        names = []
+        for k in range(nr_phases):
+            name = data[offset : offset + NAME_LENGTH]
+            names.append(name.split(b"\x00")[0].decode())
+            offset += NAME_LENGTH
+
+        # The records run until the next header or the end of the file.
+        end = data.find(MAGIC, offset)
+        while end != -1 and (end - offset) % record_size != 0:
+            end = data.find(MAGIC, end + 1)
+        if end == -1:
+            end = offset + (len(data) - offset) // record_size * record_size
+
+        dtype = record_dtype(nr_phases, nr_runners, nr_queues, record_size)
+        records = np.frombuffer(data[offset:end], dtype=dtype)
+        blocks.append(
+            {
+                "nodeID": nodeID,
+                "cpufreq": cpufreq,
+                "phases": names,
+                "nr_runners": nr_runners,
+                "nr_queues": nr_queues,
+                "records": records,
+            }
+        )
+        offset = end
+
+    return blocks
+
+
+def read_step_profile(filename):
+    """
+    Read a profile file. Returns the list of its blocks, each a dictionary with
+    the phase names, the CPU frequency and the records of the steps.
+    """
+    with open(filename, "rb") as f:
+        return read_blocks(f.read())
+
+
+def print_header(block):
+    phases = " ".join("%11s" % name for name in block["phases"])
+    print(
+        "# %6s %12s %11s %s %11s %6s %6s %6s %8s"
+        % (
+            "step",
+            "time",
+            "total",
+            phases,
+            "other",
+            "busy%",
+            "imbal%",
+            "steal%",
+            "depth",
+        )
+    )
+
+
+def print_steps(block, records):
+    """
+    One line per step: times in ms, then the mean busy fraction of the runners
+    while the tasks ran, the busy fraction of the idlest runner relative to the
+    mean, the fraction of the tasks that were stolen and the mean depth of the
+    queues the runners took tasks from.
+    """
+    to_ms = 1000.0 / block["cpufreq"]
+    launch = block["phases"].index("launch")
+    for rec in records:
+        phases = rec["phases"] * to_ms
+        total = rec["total"] * to_ms
+        other = total - phases.sum()
+
+        runners = rec["runners"]
+        nr_tasks = runners["nr_tasks"].sum()
+        if rec["phases"][launch] > 0:
+            busy = runners["busy"] / float(rec["phases"][launch])
+        else:
+            busy = np.zeros(len(runners))
+        mean_busy = busy.mean() if len(busy) > 0 else 0.0
+        imbalance = 1.0 - busy.min() / mean_busy if mean_busy > 0 else 0.0
+        steals = rec["steals"].sum() / float(nr_tasks) if nr_tasks > 0 else 0.0
+        depth = (
+            runners["queue_depth_sum"].sum() / float(nr_tasks) if nr_tasks > 0 else 0.0
+        )
+
+        print(
+            "  %6d %12.6e %11.3f %s %11.3f %6.1f %6.1f %6.1f %8.1f"
+            % (
+                rec["step"],
+                rec["time"],
+                total,
+                " ".join("%11.3f" % t for t in phases),
+                other,
+                100.0 * mean_busy,
+                100.0 * imbalance,
+                100.0 * steals,
+                depth,
+            )
+        )
+    sys.stdout.flush()
+
+
+def print_summary(block):
+    """
+    Time spent in each phase, per-runner ratios and per-queue steals, summed
+    over all the steps of a block.
+    """
+    records = block["records"]
+    if len(records) == 0:
+        return
+    to_ms = 1000.0 / block["cpufreq"]
+    launch = block["phases"].index("launch")
+    total = records["total"].sum() * to_ms
+    phases = records["phases"].sum(axis=0) * to_ms
+
+    print("# Summary of %d steps (rank %d)" % (len(records), block["nodeID"]))
+    print("#  %-12s %12s %7s" % ("phase", "time [ms]", "frac%"))
+    for name, t in zip(block["phases"], phases):
+        print("   %-12s %12.3f %7.2f" % (name, t, 100.0 * t / total))
+    other = total - phases.sum()
+    print("   %-12s %12.3f %7.2f" % ("other", other, 100.0 * other / total))
+    print("   %-12s %12.3f %7.2f" % ("total", total, 100.0))
+    print()
+
+    launch_ticks = float(records["phases"][:, launch].sum())
+    runners = records["runners"]
+    busy = runners["busy"].sum(axis=0)
+    nr_tasks = runners["nr_tasks"].sum(axis=0)
+    depth_sum = runners["queue_depth_sum"].sum(axis=0)
+    depth_max = runners["queue_depth_max"].max(axis=0)
+    qid = runners["qid"][-1]
+    steals = records["steals"].sum(axis=0)
+
+    print(
+        "#  %6s %4s %10s %7s %7s %7s %9s %9s"
+        % ("runner", "qid", "tasks", "busy%", "idle%", "steal%", "depth", "max_depth")
+    )
+    for k in range(block["nr_runners"]):
+        busy_frac = busy[k] / launch_ticks if launch_ticks > 0 else 0.0
+
+        # Steals are counted per queue, share them among the queue's runners.
+        tasks_queue = nr_tasks[qid == qid[k]].sum()
+        steal_frac = steals[qid[k]] / float(tasks_queue) if tasks_queue > 0 else 0.0
+        depth = depth_sum[k] / float(nr_tasks[k]) if nr_tasks[k] > 0 else 0.0
+        print(
+            "   %6d %4d %10d %7.2f %7.2f %7.2f %9.1f %9d"
+            % (
+                k,
+                qid[k],
+                nr_tasks[k],
+                100.0 * busy_frac,
+                100.0 * (1.0 - busy_frac),
+                100.0 * steal_frac,
+                depth,
+                depth_max[k],
+            )
+        )
+
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser(description="Read a SWIFT step profile")
+    parser.add_argument("input", help="Step profile file")
+    parser.add_argument(
+        "-f",
+        "--follow",
+        dest="follow",
+        help="Keep reading the file as the run writes it",
+        default=False,
+        action="store_true",
+    )
+    parser.add_argument(
+        "-s",
+        "--summary",
+        dest="summary",
+        help="Only print the totals over all steps",
+        default=False,
+        action="store_true",
+    )
+    parser.add_argument(
+        "-i",
+        "--interval",
+        dest="interval",
+        help="Seconds between reads of the file with --follow",
+        default=5.0,
+        type=float,
+    )
+    args = parser.parse_args()
+
+    nr_printed = []
+    while True:
+        blocks = read_step_profile(args.input)
+        for b, block in enumerate(blocks):
+            if args.summary:
+                print_summary(block)
+                continue
+            if b == len(nr_printed):
+                nr_printed.append(0)
+                print_header(block)
+            print_steps(block, block["records"][nr_printed[b] :])
+            nr_printed[b] = len(block["records"])
+
+        if not args.follow or args.summary:
+            break
+        time.sleep(args.interval)
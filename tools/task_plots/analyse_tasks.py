@@ -11,6 +11,10 @@ The output is an analysis of the task timings, including deadtime per thread
 and step, total amount of time spent for each task type, for the whole step
 and per thread and the minimum and maximum times spent per task type.
 
+If SWIFT was configured with --enable-task-counters, the hardware counts of
+the tasks dumped next to the input file (task_counters-step*.dat) are also
+summarised by task type and subtype, and by cell depth.
+
 This file is part of SWIFT.
 Copyright (c) 2017 Peter W. Draper (p.w.draper@durham.ac.uk)
 
@@ -35,6 +39,7 @@ import matplotlib.collections as collections
 import matplotlib.ticker as plticker
 import pylab as pl
 import sys
+import os
 import argparse
 
 #  Handle the command line.
@@ -57,6 +62,14 @@ parser.add_argument(
     default="all",
     action="store",
 )
+parser.add_argument(
+    "-c",
+    "--counters",
+    dest="counters",
+    help="Hardware counters file of the step (default: the task_counters file next to the input, if any)",
+    default=None,
+    action="store",
+)
 
 args = parser.parse_args()
 infile = args.input
@@ -85,6 +98,7 @@ TASKTYPES = [
     "kick2",
     "timestep",
     "timestep_limiter",
+    "kick_timestep",
     "send",
     "recv",
     "grav_long_range",
@@ -157,6 +171,100 @@ SIDS = [
     "( 0, 0,-1)",
 ]
 
+
+
+def read_counters(filename):
+    """Read a hardware counters dump, returns the column names, the CPU
+    frequency and the rows of sums."""
+    names = None
+    cpufreq = None
+    rows = []
+    with open(filename) as f:
+        for line in f:
+            if line.startswith("# CPU frequency:"):
+                cpufreq = float(line.split(":")[1])
+            elif line.startswith("# type") or line.startswith("# rank"):
+                names = line[1:].split()
+            elif not line.startswith("#"):
+                rows.append(line.split())
+    return names, cpufreq, rows
+
+
+def print_counters(names, cpufreq, rows, rank):
+    """Print the hardware counts of the tasks of a rank, by type/subtype and
+    by type/subtype and cell depth, with the derived rates."""
+    events = names[names.index("ticks") + 1 :]
+    rankcol = names.index("rank") if "rank" in names else -1
+    typecol = names.index("type")
+
+    #  Sum the counts over the depths as well.
+    bytype = {}
+    bydepth = {}
+    for row in rows:
+        if rankcol >= 0 and int(row[rankcol]) != rank:
+            continue
+        key = row[typecol] + "/" + row[typecol + 1]
+        depth = int(row[typecol + 2])
+        values = [int(v) for v in row[typecol + 3 :]]
+        for sums, k in ((bytype, key), (bydepth, (key, depth))):
+            if not k in sums:
+                sums[k] = [0] * len(values)
+            sums[k] = [a + b for a, b in zip(sums[k], values)]
+
+    #  The derived rates that can be computed from these events.
+    derived = []
+    if "cycles" in events and "instructions" in events:
+        derived.append(("IPC", "instructions", "cycles", 1.0))
+    if "llc_misses" in events and "instructions" in events:
+        derived.append(("LLC MPKI", "llc_misses", "instructions", 1000.0))
+    if "stalled_cycles_backend" in events and "cycles" in events:
+        derived.append(("%stall_be", "stalled_cycles_backend", "cycles", 100.0))
+    if "stalled_cycles_frontend" in events and "cycles" in events:
+        derived.append(("%stall_fe", "stalled_cycles_frontend", "cycles", 100.0))
+
+    def print_line(label, sums):
+        count = sums[0]
+        line = "{0:30s}: {1:7d} {2:9.4f}".format(label, count, sums[1] / cpufreq)
+        for k in range(len(events)):
+            line += " {0:>14d}".format(sums[2 + k])
+        for name, num, den, scale in derived:
+            value = sums[2 + events.index(den)]
+            if value > 0:
+                value = scale * sums[2 + events.index(num)] / value
+            line += " {0:>10.3f}".format(value)
+        print(line)
+
+    header = "# {0:<28s}: {1:>7s} {2:>9s}".format("type/subtype [depth]", "count", "time")
+    for name in events:
+        header += " {0:>14s}".format(name[:14])
+    for name, num, den, scale in derived:
+        header += " {0:>10s}".format(name)
+
+    print("# Hardware counters (sums over the tasks, time in ms):")
+    print("# ----------------------------------------------------")
+    print(header)
+    for key in sorted(bytype.keys()):
+        print_line(key, bytype[key])
+    print()
+    print("# By cell depth:")
+    print(header)
+    for key in sorted(bydepth.keys()):
+        print_line("{0:s} [{1:d}]".format(key[0], key[1]), bydepth[key])
+    print()
+
+
+#  Hardware counters of the same step, if any.
+counters = None
+counters_file = args.counters
+if counters_file is None:
+    dirname, basename = os.path.split(infile)
+    guess = os.path.join(dirname, basename.replace("thread_info", "task_counters"))
+    if guess != infile and os.path.exists(guess):
+        counters_file = guess
+if counters_file is not None:
+    counters = read_counters(counters_file)
+    print("# Hardware counters from:", counters_file)
+
 #  Read input.
 data = pl.loadtxt(infile)
 full_step = data[0, :]
@@ -177,6 +285,7 @@ if full_step.size == 13:
     updates = int(full_step[7])
     g_updates = int(full_step[8])
     s_updates = int(full_step[9])
+    criticalcol = 10
 else:
     print("# non MPI mode")
     nranks = 1
@@ -190,6 +299,7 @@ else:
     updates = int(full_step[6])
     g_updates = int(full_step[7])
     s_updates = int(full_step[8])
+    criticalcol = 9
 
 #  Get the CPU clock to convert ticks into milliseconds.
 CPU_CLOCK = float(full_step[-1]) / 1000.0
@@ -238,6 +348,11 @@ for rank in ranks:
     #  Calculate the time range.
     total_t = (toc_step - tic_step) / CPU_CLOCK
     print("# Data range: ", total_t, "ms")
+
+    #  Critical path of the tasks, zero in older dumps.
+    critical_t = int(full_step[criticalcol]) / CPU_CLOCK
+    if critical_t > 0:
+        print("# Critical path: ", critical_t, "ms")
     print()
 
     #  Correct times to relative values.
@@ -551,4 +666,9 @@ for rank in ranks:
     )
     print()
 
+    #  Hardware counters of the tasks.
+    if counters is not None:
+        names, cpufreq, rows = counters
+        print_counters(names, cpufreq / 1000.0, rows, rank)
+
 sys.exit(0)
@@ -170,6 +170,7 @@ TASKTYPES = [
     "kick2",
     "timestep",
     "timestep_limiter",
+    "kick_timestep",
     "send",
     "recv",
     "grav_long_range",